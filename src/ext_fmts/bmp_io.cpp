@@ -1,5 +1,7 @@
 #include "bmp_io.hpp"
 #include <EasyBMP/EasyBMP.h>
+#include <ppmdu/containers/img_detile.hpp>
+#include <ppmdu/containers/palette_matcher.hpp>
 #include <utils/library_wide.hpp>
 #include <utils/handymath.hpp>
 #include <iostream>
@@ -8,12 +10,6 @@ using namespace std;
 
 namespace utils{ namespace io
 {
-    //A little operator to make dealing with finding the color index easier
-    inline bool operator==( const RGBApixel & a, const gimg::colorRGB24 & b )
-    {
-        return (a.Red == b.red) && (a.Green == b.green) && (a.Blue == b.blue);
-    }
-
     //A little operator to make converting color types easier
     inline RGBApixel colorRGB24ToRGBApixel( const gimg::colorRGB24 & c )
     {
@@ -34,19 +30,6 @@ namespace utils{ namespace io
         return tmp;
     }
 
-    //Returns -1 if it doesn't find the color !
-    template< class paletteT >
-        inline int FindIndexForColor( const RGBApixel & pix, const paletteT & palette )
-    {
-        for( unsigned int i = 0; i < palette.size(); ++i )
-        {
-            if( pix == palette[i] )
-                return i;
-        }
-
-        return -1;
-    }
-
 //
 //
 //
@@ -138,32 +121,76 @@ namespace utils{ namespace io
             maxCopyHeight = std::min( input.TellHeight(), maxCopyHeight );
         }
 
-        //Copy pixels over
-        for( int i = 0; i < maxCopyWidth; ++i )
+        //EasyBMP only gives us the color of the pixels, so we need to find what index the color is..
+        gimg::PaletteMatcher matcher( std::vector<gimg::colorRGB24>( outpal.begin(), outpal.begin() + nbColors ) );
+
+        //Copy pixels over, one scanline at a time
+        std::vector<uint8_t> scanline( maxCopyWidth );
+        for( int j = 0; j < maxCopyHeight; ++j )
         {
-            for( int j = 0; j < maxCopyHeight; ++j )
+            for( int i = 0; i < maxCopyWidth; ++i )
             {
-                RGBApixel apixel = input.GetPixel(i,j);
+                RGBApixel apixel  = input.GetPixel(i,j);
+                bool      isexact = true;
+                scanline[i] = matcher.FindIndex( apixel.Red, apixel.Green, apixel.Blue, &isexact );
 
-                //First we need to find out what index the color is..
-                gimg::colorRGB24::colordata_t colorindex = FindIndexForColor( apixel, outpal );
-
-                if( !hasWarnedOORPixel && colorindex == -1 )
+                if( !hasWarnedOORPixel && !isexact )
                 {
                     //We got a problem
                     cerr <<"\n<!>-Warning: Image " <<filepath <<", has pixels with colors that aren't in the colormap/palette!\n"
-                         <<"Defaulting pixels out of range to color 0!\n";
+                         <<"Using the closest color in the palette for those pixels!\n";
                     hasWarnedOORPixel = true;
-                    colorindex        = 0;
                 }
-
-                out_timg.getPixel( i, j ) = colorindex;
             }
+            gimg::RetileScanline( scanline.data(), maxCopyWidth, j, out_timg );
         }
 
         return true;
     }
 
+    template<class _TImg_t>
+        size_t ImportBMPAndRemap( _TImg_t                             & out_timg, 
+                                  const std::string                   & filepath, 
+                                  const std::vector<gimg::colorRGB24> & palette )
+    {
+        static const unsigned int NB_Colors_Support = utils::do_exponent_of_2_<_TImg_t::pixel_t::mypixeltrait_t::BITS_PER_PIXEL>::value;
+        BMP input;
+        if( !input.ReadFromFile( filepath.c_str() ) )
+            throw runtime_error("ERROR: Couldn't read BMP image \"" + filepath + "\"!");
+
+        //Don't use colors the pixels can't refer to
+        std::vector<gimg::colorRGB24> usedpal( palette.begin(), palette.begin() + std::min<size_t>( palette.size(), NB_Colors_Support ) );
+        gimg::PaletteMatcher          matcher(usedpal);
+
+        //Make sure the height and width are divisible by the size of the tiles!
+        int tiledwidth  = input.TellWidth();
+        int tiledheight = input.TellHeight();
+        if( tiledwidth % _TImg_t::tile_t::WIDTH )
+            tiledwidth = CalcClosestHighestDenominator( tiledwidth,  _TImg_t::tile_t::WIDTH );
+        if( tiledheight % _TImg_t::tile_t::HEIGHT )
+            tiledheight = CalcClosestHighestDenominator( tiledheight,  _TImg_t::tile_t::HEIGHT );
+
+        out_timg.setPixelResolution( tiledwidth, tiledheight );
+        out_timg.setNbColors( NB_Colors_Support );
+        std::copy( usedpal.begin(), usedpal.end(), out_timg.getPalette().begin() );
+
+        size_t               nbinexact = 0;
+        std::vector<uint8_t> scanline( input.TellWidth() );
+        for( int j = 0; j < input.TellHeight(); ++j )
+        {
+            for( int i = 0; i < input.TellWidth(); ++i )
+            {
+                RGBApixel apixel  = input.GetPixel(i,j);
+                bool      isexact = true;
+                scanline[i] = matcher.FindIndex( apixel.Red, apixel.Green, apixel.Blue, &isexact );
+                if( !isexact )
+                    ++nbinexact;
+            }
+            gimg::RetileScanline( scanline.data(), scanline.size(), j, out_timg );
+        }
+        return nbinexact;
+    }
+
     template<class _TImg_t>
         bool ExportBMP( const _TImg_t     & in_indexed,
                         const std::string & filepath )
@@ -181,20 +208,22 @@ namespace utils{ namespace io
             throw std::runtime_error( "ERROR: The tiled image to write to a bitmap image file has an invalid amount of color in its palette!" );
         }
         //copy palette
+        std::vector<RGBApixel> bmppal( NbColorsPP_t::value );
         for( int i = 0; i < NbColorsPP_t::value; ++i )
-            output.SetColor( i, colorRGB24ToRGBApixel( in_indexed.getPalette()[i] ) );
+        {
+            bmppal[i] = colorRGB24ToRGBApixel( in_indexed.getPalette()[i] );
+            output.SetColor( i, bmppal[i] );
+        }
 
-        //Copy image
+        //Copy image, one scanline at a time
         output.SetSize( in_indexed.getNbPixelWidth(), in_indexed.getNbPixelHeight() );
 
-        for( int i = 0; i < output.TellWidth(); ++i )
+        std::vector<uint8_t> scanline( in_indexed.getNbPixelWidth() );
+        for( int j = 0; j < output.TellHeight(); ++j )
         {
-            for( int j = 0; j < output.TellHeight(); ++j )
-            {
-                auto &  refpixel = in_indexed.getPixel( i, j );
-                uint8_t temp     = static_cast<uint8_t>( refpixel.getWholePixelData() );
-                output.SetPixel( i,j, colorRGB24ToRGBApixel( in_indexed.getPalette()[temp] ) ); //We need to input the color directly thnaks to EasyBMP
-            }
+            gimg::DetileScanline( in_indexed, j, scanline.data() );
+            for( int i = 0; i < output.TellWidth(); ++i )
+                output.SetPixel( i,j, bmppal[scanline[i]] ); //We need to input the color directly thnaks to EasyBMP
         }
 
         bool bsuccess = false;
@@ -215,6 +244,31 @@ namespace utils{ namespace io
     }
 
 
+    utils::Resolution ImportRGBA32FromBMP( std::vector<uint8_t> & out_rgba, const std::string & filepath )
+    {
+        BMP input;
+        if( !input.ReadFromFile( filepath.c_str() ) )
+            throw runtime_error("ERROR: Couldn't read BMP image \"" + filepath + "\"!");
+
+        const unsigned int width  = input.TellWidth();
+        const unsigned int height = input.TellHeight();
+        out_rgba.resize( width * height * 4 );
+
+        uint8_t * pout = out_rgba.data();
+        for( unsigned int j = 0; j < height; ++j )
+        {
+            for( unsigned int i = 0; i < width; ++i )
+            {
+                RGBApixel apixel = input.GetPixel(i,j);
+                *(pout++) = apixel.Red;
+                *(pout++) = apixel.Green;
+                *(pout++) = apixel.Blue;
+                *(pout++) = 0xFF; //EasyBMP doesn't fill the alpha for regular BMPs
+            }
+        }
+        return utils::Resolution{ width, height };
+    }
+
     std::vector<gimg::colorRGB24> ImportPaletteFromBMP( const std::string & filepath )
     {
         std::vector<gimg::colorRGB24> outpal;
@@ -333,4 +387,20 @@ namespace utils{ namespace io
         return ImportBMP( out_indexed, filepath, forcedwidth, forcedheight, erroronwrongres );
     }
 
+    template<>
+        size_t ImportFromBMPAndRemap( gimg::tiled_image_i4bpp             & out_indexed,
+                                      const std::string                   & filepath,
+                                      const std::vector<gimg::colorRGB24> & palette )
+    {
+        return ImportBMPAndRemap( out_indexed, filepath, palette );
+    }
+
+    template<>
+        size_t ImportFromBMPAndRemap( gimg::tiled_image_i8bpp             & out_indexed,
+                                      const std::string                   & filepath,
+                                      const std::vector<gimg::colorRGB24> & palette )
+    {
+        return ImportBMPAndRemap( out_indexed, filepath, palette );
+    }
+
 };};
\ No newline at end of file
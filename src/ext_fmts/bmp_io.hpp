@@ -8,6 +8,7 @@ Description: Interface for loading bmp files into common containers, encapsulati
 */
 #include <ppmdu/containers/tiled_image.hpp>
 #include <ext_fmts/supported_io_info.hpp>
+#include <utils/utility.hpp>
 #include <string>
 
 namespace utils{ namespace io
@@ -65,6 +66,25 @@ namespace utils{ namespace io
 
 
 
+    /*
+        ImportFromBMPAndRemap
+            Imports a BMP of any bitdepth, and converts each pixels to the index of the closest 
+            color in "palette". The palette is then set as the image's palette.
+            Returns the amount of pixels whose color wasn't exactly in the palette.
+    */
+    template<class _TImg_t>
+        size_t ImportFromBMPAndRemap( _TImg_t                             & out_indexed,
+                                      const std::string                   & filepath,
+                                      const std::vector<gimg::colorRGB24> & palette );
+
+    /*
+        ImportRGBA32FromBMP
+            Reads the pixels of a BMP of any bitdepth as packed 32 bits RGBA pixels, one
+            scanline after the other, into "out_rgba". Returns the resolution of the image.
+            BMPs have no transparency, so all pixels are fully opaque.
+    */
+    utils::Resolution ImportRGBA32FromBMP( std::vector<uint8_t> & out_rgba, const std::string & filepath );
+
     std::vector<gimg::colorRGB24> ImportPaletteFromBMP( const std::string & filepath );
     void                          SetPaletteBMPImg( const std::vector<gimg::colorRGB24> & srcpal, 
                                                     const std::string & filepath);
@@ -1,10 +1,16 @@
 #include "png_io.hpp"
 #include <ppmdu/containers/tiled_image.hpp>
+#include <ppmdu/containers/img_detile.hpp>
+#include <ppmdu/containers/palette_matcher.hpp>
 #include <ppmdu/pmd2/pmd2_palettes.hpp>
 #include <utils/library_wide.hpp>
 #include <utils/handymath.hpp>
+#include <utils/gfileio.hpp>
 #include <png++/png.hpp>
 #include <iostream>
+#include <fstream>
+#include <functional>
+#include <csetjmp>
 using namespace std;
 
 namespace utils{ namespace io
@@ -26,6 +32,22 @@ namespace utils{ namespace io
             static const uint32_t nbcolors = 256u; //256 colors
         };
 
+//
+// Copy a png++ row into a scanline of a tiled image
+//
+    template<class _outTImg>
+        inline void RetilePNGRow( std::vector<png::index_pixel> & row, unsigned int count, unsigned int y, _outTImg & out_indexed )
+    {
+        gimg::RetileScanline( &row[0], count, y, out_indexed );
+    }
+
+    //4bpp png++ rows are already packed 2 pixels per bytes
+    template<class _outTImg>
+        inline void RetilePNGRow( png::packed_pixel_row<png::index_pixel_4> & row, unsigned int count, unsigned int y, _outTImg & out_indexed )
+    {
+        gimg::RetileScanlinePacked4bpp( row.get_data(), count, y, out_indexed );
+    }
+
 
 //
 // Copy from indexed to PNG palette
@@ -45,6 +67,164 @@ namespace utils{ namespace io
         return std::move(palette);
     }
 
+//==============================================================================================
+//  PNG Encoding
+//==============================================================================================
+    static PNGWriteSettings s_DefaultPNGWriteSettings;
+
+    void SetDefaultPNGWriteSettings( const PNGWriteSettings & settings )
+    {
+        s_DefaultPNGWriteSettings = settings;
+    }
+
+    const PNGWriteSettings & GetDefaultPNGWriteSettings()
+    {
+        return s_DefaultPNGWriteSettings;
+    }
+
+    //libpng callbacks
+    namespace
+    {
+        struct pngwritectx
+        {
+            std::vector<uint8_t> * pout;
+            std::string            lasterror;
+        };
+
+        void PNGWriteToVector( png_structp png, png_bytep data, png_size_t length )
+        {
+            pngwritectx * pctx = reinterpret_cast<pngwritectx*>( png_get_io_ptr(png) );
+            pctx->pout->insert( pctx->pout->end(), data, data + length );
+        }
+
+        void PNGFlushNothing( png_structp ) 
+        {}
+
+        void PNGOnError( png_structp png, png_const_charp msg )
+        {
+            pngwritectx * pctx = reinterpret_cast<pngwritectx*>( png_get_error_ptr(png) );
+            pctx->lasterror = msg;
+            png_longjmp( png, 1 );
+        }
+
+        void PNGOnWarning( png_structp, png_const_charp )
+        {}
+
+        int PNGFilterFlags( PNGWriteSettings::eFilter filter )
+        {
+            switch(filter)
+            {
+                case PNGWriteSettings::eFilter::None:    return PNG_FILTER_NONE;
+                case PNGWriteSettings::eFilter::Sub:     return PNG_FILTER_SUB;
+                case PNGWriteSettings::eFilter::Up:      return PNG_FILTER_UP;
+                case PNGWriteSettings::eFilter::Average: return PNG_FILTER_AVG;
+                case PNGWriteSettings::eFilter::Paeth:   return PNG_FILTER_PAETH;
+                case PNGWriteSettings::eFilter::All:     return PNG_ALL_FILTERS;
+                default:                                 return -1;
+            };
+        }
+
+        //Detile a scanline into the packed format PNG expects for the bitdepth
+        inline void DetilePNGRow( const gimg::tiled_image_i4bpp & img, unsigned int y, uint8_t * pout )
+        {
+            gimg::DetileScanlinePacked4bpp( img, y, pout );
+        }
+
+        inline void DetilePNGRow( const gimg::tiled_image_i8bpp & img, unsigned int y, uint8_t * pout )
+        {
+            gimg::DetileScanline( img, y, pout );
+        }
+
+        //One encoder per thread, so buffers get reused between images
+        PNGIndexedEncoder & ThisThreadPNGEncoder()
+        {
+            thread_local PNGIndexedEncoder s_encoder;
+            s_encoder.setSettings( GetDefaultPNGWriteSettings() );
+            return s_encoder;
+        }
+    };
+
+    PNGIndexedEncoder::PNGIndexedEncoder( const PNGWriteSettings & settings )
+        :m_settings(settings)
+    {}
+
+    template<class _TImg_t>
+        void PNGIndexedEncoder::DoEncode( const _TImg_t & img, int bitdepth, std::vector<uint8_t> & out_png )
+    {
+        const png_uint_32 width    = img.getNbPixelWidth();
+        const png_uint_32 height   = img.getNbPixelHeight();
+        const auto      & srcpal   = img.getPalette();
+        const size_t      nbcolors = std::min<size_t>( srcpal.size(), (1u << bitdepth) );
+        png_color         palette[256];
+        pngwritectx       ctx;
+        ctx.pout = &out_png;
+        out_png.resize(0);
+
+        for( size_t i = 0; i < nbcolors; ++i )
+        {
+            palette[i].red   = srcpal[i].red;
+            palette[i].green = srcpal[i].green;
+            palette[i].blue  = srcpal[i].blue;
+        }
+        m_rowbuf.resize( ((width * bitdepth) + 7) / 8 );
+
+        png_structp png  = png_create_write_struct( PNG_LIBPNG_VER_STRING, &ctx, PNGOnError, PNGOnWarning );
+        png_infop   info = (png != nullptr)? png_create_info_struct(png) : nullptr;
+        if( png == nullptr || info == nullptr )
+        {
+            png_destroy_write_struct( &png, &info );
+            throw std::runtime_error( "PNGIndexedEncoder::Encode(): Couldn't allocate libpng write structures!" );
+        }
+
+        //Nothing below this point may need a destructor, because of longjmp
+        if( setjmp( png_jmpbuf(png) ) )
+        {
+            png_destroy_write_struct( &png, &info );
+            throw std::runtime_error( "PNGIndexedEncoder::Encode(): libpng error: " + ctx.lasterror );
+        }
+
+        png_set_write_fn( png, &ctx, PNGWriteToVector, PNGFlushNothing );
+        if( m_settings.zlibLevel >= 0 )
+            png_set_compression_level( png, std::min( m_settings.zlibLevel, 9 ) );
+        if( m_settings.filter != PNGWriteSettings::eFilter::Default )
+            png_set_filter( png, PNG_FILTER_TYPE_BASE, PNGFilterFlags(m_settings.filter) );
+
+        png_set_IHDR( png, info, width, height, bitdepth, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+        png_set_PLTE( png, info, palette, static_cast<int>(nbcolors) );
+        png_write_info( png, info );
+
+        for( png_uint_32 y = 0; y < height; ++y )
+        {
+            DetilePNGRow( img, y, m_rowbuf.data() );
+            png_write_row( png, m_rowbuf.data() );
+        }
+
+        png_write_end( png, info );
+        png_destroy_write_struct( &png, &info );
+    }
+
+    void PNGIndexedEncoder::Encode( const gimg::tiled_image_i4bpp & img, std::vector<uint8_t> & out_png )
+    {
+        DoEncode( img, 4, out_png );
+    }
+
+    void PNGIndexedEncoder::Encode( const gimg::tiled_image_i8bpp & img, std::vector<uint8_t> & out_png )
+    {
+        DoEncode( img, 8, out_png );
+    }
+
+    void PNGIndexedEncoder::EncodeToFile( const gimg::tiled_image_i4bpp & img, const std::string & filepath )
+    {
+        Encode( img, m_filebuf );
+        WriteByteVectorToFile( filepath, m_filebuf );
+    }
+
+    void PNGIndexedEncoder::EncodeToFile( const gimg::tiled_image_i8bpp & img, const std::string & filepath )
+    {
+        Encode( img, m_filebuf );
+        WriteByteVectorToFile( filepath, m_filebuf );
+    }
+
 //
 // Read an indexed png of a specific bitdepth
 //
@@ -125,13 +305,72 @@ namespace utils{ namespace io
         //Fill the pixels
         //out_indexed.setPixelResolution( input.get_width(), input.get_height() );
 
-        for( unsigned int i = 0; i < maxCopyWidth; ++i )
+        for( unsigned int j = 0; j < maxCopyHeight; ++j )
+            RetilePNGRow( input.get_row(j), maxCopyWidth, j, out_indexed );
+    }
+
+//
+// Read a png of any color type, and remap its pixels to the closest colors in a palette
+//
+    template<class _outTImg>
+        size_t readPNG_remapped( _outTImg                            & out_indexed, 
+                                 const std::string                   & filepath,
+                                 const std::vector<gimg::colorRGB24> & palette )
+    {
+        static const unsigned int NbColorsMax = utils::do_exponent_of_2_<_outTImg::pixel_t::mypixeltrait_t::BITS_PER_PIXEL>::value;
+        png::image<png::rgb_pixel> input;
+        input.read( filepath ); //png++ converts indexed and grayscale images to rgb for us
+
+        //Don't use colors the pixels can't refer to
+        std::vector<gimg::colorRGB24> usedpal( palette.begin(), palette.begin() + std::min<size_t>( palette.size(), NbColorsMax ) );
+        gimg::PaletteMatcher          matcher(usedpal);
+
+        //Make sure the height and width are divisible by the size of the tiles!
+        unsigned int tiledwidth  = input.get_width();
+        unsigned int tiledheight = input.get_height();
+        if( tiledwidth % _outTImg::tile_t::WIDTH )
+            tiledwidth = CalcClosestHighestDenominator( tiledwidth,  _outTImg::tile_t::WIDTH );
+        if( tiledheight % _outTImg::tile_t::HEIGHT )
+            tiledheight = CalcClosestHighestDenominator( tiledheight,  _outTImg::tile_t::HEIGHT );
+
+        out_indexed.setPixelResolution( tiledwidth, tiledheight );
+        out_indexed.setNbColors( NbColorsMax );
+        std::copy( usedpal.begin(), usedpal.end(), out_indexed.getPalette().begin() );
+
+        //Remap the image one scanline at a time
+        size_t               nbinexact = 0;
+        std::vector<uint8_t> scanline( input.get_width() );
+        for( unsigned int j = 0; j < input.get_height(); ++j )
         {
-            for( unsigned int j = 0; j < maxCopyHeight; ++j )
+            const auto & row = input.get_row(j);
+            nbinexact += matcher.MapPixels( &(row[0].red), scanline.size(), sizeof(png::rgb_pixel), scanline.data() );
+            gimg::RetileScanline( scanline.data(), scanline.size(), j, out_indexed );
+        }
+        return nbinexact;
+    }
+
+    utils::Resolution ImportRGBA32FromPNG( std::vector<uint8_t> & out_rgba, const std::string & filepath )
+    {
+        png::image<png::rgba_pixel> input;
+        input.read( filepath ); //png++ converts indexed and grayscale images to rgba for us, tRNS chunk included
+
+        const unsigned int width  = input.get_width();
+        const unsigned int height = input.get_height();
+        out_rgba.resize( width * height * 4 );
+
+        uint8_t * pout = out_rgba.data();
+        for( unsigned int j = 0; j < height; ++j )
+        {
+            const auto & row = input.get_row(j);
+            for( unsigned int i = 0; i < width; ++i )
             {
-                out_indexed.getPixel( i, j ) = _outTImg::pixel_t::GetAcomponentBitmask(0) & static_cast<uint8_t>( input.get_pixel(i,j) );
+                *(pout++) = row[i].red;
+                *(pout++) = row[i].green;
+                *(pout++) = row[i].blue;
+                *(pout++) = row[i].alpha;
             }
         }
+        return utils::Resolution{ width, height };
     }
 
 //==============================================================================================
@@ -179,35 +418,9 @@ namespace utils{ namespace io
     bool ExportTo4bppPNG( const gimg::tiled_image_i4bpp  & in_indexed,
                           const std::string              & filepath )
     {
-        png::image<png::index_pixel_4> output;
-        //png::palette                   palette(in_indexed.getNbColors());
-
-        ////copy palette
-        //for( unsigned int i = 0; i < palette.size(); ++i )
-        //{
-        //    palette[i].red   = in_indexed.getPalette()[i].red;
-        //    palette[i].green = in_indexed.getPalette()[i].green;
-        //    palette[i].blue  = in_indexed.getPalette()[i].blue;
-        //}
-        output.set_palette( PalToPngPal(in_indexed.getPalette()) );
-
-        //Copy image
-        output.resize( in_indexed.getNbPixelWidth(), in_indexed.getNbPixelHeight() );
-
-        for( unsigned int i = 0; i < output.get_width(); ++i )
-        {
-            for( unsigned int j = 0; j < output.get_height(); ++j )
-            {
-                auto &  refpixel = in_indexed.getPixel( i, j );
-                uint8_t temp     = static_cast<uint8_t>( refpixel.getWholePixelData() );
-                //output[j][i] = png::index_pixel_4( temp );
-                output.set_pixel( i,j, temp ); //If only one component returns the entire pixel data
-            }
-        }
-
         try
         {
-            output.write( filepath );
+            ThisThreadPNGEncoder().EncodeToFile( in_indexed, filepath );
         }
         catch( const std::exception & e )
         {
@@ -251,21 +464,9 @@ namespace utils{ namespace io
     bool ExportTo8bppPNG( const gimg::tiled_image_i8bpp & in_indexed,
                           const std::string             & filepath )
     {
-        png::image<png::index_pixel> output;
-        output.set_palette( PalToPngPal(in_indexed.getPalette()) );
-
-        //Copy image
-        output.resize( in_indexed.getNbPixelWidth(), in_indexed.getNbPixelHeight() );
-
-        for( unsigned int i = 0; i < output.get_width(); ++i )
-        {
-            for( unsigned int j = 0; j < output.get_height(); ++j )
-                output.set_pixel( i,j, static_cast<uint8_t>( in_indexed.getPixel( i, j ).getWholePixelData() ) ); //If only one component returns the entire pixel data
-        }
-
         try
         {
-            output.write( filepath );
+            ThisThreadPNGEncoder().EncodeToFile( in_indexed, filepath );
         }
         catch( const std::exception & e )
         {
@@ -294,18 +495,12 @@ namespace utils{ namespace io
         //Copy image
         output.resize( (srcMaxX - begpixX), (srcMaxY - begpixY) );
 
-        for( unsigned int i = 0; i < output.get_width(); ++i )
+        //Detile whole scanlines, and only keep the part within the crop area
+        std::vector<uint8_t> scanline( in_indexed.getNbPixelWidth() );
+        for( unsigned int j = 0; j < output.get_height() && (j + begpixY) < srcMaxY; ++j )
         {
-            for( unsigned int j = 0; j < output.get_height(); ++j )
-            {
-                size_t srcX = i + begpixX;
-                size_t srcY = j + begpixY;
-
-                if( srcX < srcMaxX && srcY < srcMaxY )
-                    output.set_pixel( i,j, static_cast<uint8_t>( in_indexed.getPixel( srcX, srcY ).getWholePixelData() ) );
-                else 
-                    break;
-            }
+            gimg::DetileScanline( in_indexed, j + begpixY, scanline.data() );
+            std::copy( scanline.begin() + begpixX, scanline.begin() + srcMaxX, output.get_row(j).begin() );
         }
 
         try
@@ -463,6 +658,23 @@ namespace utils{ namespace io
     }
 
 
+    template<>
+        size_t ImportFromPNGAndRemap( gimg::tiled_image_i4bpp             & out_indexed,
+                                      const std::string                   & filepath,
+                                      const std::vector<gimg::colorRGB24> & palette )
+    {
+        return readPNG_remapped( out_indexed, filepath, palette );
+    }
+
+    template<>
+        size_t ImportFromPNGAndRemap( gimg::tiled_image_i8bpp             & out_indexed,
+                                      const std::string                   & filepath,
+                                      const std::vector<gimg::colorRGB24> & palette )
+    {
+        return readPNG_remapped( out_indexed, filepath, palette );
+    }
+
+
     bool ExportToPNG( std::vector<gimg::colorRGBX32>    & bitmap,
                       const std::string                 & filepath, 
                       unsigned int                      forcedwidth,
@@ -529,10 +741,10 @@ namespace utils{ namespace io
         //Copy image
         output.resize( indexed8bpp.front().size(), indexed8bpp.size() );
 
-        for( unsigned int i = 0; i < output.get_width(); ++i )
+        for( unsigned int j = 0; j < output.get_height(); ++j )
         {
-            for( unsigned int j = 0; j < output.get_height(); ++j )
-                output.set_pixel( i,j, indexed8bpp[j][i] );
+            auto & outrow = output.get_row(j);
+            std::copy( indexed8bpp[j].begin(), indexed8bpp[j].begin() + outrow.size(), outrow.begin() );
         }
 
         try
@@ -551,5 +763,64 @@ namespace utils{ namespace io
         return true;
     }
 
+//================================================================================================
+//  ParallelPNGWriter
+//================================================================================================
+    ParallelPNGWriter::ParallelPNGWriter()
+        :m_nbfailed(0), m_bRunning(false)
+    {}
+
+    ParallelPNGWriter::~ParallelPNGWriter()
+    {
+        try
+        {
+            WaitAllWritten();
+        }
+        catch(...)
+        {}
+    }
+
+    void ParallelPNGWriter::Queue( const gimg::tiled_image_i4bpp & img, const std::string & filepath )
+    {
+        auto lambdaWrite = [this]( const gimg::tiled_image_i4bpp * pimg, const std::string & path )->bool
+        {
+            if( !ExportToPNG( *pimg, path ) )
+                ++m_nbfailed;
+            return true;
+        };
+        m_taskhandler.AddTask( multitask::pktask_t( std::bind( lambdaWrite, &img, filepath ) ) );
+        if( !m_bRunning )
+        {
+            m_taskhandler.Execute();
+            m_bRunning = true;
+        }
+    }
+
+    void ParallelPNGWriter::Queue( const gimg::tiled_image_i8bpp & img, const std::string & filepath )
+    {
+        auto lambdaWrite = [this]( const gimg::tiled_image_i8bpp * pimg, const std::string & path )->bool
+        {
+            if( !ExportToPNG( *pimg, path ) )
+                ++m_nbfailed;
+            return true;
+        };
+        m_taskhandler.AddTask( multitask::pktask_t( std::bind( lambdaWrite, &img, filepath ) ) );
+        if( !m_bRunning )
+        {
+            m_taskhandler.Execute();
+            m_bRunning = true;
+        }
+    }
+
+    size_t ParallelPNGWriter::WaitAllWritten()
+    {
+        if( m_bRunning )
+        {
+            m_taskhandler.BlockUntilTaskQueueEmpty();
+            m_taskhandler.StopExecute();
+            m_bRunning = false;
+        }
+        return m_nbfailed.exchange(0);
+    }
 
 };};
\ No newline at end of file
@@ -8,6 +8,10 @@ Description: Utilities for importing and exporting PNG images and their palettes
 */
 #include <ppmdu/containers/tiled_image.hpp>
 #include <ext_fmts/supported_io_info.hpp>
+#include <utils/utility.hpp>
+#include <utils/multiple_task_handler.hpp>
+#include <atomic>
+#include <memory>
 #include <string>
 
 
@@ -23,6 +27,108 @@ namespace utils{ namespace io
         unsigned int nbcolorspal;
     };
 
+//==============================================================================================
+//  PNG Encoding
+//==============================================================================================
+    /*
+        PNGWriteSettings
+            How the pixel data of the PNG images we write is compressed.
+                - zlibLevel : 0 stores the data without compression, 1 is the fastest, and 9 gives 
+                              the smallest files. -1 uses zlib's default.
+                - filter    : The row filters libpng is allowed to pick from before compressing.
+                              Indexed images are usually smaller unfiltered, which is libpng's
+                              default for them.
+    */
+    struct PNGWriteSettings
+    {
+        enum struct eFilter
+        {
+            Default,
+            None,
+            Sub,
+            Up,
+            Average,
+            Paeth,
+            All,
+        };
+
+        PNGWriteSettings( int level = -1, eFilter filt = eFilter::Default )
+            :zlibLevel(level), filter(filt)
+        {}
+
+        //The fastest settings, for intermediate files that will be read back right away.
+        static inline PNGWriteSettings Fast() { return PNGWriteSettings( 1, eFilter::None ); }
+
+        int     zlibLevel;
+        eFilter filter;
+    };
+
+    //The settings ExportToPNG uses. Those should be set before any worker threads are started!
+    void                     SetDefaultPNGWriteSettings( const PNGWriteSettings & settings );
+    const PNGWriteSettings & GetDefaultPNGWriteSettings();
+
+    /*
+        PNGIndexedEncoder
+            Writes indexed tiled images as 4bpp or 8bpp PNGs, using libpng directly.
+            Each scanline is detiled straight into a packed row buffer, and the whole file is
+            encoded in memory and then written in one go.
+
+            The buffers are kept from one image to the next, so an encoder should be reused for
+            as many images as possible. A single encoder must not be used by several threads at
+            the same time. ExportToPNG keeps one encoder per thread.
+    */
+    class PNGIndexedEncoder
+    {
+    public:
+        explicit PNGIndexedEncoder( const PNGWriteSettings & settings = GetDefaultPNGWriteSettings() );
+
+        //Encodes the image to a PNG file in memory. Throws on error.
+        void Encode( const gimg::tiled_image_i4bpp & img, std::vector<uint8_t> & out_png );
+        void Encode( const gimg::tiled_image_i8bpp & img, std::vector<uint8_t> & out_png );
+
+        //Encodes the image and writes it to "filepath". Throws on error.
+        void EncodeToFile( const gimg::tiled_image_i4bpp & img, const std::string & filepath );
+        void EncodeToFile( const gimg::tiled_image_i8bpp & img, const std::string & filepath );
+
+        inline void                     setSettings( const PNGWriteSettings & settings ) { m_settings = settings; }
+        inline const PNGWriteSettings & getSettings()const                               { return m_settings; }
+
+    private:
+        template<class _TImg_t>
+            void DoEncode( const _TImg_t & img, int bitdepth, std::vector<uint8_t> & out_png );
+
+        PNGWriteSettings     m_settings;
+        std::vector<uint8_t> m_rowbuf;
+        std::vector<uint8_t> m_filebuf;
+    };
+
+    /*
+        ParallelPNGWriter
+            Encodes and writes indexed images as PNGs on worker threads, while the caller keeps
+            going. Images are written with ExportToPNG, so each worker thread reuses its own encoder.
+            The images passed to Queue must stay alive and unchanged until WaitAllWritten returns!
+    */
+    class ParallelPNGWriter
+    {
+    public:
+        ParallelPNGWriter();
+        ~ParallelPNGWriter();
+
+        void Queue( const gimg::tiled_image_i4bpp & img, const std::string & filepath );
+        void Queue( const gimg::tiled_image_i8bpp & img, const std::string & filepath );
+
+        //Blocks until all queued images were written. Returns the amount of images that couldn't be written.
+        size_t WaitAllWritten();
+
+    private:
+        ParallelPNGWriter( const ParallelPNGWriter & );
+        ParallelPNGWriter & operator=( const ParallelPNGWriter & );
+
+        multitask::CMultiTaskHandler m_taskhandler;
+        std::atomic<size_t>          m_nbfailed;
+        bool                         m_bRunning;
+    };
+
 //==============================================================================================
 //  Import/Export from/to 4bpp
 //==============================================================================================
@@ -80,6 +186,26 @@ namespace utils{ namespace io
                             bool                erroronwrongres = false );
 
 
+    /*
+        ImportFromPNGAndRemap
+            Imports a PNG of any color type, indexed or not, and converts each pixels to the index 
+            of the closest color in "palette". The palette is then set as the image's palette.
+            Only the colors the image's pixels can refer to are used.
+            Returns the amount of pixels whose color wasn't exactly in the palette.
+    */
+    template<class _TImg_t>
+        size_t ImportFromPNGAndRemap( _TImg_t                             & out_indexed,
+                                      const std::string                   & filepath,
+                                      const std::vector<gimg::colorRGB24> & palette );
+
+
+    /*
+        ImportRGBA32FromPNG
+            Reads the pixels of a PNG of any color type as packed 32 bits RGBA pixels, one
+            scanline after the other, into "out_rgba". Returns the resolution of the image.
+    */
+    utils::Resolution ImportRGBA32FromPNG( std::vector<uint8_t> & out_rgba, const std::string & filepath );
+
     std::vector<gimg::colorRGB24> ImportPaletteFromPNG( const std::string & filepath );
     void                          SetPalettePNGImg( const std::vector<gimg::colorRGB24> & srcpal, 
                                                     const std::string & filepath);
@@ -4,7 +4,9 @@
 //#include <ppmdu/pmd2/pmd2_sprites.hpp>
 #include <ppmdu/pmd2/pmd2_filetypes.hpp>
 #include <ppmdu/containers/sprite_data.hpp>
+#include <ppmdu/containers/sprite_build_cache.hpp>
 #include <utils/multiple_task_handler.hpp>
+#include <utils/bounded_queue.hpp>
 #include <utils/library_wide.hpp>
 #include <ppmdu/fmts/wan.hpp>
 #include <ppmdu/fmts/pack_file.hpp>
@@ -17,6 +19,7 @@
 #include <ppmdu/fmts/bpc.hpp>
 #include <ppmdu/fmts/bpl.hpp>
 #include <ppmdu/fmts/bma.hpp>
+#include <ext_fmts/png_io.hpp>
 #include <cfenv>
 #include <string>
 #include <algorithm>
@@ -30,6 +33,7 @@
 #include <chrono>
 #include <thread>
 #include <future>
+#include <mutex>
 #include <fstream>
 #include <Poco/Path.h>
 #include <Poco/File.h>
@@ -62,6 +66,7 @@ namespace gfx_util
     //static const int                  HPBar_UpdateMSecs    = 80; //Updates at every HPBar_UpdateMSecs mseconds
     static const uint32_t             ForcedPokeSpritePack = 0x1300; //The offset where pack files containing pokemon sprites are forced to begin at
     static const chrono::milliseconds ProgressUpdThWait    = chrono::milliseconds(100);
+    static const unsigned int         SprExpQueueLenPerThread = 2;     //Max amount of sprites waiting in front of each threads of a sprite export stage
 
     static const int                  RETVAL_GenericFail  = -1;
     static const int                  RETVAL_InvalidOp    = -2;
@@ -190,45 +195,183 @@ namespace gfx_util
     }
 
     /*
+        ExportPackedSprites
+            Exports every sprites in a pack file to their own sub-directory, through a pipeline of
+            bounded stages each running on their own threads:
+                PX decompress -> WAN parse -> export (image encoding and writing)
+            The pack is already in memory, so the decompress threads take the sub-files straight 
+            from it. Only a few sprites are in flight at the same time, instead of the whole pack 
+            being parsed at once. Sub-files that aren't sprites are written as-is.
+            The stages' threads count as worker threads, so the frames of a sprite aren't decoded 
+            over even more threads.
+
+            - pokesprnames : Names to give the sub-directories of each sprites, by index.
+                             Sprites past the end of the list are named after the pack file.
     */
-    void TurnPackContentToSpriteData( CPack & srcpack, std::vector<std::unique_ptr<graphics::BaseSprite>> & out_table )
-    {
-        cout <<"Parsing sprites..\n";
-        out_table.resize( srcpack.getNbSubFiles() );
-        for( unsigned int i = 0; i < srcpack.getNbSubFiles(); )
+    void ExportPackedSprites( const CPack                     & inpack, 
+                              const Poco::Path                & inputPath, 
+                              const std::string               & outdir, 
+                              utils::io::eSUPPORT_IMG_IO        imgty, 
+                              const std::vector<std::string>  & pokesprnames, 
+                              bool                              asatlas,
+                              atomic<uint32_t>                & completed )
+    {
+        struct sprexp_item
+        {
+            unsigned int                          index;
+            const vector<uint8_t>               * psrc;         //The sub-file, or the decompressed sub-file
+            vector<uint8_t>                       decompressed;
+            std::unique_ptr<graphics::BaseSprite> sprite;
+        };
+        typedef std::unique_ptr<sprexp_item>         item_t;
+        typedef multitask::BoundedQueue<item_t>      queue_t;
+
+        //Give the threads to the stages based on how heavy they are
+        const unsigned int nbthreads  = std::max( 1u, static_cast<unsigned int>(utils::LibWide().getNbThreadsToUse()) );
+        const unsigned int nbdecomp   = std::max( 1u, nbthreads / 4 );
+        const unsigned int nbparse    = std::max( 1u, nbthreads / 4 );
+        const unsigned int nbexport   = std::max( 1u, nbthreads / 2 );
+
+        queue_t               qparse ( nbparse  * SprExpQueueLenPerThread );
+        queue_t               qexport( nbexport * SprExpQueueLenPerThread );
+        std::atomic<unsigned> nextsubfile(0);
+        std::mutex            mtxexcept;
+        std::exception_ptr    firstexcept;
+
+        auto lambdaFail = [&]()
         {
-            auto & curSubFile = srcpack.getSubFile(i);
-            auto   cnttype    = DetermineCntTy( curSubFile.begin(), curSubFile.end() );
+            {
+                std::lock_guard<std::mutex> lck(mtxexcept);
+                if( !firstexcept )
+                    firstexcept = std::current_exception();
+            }
+            qparse .Abort();
+            qexport.Abort();
+        };
 
-            //
-            if( cnttype._type == CnTy_WAN )
+        //Decompress
+        auto lambdaDecompress = [&]()
+        {
+            multitask::ScopedWorkerThread markworker;
+            try
             {
-                if( utils::LibWide().isLogOn() )
+                for( unsigned int i = nextsubfile++; i < inpack.getNbSubFiles(); i = nextsubfile++ )
                 {
-                    clog <<"============================\n"
-                         <<"== Parsing Sprite #" <<setfill('0') <<setw(3) <<i <<" ==\n"
-                         <<"============================\n";
+                    item_t item( new sprexp_item );
+                    item->index = i;
+                    item->psrc  = &inpack.getSubFile(i);
+
+                    const vector<uint8_t> & cursubf = *(item->psrc);
+                    if( DetermineCntTy( cursubf.begin(), cursubf.end() )._type == CnTy_PKDPX )
+                    {
+                        DecompressPKDPX( cursubf.begin(), cursubf.end(), item->decompressed );
+                        item->psrc = &(item->decompressed);
+                    }
+                    if( !qparse.Push( std::move(item) ) )
+                        break;
                 }
-                //Convert directly
-                ParseASprite( curSubFile, out_table[i] );
             }
-            else if( cnttype._type == CnTy_PKDPX )
+            catch(...)
             {
-                //Do decompress before converting!
-                vector<uint8_t> decompbuff;
-                DecompressPKDPX( curSubFile.begin(), curSubFile.end(), decompbuff );
+                lambdaFail();
+            }
+        };
 
-                //Do a check on the decompressed file
-                if( DetermineCntTy( decompbuff.begin(), decompbuff.end() )._type != CnTy_WAN )
-                    continue; //skip this file if not a wan sprite
+        //Parse
+        auto lambdaParse = [&]()
+        {
+            multitask::ScopedWorkerThread markworker;
+            try
+            {
+                item_t item;
+                while( qparse.Pop(item) )
+                {
+                    const vector<uint8_t> & data = *(item->psrc);
+                    if( DetermineCntTy( data.begin(), data.end() )._type == CnTy_WAN )
+                    {
+                        if( utils::LibWide().isLogOn() )
+                        {
+                            stringstream sstr;
+                            sstr <<"============================\n"
+                                 <<"== Parsing Sprite #" <<setfill('0') <<setw(3) <<item->index <<" ==\n"
+                                 <<"============================\n";
+                            clog <<sstr.str();
+                        }
+                        ParseASprite( data, item->sprite );
+                    }
+                    //Don't keep the decompressed data around while waiting on the export stage
+                    item->psrc = &inpack.getSubFile(item->index);
+                    vector<uint8_t>().swap(item->decompressed);
+                    if( !qexport.Push( std::move(item) ) )
+                        break;
+                }
+            }
+            catch(...)
+            {
+                lambdaFail();
+            }
+        };
 
-                ParseASprite( decompbuff, out_table[i] );
+        //Encode and write
+        auto lambdaExport = [&]()
+        {
+            multitask::ScopedWorkerThread markworker;
+            try
+            {
+                item_t item;
+                while( qexport.Pop(item) )
+                {
+                    stringstream sstr;
+                    if( item->sprite == nullptr )
+                    {
+                        //Output the packed file's content as is
+                        const vector<uint8_t> & cursubf = *(item->psrc);
+                        sstr << inputPath.getBaseName()
+                             <<"_" <<setw(4) <<setfill('0') <<item->index <<"." 
+                             << GetAppropriateFileExtension( cursubf.begin(), cursubf.end() );
+                        utils::io::WriteByteVectorToFile( Poco::Path(outdir).append(sstr.str()).toString(), cursubf );
+                    }
+                    else
+                    {
+                        //Build the sub-folder name
+                        if( pokesprnames.size() > item->index )
+                            sstr <<setw(4) <<setfill('0') <<item->index <<"_" << pokesprnames[item->index];
+                        else
+                            sstr << inputPath.getBaseName() <<"_" <<setw(4) <<setfill('0') <<item->index;
+                        graphics::ExportSpriteToDirectoryPtr( item->sprite.get(), Poco::Path(outdir).append(sstr.str()).toString(), imgty, false, nullptr, asatlas );
+                    }
+                    item.reset();
+                    ++completed;
+                }
+            }
+            catch(...)
+            {
+                lambdaFail();
             }
-            //Skip anything else
+        };
 
-            ++i;
-            cout<<"\r" <<setw(3) <<setfill(' ') <<(( i * 100) / srcpack.getNbSubFiles()) <<"%";
-        }
+        //Each stage closes the queue after it once all its threads are done
+        vector<thread> decompthreads;
+        vector<thread> parsethreads;
+        vector<thread> exportthreads;
+        for( unsigned int i = 0; i < nbdecomp; ++i )
+            decompthreads.push_back( thread(lambdaDecompress) );
+        for( unsigned int i = 0; i < nbparse; ++i )
+            parsethreads.push_back( thread(lambdaParse) );
+        for( unsigned int i = 0; i < nbexport; ++i )
+            exportthreads.push_back( thread(lambdaExport) );
+
+        for( auto & th : decompthreads )
+            th.join();
+        qparse.Close();
+        for( auto & th : parsethreads )
+            th.join();
+        qexport.Close();
+        for( auto & th : exportthreads )
+            th.join();
+
+        if( firstexcept )
+            std::rethrow_exception(firstexcept);
     }
 
     /*
@@ -455,6 +598,46 @@ namespace gfx_util
             "-noresfix",
             std::bind( &CGfxUtil::ParseOptionNoResFix,  &GetInstance(), placeholders::_1 ),
         },
+        //Don't reuse cached sprites
+        {
+            "nocache",
+            0,
+            "When building a pack file of sprites, rebuild every sprites instead of reusing the ones from the last run whose directory didn't change. The cache is kept in a \".gfxcache\" directory next to the input directory.",
+            "-nocache",
+            std::bind( &CGfxUtil::ParseOptionNoCache,  &GetInstance(), placeholders::_1 ),
+        },
+        //Compress all portraits on import
+        {
+            "kaofullimport",
+            0,
+            "If present, all portraits are compressed when importing a kaomado, instead of reusing the unchanged ones from the kaomado being overwritten.",
+            "-kaofullimport",
+            std::bind( &CGfxUtil::ParseOptionKaoFullImport,  &GetInstance(), placeholders::_1 ),
+        },
+        //Export sprite frames as an atlas
+        {
+            "atlas",
+            0,
+            "When exporting sprites, write all the frames of each sprites into a single image, with an index of where each frames are, instead of one image per frame. Sprites exported this way can be imported back as-is.",
+            "-atlas",
+            std::bind( &CGfxUtil::ParseOptionAtlas,  &GetInstance(), placeholders::_1 ),
+        },
+        //PNG compression level
+        {
+            "pnglvl",
+            1,
+            "Set the zlib compression level of the PNG images being exported, from 0(no compression, fastest) to 9(smallest files, slowest).",
+            "-pnglvl 6",
+            std::bind( &CGfxUtil::ParseOptionPNGLevel,  &GetInstance(), placeholders::_1 ),
+        },
+        //Fast PNG export
+        {
+            "pngfast",
+            0,
+            "Export PNG images with the fastest compression settings, and no row filtering. Files are bigger, but are written much faster. Handy for intermediate files!",
+            "-pngfast",
+            std::bind( &CGfxUtil::ParseOptionPNGFast,  &GetInstance(), placeholders::_1 ),
+        },
 
 
     //=====================
@@ -569,6 +752,9 @@ namespace gfx_util
         m_ImportByIndex = false;
         m_bRedirectClog = false;
         m_bNoResAutoFix = false;
+        m_bNoSprCache   = false;
+        m_bKaoFullImport= false;
+        m_bSprAtlas     = false;
         m_execMode      = eExecMode::INVALID_Mode;
         m_PrefOutFormat = utils::io::eSUPPORT_IMG_IO::PNG;
 
@@ -647,14 +833,14 @@ namespace gfx_util
         {
             clog <<"4 bpp\n";
             auto sprite = parser.ParseAs4bpp();
-            graphics::ExportSpriteToDirectory( sprite, outpath.toString(), m_PrefOutFormat, false );
+            graphics::ExportSpriteToDirectory( sprite, outpath.toString(), m_PrefOutFormat, false, nullptr, m_bSprAtlas );
             
         }
         else if( sprty == graphics::eSpriteImgType::spr8bpp )
         {
             clog <<"8 bpp\n";
             auto sprite = parser.ParseAs8bpp();
-            graphics::ExportSpriteToDirectory( sprite, outpath.toString(), m_PrefOutFormat, false );
+            graphics::ExportSpriteToDirectory( sprite, outpath.toString(), m_PrefOutFormat, false, nullptr, m_bSprAtlas );
         }
 
         //draw one last time
@@ -743,25 +929,11 @@ namespace gfx_util
         Poco::Path                   outpath;
         future<void>                 updtProgress;
         atomic<bool>                 shouldUpdtProgress = true;
-        multitask::CMultiTaskHandler taskmanager;
         atomic<uint32_t>             completed = 1;
 
         //Currently, we do not support raw image export on sprites !
         ChkAndHndlUnsupportedRawOutput();
 
-        auto lambdaExpSpriteWrap = [&]( const graphics::BaseSprite * srcspr, const std::string & outpath )->bool
-        {
-            graphics::ExportSpriteToDirectoryPtr(srcspr, outpath, m_PrefOutFormat);
-            ++completed;
-            return true;
-        };
-        auto lambdaWriteFileByVec = [&completed](const std::string & path, const std::vector<uint8_t> & filedata)->bool
-        {
-            utils::io::WriteByteVectorToFile( path, filedata );
-            ++completed;
-            return true;
-        };
-
         
         if( m_outputPath.empty() )
             m_outputPath = inputPath.parent().append( Poco::Path(inputPath).makeFile().getBaseName() ).toString();
@@ -788,62 +960,19 @@ namespace gfx_util
             //#2 - Unpack files to raw data vector.
             auto inpack = UnpackPackFile( inputPath );
 
-            //#3 - Run a check to find files that must be decompressed. And decompress them on the spot, replacing the raw data in the vector.
-            vector<unique_ptr<graphics::BaseSprite>> mysprites(inpack.getNbSubFiles());
-            TurnPackContentToSpriteData( inpack, mysprites );
-
             //Create output directory
             Poco::File outdir( outpath );
             if( ! outdir.exists() )
                 outdir.createDirectory();
 
-            //#4 - Run the sprite export code on every sprites, and export to output folder in its own named sub-folder.
+            //#3 - Decompress, parse and export every sprites to the output folder in its own named sub-folder.
             //     Use the pokemon name list if its one of the 3 special files.
-            cout<<"\nWriting sprites to directories..\n";
-
-            for( unsigned int i = 0; i < mysprites.size(); )
-            {
-                if( mysprites[i] == nullptr )
-                {
-                    //Output the packed file's content as is
-                    auto & cursubf = inpack.getSubFile(i);
-                    stringstream sstr;
-                    sstr << inputPath.getBaseName()
-                         <<"_" <<setw(4) <<setfill('0') <<i <<"." 
-                         << GetAppropriateFileExtension( cursubf.begin(), cursubf.end() );                   
+            cout<<"\nParsing and writing sprites to directories..\n";
+            if( !isPokeSpriteFile )
+                pokesprnames.clear();
 
-                    taskmanager.AddTask( 
-                        multitask::pktask_t( 
-                            std::bind(lambdaWriteFileByVec, Poco::Path(outpath).append(sstr.str()).toString(), std::ref(inpack.getSubFile(i)) ) ) );
-                }
-                else 
-                {
-                    //Build the sub-folder name
-                    stringstream sstr;
-                    BaseSprite * curspr = mysprites[i].get();
-
-                    if( isPokeSpriteFile && pokesprnames.size() > i )
-                    {
-                        sstr <<setw(4) <<setfill('0') <<i <<"_" << pokesprnames[i];
-                    }
-                    else
-                    {
-                        sstr << inputPath.getBaseName()
-                             <<"_" <<setw(4) <<setfill('0') <<i;   
-                    }
-
-                    taskmanager.AddTask( 
-                        multitask::pktask_t( 
-                            std::bind(lambdaExpSpriteWrap, (mysprites[i].get()), Poco::Path(outpath).append(sstr.str()).toString() ) ) );
-                }
-                ++i;
-            }
-
-            updtProgress = std::async( std::launch::async, PrintProgressLoop, std::ref(completed), mysprites.size(), std::ref(shouldUpdtProgress) );
-            
-            taskmanager.Execute();
-            taskmanager.BlockUntilTaskQueueEmpty();
-            taskmanager.StopExecute();
+            updtProgress = std::async( std::launch::async, PrintProgressLoop, std::ref(completed), inpack.getNbSubFiles(), std::ref(shouldUpdtProgress) );
+            ExportPackedSprites( inpack, inputPath, outpath.toString(), m_PrefOutFormat, pokesprnames, m_bSprAtlas, completed );
 
             shouldUpdtProgress = false;
             if( updtProgress.valid() )
@@ -934,10 +1063,25 @@ namespace gfx_util
         atomic<bool>                 shouldUpdtProgress = true;
         multitask::CMultiTaskHandler taskmanager;
         atomic<uint32_t>             completed = 0;
+        atomic<uint32_t>             nbcached  = 0;
+        unique_ptr<SpriteBuildCache> sprcache;
+
+        //Anything that changes the output for the same sprite directory must be part of the flags
+        const uint32_t cacheflags = (m_ImportByIndex?   1 : 0) | 
+                                    (m_compressToPKDPX? 2 : 0) | 
+                                    (m_bNoResAutoFix?   4 : 0);
 
         auto lambdaWrapBuildSpr = [&]( vector<uint8_t> & out_sprRaw, const Poco::File & infile, bool importByIndex, bool bShouldCompress )->bool
         {
-            BuildSprFromDirAndInsert(out_sprRaw, infile.path(), importByIndex, bShouldCompress, m_bNoResAutoFix);
+            SpriteBuildCache::fingerprint fprint;
+            if( sprcache && sprcache->Fetch( infile.path(), cacheflags, out_sprRaw, fprint ) )
+                ++nbcached;
+            else
+            {
+                BuildSprFromDirAndInsert(out_sprRaw, infile.path(), importByIndex, bShouldCompress, m_bNoResAutoFix);
+                if( sprcache )
+                    sprcache->Store( fprint, out_sprRaw );
+            }
             ++completed;
             return true;
         };
@@ -960,6 +1104,18 @@ namespace gfx_util
         }
         cout <<"\rFound " <<validDirs.size() <<" valid sprites sub-directories!\n";
 
+        if( !m_bNoSprCache )
+        {
+            Poco::Path cachedir(inpath);
+            cachedir.makeFile();
+            cachedir.setFileName( cachedir.getFileName() + ".gfxcache" );
+            sprcache.reset( new SpriteBuildCache(cachedir.toString()) );
+
+            Poco::File cachedirinf(cachedir);
+            if( !cachedirinf.exists() )
+                cachedirinf.createDirectories();
+        }
+
         cout <<"\nReading sprite data...\n";
         //Resize the file container
         mypack.SubFiles().resize( validDirs.size() );
@@ -1010,6 +1166,8 @@ namespace gfx_util
             if( updtProgress.valid() )
                 updtProgress.get();
             cout<<"\r100%"; //Can't be bothered to make another drawing update
+            if( sprcache )
+                cout<<"\n" <<nbcached <<" unchanged sprite(s) reused from \"" <<sprcache->getCacheDir() <<"\".";
         }
         catch( Poco::Exception & )
         {
@@ -1087,7 +1245,7 @@ namespace gfx_util
         ParseASprite( decompBuf, targetptr );
 
         //Write it out
-        graphics::ExportSpriteToDirectoryPtr( targetptr.get(), outpath.toString(), m_PrefOutFormat );
+        graphics::ExportSpriteToDirectoryPtr( targetptr.get(), outpath.toString(), m_PrefOutFormat, false, nullptr, m_bSprAtlas );
 
         //write output message
         if( ! m_bQuiet )
@@ -1535,6 +1693,51 @@ namespace gfx_util
         return m_bNoResAutoFix = true;
     }
 
+    bool CGfxUtil::ParseOptionNoCache( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-nocache specified. All sprites will be rebuilt!\n";
+        return m_bNoSprCache = true;
+    }
+
+    bool CGfxUtil::ParseOptionKaoFullImport( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-kaofullimport specified. All portraits will be compressed!\n";
+        return m_bKaoFullImport = true;
+    }
+
+    bool CGfxUtil::ParseOptionAtlas( const std::vector<std::string> & optdata )
+    {
+        cout <<"<*>-Exporting sprite frames as atlas images!\n";
+        return m_bSprAtlas = true;
+    }
+
+    bool CGfxUtil::ParseOptionPNGLevel( const std::vector<std::string> & optdata )
+    {
+        if( optdata.size() == 2 )
+        {
+            int level = stoi(optdata.back());
+            if( level < 0 || level > 9 )
+            {
+                cerr <<"<!>-Invalid PNG compression level " <<level <<"! Must be between 0 and 9!\n";
+                return false;
+            }
+            utils::io::PNGWriteSettings settings = utils::io::GetDefaultPNGWriteSettings();
+            settings.zlibLevel = level;
+            utils::io::SetDefaultPNGWriteSettings(settings);
+            cout<<"<*>-PNG compression level set to " <<level <<"!\n";
+            return true;
+        }
+        else
+            return false;
+    }
+
+    bool CGfxUtil::ParseOptionPNGFast( const std::vector<std::string> & optdata )
+    {
+        cout<<"<*>-Using fast PNG compression!\n";
+        utils::io::SetDefaultPNGWriteSettings( utils::io::PNGWriteSettings::Fast() );
+        return true;
+    }
+
 
     //New System
     bool CGfxUtil::ParseOptionForceExport( const std::vector<std::string> & optdata )
@@ -1918,11 +2121,10 @@ namespace gfx_util
     const std::string Monster_Dir     = "MONSTER";
 
 
-    void ExportASpritePackFile( const std::string & fpath, const std::string & outdir, utils::io::eSUPPORT_IMG_IO imgty, const std::vector<string> & pokesprnames )
+    void ExportASpritePackFile( const std::string & fpath, const std::string & outdir, utils::io::eSUPPORT_IMG_IO imgty, const std::vector<string> & pokesprnames, bool asatlas )
     {
         future<void>                 updtProgress;
         atomic<bool>                 shouldUpdtProgress = true;
-        multitask::CMultiTaskHandler taskmanager;
         atomic<uint32_t>             completed = 1;
         Poco::Path inputPath(fpath);
 
@@ -1931,71 +2133,10 @@ namespace gfx_util
             //Unpack files to raw data vector.
             auto inpack = UnpackPackFile( fpath );
 
-            //Run a check to find files that must be decompressed. And decompress them on the spot, replacing the raw data in the vector.
-            vector<unique_ptr<graphics::BaseSprite>> mysprites(inpack.getNbSubFiles());
-            TurnPackContentToSpriteData( inpack, mysprites );
-
-            auto lambdaExpSpriteWrap = [&]( const graphics::BaseSprite * srcspr, const std::string & outpath )->bool
-            {
-                graphics::ExportSpriteToDirectoryPtr(srcspr, outpath, imgty);
-                ++completed;
-                return true;
-            };
-            auto lambdaWriteFileByVec = [&completed](const std::string & path, const std::vector<uint8_t> & filedata)->bool
-            {
-                utils::io::WriteByteVectorToFile( path, filedata );
-                ++completed;
-                return true;
-            };
-
-
-            //#4 - Run the sprite export code on every sprites, and export to output folder in its own named sub-folder.
-            //     Use the pokemon name list if its one of the 3 special files.
-            cout<<"\nWriting sprites to directories..\n";
-
-            for( unsigned int i = 0; i < mysprites.size(); )
-            {
-                if( mysprites[i] == nullptr )
-                {
-                    //Output the packed file's content as is
-                    auto & cursubf = inpack.getSubFile(i);
-                    stringstream sstr;
-                    sstr << inputPath.getBaseName()
-                         <<"_" <<setw(4) <<setfill('0') <<i <<"." 
-                         << GetAppropriateFileExtension( cursubf.begin(), cursubf.end() );                   
-
-                    taskmanager.AddTask( 
-                        multitask::pktask_t( 
-                            std::bind(lambdaWriteFileByVec, Poco::Path(outdir).append(sstr.str()).toString(), std::ref(inpack.getSubFile(i)) ) ) );
-                }
-                else 
-                {
-                    //Build the sub-folder name
-                    stringstream sstr;
-                    BaseSprite * curspr = mysprites[i].get();
-
-                    if( pokesprnames.size() > i )
-                    {
-                        sstr <<setw(4) <<setfill('0') <<i <<"_" << pokesprnames[i];
-                    }
-                    else
-                    {
-                        sstr << inputPath.getBaseName()
-                             <<"_" <<setw(4) <<setfill('0') <<i;   
-                    }
-
-                    taskmanager.AddTask( 
-                        multitask::pktask_t( 
-                            std::bind(lambdaExpSpriteWrap, (mysprites[i].get()), Poco::Path(outdir).append(sstr.str()).toString() ) ) );
-                }
-                ++i;
-            }
-
-            updtProgress = std::async( std::launch::async, PrintProgressLoop, std::ref(completed), mysprites.size(), std::ref(shouldUpdtProgress) );
-            
-            taskmanager.Execute();
-            taskmanager.BlockUntilTaskQueueEmpty();
-            taskmanager.StopExecute();
+            //Decompress, parse and export every sprites to the output folder in its own named sub-folder.
+            cout<<"\nParsing and writing sprites to directories..\n";
+            updtProgress = std::async( std::launch::async, PrintProgressLoop, std::ref(completed), inpack.getNbSubFiles(), std::ref(shouldUpdtProgress) );
+            ExportPackedSprites( inpack, inputPath, outdir, imgty, pokesprnames, asatlas, completed );
 
             shouldUpdtProgress = false;
             if( updtProgress.valid() )
@@ -2119,7 +2260,25 @@ namespace gfx_util
 
         CKaomado kao;
         KaoParser()( inkao.toString(), kao );
-        KaoWriter()( kao, outkao.toString() );
+
+        //If there's already a kaomado where we're writing, reuse the portraits that didn't change
+        vector<uint8_t> result;
+        {
+            unique_ptr<CKaomadoReader> pprevkao;
+            if( !m_bKaoFullImport && Poco::File(outkao).exists() )
+            {
+                try
+                {
+                    pprevkao.reset( new CKaomadoReader( outkao.toString() ) );
+                }
+                catch( const exception & e )
+                {
+                    clog <<"<!>-Warning: CGfxUtil::DoImportPortraits(): Couldn't read the existing kaomado, rebuilding every portraits: " <<e.what() <<"\n";
+                }
+            }
+            result = KaoWriter( nullptr, nullptr, true, false, false, pprevkao.get() )( kao );
+        } //Unmap the previous kaomado before overwriting it
+        utils::io::WriteByteVectorToFile( outkao.toString(), result );
     }
 
     void CGfxUtil::DoExportPokeSprites()
@@ -2200,7 +2359,7 @@ namespace gfx_util
             }
             else
             {
-                ExportASpritePackFile( inspr.path(), outsubdirfile.path(), m_PrefOutFormat, pknames );
+                ExportASpritePackFile( inspr.path(), outsubdirfile.path(), m_PrefOutFormat, pknames, m_bSprAtlas );
             }
         }
 
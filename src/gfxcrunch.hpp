@@ -73,6 +73,11 @@ namespace gfx_util
         bool ParseOptionLog             ( const std::vector<std::string> & optdata );
 
         bool ParseOptionNoResFix        ( const std::vector<std::string> & optdata );
+        bool ParseOptionNoCache         ( const std::vector<std::string> & optdata );
+        bool ParseOptionKaoFullImport   ( const std::vector<std::string> & optdata );
+        bool ParseOptionAtlas           ( const std::vector<std::string> & optdata );
+        bool ParseOptionPNGLevel        ( const std::vector<std::string> & optdata );
+        bool ParseOptionPNGFast         ( const std::vector<std::string> & optdata );
 
         bool ParseOptionForceExport     ( const std::vector<std::string> & optdata );
         bool ParseOptionForceImport     ( const std::vector<std::string> & optdata );
@@ -174,6 +179,9 @@ namespace gfx_util
         bool                           m_bRedirectClog;   //Whether we should redirect clog to a file
         bool                           m_bNoResAutoFix;   //Whether in case of resolution mismatch between the sprite XML data and the images, the utility will autofix
                                                           // the content of meta-frames with the resolution of the corresponding image!
+        bool                           m_bSprAtlas;       //Whether exported sprites should have all their frames in a single atlas image
+        bool                           m_bNoSprCache;     //Whether sprites packed into a pack file should all be rebuilt, instead of reusing the ones cached by the last run
+        bool                           m_bKaoFullImport;  //Whether all portraits are compressed on import, instead of reusing the unchanged ones from the kaomado being overwritten
         eExecMode                      m_execMode;        //This is set after reading the input path.
 
         std::string                    m_inputPath;      //This is the input path that was parsed 
@@ -8,14 +8,18 @@
 #include <ppmdu/pmd2/pmd2_gameloader.hpp>
 #include <ppmdu/pmd2/pmd2_xml_sniffer.hpp>
 #include <ppmdu/pmd2/pmd2_asm.hpp>
+#include <ppmdu/fmts/bpc.hpp>
+#include <ppmdu/fmts/bpc_compression.hpp>
 #include <utils/poco_wrapper.hpp>
 #include <utils/whereami_wrapper.hpp>
 //stdlib
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <fstream>
+#include <random>
 //Poco
 #include <Poco/Path.h>
 #include <Poco/File.h>
@@ -154,6 +158,17 @@ using namespace ::std;
             std::bind( &CMapNybbler::ParseOptionForceExport, &GetInstance(), placeholders::_1 ),
         },
 
+        //Test BPC compression
+        {
+            "testbpc",
+            0,
+            "Runs a compress/decompress roundtrip test and a benchmark of the BPC compression, then exits. "
+            "If a .bpc file, or a directory containing .bpc files is specified as input path, those will be "
+            "parsed, re-written and parsed again, and compared with the original. The rom root is not needed!",
+            "-testbpc",
+            std::bind( &CMapNybbler::ParseOptionTestBPC, &GetInstance(), placeholders::_1 ),
+        },
+
     //=== Exec Options ===
 
         //Assemble a level_list.bin
@@ -389,6 +404,12 @@ using namespace ::std;
         return false;
     }
 
+    bool CMapNybbler::ParseOptionTestBPC(const std::vector<std::string>& optdata)
+    {
+        m_opmode = eOpMode::TestBPC;
+        return true;
+    }
+
     void CMapNybbler::SetupCFGPath(const std::string & cfgrelpath)
     {
         if(m_applicationdir.empty())
@@ -470,6 +491,10 @@ using namespace ::std;
         utils::MrChronometer chronoexecuter("Total time elapsed");
         try
         {
+            //The BPC test doesn't touch the game data
+            if( m_opmode == eOpMode::TestBPC )
+                return HandleTestBPC(m_firstarg);
+
             ValidateRomRoot();
             pmd2::GameDataLoader gloader( m_romroot, m_cfgpath );
             gloader.AnalyseGame(); //Load config, and etc..
@@ -697,6 +722,329 @@ using namespace ::std;
         return 0;
     }
 
+//--------------------------------------------
+//  BPC Test
+//--------------------------------------------
+namespace
+{
+    typedef vector<uint8_t>::const_iterator             bytecit_t;
+    typedef back_insert_iterator<vector<uint8_t>>       byteoutit_t;
+
+    /*
+        ScopedMuteClog
+            The BPC decompressor writes to clog on every call. Mute it while running the tests, 
+            unless the log was enabled explicitly.
+    */
+    class ScopedMuteClog
+    {
+    public:
+        ScopedMuteClog()
+            :m_prevstate(clog.rdstate())
+        {
+            if( !utils::LibWide().isLogOn() )
+                clog.setstate(ios::failbit);
+        }
+        ~ScopedMuteClog()
+        {
+            clog.clear(m_prevstate);
+        }
+    private:
+        ios::iostate m_prevstate;
+    };
+
+    /*
+        Compress the image data, then decompress it and check we get the exact same data back.
+        Some junk is appended after the compressed data, to make sure the decompressor stops where it should.
+    */
+    bool RoundtripBPCImg( const vector<uint8_t> & data, size_t & out_complen )
+    {
+        vector<uint8_t> comp;
+        bpc_compression::BPCImgCompressor<bytecit_t,byteoutit_t>(data.begin(), data.end())(back_inserter(comp));
+        out_complen = comp.size();
+        if( (comp.size() % 2) != 0 )
+        {
+            cerr <<"<!>- Image compressor output has an odd length! Input length : " <<data.size() <<"\n";
+            return false;
+        }
+        comp.push_back(0xAA);
+        comp.push_back(0xAA);
+
+        vector<uint8_t> decomp;
+        byteoutit_t     itdecomp = back_inserter(decomp);
+        bytecit_t       itcomp   = comp.begin();
+        bpc_compression::BPCImgDecompressor<bytecit_t,byteoutit_t>(itcomp, comp.end(), data.size())(itdecomp);
+
+        if( static_cast<size_t>(itcomp - comp.begin()) != out_complen )
+        {
+            cerr <<"<!>- Image decompressor read " <<(itcomp - comp.begin()) <<" bytes, but " <<out_complen <<" were written! Input length : " <<data.size() <<"\n";
+            return false;
+        }
+        if( decomp != data )
+        {
+            cerr <<"<!>- Image roundtrip mismatch! Input length : " <<data.size() <<", output length : " <<decomp.size() <<"\n";
+            return false;
+        }
+        return true;
+    }
+
+    /*
+        Same thing as above, for the tile mapping table compression.
+    */
+    bool RoundtripBPCTileMap( const vector<uint8_t> & data, size_t & out_complen )
+    {
+        vector<uint8_t> comp;
+        bpc_compression::BPC_TileMapCompressor<bytecit_t,byteoutit_t>(data.begin(), data.end())(back_inserter(comp));
+        out_complen = comp.size();
+        comp.push_back(0xAA);
+
+        bytecit_t       itcomp = comp.begin();
+        vector<uint8_t> decomp = bpc_compression::BPC_TileMapDecompressor<bytecit_t,vector<uint8_t>>(itcomp, comp.end(), data.size())();
+
+        if( static_cast<size_t>(itcomp - comp.begin()) != out_complen )
+        {
+            cerr <<"<!>- Tile mapping decompressor read " <<(itcomp - comp.begin()) <<" bytes, but " <<out_complen <<" were written! Input length : " <<data.size() <<"\n";
+            return false;
+        }
+        if( decomp != data )
+        {
+            cerr <<"<!>- Tile mapping roundtrip mismatch! Input length : " <<data.size() <<", output length : " <<decomp.size() <<"\n";
+            return false;
+        }
+        return true;
+    }
+
+    /*
+        Roundtrip a large amount of generated data, ranging from noise to long runs of the same byte.
+        Returns the nb of failures.
+    */
+    size_t RunSyntheticBPCTests()
+    {
+        static const size_t NbCases    = 20000;
+        static const size_t MaxNbWords = 600;
+        mt19937 rng(1); //Fixed seed, so failures can be reproduced
+        size_t  nbfails = 0;
+        size_t  complen = 0;
+
+        for( size_t cntcase = 0; cntcase < NbCases; ++cntcase )
+        {
+            vector<uint8_t> data( (rng() % MaxNbWords) * 2 );
+            const unsigned  mode = rng() % 4;
+            uint8_t         cur  = static_cast<uint8_t>(rng());
+            for( auto & by : data )
+            {
+                switch(mode)
+                {
+                    case 0: //Noise
+                        by = static_cast<uint8_t>(rng());
+                        break;
+                    case 1: //Short runs of a few values
+                        if( rng() % 8 == 0 )
+                            cur = static_cast<uint8_t>(rng() % 4);
+                        by = cur;
+                        break;
+                    case 2: //Long runs
+                        if( rng() % 40 == 0 )
+                            cur = static_cast<uint8_t>(rng());
+                        by = cur;
+                        break;
+                    default: //Mostly zeros
+                        by = (rng() % 3 != 0)? 0 : static_cast<uint8_t>(rng() % 3);
+                };
+            }
+            if( !RoundtripBPCImg(data, complen) )
+                ++nbfails;
+            if( !RoundtripBPCTileMap(data, complen) )
+                ++nbfails;
+        }
+
+        //Inputs bigger than what a BPC file can hold
+        for( size_t len : {0x20000, 0x30002} )
+        {
+            vector<uint8_t> noise(len);
+            for( auto & by : noise )
+                by = static_cast<uint8_t>(rng());
+            vector<uint8_t> constant(len, 0x11);
+
+            if( !RoundtripBPCImg(noise, complen) )
+                ++nbfails;
+            if( !RoundtripBPCImg(constant, complen) )
+                ++nbfails;
+            if( !RoundtripBPCTileMap(constant, complen) )
+                ++nbfails;
+        }
+        return nbfails;
+    }
+
+    /*
+        Time compression and decompression of a generated 400 tiles image.
+    */
+    void RunBPCBenchmark()
+    {
+        static const size_t NbTiles         = 400;
+        static const size_t NbBytesPerTile  = 32;
+        static const size_t NbIterations    = 200;
+        mt19937         rng(1);
+        vector<uint8_t> img(NbTiles * NbBytesPerTile);
+        for( size_t i = 0; i < img.size(); ++i )
+        {
+            if( (i / NbBytesPerTile) % 7 == 0 )
+                img[i] = 0;
+            else if( i % 5 != 0 )
+                img[i] = static_cast<uint8_t>( 0x11 * ((i / 64) % 3) );
+            else
+                img[i] = static_cast<uint8_t>(rng());
+        }
+
+        vector<uint8_t> comp;
+        auto tcomp = chrono::steady_clock::now();
+        for( size_t i = 0; i < NbIterations; ++i )
+        {
+            comp.clear();
+            bpc_compression::BPCImgCompressor<bytecit_t,byteoutit_t>(img.begin(), img.end())(back_inserter(comp));
+        }
+        auto            tdecomp = chrono::steady_clock::now();
+        vector<uint8_t> decomp;
+        for( size_t i = 0; i < NbIterations; ++i )
+        {
+            decomp.clear();
+            byteoutit_t itdecomp = back_inserter(decomp);
+            bytecit_t   itcomp   = comp.begin();
+            bpc_compression::BPCImgDecompressor<bytecit_t,byteoutit_t>(itcomp, comp.end(), img.size())(itdecomp);
+        }
+        auto tend = chrono::steady_clock::now();
+
+        const double totalmb    = static_cast<double>(img.size() * NbIterations) / (1024.0 * 1024.0);
+        const double compsecs   = chrono::duration<double>(tdecomp - tcomp).count();
+        const double decompsecs = chrono::duration<double>(tend - tdecomp).count();
+        cout <<"Benchmark, " <<NbTiles <<" tiles image (" <<img.size() <<" bytes) x" <<NbIterations <<" :\n"
+             <<"    Ratio      : " <<fixed <<setprecision(3) <<(static_cast<double>(comp.size()) / img.size()) <<"\n"
+             <<"    Compress   : " <<setprecision(2) <<(totalmb / compsecs)   <<" MB/s\n"
+             <<"    Decompress : " <<(totalmb / decompsecs) <<" MB/s\n"
+             <<defaultfloat;
+    }
+
+    bool CompareTilesetLayers( const pmd2::TilesetLayers & orig, const pmd2::TilesetLayers & rewritten )
+    {
+        if( orig.size() != rewritten.size() || orig.layerasmdata.size() != rewritten.layerasmdata.size() )
+            return false;
+
+        for( size_t cntlayer = 0; cntlayer < orig.size(); ++cntlayer )
+        {
+            const pmd2::TilesetLayer & lorig = orig[cntlayer];
+            const pmd2::TilesetLayer & lnew  = rewritten[cntlayer];
+            if( lorig.Tiles().size() != lnew.Tiles().size() || lorig.TileMap().size() != lnew.TileMap().size() )
+                return false;
+
+            for( size_t cnttile = 0; cnttile < lorig.Tiles().size(); ++cnttile )
+            {
+                const auto & torig = lorig.Tiles()[cnttile];
+                const auto & tnew  = lnew.Tiles()[cnttile];
+                if( torig.size() != tnew.size() )
+                    return false;
+                for( size_t cntpix = 0; cntpix < torig.size(); ++cntpix )
+                {
+                    if( torig[cntpix].pixeldata != tnew[cntpix].pixeldata )
+                        return false;
+                }
+            }
+
+            for( size_t cntent = 0; cntent < lorig.TileMap().size(); ++cntent )
+            {
+                if( static_cast<uint16_t>(lorig.TileMap()[cntent]) != static_cast<uint16_t>(lnew.TileMap()[cntent]) )
+                    return false;
+            }
+        }
+
+        for( size_t i = 0; i < orig.layerasmdata.size(); ++i )
+        {
+            const auto & aorig = orig.layerasmdata[i];
+            const auto & anew  = rewritten.layerasmdata[i];
+            if( aorig.unk2 != anew.unk2 || aorig.unk3 != anew.unk3 || aorig.unk4 != anew.unk4 || aorig.unk5 != anew.unk5 )
+                return false;
+        }
+        return true;
+    }
+
+    /*
+        Parse a bpc file, write it back to memory, parse the result and compare.
+    */
+    bool RoundtripBPCFile( const string & fpath )
+    {
+        try
+        {
+            vector<uint8_t>     original = utils::io::ReadFileToByteVector(fpath);
+            pmd2::TilesetLayers layers   = filetypes::ParseBPC(original);
+
+            auto                tbeg      = chrono::steady_clock::now();
+            vector<uint8_t>     rewritten = filetypes::WriteBPC(layers);
+            auto                tend      = chrono::steady_clock::now();
+            pmd2::TilesetLayers relayers  = filetypes::ParseBPC(rewritten);
+
+            size_t rawsize = 0;
+            for( const auto & layer : layers )
+                rawsize += (layer.Tiles().size() * 32) + (layer.TileMap().size() * sizeof(uint16_t));
+
+            cout <<Poco::Path(fpath).getFileName() <<" : original " <<original.size() <<" bytes, rewritten " <<rewritten.size() 
+                 <<" bytes, raw " <<rawsize <<" bytes, ratio " <<fixed <<setprecision(3) 
+                 <<((rawsize != 0)? (static_cast<double>(rewritten.size()) / rawsize) : 0.0) <<defaultfloat
+                 <<", written in " <<chrono::duration_cast<chrono::microseconds>(tend - tbeg).count() <<"us";
+
+            if( !CompareTilesetLayers(layers, relayers) )
+            {
+                cout <<" - MISMATCH!\n";
+                return false;
+            }
+            cout <<" - OK\n";
+            return true;
+        }
+        catch( const exception & e )
+        {
+            cout <<Poco::Path(fpath).getFileName() <<" - FAILED : " <<e.what() <<"\n";
+            return false;
+        }
+    }
+};
+
+    /*
+        Roundtrip tests and benchmark for the BPC compression. Returns the nb of failed tests.
+    */
+    int CMapNybbler::HandleTestBPC(const std::string & inpath)
+    {
+        ScopedMuteClog mute;
+        cout    <<"================================================\n"
+                <<"                    BPC Test                    \n"
+                <<"================================================\n\n";
+
+        size_t nbfails = RunSyntheticBPCTests();
+        cout <<"Synthetic roundtrips : " <<nbfails <<" failed\n";
+        RunBPCBenchmark();
+
+        if( !inpath.empty() )
+        {
+            vector<string> files;
+            if( utils::isFolder(inpath) )
+            {
+                for( Poco::DirectoryIterator itdir(inpath), itend; itdir != itend; ++itdir )
+                {
+                    if( itdir->isFile() && utils::CompareStrIgnoreCase( Poco::Path(itdir.path()).getExtension(), filetypes::BPC_FileExt ) )
+                        files.push_back(itdir.path().toString());
+                }
+            }
+            else
+                files.push_back(inpath);
+
+            cout <<"\nRoundtripping " <<files.size() <<" bpc file(s)..\n";
+            for( const auto & fpath : files )
+            {
+                if( !RoundtripBPCFile(fpath) )
+                    ++nbfails;
+            }
+        }
+
+        cout <<"\n" <<nbfails <<" failure(s)\n";
+        return static_cast<int>(nbfails);
+    }
+
 //--------------------------------------------
 //  Main Methods
 //--------------------------------------------
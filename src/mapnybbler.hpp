@@ -34,6 +34,7 @@ All wrongs reversed, no crappyrights :P
             Invalid,
             Export,
             Import,
+            TestBPC,
         };
         enum struct eTasks
         {
@@ -90,6 +91,7 @@ All wrongs reversed, no crappyrights :P
         bool ParseOptionAssembleLvlList ( const std::vector<std::string> & optdata );
         bool ParseOptionAssembleBgList  ( const std::vector<std::string> & optdata );
         bool ParseOptionAssemblePatchOp ( const std::vector<std::string> & optdata );
+        bool ParseOptionTestBPC         ( const std::vector<std::string> & optdata );
 
         //Execution
         void DetermineOperation();
@@ -102,6 +104,7 @@ All wrongs reversed, no crappyrights :P
         void HandleExtraTasks(pmd2::GameDataLoader & gloader);
         int HandleImport(const std::string & inpath, pmd2::GameDataLoader & gloader);
         int HandleExport(const std::string & inpath, pmd2::GameDataLoader & gloader);
+        int HandleTestBPC(const std::string & inpath);
 
         void RunLvlListAssembly     ( const ExtraTasks & task, pmd2::GameDataLoader & gloader );
         void RunActorListAssembly   ( const ExtraTasks & task, pmd2::GameDataLoader & gloader );
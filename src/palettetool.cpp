@@ -6,14 +6,20 @@
 #include <ext_fmts/bmp_io.hpp>
 #include <ext_fmts/txt_palette_io.hpp>
 #include <ppmdu/containers/tiled_image.hpp>
+#include <ppmdu/containers/color_quantizer.hpp>
 #include <ext_fmts/supported_io_info.hpp>
 #include <ppmdu/pmd2/pmd2_filetypes.hpp>
 #include <ppmdu/pmd2/pmd2_palettes.hpp>
 #include <types/content_type_analyser.hpp>
+#include <utils/multiple_task_handler.hpp>
+#include <utils/library_wide.hpp>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <fstream>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
 #include <Poco/Path.h>
 #include <Poco/File.h>
 #include <Poco/DirectoryIterator.h>
@@ -44,7 +50,13 @@ namespace palettetool
         "It can also insert a dummy color in the first palette slot for image\n"
         "without transparency(Ex: pokemon portraits), and preserve the\n"
         "15 or 254 previous colors!\n"
-        "And finally, it also can inject a palette back into an image!\n"
+        "It also can inject a palette back into an image!\n"
+        "And finally, it can remap the pixels of an image, indexed or not, to\n"
+        "the closest colors of a palette with the \"-remap\" option!\n"
+        "It can also reduce the colors of truecolor images, or of a whole\n"
+        "directory of images, to 16 or 256 colors with the \"-quantize\" option,\n"
+        "or to banks of 16 colors with the \"-banks\" option, and have all the\n"
+        "images share the same palette with \"-sharedpal\"!\n"
         "\n"
         "The text file contains one color per line in HTML notation, which\n"
         "should make it very easy for peope to edit a palette! and convert\n"
@@ -111,6 +123,46 @@ namespace palettetool
             "-adddummy",
             std::bind( &CPaletteUtil::ParseOptionAddDummy, &GetInstance(), placeholders::_1 ),
         },
+        //Remap image colors to palette
+        {
+            "remap",
+            0,
+            "Converts the pixels of the image at the output path to the index of the closest color in the input palette, and sets the input palette as the image's palette. Works on indexed and non-indexed images. Images are saved as 4bpp if the palette has 16 colors or less, or 8bpp otherwise.",
+            "-remap",
+            std::bind( &CPaletteUtil::ParseOptionRemap, &GetInstance(), placeholders::_1 ),
+        },
+        //Quantize images
+        {
+            "quantize",
+            1,
+            "Reduces the colors of the input image, or of all the png and bmp images in the input directory, to the specified amount of colors, between 2 and 256, and saves them as indexed images. Color 0 is reserved for transparent pixels. Images are saved as 4bpp if the amount of colors is 16 or less, or 8bpp otherwise. The images are written to the output path if specified, or overwritten otherwise!",
+            "-quantize 16",
+            std::bind( &CPaletteUtil::ParseOptionQuantize, &GetInstance(), placeholders::_1 ),
+        },
+        //Quantize images to 16 colors banks
+        {
+            "banks",
+            1,
+            "Same as \"-quantize\", but reduces the colors to the specified amount of 16 colors palette banks, between 1 and 16, where each 8x8 tiles only uses the colors of a single bank. Color 0 of each bank is reserved for transparent pixels. Images are saved as 8bpp. Replaces \"-quantize\"'s amount of colors!",
+            "-banks 4",
+            std::bind( &CPaletteUtil::ParseOptionBanks, &GetInstance(), placeholders::_1 ),
+        },
+        //K-means passes for quantization
+        {
+            "kmeans",
+            1,
+            "Refines the palette made by \"-quantize\" or \"-banks\" with the specified amount of k-means passes. Gives better colors, but is slower. Def: 0.",
+            "-kmeans 4",
+            std::bind( &CPaletteUtil::ParseOptionKMeans, &GetInstance(), placeholders::_1 ),
+        },
+        //Shared palette for quantization
+        {
+            "sharedpal",
+            0,
+            "Makes all the images quantized with \"-quantize\" or \"-banks\" share a single palette, built from the colors of all the images. Needed for sprite frames!",
+            "-sharedpal",
+            std::bind( &CPaletteUtil::ParseOptionSharedPal, &GetInstance(), placeholders::_1 ),
+        },
         //Force output to RIFF palette
         {
             "outriff",
@@ -169,6 +221,10 @@ namespace palettetool
         m_outPalType      = ePalType::TEXT;
         m_inPalType       = ePalType::Invalid;
         m_operationMode   = eOpMode ::Invalid;
+        m_nbQuantColors   = 0;
+        m_nbQuantBanks    = 0;
+        m_nbKMeansPasses  = 0;
+        m_bSharedPal      = false;
     }
 
     const vector<argumentparsing_t> & CPaletteUtil::getArgumentsList   ()const { return Arguments_List;          }
@@ -188,8 +244,8 @@ namespace palettetool
     {
         Poco::File inputfile(path);
 
-        //check if path exists
-        if( inputfile.exists() && inputfile.isFile() )
+        //check if path exists. Directories are only valid when quantizing images
+        if( inputfile.exists() && ( inputfile.isFile() || inputfile.isDirectory() ) )
         {
             m_inputPath = path;
             return true;
@@ -224,6 +280,58 @@ namespace palettetool
         return true;
     }
 
+    bool CPaletteUtil::ParseOptionRemap( const std::vector<std::string> & optdata )
+    {
+        m_operationMode = eOpMode::Remap;
+        return true;
+    }
+
+    bool CPaletteUtil::ParseOptionQuantize( const std::vector<std::string> & optdata )
+    {
+        if( optdata.size() != 2 )
+            return false;
+
+        unsigned int nbcolors = stoul(optdata.back());
+        if( nbcolors < 2 || nbcolors > 256 )
+        {
+            cerr <<"<!>-Invalid amount of colors for quantization! Must be between 2 and 256!\n";
+            return false;
+        }
+        m_nbQuantColors = nbcolors;
+        m_operationMode = eOpMode::Quantize;
+        return true;
+    }
+
+    bool CPaletteUtil::ParseOptionBanks( const std::vector<std::string> & optdata )
+    {
+        if( optdata.size() != 2 )
+            return false;
+
+        unsigned int nbbanks = stoul(optdata.back());
+        if( nbbanks < 1 || nbbanks > (256 / gimg::BankNbColors) )
+        {
+            cerr <<"<!>-Invalid amount of palette banks for quantization! Must be between 1 and " <<(256 / gimg::BankNbColors) <<"!\n";
+            return false;
+        }
+        m_nbQuantBanks  = nbbanks;
+        m_operationMode = eOpMode::Quantize;
+        return true;
+    }
+
+    bool CPaletteUtil::ParseOptionKMeans( const std::vector<std::string> & optdata )
+    {
+        if( optdata.size() != 2 )
+            return false;
+        m_nbKMeansPasses = stoul(optdata.back());
+        return true;
+    }
+
+    bool CPaletteUtil::ParseOptionSharedPal( const std::vector<std::string> & optdata )
+    {
+        m_bSharedPal = true;
+        return true;
+    }
+
     bool CPaletteUtil::ParseOptionToTxt( const std::vector<std::string> & optdata )
     {
         m_outPalType = ePalType::TEXT;
@@ -285,7 +393,24 @@ namespace palettetool
         Poco::Path inpath( m_inputPath );
         eSUPPORT_IMG_IO imgtype = GetSupportedImageType(m_inputPath);
 
-        if( m_operationMode != eOpMode::Invalid )
+        if( m_operationMode == eOpMode::Remap )
+        {
+            if( imgtype != eSUPPORT_IMG_IO::INVALID )
+                throw runtime_error( "The input path must be a palette file when remapping an image!" );
+            if( m_outputPath.empty() || GetSupportedImageType(m_outputPath) == eSUPPORT_IMG_IO::INVALID )
+                throw runtime_error( "The output path must be an existing png or bmp image when remapping an image!" );
+        }
+
+        if( m_operationMode == eOpMode::Quantize )
+        {
+            if( !Poco::File(inpath).isDirectory() && imgtype == eSUPPORT_IMG_IO::INVALID )
+                throw runtime_error( "The input path must be a png or bmp image, or a directory, when quantizing images!" );
+            return;
+        }
+        else if( Poco::File(inpath).isDirectory() )
+            throw runtime_error( "The input path can only be a directory when quantizing images!" );
+
+        if( m_operationMode != eOpMode::Invalid && m_operationMode != eOpMode::Remap )
             return; //Skip if we have a forced mode
 
         if( imgtype == eSUPPORT_IMG_IO::BMP || 
@@ -319,6 +444,9 @@ namespace palettetool
                     m_inPalType = ePalType::TEXT;
             }
 
+            if( m_operationMode == eOpMode::Remap )
+                return; //We only needed the palette type
+
             if( m_outputPath.empty() )
             {
                 //If output empty assume we want palette conversion
@@ -381,6 +509,16 @@ namespace palettetool
                     returnval = AddDummyColorAndShift();
                     break;
                 }
+                case eOpMode::Remap:
+                {
+                    returnval = RemapImageToPalette();
+                    break;
+                }
+                case eOpMode::Quantize:
+                {
+                    returnval = QuantizeImages();
+                    break;
+                }
                 default:
                 {
                     throw runtime_error( "Invalid operation mode. Something is wrong with the arguments!" );
@@ -618,6 +756,287 @@ namespace palettetool
         return 0;
     }
 
+    template<class TImg_T>
+        size_t DoRemapImageToPalette( const std::string & imgpath, eSUPPORT_IMG_IO imgtype, const std::vector<gimg::colorRGB24> & palette )
+    {
+        TImg_T img;
+        size_t nbinexact = 0;
+        if( imgtype == eSUPPORT_IMG_IO::BMP )
+        {
+            nbinexact = ImportFromBMPAndRemap( img, imgpath, palette );
+            ExportToBMP( img, imgpath );
+        }
+        else if( imgtype == eSUPPORT_IMG_IO::PNG )
+        {
+            nbinexact = ImportFromPNGAndRemap( img, imgpath, palette );
+            ExportToPNG( img, imgpath );
+        }
+        return nbinexact;
+    }
+
+    int CPaletteUtil::RemapImageToPalette()
+    {
+        using namespace gimg;
+        vector<gimg::colorRGB24> palette = ImportPalette(m_inputPath);
+        eSUPPORT_IMG_IO          imgtype = GetSupportedImageType(m_outputPath);
+        size_t                   nbinexact = 0;
+
+        if( palette.empty() )
+            throw runtime_error("ERROR: The input palette is empty!");
+        else if( palette.size() > 256 )
+        {
+            cerr <<"<!>-Warning: The palette has more than 256 colors! Only the first 256 colors will be used!\n";
+            palette.resize(256);
+        }
+
+        cout<<"\n";
+        cout <<"Remapping pixels of \"" <<m_outputPath <<"\" to the " <<palette.size() <<" colors of \"" <<m_inputPath <<"\"...\n";
+
+        if( palette.size() <= 16 )
+            nbinexact = DoRemapImageToPalette<tiled_image_i4bpp>( m_outputPath, imgtype, palette );
+        else
+            nbinexact = DoRemapImageToPalette<tiled_image_i8bpp>( m_outputPath, imgtype, palette );
+
+        if( nbinexact != 0 )
+            cout <<nbinexact <<" pixel(s) had no exact match in the palette, and were set to the closest color!\n";
+        cout <<"Image remapped succesfully!\n";
+        return 0;
+    }
+
+    utils::Resolution ImportImageAsRGBA32( std::vector<uint8_t> & out_rgba, const std::string & imgpath )
+    {
+        eSUPPORT_IMG_IO imgtype = GetSupportedImageType(imgpath);
+        if( imgtype == eSUPPORT_IMG_IO::BMP )
+            return utils::io::ImportRGBA32FromBMP( out_rgba, imgpath );
+        else if( imgtype == eSUPPORT_IMG_IO::PNG )
+            return utils::io::ImportRGBA32FromPNG( out_rgba, imgpath );
+        else
+            throw runtime_error("ERROR: Image \"" + imgpath + "\" isn't a png or bmp image!");
+    }
+
+    /*
+        WriteQuantizedImage
+            Remaps a decoded RGBA32 image to the matcher's palette, and writes it as an indexed image.
+    */
+    template<class TImg_T>
+        void WriteQuantizedImage( const std::vector<uint8_t> & rgba,
+                                  const utils::Resolution    & res,
+                                  gimg::PaletteBankMatcher   & matcher,
+                                  const std::string          & outpath )
+    {
+        TImg_T img;
+        gimg::RemapRGBA32ToImage( rgba.data(), res.width, res.height, matcher, img );
+
+        if( GetSupportedImageType(outpath) == eSUPPORT_IMG_IO::BMP )
+            ExportToBMP( img, outpath );
+        else
+            ExportToPNG( img, outpath );
+    }
+
+    int CPaletteUtil::QuantizeImages()
+    {
+        using namespace gimg;
+        Poco::File     infile(m_inputPath);
+        vector<string> inputs;
+        vector<string> outputs;
+
+        //List the images to work on, and where they go
+        if( infile.isDirectory() )
+        {
+            Poco::DirectoryIterator itdirend;
+            for( Poco::DirectoryIterator itdir(infile); itdir != itdirend; ++itdir )
+            {
+                if( itdir->isFile() && !itdir->isHidden() && GetSupportedImageType(itdir->path()) != eSUPPORT_IMG_IO::INVALID )
+                    inputs.push_back( itdir->path() );
+            }
+            std::sort( inputs.begin(), inputs.end() );
+
+            Poco::Path outdir( m_outputPath.empty()? m_inputPath : m_outputPath );
+            outdir.makeDirectory();
+            Poco::File(outdir).createDirectories();
+            for( const auto & in : inputs )
+                outputs.push_back( Poco::Path(outdir).setFileName( Poco::Path(in).getFileName() ).toString() );
+        }
+        else
+        {
+            inputs .push_back( m_inputPath );
+            outputs.push_back( m_outputPath.empty()? m_inputPath : m_outputPath );
+        }
+
+        if( inputs.empty() )
+            throw runtime_error("ERROR: No png or bmp images found in \"" + m_inputPath + "\"!");
+
+        const bool         usebanks = (m_nbQuantBanks != 0);
+        const unsigned int tilew    = tiled_image_i8bpp::tile_t::WIDTH;
+        const unsigned int tileh    = tiled_image_i8bpp::tile_t::HEIGHT;
+
+        cout <<"Quantizing " <<inputs.size() <<" image(s) to ";
+        if( usebanks )
+            cout <<m_nbQuantBanks <<" bank(s) of " <<BankNbColors <<" colors";
+        else
+            cout <<m_nbQuantColors <<" colors";
+        cout <<( (m_bSharedPal)? ", using a single shared palette" : "" ) <<"...\n";
+
+        mutex          mtxshared;
+        atomic<size_t> nbfailed(0);
+        auto lambdaReportFailure = [&]( const string & path, const exception & e )
+        {
+            lock_guard<mutex> lck(mtxshared);
+            cerr <<"\n<!>-Warning: Failure quantizing image " <<path <<":\n" <<e.what() <<"\nSkipping !\n";
+            ++nbfailed;
+        };
+
+        auto lambdaBuildPalette = [&]( const vector<tilecolors_t> & tiles, const ColorHistogram & hist )->vector<colorRGB24>
+        {
+            if( usebanks )
+                return QuantizeColorBanks( tiles, m_nbQuantBanks, m_nbKMeansPasses );
+            else
+                return QuantizePalette( hist, m_nbQuantColors, m_nbKMeansPasses );
+        };
+
+        auto lambdaMakeMatcher = [&]( const vector<colorRGB24> & palette )->PaletteBankMatcher
+        {
+            return PaletteBankMatcher( palette, (usebanks)? BankNbColors : static_cast<unsigned int>(palette.size()) );
+        };
+
+        auto lambdaWriteImage = [&]( const vector<uint8_t> & rgba, const utils::Resolution & res, PaletteBankMatcher & matcher, const string & outpath )
+        {
+            if( !usebanks && m_nbQuantColors <= 16 )
+                WriteQuantizedImage<tiled_image_i4bpp>( rgba, res, matcher, outpath );
+            else
+                WriteQuantizedImage<tiled_image_i8bpp>( rgba, res, matcher, outpath );
+        };
+
+        if( !m_bSharedPal )
+        {
+            //Each image gets its own palette, so everything can be done in a single pass
+            multitask::CMultiTaskHandler taskmanager;
+            auto lambdaQuantize = [&]( const string & inpath, const string & outpath )->bool
+            {
+                try
+                {
+                    vector<uint8_t>      rgba;
+                    utils::Resolution    res = ImportImageAsRGBA32( rgba, inpath );
+                    vector<tilecolors_t> tiles;
+                    ColorHistogram       hist;
+                    if( usebanks )
+                        GatherTileColors( rgba.data(), res.width, res.height, tilew, tileh, tiles );
+                    else
+                        hist.AddPixels( rgba.data(), res.width * res.height );
+                    PaletteBankMatcher matcher = lambdaMakeMatcher( lambdaBuildPalette( tiles, hist ) );
+                    lambdaWriteImage( rgba, res, matcher, outpath );
+                }
+                catch( exception & e )
+                {
+                    lambdaReportFailure( inpath, e );
+                }
+                return true;
+            };
+
+            for( size_t i = 0; i < inputs.size(); ++i )
+                taskmanager.AddTask( multitask::pktask_t( std::bind( lambdaQuantize, std::cref(inputs[i]), std::cref(outputs[i]) ) ) );
+            taskmanager.Execute();
+            taskmanager.BlockUntilTaskQueueEmpty();
+            taskmanager.StopExecute();
+        }
+        else
+        {
+            //To share a palette, we need the colors of all images first. The decoded images are
+            // kept around, so they don't have to be decoded a second time when remapping them.
+            vector<vector<uint8_t>>      decoded    ( inputs.size() );
+            vector<utils::Resolution>    resolutions( inputs.size() );
+            vector<vector<tilecolors_t>> imgtiles   ( inputs.size() );
+            ColorHistogram               sharedhist;
+            atomic<size_t>               nbdecoded(0);
+
+            multitask::CMultiTaskHandler gathermanager;
+            auto lambdaGatherColors = [&]( size_t index )->bool
+            {
+                try
+                {
+                    resolutions[index] = ImportImageAsRGBA32( decoded[index], inputs[index] );
+                    if( usebanks )
+                        GatherTileColors( decoded[index].data(), resolutions[index].width, resolutions[index].height, tilew, tileh, imgtiles[index] );
+                    else
+                    {
+                        ColorHistogram hist;
+                        hist.AddPixels( decoded[index].data(), resolutions[index].width * resolutions[index].height );
+
+                        lock_guard<mutex> lck(mtxshared);
+                        sharedhist.Merge(hist);
+                    }
+                    ++nbdecoded;
+                }
+                catch( exception & e )
+                {
+                    decoded[index].clear();
+                    lambdaReportFailure( inputs[index], e );
+                }
+                return true;
+            };
+
+            for( size_t i = 0; i < inputs.size(); ++i )
+                gathermanager.AddTask( multitask::pktask_t( std::bind( lambdaGatherColors, i ) ) );
+            gathermanager.Execute();
+            gathermanager.BlockUntilTaskQueueEmpty();
+            gathermanager.StopExecute();
+
+            if( nbdecoded == 0 )
+                throw runtime_error("ERROR: Couldn't read any of the input images!");
+
+            //Put the tiles of all images together, in the same order as the images
+            vector<tilecolors_t> alltiles;
+            for( auto & tiles : imgtiles )
+            {
+                std::move( tiles.begin(), tiles.end(), std::back_inserter(alltiles) );
+                tiles = vector<tilecolors_t>();
+            }
+
+            const vector<colorRGB24> sharedpal = lambdaBuildPalette( alltiles, sharedhist );
+            if( usebanks )
+                cout <<"Built shared palette of " <<m_nbQuantBanks <<" bank(s) from " <<alltiles.size() <<" tiles!\n";
+            else
+                cout <<"Built shared palette of " <<sharedpal.size() <<" colors from " <<sharedhist.NbUniqueColors() <<" unique colors!\n";
+            alltiles = vector<tilecolors_t>();
+
+            //Then remap and write all the images. The images are split into a few chunks per threads, and each
+            // chunk gets its own matcher, so the matcher's lookup tables are re-used from one image to the next.
+            const size_t nbthreads = utils::LibWide().getNbThreadsToUse();
+            const size_t nbchunks  = std::min<size_t>( inputs.size(), std::max<size_t>( nbthreads, 1 ) * 4 );
+            multitask::CMultiTaskHandler remapmanager;
+            auto lambdaRemapChunk = [&]( size_t chunk )->bool
+            {
+                PaletteBankMatcher matcher = lambdaMakeMatcher( sharedpal );
+                for( size_t index = chunk; index < inputs.size(); index += nbchunks )
+                {
+                    if( decoded[index].empty() )
+                        continue; //Failed to decode, already reported
+                    try
+                    {
+                        lambdaWriteImage( decoded[index], resolutions[index], matcher, outputs[index] );
+                    }
+                    catch( exception & e )
+                    {
+                        lambdaReportFailure( inputs[index], e );
+                    }
+                    decoded[index] = vector<uint8_t>(); //Free the image as soon as we're done with it
+                }
+                return true;
+            };
+
+            for( size_t i = 0; i < nbchunks; ++i )
+                remapmanager.AddTask( multitask::pktask_t( std::bind( lambdaRemapChunk, i ) ) );
+            remapmanager.Execute();
+            remapmanager.BlockUntilTaskQueueEmpty();
+            remapmanager.StopExecute();
+        }
+
+        if( nbfailed != 0 )
+            cout <<nbfailed <<" image(s) couldn't be quantized!\n";
+        cout <<"Done!\n";
+        return 0;
+    }
+
 //--------------------------------------------
 //  Main Methods
 //--------------------------------------------
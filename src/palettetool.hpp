@@ -46,6 +46,11 @@ namespace palettetool
         //Parse Options
         bool ParseOptionToRIFF    ( const std::vector<std::string> & optdata );
         bool ParseOptionAddDummy  ( const std::vector<std::string> & optdata );
+        bool ParseOptionRemap     ( const std::vector<std::string> & optdata );
+        bool ParseOptionQuantize  ( const std::vector<std::string> & optdata );
+        bool ParseOptionBanks     ( const std::vector<std::string> & optdata );
+        bool ParseOptionKMeans    ( const std::vector<std::string> & optdata );
+        bool ParseOptionSharedPal ( const std::vector<std::string> & optdata );
         bool ParseOptionToTxt     ( const std::vector<std::string> & optdata );
         bool ParseOptionToRGBX32  ( const std::vector<std::string> & optdata );
         bool ParseOptionInAsTxt   ( const std::vector<std::string> & optdata );
@@ -61,6 +66,8 @@ namespace palettetool
         int ConvertPalette();
         int InjectPalette();
         int AddDummyColorAndShift();
+        int RemapImageToPalette();
+        int QuantizeImages();
         void ExportPalette( const std::string & inparentdirpath, const std::vector<gimg::colorRGB24> & palette );
         std::vector<gimg::colorRGB24> ImportPalette( const std::string & inpath );
 
@@ -88,6 +95,8 @@ namespace palettetool
             Convert,
             Inject,
             AddDummyColor,
+            Remap,
+            Quantize,
         };
 
         //Variables
@@ -96,6 +105,10 @@ namespace palettetool
         ePalType                       m_outPalType;     //This is the type of palette to output
         ePalType                       m_inPalType;      //The detected, or forced input palette type!
         eOpMode                        m_operationMode;  //This holds what the program should do
+        unsigned int                   m_nbQuantColors;  //The amount of colors to reduce images to when quantizing
+        unsigned int                   m_nbQuantBanks;   //The amount of 16 colors palette banks to reduce images to when quantizing, or 0 to not use banks
+        unsigned int                   m_nbKMeansPasses; //The amount of k-means passes to refine the quantized palette with
+        bool                           m_bSharedPal;     //Whether all the quantized images should share a single palette
     };
 
 };
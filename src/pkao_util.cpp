@@ -51,10 +51,11 @@ namespace pkao_util
     static const string OPTION_QUIET                        = "q";
     static const string OPTION_NON_ZEALOUS_STR_SEARCH       = "nz";
     const string OPTION_VERBOSE                             = "v";
+    static const string OPTION_FULL_IMPORT                  = "fullimport";
 
 
     //Definition of all the possible options for the program!
-    static const array<optionparsing_t, 8> MY_OPTIONS  =
+    static const array<optionparsing_t, 9> MY_OPTIONS  =
     {{
         //Disable console output except errors!
         {
@@ -105,6 +106,13 @@ namespace pkao_util
             0,
             "Will trigger verbose progress output!",
         },
+
+        //Compress all portraits when packing
+        {
+            OPTION_FULL_IMPORT,
+            0,
+            "Compress every portraits when packing, instead of reusing the unchanged ones from the kaomado being overwritten!",
+        },
     }};
 
     //A little struct to make it easier to throw around any new parsed parameters !
@@ -120,6 +128,7 @@ namespace pkao_util
         bool           bIsZealous;
         bool           bExportAsBmp;
         bool           bisVerbose;
+        bool           bIsFullImport;
     };
 
 
@@ -270,6 +279,16 @@ namespace pkao_util
                 parameters.bisVerbose = true;
                 success               = true;
             }
+            else if( parsedoption.front().compare(OPTION_FULL_IMPORT) == 0  )
+            {
+                parameters.bIsFullImport = true;
+                success                  = true;
+                if( !parameters.bisQuiet )
+                {
+                    cout <<"Option " <<OPTION_FULL_IMPORT 
+                        <<" specified. Compressing every portraits!\n";
+                }
+            }
         }
 
         return success;
@@ -505,8 +524,25 @@ namespace pkao_util
             if( !parameters.bisQuiet )
                 cout<<"Writing to file..\n";
 
-            KaoWriter mywriter( nullptr, nullptr, true, parameters.bisQuiet, parameters.bisVerbose );
-            mywriter( kao, outpath.toString() );
+            //If we're overwriting a kaomado, reuse the portraits that didn't change
+            vector<uint8_t> result;
+            {
+                unique_ptr<CKaomadoReader> pprevkao;
+                if( !parameters.bIsFullImport && Poco::File(outpath).exists() )
+                {
+                    try
+                    {
+                        pprevkao.reset( new CKaomadoReader( outpath.toString() ) );
+                    }
+                    catch( const exception & e )
+                    {
+                        cerr <<"<!>-Warning: Couldn't read the existing kaomado, rebuilding every portraits: " <<e.what() <<"\n";
+                    }
+                }
+                KaoWriter mywriter( nullptr, nullptr, true, parameters.bisQuiet, parameters.bisVerbose, pprevkao.get() );
+                result = mywriter( kao );
+            } //Unmap the previous kaomado before overwriting it
+            WriteByteVectorToFile( outpath.toString(), result );
 
             //WriteByteVectorToFile( outpath.toString(), filedata );
 
@@ -549,6 +585,8 @@ int main( int argc, const char * argv[] )
         false,                              //bisQuiet
         true,                               //bIsZealous
         false,                              //bExportAsBmp
+        false,                              //bisVerbose
+        false,                              //bIsFullImport
     };
 
 	cout << "================================================\n"
@@ -0,0 +1,523 @@
+#include "color_quantizer.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <sstream>
+using namespace std;
+
+namespace gimg
+{
+    namespace
+    {
+        const unsigned int BinShift = 8 - ColorHistogram::NbBitsPerChannel;
+
+        //Color put in the reserved transparent slot. Same as the palette tool's dummy color.
+        const colorRGB24   TransparentSlotColor( 0, 255, 0 );
+
+        inline bool IsOpaque( const uint8_t * prgba )
+        {
+            return prgba[3] >= QuantAlphaThreshold;
+        }
+
+        inline uint64_t ColorDistance( const colorRGB24 & a, const colorRGB24 & b )
+        {
+            const int32_t dr = static_cast<int32_t>(a.red)   - b.red;
+            const int32_t dg = static_cast<int32_t>(a.green) - b.green;
+            const int32_t db = static_cast<int32_t>(a.blue)  - b.blue;
+            return static_cast<uint64_t>( (dr * dr) + (dg * dg) + (db * db) );
+        }
+
+        //A single used histogram bin
+        struct histentry
+        {
+            uint8_t  comp[3];   //Average color of the bin, red, green, blue
+            uint32_t count;
+            uint64_t sum[3];
+        };
+
+        //A range of entries for median-cut
+        struct colorbox
+        {
+            size_t   beg;
+            size_t   end;
+            uint64_t count;
+            uint8_t  minc[3];
+            uint8_t  maxc[3];
+
+            inline unsigned int LongestAxis()const
+            {
+                unsigned int axis = 0;
+                for( unsigned int i = 1; i < 3; ++i )
+                {
+                    if( (maxc[i] - minc[i]) > (maxc[axis] - minc[axis]) )
+                        axis = i;
+                }
+                return axis;
+            }
+
+            //Boxes with the widest range of colors that are used the most are split first
+            inline uint64_t Score()const
+            {
+                if( (end - beg) < 2 )
+                    return 0;
+                const unsigned int axis = LongestAxis();
+                return static_cast<uint64_t>(maxc[axis] - minc[axis]) * count;
+            }
+        };
+
+        colorbox MakeBox( const vector<histentry> & entries, size_t beg, size_t end )
+        {
+            colorbox box;
+            box.beg   = beg;
+            box.end   = end;
+            box.count = 0;
+            for( unsigned int c = 0; c < 3; ++c )
+            {
+                box.minc[c] = 255;
+                box.maxc[c] = 0;
+            }
+
+            for( size_t i = beg; i < end; ++i )
+            {
+                box.count += entries[i].count;
+                for( unsigned int c = 0; c < 3; ++c )
+                {
+                    box.minc[c] = std::min( box.minc[c], entries[i].comp[c] );
+                    box.maxc[c] = std::max( box.maxc[c], entries[i].comp[c] );
+                }
+            }
+            return box;
+        }
+
+        inline uint8_t AverageComponent( uint64_t sum, uint64_t count )
+        {
+            return static_cast<uint8_t>( (sum + (count / 2)) / count );
+        }
+
+        //Appends the opaque colors within [x0, x1) and [y0, y1) of an RGBA32 image to "out_tile"
+        void AppendTileColors( const uint8_t * prgba, unsigned int width, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, tilecolors_t & out_tile )
+        {
+            for( unsigned int y = y0; y < y1; ++y )
+            {
+                const uint8_t * ppix = prgba + ( ((y * width) + x0) * 4 );
+                for( unsigned int x = x0; x < x1; ++x, ppix += 4 )
+                {
+                    if( IsOpaque(ppix) )
+                        out_tile.push_back( colorRGB24( ppix[0], ppix[1], ppix[2] ) );
+                }
+            }
+        }
+
+        //Builds the palette of each banks from the colors of the tiles assigned to it
+        vector<colorRGB24> BuildColorBanks( const vector<tilecolors_t> & tiles, const vector<size_t> & tilebanks, unsigned int nbbanks, unsigned int nbkmeanspasses )
+        {
+            vector<ColorHistogram> hists(nbbanks);
+            for( size_t i = 0; i < tiles.size(); ++i )
+            {
+                for( const auto & col : tiles[i] )
+                    hists[tilebanks[i]].AddColor(col);
+            }
+
+            vector<colorRGB24> palette;
+            palette.reserve( nbbanks * BankNbColors );
+            for( const auto & hist : hists )
+            {
+                vector<colorRGB24> bankpal = QuantizePalette( hist, BankNbColors, nbkmeanspasses );
+                bankpal.resize( BankNbColors, colorRGB24( 0, 0, 0 ) );
+                palette.insert( palette.end(), bankpal.begin(), bankpal.end() );
+            }
+            return std::move(palette);
+        }
+    };
+
+//==================================================================
+// ColorHistogram
+//==================================================================
+    ColorHistogram::ColorHistogram()
+        :m_count(NbBins, 0), m_sumred(NbBins, 0), m_sumgreen(NbBins, 0), m_sumblue(NbBins, 0), m_nbpixels(0)
+    {}
+
+    void ColorHistogram::AddPixels( const uint8_t * prgba, size_t nbpixels )
+    {
+        for( size_t i = 0; i < nbpixels; ++i, prgba += 4 )
+        {
+            if( IsOpaque(prgba) )
+                AddColor( prgba[0], prgba[1], prgba[2] );
+        }
+    }
+
+    void ColorHistogram::AddColor( uint8_t r, uint8_t g, uint8_t b )
+    {
+        const uint32_t bin = ( static_cast<uint32_t>(r >> BinShift) << (NbBitsPerChannel * 2) ) |
+                             ( static_cast<uint32_t>(g >> BinShift) <<  NbBitsPerChannel      ) |
+                               static_cast<uint32_t>(b >> BinShift);
+        ++m_count[bin];
+        m_sumred  [bin] += r;
+        m_sumgreen[bin] += g;
+        m_sumblue [bin] += b;
+        ++m_nbpixels;
+    }
+
+    void ColorHistogram::Merge( const ColorHistogram & other )
+    {
+        for( size_t i = 0; i < NbBins; ++i )
+        {
+            m_count   [i] += other.m_count[i];
+            m_sumred  [i] += other.m_sumred[i];
+            m_sumgreen[i] += other.m_sumgreen[i];
+            m_sumblue [i] += other.m_sumblue[i];
+        }
+        m_nbpixels += other.m_nbpixels;
+    }
+
+    void ColorHistogram::clear()
+    {
+        std::fill( m_count   .begin(), m_count   .end(), 0 );
+        std::fill( m_sumred  .begin(), m_sumred  .end(), 0 );
+        std::fill( m_sumgreen.begin(), m_sumgreen.end(), 0 );
+        std::fill( m_sumblue .begin(), m_sumblue .end(), 0 );
+        m_nbpixels = 0;
+    }
+
+    size_t ColorHistogram::NbUniqueColors()const
+    {
+        return m_count.size() - std::count( m_count.begin(), m_count.end(), 0 );
+    }
+
+//==================================================================
+// QuantizeColors
+//==================================================================
+    std::vector<colorRGB24> QuantizeColors( const ColorHistogram & hist, unsigned int nbcolors, unsigned int nbkmeanspasses )
+    {
+        if( nbcolors == 0 || nbcolors > 256 )
+        {
+            stringstream sstr;
+            sstr << "QuantizeColors(): Asked for " <<nbcolors <<" colors! Expected between 1 and 256 colors!";
+            throw std::length_error(sstr.str());
+        }
+
+        //Gather the used bins
+        vector<histentry> entries;
+        entries.reserve( hist.NbUniqueColors() );
+        for( size_t i = 0; i < ColorHistogram::NbBins; ++i )
+        {
+            if( hist.m_count[i] == 0 )
+                continue;
+            histentry entry;
+            entry.count  = hist.m_count[i];
+            entry.sum[0] = hist.m_sumred[i];
+            entry.sum[1] = hist.m_sumgreen[i];
+            entry.sum[2] = hist.m_sumblue[i];
+            for( unsigned int c = 0; c < 3; ++c )
+                entry.comp[c] = AverageComponent( entry.sum[c], entry.count );
+            entries.push_back(entry);
+        }
+
+        vector<colorRGB24> palette;
+        if( entries.empty() )
+            return std::move(palette);
+
+        if( entries.size() <= nbcolors )
+        {
+            //No need to reduce anything
+            palette.reserve(entries.size());
+            for( const auto & entry : entries )
+                palette.push_back( colorRGB24( entry.comp[0], entry.comp[1], entry.comp[2] ) );
+            return std::move(palette);
+        }
+
+        //Median-cut
+        vector<colorbox> boxes;
+        boxes.reserve(nbcolors);
+        boxes.push_back( MakeBox( entries, 0, entries.size() ) );
+
+        while( boxes.size() < nbcolors )
+        {
+            auto itbest = std::max_element( boxes.begin(), boxes.end(), []( const colorbox & a, const colorbox & b ){ return a.Score() < b.Score(); } );
+            if( itbest->Score() == 0 )
+                break; //Nothing left to split
+
+            const colorbox     tosplit = *itbest;
+            const unsigned int axis    = tosplit.LongestAxis();
+            std::sort( entries.begin() + tosplit.beg,
+                       entries.begin() + tosplit.end,
+                       [axis]( const histentry & a, const histentry & b ){ return a.comp[axis] < b.comp[axis]; } );
+
+            //Find the entry where half the pixels of the box are on each side
+            uint64_t accum = 0;
+            size_t   split = tosplit.beg;
+            while( split < (tosplit.end - 1) && (accum + entries[split].count) <= (tosplit.count / 2) )
+                accum += entries[split++].count;
+            if( split == tosplit.beg )
+                ++split;
+
+            *itbest = MakeBox( entries, tosplit.beg, split );
+            boxes.push_back( MakeBox( entries, split, tosplit.end ) );
+        }
+
+        palette.reserve(boxes.size());
+        for( const auto & box : boxes )
+        {
+            uint64_t sum[3] = {0,0,0};
+            for( size_t i = box.beg; i < box.end; ++i )
+            {
+                for( unsigned int c = 0; c < 3; ++c )
+                    sum[c] += entries[i].sum[c];
+            }
+            palette.push_back( colorRGB24( AverageComponent( sum[0], box.count ),
+                                           AverageComponent( sum[1], box.count ),
+                                           AverageComponent( sum[2], box.count ) ) );
+        }
+
+        //K-means refinement
+        vector<uint64_t> clustercnt;
+        vector<uint64_t> clustersum;
+        for( unsigned int pass = 0; pass < nbkmeanspasses; ++pass )
+        {
+            PaletteMatcher matcher(palette);
+            clustercnt.assign( palette.size(),     0 );
+            clustersum.assign( palette.size() * 3, 0 );
+
+            for( const auto & entry : entries )
+            {
+                const uint8_t idx = matcher.FindIndex( entry.comp[0], entry.comp[1], entry.comp[2] );
+                clustercnt[idx] += entry.count;
+                for( unsigned int c = 0; c < 3; ++c )
+                    clustersum[(idx * 3) + c] += entry.sum[c];
+            }
+
+            bool haschanged = false;
+            for( size_t i = 0; i < palette.size(); ++i )
+            {
+                if( clustercnt[i] == 0 )
+                    continue; //Keep colors nothing is close to as-is
+                colorRGB24 newcol( AverageComponent( clustersum[(i * 3)],     clustercnt[i] ),
+                                   AverageComponent( clustersum[(i * 3) + 1], clustercnt[i] ),
+                                   AverageComponent( clustersum[(i * 3) + 2], clustercnt[i] ) );
+                if( newcol.red != palette[i].red || newcol.green != palette[i].green || newcol.blue != palette[i].blue )
+                {
+                    palette[i] = newcol;
+                    haschanged = true;
+                }
+            }
+
+            if( !haschanged )
+                break;
+        }
+
+        return std::move(palette);
+    }
+
+//==================================================================
+// QuantizePalette
+//==================================================================
+    std::vector<colorRGB24> QuantizePalette( const ColorHistogram & hist, unsigned int nbcolors, unsigned int nbkmeanspasses )
+    {
+        if( nbcolors < 2 || nbcolors > 256 )
+        {
+            stringstream sstr;
+            sstr << "QuantizePalette(): Asked for " <<nbcolors <<" colors! Expected between 2 and 256 colors!";
+            throw std::length_error(sstr.str());
+        }
+
+        vector<colorRGB24> palette = QuantizeColors( hist, nbcolors - 1, nbkmeanspasses );
+        palette.insert( palette.begin(), TransparentSlotColor );
+        return std::move(palette);
+    }
+
+//==================================================================
+// Color Banks
+//==================================================================
+    void GatherTileColors( const uint8_t * prgba, unsigned int width, unsigned int height, unsigned int tilew, unsigned int tileh, std::vector<tilecolors_t> & out_tiles )
+    {
+        for( unsigned int y0 = 0; y0 < height; y0 += tileh )
+        {
+            for( unsigned int x0 = 0; x0 < width; x0 += tilew )
+            {
+                out_tiles.push_back( tilecolors_t() );
+                out_tiles.back().reserve( tilew * tileh );
+                AppendTileColors( prgba, width, x0, y0, std::min( width, x0 + tilew ), std::min( height, y0 + tileh ), out_tiles.back() );
+            }
+        }
+    }
+
+    std::vector<colorRGB24> QuantizeColorBanks( const std::vector<tilecolors_t> & tiles, unsigned int nbbanks, unsigned int nbkmeanspasses )
+    {
+        if( nbbanks == 0 || (nbbanks * BankNbColors) > 256 )
+        {
+            stringstream sstr;
+            sstr << "QuantizeColorBanks(): Asked for " <<nbbanks <<" banks! Expected between 1 and " <<(256 / BankNbColors) <<" banks!";
+            throw std::length_error(sstr.str());
+        }
+
+        //Start by grouping the tiles by their average color
+        ColorHistogram     avghist;
+        vector<colorRGB24> avgcolors( tiles.size() );
+        for( size_t i = 0; i < tiles.size(); ++i )
+        {
+            if( tiles[i].empty() )
+                continue;
+            uint64_t sum[3] = {0,0,0};
+            for( const auto & col : tiles[i] )
+            {
+                sum[0] += col.red;
+                sum[1] += col.green;
+                sum[2] += col.blue;
+            }
+            avgcolors[i] = colorRGB24( AverageComponent( sum[0], tiles[i].size() ),
+                                       AverageComponent( sum[1], tiles[i].size() ),
+                                       AverageComponent( sum[2], tiles[i].size() ) );
+            avghist.AddColor( avgcolors[i] );
+        }
+
+        vector<size_t>     tilebanks( tiles.size(), 0 );
+        vector<colorRGB24> groupcolors = QuantizeColors( avghist, nbbanks );
+        if( !groupcolors.empty() )
+        {
+            PaletteMatcher groupmatcher(groupcolors);
+            for( size_t i = 0; i < tiles.size(); ++i )
+            {
+                if( !tiles[i].empty() )
+                    tilebanks[i] = groupmatcher.FindIndex( avgcolors[i] );
+            }
+        }
+
+        //Then move the tiles to the bank that fits them best, until nothing changes
+        vector<colorRGB24> palette = BuildColorBanks( tiles, tilebanks, nbbanks, nbkmeanspasses );
+        for( unsigned int pass = 0; pass < nbkmeanspasses; ++pass )
+        {
+            PaletteBankMatcher matcher( palette, BankNbColors );
+            bool               haschanged = false;
+            for( size_t i = 0; i < tiles.size(); ++i )
+            {
+                if( tiles[i].empty() )
+                    continue;
+                const size_t best = matcher.BestBank( tiles[i] );
+                if( best != tilebanks[i] )
+                {
+                    tilebanks[i] = best;
+                    haschanged   = true;
+                }
+            }
+
+            if( !haschanged )
+                break;
+            palette = BuildColorBanks( tiles, tilebanks, nbbanks, nbkmeanspasses );
+        }
+
+        return std::move(palette);
+    }
+
+//==================================================================
+// PaletteBankMatcher
+//==================================================================
+    PaletteBankMatcher::PaletteBankMatcher( const std::vector<colorRGB24> & palette, unsigned int banksize )
+        :m_palette(palette), m_banksize(banksize)
+    {
+        if( banksize == 0 || palette.size() > 256 )
+        {
+            stringstream sstr;
+            sstr << "PaletteBankMatcher::PaletteBankMatcher(): Got banks of " <<banksize <<" colors, in a palette of " <<palette.size() <<" colors!";
+            throw std::length_error(sstr.str());
+        }
+
+        for( size_t beg = 0; beg < palette.size(); beg += banksize )
+        {
+            const size_t end = std::min<size_t>( palette.size(), beg + banksize );
+            m_colors.push_back( vector<colorRGB24>( palette.begin() + std::min( beg + 1, end ), palette.begin() + end ) );
+            m_matchers.push_back( m_colors.back().empty()? nullptr : unique_ptr<PaletteMatcher>( new PaletteMatcher(m_colors.back()) ) );
+        }
+    }
+
+    uint64_t PaletteBankMatcher::TileError( size_t bank, const tilecolors_t & tile, uint64_t maxerr )
+    {
+        if( tile.empty() )
+            return 0;
+        if( !m_matchers[bank] )
+            return std::numeric_limits<uint64_t>::max();
+
+        uint64_t err = 0;
+        for( auto itcol = tile.begin(); itcol != tile.end() && err < maxerr; ++itcol )
+            err += ColorDistance( *itcol, m_colors[bank][m_matchers[bank]->FindIndex(*itcol)] );
+        return err;
+    }
+
+    size_t PaletteBankMatcher::BestBank( const tilecolors_t & tile )
+    {
+        size_t   best    = 0;
+        uint64_t besterr = std::numeric_limits<uint64_t>::max();
+        for( size_t bank = 0; bank < NbBanks() && besterr != 0; ++bank )
+        {
+            const uint64_t err = TileError( bank, tile, besterr ); //No need to finish adding up once it can't be the best
+            if( err < besterr )
+            {
+                best    = bank;
+                besterr = err;
+            }
+        }
+        return best;
+    }
+
+    uint8_t PaletteBankMatcher::FindIndex( size_t bank, uint8_t r, uint8_t g, uint8_t b, bool * out_isexact )
+    {
+        if( !m_matchers[bank] )
+        {
+            if( out_isexact )
+                *out_isexact = false;
+            return static_cast<uint8_t>( bank * m_banksize );
+        }
+        return static_cast<uint8_t>( (bank * m_banksize) + 1 + m_matchers[bank]->FindIndex( r, g, b, out_isexact ) );
+    }
+
+//==================================================================
+// MapRGBA32ToIndices
+//==================================================================
+    size_t MapRGBA32ToIndices( const uint8_t        * prgba,
+                               unsigned int           width,
+                               unsigned int           height,
+                               PaletteBankMatcher   & matcher,
+                               unsigned int           tilew,
+                               unsigned int           tileh,
+                               std::vector<uint8_t> & out_indices )
+    {
+        const unsigned int banksize = matcher.BankSize();
+        tilecolors_t       tile;
+        size_t       nbinexact = 0;
+        out_indices.assign( width * height, 0 );
+
+        for( unsigned int y0 = 0; y0 < height; y0 += tileh )
+        {
+            for( unsigned int x0 = 0; x0 < width; x0 += tilew )
+            {
+                const unsigned int x1   = std::min( width,  x0 + tilew );
+                const unsigned int y1   = std::min( height, y0 + tileh );
+                size_t             bank = 0;
+                if( matcher.NbBanks() > 1 )
+                {
+                    tile.clear();
+                    AppendTileColors( prgba, width, x0, y0, x1, y1, tile );
+                    bank = matcher.BestBank(tile);
+                }
+
+                for( unsigned int y = y0; y < y1; ++y )
+                {
+                    const uint8_t * ppix = prgba + ( ((y * width) + x0) * 4 );
+                    uint8_t       * pout = out_indices.data() + (y * width) + x0;
+                    for( unsigned int x = x0; x < x1; ++x, ppix += 4, ++pout )
+                    {
+                        if( !IsOpaque(ppix) )
+                        {
+                            *pout = static_cast<uint8_t>( bank * banksize );
+                            continue;
+                        }
+                        bool isexact = false;
+                        *pout = matcher.FindIndex( bank, ppix[0], ppix[1], ppix[2], &isexact );
+                        if( !isexact )
+                            ++nbinexact;
+                    }
+                }
+            }
+        }
+        return nbinexact;
+    }
+};
@@ -0,0 +1,220 @@
+#ifndef COLOR_QUANTIZER_HPP
+#define COLOR_QUANTIZER_HPP
+/*
+color_quantizer.hpp
+psycommando@gmail.com
+Description: Utilities for reducing the colors of truecolor images to a palette small enough
+             for the NDS formats. (16 colors for 4bpp, 256 colors for 8bpp, or banks of 16 colors
+             for 8bpp images whose tiles each use a single bank)
+
+             The first color of each palette, or of each bank, is reserved for transparent pixels.
+*/
+#include <ppmdu/containers/color.hpp>
+#include <ppmdu/containers/palette_matcher.hpp>
+#include <ppmdu/containers/img_detile.hpp>
+#include <utils/handymath.hpp>
+#include <utils/gbyteutils.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace gimg
+{
+    static const uint8_t      QuantAlphaThreshold = 0x80; //Pixels with an alpha below this are transparent
+    static const unsigned int BankNbColors        = 16;   //Amount of colors in a palette bank, transparent color included
+
+    //The opaque colors of a single tile
+    typedef std::vector<colorRGB24> tilecolors_t;
+
+    /*************************************************************************************************
+        ColorHistogram
+            Counts how many pixels use each colors, at the 15 bits color depth of the NDS.
+            Colors that differ only in their 3 lowest bits end up in the same bin, and the bin
+            keeps the average of the actual colors that were added to it.
+
+            Histograms can be built separately, for example one per thread or per image, and
+            merged afterwards to get a palette shared by all the images.
+    *************************************************************************************************/
+    class ColorHistogram
+    {
+    public:
+        static const unsigned int NbBitsPerChannel = 5;
+        static const unsigned int NbBins           = 1u << (NbBitsPerChannel * 3);
+
+        ColorHistogram();
+
+        /*
+            AddPixels
+                Adds "nbpixels" packed RGBA32 pixels to the histogram. Transparent pixels are
+                skipped, and aren't counted by NbPixels().
+        */
+        void AddPixels( const uint8_t * prgba, size_t nbpixels );
+
+        inline void AddColor( const colorRGB24 & col ) { AddColor( col.red, col.green, col.blue ); }
+
+        //Adds the counts of another histogram to this one.
+        void Merge( const ColorHistogram & other );
+
+        void clear();
+
+        inline uint64_t NbPixels()const { return m_nbpixels; }
+        size_t          NbUniqueColors()const;
+
+    private:
+        void AddColor( uint8_t r, uint8_t g, uint8_t b );
+
+        friend std::vector<colorRGB24> QuantizeColors( const ColorHistogram &, unsigned int, unsigned int );
+
+        std::vector<uint32_t> m_count;
+        std::vector<uint64_t> m_sumred;
+        std::vector<uint64_t> m_sumgreen;
+        std::vector<uint64_t> m_sumblue;
+        uint64_t              m_nbpixels;
+    };
+
+    /*************************************************************************************************
+        QuantizeColors
+            Builds a palette of at most "nbcolors" colors, (between 1 and 256) that best
+            represents the colors in the histogram.
+
+            The palette is built using median-cut, which repeatedly splits the group of colors
+            with the widest, most used, range of colors in two. Then "nbkmeanspasses" passes of
+            k-means are applied, moving each palette colors to the average of the colors that
+            are closest to it. K-means gives better looking results, but costs a bit more time.
+
+            If the histogram has "nbcolors" unique colors or less, they're returned as-is.
+    *************************************************************************************************/
+    std::vector<colorRGB24> QuantizeColors( const ColorHistogram & hist, unsigned int nbcolors, unsigned int nbkmeanspasses = 0 );
+
+    /*************************************************************************************************
+        QuantizePalette
+            Same as QuantizeColors, but the first color of the palette is reserved for transparent
+            pixels. So only "nbcolors" - 1 colors, (between 2 and 256 colors) are picked from the
+            histogram.
+    *************************************************************************************************/
+    std::vector<colorRGB24> QuantizePalette( const ColorHistogram & hist, unsigned int nbcolors, unsigned int nbkmeanspasses = 0 );
+
+    /*************************************************************************************************
+        GatherTileColors
+            Appends the opaque colors of each "tilew" x "tileh" tiles of a "width" x "height" image
+            made of packed RGBA32 pixels to "out_tiles", from left to right and top to bottom.
+    *************************************************************************************************/
+    void GatherTileColors( const uint8_t            * prgba, 
+                           unsigned int               width, 
+                           unsigned int               height, 
+                           unsigned int               tilew, 
+                           unsigned int               tileh, 
+                           std::vector<tilecolors_t> & out_tiles );
+
+    /*************************************************************************************************
+        QuantizeColorBanks
+            Builds a palette of "nbbanks" banks of BankNbColors colors, (between 1 and 16 banks)
+            for images where each tiles may only use the colors of a single bank, like 4bpp tiles
+            do on the NDS. The first color of each bank is reserved for transparent pixels.
+
+            Tiles are first grouped by their average color, and each group gets a bank quantized
+            from its tiles' colors. Then, each of the "nbkmeanspasses" passes moves the tiles to
+            the bank that matches their colors best, and rebuilds the banks.
+    *************************************************************************************************/
+    std::vector<colorRGB24> QuantizeColorBanks( const std::vector<tilecolors_t> & tiles, unsigned int nbbanks, unsigned int nbkmeanspasses = 0 );
+
+    /*************************************************************************************************
+        PaletteBankMatcher
+            Finds the closest color within a single bank of a palette split in banks of "banksize"
+            colors. The first color of each bank is the transparent color, and is never matched.
+            For a palette without banks, "banksize" is the palette's size.
+
+            Like PaletteMatcher, lookups modify the object, so a single matcher shouldn't be shared
+            between threads. But re-using a matcher for several images that use the same palette
+            saves having to look for the candidate colors all over again.
+    *************************************************************************************************/
+    class PaletteBankMatcher
+    {
+    public:
+        PaletteBankMatcher( const std::vector<colorRGB24> & palette, unsigned int banksize );
+
+        inline size_t                          NbBanks()const  { return m_colors.size(); }
+        inline unsigned int                    BankSize()const { return m_banksize; }
+        inline const std::vector<colorRGB24> & Palette()const  { return m_palette; }
+
+        /*
+            TileError
+                Sum of the squared distances between the colors of the tile and their closest color
+                in the bank. Stops adding up as soon as the sum reaches "maxerr".
+        */
+        uint64_t TileError( size_t bank, const tilecolors_t & tile, uint64_t maxerr = std::numeric_limits<uint64_t>::max() );
+
+        //Returns the bank whose colors are the closest to the colors of the tile
+        size_t   BestBank( const tilecolors_t & tile );
+
+        /*
+            FindIndex
+                Returns the palette index of the closest color in the bank, or the bank's 
+                transparent color if the bank has no other colors.
+        */
+        uint8_t  FindIndex( size_t bank, uint8_t r, uint8_t g, uint8_t b, bool * out_isexact = nullptr );
+
+    private:
+        std::vector<colorRGB24>                      m_palette;
+        unsigned int                                 m_banksize;
+        std::vector<std::vector<colorRGB24>>         m_colors;
+        std::vector<std::unique_ptr<PaletteMatcher>> m_matchers;
+    };
+
+    /*************************************************************************************************
+        MapRGBA32ToIndices
+            Converts a "width" x "height" image made of packed RGBA32 pixels into palette indexes,
+            one per pixel, written to "out_indices" one scanline after the other.
+
+            Each "tilew" x "tileh" tiles uses the bank of the matcher's palette that matches its
+            colors best. Transparent pixels get the first color of the tile's bank.
+
+            Returns the amount of opaque pixels whose color wasn't exactly in the palette.
+    *************************************************************************************************/
+    size_t MapRGBA32ToIndices( const uint8_t        * prgba,
+                               unsigned int           width,
+                               unsigned int           height,
+                               PaletteBankMatcher   & matcher,
+                               unsigned int           tilew,
+                               unsigned int           tileh,
+                               std::vector<uint8_t> & out_indices );
+
+    /*************************************************************************************************
+        RemapRGBA32ToImage
+            Converts a "width" x "height" image made of packed RGBA32 pixels into an indexed tiled
+            image, the same way MapRGBA32ToIndices does, and sets the matcher's palette as its
+            palette. The resolution of the tiled image is rounded up to the nearest tile size.
+
+            Returns the amount of opaque pixels whose color wasn't exactly in the palette.
+    *************************************************************************************************/
+    template<class _TImg_t>
+        size_t RemapRGBA32ToImage( const uint8_t      * prgba,
+                                   unsigned int         width,
+                                   unsigned int         height,
+                                   PaletteBankMatcher & matcher,
+                                   _TImg_t            & out_img )
+    {
+        typedef typename _TImg_t::tile_t tile_t;
+        static const unsigned int       NbColorsMax = utils::do_exponent_of_2_<_TImg_t::pixel_t::mypixeltrait_t::BITS_PER_PIXEL>::value;
+        const std::vector<colorRGB24> & palette     = matcher.Palette();
+        if( palette.size() > NbColorsMax )
+            throw std::length_error("RemapRGBA32ToImage(): The palette has too many colors for the bitdepth of the image!");
+
+        unsigned int tiledwidth  = (width  % tile_t::WIDTH)  ? CalcClosestHighestDenominator( width,  tile_t::WIDTH )  : width;
+        unsigned int tiledheight = (height % tile_t::HEIGHT) ? CalcClosestHighestDenominator( height, tile_t::HEIGHT ) : height;
+        out_img.setPixelResolution( tiledwidth, tiledheight );
+        out_img.setNbColors( NbColorsMax );
+        std::copy( palette.begin(), palette.end(), out_img.getPalette().begin() );
+
+        std::vector<uint8_t> indices;
+        const size_t         nbinexact = MapRGBA32ToIndices( prgba, width, height, matcher, tile_t::WIDTH, tile_t::HEIGHT, indices );
+        for( unsigned int y = 0; y < height; ++y )
+            RetileScanline( indices.data() + (y * width), width, y, out_img );
+        return nbinexact;
+    }
+};
+
+#endif
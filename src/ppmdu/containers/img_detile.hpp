@@ -0,0 +1,185 @@
+#ifndef IMG_DETILE_HPP
+#define IMG_DETILE_HPP
+/*
+img_detile.hpp
+psycommando@gmail.com
+Description: Kernels for converting pixels between the tile order of a tiled_image and the
+             scanline order used by linear_image and most image file formats.
+
+             Everything here works on whole tile rows at a time, instead of going through
+             getPixel(x,y) for every single pixels. The inner loops only touch contiguous
+             memory on both sides, so the compiler can vectorize them.
+*/
+#include <ppmdu/containers/tiled_image.hpp>
+#include <ppmdu/containers/linear_image.hpp>
+#include <algorithm>
+#include <cstdint>
+
+namespace gimg
+{
+//=============================================================================
+// Scanline Kernels
+//=============================================================================
+    /*************************************************************************************************
+        DetileScanline
+            Copies the pixels of scanline "y" of a tiled image into "pout", from left to right.
+
+            "pout" must have room for img.getNbPixelWidth() pixels, and its type must be assignable
+            from the image's pixeldata_t. (Ex: uint8_t, png::index_pixel, or another gimg pixel.)
+    *************************************************************************************************/
+    template<class _TImg_t, class _outpix>
+        inline void DetileScanline( const _TImg_t & img, unsigned int y, _outpix * pout )
+    {
+        typedef typename _TImg_t::tile_t               tile_t;
+        typedef typename _TImg_t::pixel_t::pixeldata_t pixeldata_t;
+        const unsigned int tilerow   = y / tile_t::HEIGHT;
+        const unsigned int rowintile = y % tile_t::HEIGHT;
+        const unsigned int nbcols    = img.getNbCol();
+
+        for( unsigned int col = 0; col < nbcols; ++col, pout += tile_t::WIDTH )
+        {
+            const auto * psrc = img.getTile( col, tilerow ).getRowData(rowintile);
+            for( unsigned int x = 0; x < tile_t::WIDTH; ++x )
+                pout[x] = static_cast<pixeldata_t>( psrc[x].getWholePixelData() );
+        }
+    }
+
+    /*************************************************************************************************
+        RetileScanline
+            Copies "count" pixels from "pin" into scanline "y" of a tiled image, from left to right.
+            The tiled image must already have the proper resolution.
+            Values are masked to the bitdepth of the image's pixels.
+    *************************************************************************************************/
+    template<class _inpix, class _TImg_t>
+        inline void RetileScanline( const _inpix * pin, unsigned int count, unsigned int y, _TImg_t & img )
+    {
+        typedef typename _TImg_t::tile_t               tile_t;
+        typedef typename _TImg_t::pixel_t::pixeldata_t pixeldata_t;
+        const pixeldata_t  mask      = _TImg_t::pixel_t::mypixeltrait_t::MASK_PIXEL_DATA;
+        const unsigned int tilerow   = y / tile_t::HEIGHT;
+        const unsigned int rowintile = y % tile_t::HEIGHT;
+        count = std::min( count, img.getNbPixelWidth() );
+
+        for( unsigned int col = 0; count > 0; ++col, pin += tile_t::WIDTH )
+        {
+            const unsigned int nbtocopy = std::min( count, tile_t::WIDTH );
+            auto * pdst = img.getTile( col, tilerow ).getRowData(rowintile);
+            for( unsigned int x = 0; x < nbtocopy; ++x )
+                pdst[x] = static_cast<pixeldata_t>( static_cast<pixeldata_t>(pin[x]) & mask );
+            count -= nbtocopy;
+        }
+    }
+
+    /*************************************************************************************************
+        DetileScanlinePacked4bpp
+            Same as DetileScanline, but packs 2 pixels per bytes into "pout", high nybble first,
+            the way PNG and BMP store 4bpp scanlines.
+            "pout" must have room for img.getNbPixelWidth() / 2 bytes.
+    *************************************************************************************************/
+    template<class _TImg_t>
+        inline void DetileScanlinePacked4bpp( const _TImg_t & img, unsigned int y, uint8_t * pout )
+    {
+        typedef typename _TImg_t::tile_t tile_t;
+        static_assert( (tile_t::WIDTH % 2) == 0, "DetileScanlinePacked4bpp(): Tile width must be even!" );
+        const unsigned int tilerow   = y / tile_t::HEIGHT;
+        const unsigned int rowintile = y % tile_t::HEIGHT;
+        const unsigned int nbcols    = img.getNbCol();
+
+        for( unsigned int col = 0; col < nbcols; ++col, pout += (tile_t::WIDTH / 2) )
+        {
+            const auto * psrc = img.getTile( col, tilerow ).getRowData(rowintile);
+            for( unsigned int x = 0; x < (tile_t::WIDTH / 2); ++x )
+            {
+                pout[x] = static_cast<uint8_t>( ( (psrc[2*x].getWholePixelData() & 0xF) << 4 ) |
+                                                  (psrc[2*x+1].getWholePixelData() & 0xF) );
+            }
+        }
+    }
+
+    /*************************************************************************************************
+        RetileScanlinePacked4bpp
+            Same as RetileScanline, but reads "count" pixels packed 2 per bytes, high nybble first.
+    *************************************************************************************************/
+    template<class _TImg_t>
+        inline void RetileScanlinePacked4bpp( const uint8_t * pin, unsigned int count, unsigned int y, _TImg_t & img )
+    {
+        typedef typename _TImg_t::tile_t tile_t;
+        static_assert( (tile_t::WIDTH % 2) == 0, "RetileScanlinePacked4bpp(): Tile width must be even!" );
+        const unsigned int tilerow   = y / tile_t::HEIGHT;
+        const unsigned int rowintile = y % tile_t::HEIGHT;
+        count = std::min( count, img.getNbPixelWidth() );
+
+        for( unsigned int col = 0; count > 0; ++col, pin += (tile_t::WIDTH / 2) )
+        {
+            const unsigned int nbtocopy = std::min( count, tile_t::WIDTH );
+            auto * pdst = img.getTile( col, tilerow ).getRowData(rowintile);
+            for( unsigned int x = 0; x < nbtocopy; ++x )
+                pdst[x] = static_cast<uint8_t>( ( x & 1 )? (pin[x/2] & 0xF) : (pin[x/2] >> 4) );
+            count -= nbtocopy;
+        }
+    }
+
+//=============================================================================
+// Whole Image Conversion
+//=============================================================================
+    /*************************************************************************************************
+        DetileImage
+            Converts the pixels of a tiled image into a linear image of the same resolution.
+            Works one tile row at a time, so each tile is only visited once.
+            Only the pixels are copied, not the palette.
+    *************************************************************************************************/
+    template<class _TImg_t, class _LImg_t>
+        void DetileImage( const _TImg_t & src, _LImg_t & dst )
+    {
+        typedef typename _TImg_t::tile_t               tile_t;
+        typedef typename _TImg_t::pixel_t::pixeldata_t pixeldata_t;
+        dst.setPixelResolution( src.getNbPixelWidth(), src.getNbPixelHeight() );
+
+        for( unsigned int tilerow = 0; tilerow < src.getNbRows(); ++tilerow )
+        {
+            for( unsigned int col = 0; col < src.getNbCol(); ++col )
+            {
+                const tile_t & curtile = src.getTile( col, tilerow );
+                for( unsigned int y = 0; y < tile_t::HEIGHT; ++y )
+                {
+                    const auto * psrc = curtile.getRowData(y);
+                    auto       * pdst = dst.getRowData( (tilerow * tile_t::HEIGHT) + y ) + (col * tile_t::WIDTH);
+                    for( unsigned int x = 0; x < tile_t::WIDTH; ++x )
+                        pdst[x] = static_cast<pixeldata_t>( psrc[x].getWholePixelData() );
+                }
+            }
+        }
+    }
+
+    /*************************************************************************************************
+        RetileImage
+            Converts the pixels of a linear image into a tiled image of the same resolution.
+            The linear image's resolution must be divisible by the tile size, or
+            ExTImgResNotDivisibleBy is thrown. Only the pixels are copied, not the palette.
+    *************************************************************************************************/
+    template<class _LImg_t, class _TImg_t>
+        void RetileImage( const _LImg_t & src, _TImg_t & dst )
+    {
+        typedef typename _TImg_t::tile_t               tile_t;
+        typedef typename _TImg_t::pixel_t::pixeldata_t pixeldata_t;
+        dst.setPixelResolution( src.getNbPixelWidth(), src.getNbPixelHeight() );
+
+        for( unsigned int tilerow = 0; tilerow < dst.getNbRows(); ++tilerow )
+        {
+            for( unsigned int col = 0; col < dst.getNbCol(); ++col )
+            {
+                tile_t & curtile = dst.getTile( col, tilerow );
+                for( unsigned int y = 0; y < tile_t::HEIGHT; ++y )
+                {
+                    const auto * psrc = src.getRowData( (tilerow * tile_t::HEIGHT) + y ) + (col * tile_t::WIDTH);
+                    auto       * pdst = curtile.getRowData(y);
+                    for( unsigned int x = 0; x < tile_t::WIDTH; ++x )
+                        pdst[x] = static_cast<pixeldata_t>( psrc[x].getWholePixelData() );
+                }
+            }
+        }
+    }
+
+};
+
+#endif
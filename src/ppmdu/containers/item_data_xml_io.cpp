@@ -143,11 +143,11 @@ namespace pmd2 { namespace stats
 
         stringstream & MakeFilename( stringstream & out_fname, const string & outpathpre, unsigned int cntitem )
         {
-            const std::string * pstr = nullptr;
-            if( !m_bNoStrings && (pstr = m_pgametext->GetDefaultLanguage().GetStringIfBlockExists(eStringBlocks::ItemNames, cntitem)) )
+            utils::StrView str;
+            if( !m_bNoStrings && m_pgametext->GetDefaultLanguage().GetStringIfBlockExists(eStringBlocks::ItemNames, cntitem, str) )
             {
                 out_fname <<outpathpre <<setw(4) <<setfill('0') <<cntitem <<"_" 
-                          <<PrepareItemFName(*pstr, m_pgametext->begin()->first) <<".xml";
+                          <<PrepareItemFName(str, m_pgametext->begin()->first) <<".xml";
             }
             else
                 out_fname <<outpathpre <<setw(4) <<setfill('0') <<cntitem <<".xml";
@@ -192,10 +192,11 @@ namespace pmd2 { namespace stats
             return utils::CleanFilename( name.substr( 0, name.find("\\0",0 ) ), std::locale( *m_pgametext->GetLocaleString(glang)) ); //Remove ending "\0" and remove illegal characters for filesystem
         }
 
-        inline void WriteStringNode( xml_node & strnode, const string & nodename, const string * value )
+        inline void WriteStringNode( xml_node & strnode, const string & nodename, const StringAccessor & langstrs, eStringBlocks blk, unsigned int cntitem )
         {
-            if( value )
-                WriteNodeWithValue( strnode, nodename, utils::StrRemoveAfter( *value, "\\0" ) ); //remove ending \0
+            utils::StrView value;
+            if( langstrs.GetStringIfBlockExists(blk, cntitem, value) )
+                WriteNodeWithValue( strnode, nodename, utils::StrRemoveAfter( value, "\\0" ) ); //remove ending \0
         }
 
         void WriteStrings( xml_node & in, unsigned int cntitem )
@@ -209,11 +210,11 @@ namespace pmd2 { namespace stats
             {
                 xml_node langnode = strnode.append_child( GetGameLangName(alang.first).c_str() );
                 //Write Name
-                WriteStringNode( langnode, PROP_Name,      alang.second.GetStringIfBlockExists(eStringBlocks::ItemNames, cntitem) );
+                WriteStringNode( langnode, PROP_Name,      alang.second, eStringBlocks::ItemNames, cntitem );
                 //Write Description
-                WriteStringNode( langnode, PROP_ShortDesc, alang.second.GetStringIfBlockExists(eStringBlocks::ItemDescS, cntitem) );
+                WriteStringNode( langnode, PROP_ShortDesc, alang.second, eStringBlocks::ItemDescS, cntitem );
                 //Write Description
-                WriteStringNode( langnode, PROP_LongDesc,  alang.second.GetStringIfBlockExists(eStringBlocks::ItemDescL, cntitem) );
+                WriteStringNode( langnode, PROP_LongDesc,  alang.second, eStringBlocks::ItemDescL, cntitem );
             }
         }
 
@@ -372,28 +373,22 @@ namespace pmd2 { namespace stats
                 {
                     string itemname = curnode.child_value();
                     itemname += "\\0"; //put back the \0
-                    string * pstr = langstr->second.GetStringIfBlockExists(eStringBlocks::ItemNames, itemID);
-                    if(!pstr)
+                    if( !langstr->second.SetStringIfBlockExists(eStringBlocks::ItemNames, itemID, itemname) )
                         throw std::runtime_error("ItemXMLParser::ReadLangStrings(): Couldn't access the item names string block!");
-                    *(pstr) = itemname;
                 }
                 else if( curnode.name() == PROP_ShortDesc )
                 {
                     string itemdescsh = curnode.child_value();
                     itemdescsh += "\\0"; //put back the \0
-                    string * pstr = langstr->second.GetStringIfBlockExists(eStringBlocks::ItemDescS, itemID);
-                    if(!pstr)
+                    if( !langstr->second.SetStringIfBlockExists(eStringBlocks::ItemDescS, itemID, itemdescsh) )
                         throw std::runtime_error("ItemXMLParser::ReadLangStrings(): Couldn't access the item short description string block!");
-                    *(pstr) = itemdescsh;
                 }
                 else if( curnode.name() == PROP_LongDesc )
                 {
                     string itemdescl = curnode.child_value();
                     itemdescl += "\\0"; //put back the \0
-                    string * pstr = langstr->second.GetStringIfBlockExists(eStringBlocks::ItemDescL, itemID);
-                    if(!pstr)
+                    if( !langstr->second.SetStringIfBlockExists(eStringBlocks::ItemDescL, itemID, itemdescl) )
                         throw std::runtime_error("ItemXMLParser::ReadLangStrings(): Couldn't access the item long description string block!");
-                    *(pstr) = itemdescl;
                 }
             }
         }
@@ -236,57 +236,53 @@ namespace pmd2
 
     //
     //
-    void CopyATile( const pmd2::tileproperties & curtmap, const std::vector<std::vector<gimg::pixel_indexed_4bpp>> & tiles, gimg::tiled_image_i8bpp::tile_t & outitle )//_outit & itout )
-    {
-        static const size_t tilesqrtres         = 8;
-        static const size_t NbBytesPer4bppTile  = 64;
-        static const size_t NbColors4bpp        = 16;
-
-        const std::vector<gimg::pixel_indexed_4bpp> * curtile = nullptr;
-        if( curtmap.tileindex >= tiles.size() )
-        {
-            curtile = &(tiles.front());
-        }
-        else
-            curtile = &(tiles[curtmap.tileindex]);
+    TileRenderCache::TileRenderCache( const TilesetLayer::imgdat_t & tiles )
+        :m_tiles(tiles)
+    {}
 
+    const TileRenderCache::block_t & TileRenderCache::GetBlock( const tileproperties & tinfo )
+    {
+        const uint32_t key   = MakeKey(tinfo);
+        auto           itfnd = m_blocks.find(key);
+        if( itfnd != m_blocks.end() )
+            return itfnd->second;
+
+        block_t & block = m_blocks[key];
+        DecodeBlock( m_tiles, tinfo, block );
+        return block;
+    }
 
-        size_t cntoutpix = 0;
-        //_init itcurtile = std::next(itbegcnt,tileindex);
-        if(!curtmap.hflip && !curtmap.vflip)
-        {
-            for( size_t i = 0; i < NbBytesPer4bppTile; ++i, ++cntoutpix )
-            {
-                uint8_t curby = (*curtile)[i];
-                outitle[cntoutpix] = (curby & 0xF) + (curtmap.palindex * NbColors4bpp);
-            }
-        }
-        else
+    void TileRenderCache::DecodeBlock( const TilesetLayer::imgdat_t & tiles, const tileproperties & tinfo, block_t & block )
+    {
+        static const unsigned int NbColors4bpp = 16;
+        block.fill(0);
+        if( tiles.empty() )
+            return;
+
+        const auto  & srctile = (tinfo.tileindex < tiles.size())? tiles[tinfo.tileindex] : tiles.front();
+        const uint8_t palbase = static_cast<uint8_t>(tinfo.palindex * NbColors4bpp);
+        for( unsigned int y = 0; y < TileHeight; ++y )
         {
-            const int InitRowCnt= (!curtmap.vflip)? 0 : tilesqrtres;
-            const int TargetRow = (!curtmap.vflip)? tilesqrtres : 0;
-            const int StepRow   = (!curtmap.vflip)? 1 :-1;
-            const int CntRAdjust= (!curtmap.vflip)? 0 :-1; //Modifier added to the row counter, when interpreting its value on an index starting at 0
-
-            for( int cntrow = InitRowCnt; cntrow != TargetRow; cntrow += StepRow )
+            const unsigned int srcrow = ((tinfo.vflip)? (TileHeight - 1 - y) : y) * TileWidth;
+            for( unsigned int x = 0; x < TileWidth; ++x )
             {
-                size_t currowbeg = ((cntrow + CntRAdjust) * tilesqrtres);
-                int InitColCnt= (!curtmap.hflip)? 0 : tilesqrtres;
-                int TargetCol = (!curtmap.hflip)? tilesqrtres : 0;
-                int StepCol   = (!curtmap.hflip)? 1 :-1;
-                int CntCAdjust= (!curtmap.hflip)? 0 :-1; //Modifier added to the column counter, when interpreting its value on an index starting at 0
-
-                for( int cntcol = InitColCnt; cntcol != TargetCol; cntcol += StepCol, ++cntoutpix )
+                const size_t srcpos = srcrow + ((tinfo.hflip)? (TileWidth - 1 - x) : x);
+                if( srcpos < srctile.size() )
                 {
-                    size_t curpos = (cntcol + CntCAdjust) + currowbeg;
-                    uint8_t curby = (*curtile)[curpos];
-                    outitle[cntoutpix] = (curby & 0xF) + (curtmap.palindex * NbColors4bpp);
+                    const uint8_t curby = srctile[srcpos];
+                    block[(y * TileWidth) + x] = (curby & 0xF) + palbase;
                 }
-
             }
         }
     }
 
+    void TileRenderCache::CopyTo( const tileproperties & tinfo, gimg::tiled_image_i8bpp::tile_t & outtile )
+    {
+        const block_t & block = GetBlock(tinfo);
+        for( unsigned int i = 0; i < NbPixels; ++i )
+            outtile[i] = block[i];
+    }
+
     //std::vector<std::vector<pmd2::tileproperties>> TileTileMaps( const Tileset & tileset )
     //{
     //    const uint16_t tmgrpsz = tileset.BMAData().unk1 * tileset.BMAData().unk2;
@@ -426,53 +422,12 @@ namespace pmd2
     //    return std::move(assembledimg);
     //}
 
-    /*
-            -img         : Destination image
-            -tileoffsetx : Offset in pixel of the tile's first upper left pixel
-            -tileoffsety : Offset in pixel of the tile's first upper left pixel
-            -tinfo       : Tile mapping data
-            -ittilebeg   : Iterator on the first pixel of the tile. (The pixel data must be stored linearly)
-            -ittileend   : Iterator past the last pixel of the tile. (The pixel data must be stored linearly)
-    */
-    template<class _init>
-        void WriteTileAtCoordinates( gimg::tiled_image_i8bpp & img, size_t tileoffsetx, size_t tileoffsety, const tileproperties & tinfo, _init ittilebeg, _init ittileend )
-    {
-        static const size_t TileWidth   = 8;
-        static const size_t TileWHeight = 8;
-        static const size_t SizePalette = 16;
-        const size_t oldsize = tileoffsetx * tileoffsety;
-        const size_t newsize = (( tileoffsetx + TileWidth ) * ( tileoffsety + TileWHeight )) + oldsize;
-
-        if( (tileoffsetx + TileWidth)   > img.width() ||
-            (tileoffsety + TileWHeight) > img.height() ||
-            newsize > img.getTotalNbPixels()  )
-        {
-            assert(false);
-            throw std::runtime_error( "WriteTileAtCoordinates(): Not enough pixels left to write current tile!" );
-        }
-
-        const int XIncr = (tinfo.hflip)? -1        : 1;
-        const int XTarg = (tinfo.hflip)? -1        : TileWidth;
-        const int XInit = (tinfo.hflip)? (TileWidth - 1) : 0;
-
-        const int YIncr = (tinfo.vflip)? -1          : 1;
-        const int YTarg = (tinfo.vflip)? -1          : TileWHeight;
-        const int YInit = (tinfo.vflip)? (TileWHeight - 1) : 0;
-
-        for( int y = YInit; (y != YTarg) && (ittilebeg != ittileend); y += YIncr )
-        {
-            for( int x = XInit; (x != XTarg) && (ittilebeg != ittileend); x += XIncr, ++ittilebeg )
-                img.getPixel(tileoffsetx + x, tileoffsety + y) = (*ittilebeg) + (tinfo.palindex * SizePalette);
-        }
-    }
-
-
     /*
             -tgrpoffsetx : Offset of the first upper right pixel of the first tile in the tile group on the target image.
             -tgrpoffsety : Offset of the first upper right pixel of the first tile in the tile group on the target image.
             -itcurtmap   : Current tilemap data entry.
             -itendtmap   : Past the last tilemap entry for this tile group.
-            -tiles       : all the tiles for this tileset
+            -rendcache   : decoded tiles for this tileset
     */
     template<class _inittmap>
         void WriteTileGroupAtCoord( gimg::tiled_image_i8bpp      & img, 
@@ -480,8 +435,7 @@ namespace pmd2
                                     size_t                         tgrpoffsety, 
                                     _inittmap                    & itcurtmap, 
                                     _inittmap                      itendtmap, 
-                                    const TilesetLayer::imgdat_t & tiles,
-                                    size_t                       & mapcnt)
+                                    TileRenderCache              & rendcache )
     {
         static const size_t TileGroupWidth  = 3;
         static const size_t TileGroupHeight = 3;
@@ -505,16 +459,9 @@ namespace pmd2
         {
             for( size_t tmx = 0; (tmx < TileGroupWidth) && (itcurtmap != itendtmap); ++tmx, ++itcurtmap )
             {
-                size_t tindex = itcurtmap->tileindex;
-                if( itcurtmap->tileindex >= tiles.size() )
-                {
-                    clog << "    *Invalid tile index " <<itcurtmap->tileindex <<"\n";
-                    tindex = 0;
-                }
-                clog <<"TileMap #" <<mapcnt <<" - Target Tile #" <<tindex <<" at (" <<(tgrpoffsetx + (tmx * TileWidth)) <<", " <<curryoff <<")\n";
-                WriteTileAtCoordinates( img, (tgrpoffsetx + (tmx * TileWidth)), curryoff, *itcurtmap, std::begin(tiles[tindex]), std::end(tiles[tindex]) );
+                //Tile groups are always aligned on tiles
+                rendcache.CopyTo( *itcurtmap, img.getTile( (tgrpoffsetx / TileWidth) + tmx, curryoff / TileWHeight ) );
                 //currxoff += TileWidth;
-                ++mapcnt;
             }
             curryoff += TileWHeight;
             //currxoff = tgrpoffsetx;
@@ -532,7 +479,7 @@ namespace pmd2
         size_t       currentoffsety = 0;
         auto         ittmap         = tileset.TileMap().begin();
         auto         ittmapend      = tileset.TileMap().end();
-        size_t       mapcnt         = 0;
+        TileRenderCache         rendcache(tileset.Tiles());
         gimg::tiled_image_i8bpp assembledimg;
 
         //!FIXME: This calculation for the image size is wrong!
@@ -552,7 +499,7 @@ namespace pmd2
             for( size_t tmgrpx = 0; tmgrpx < imgwidthtgrp; ++tmgrpx )
             {
                 currentoffsetx = tmgrpx * (tilegrpwidth * tilesqrt);
-                WriteTileGroupAtCoord( assembledimg, currentoffsetx, currentoffsety, ittmap, ittmapend, tileset.Tiles(), mapcnt );
+                WriteTileGroupAtCoord( assembledimg, currentoffsetx, currentoffsety, ittmap, ittmapend, rendcache );
             }
             currentoffsety += (tilegrpheight * tilesqrt);
             currentoffsetx = 0;
@@ -616,13 +563,18 @@ namespace pmd2
             size_t                  nbrows = (layer.Tiles().size() / ImgRowLenTiles) + ( (layer.Tiles().size() % ImgRowLenTiles != 0)? 1 : 0);
             assembledimg.setNbTilesRowsAndColumns( ImgRowLenTiles, nbrows );
 
-            //Write all tiles
+            //Write all tiles. Each one is drawn once, so there's nothing to gain from caching them
+            TileRenderCache::block_t block;
             for( size_t tidx = 0; tidx < layer.Tiles().size(); ++tidx )
             {
-                for( size_t pidx = 0; pidx < layer.Tiles()[tidx].size(); ++pidx )
-                {
-                    assembledimg.getTile(tidx)[pidx] = layer.Tiles()[tidx][pidx] + (pallut[tidx] * NbColorsPerPalette);
-                }
+                tileproperties tinfo;
+                tinfo.tileindex = static_cast<uint16_t>(tidx);
+                tinfo.palindex  = pallut[static_cast<tileindex_t>(tidx)];
+                TileRenderCache::DecodeBlock( layer.Tiles(), tinfo, block );
+
+                auto & outtile = assembledimg.getTile(tidx);
+                for( unsigned int i = 0; i < TileRenderCache::NbPixels; ++i )
+                    outtile[i] = block[i];
             }
 
             //Fill the color palette
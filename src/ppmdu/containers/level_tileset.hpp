@@ -14,6 +14,7 @@ Description: Storage and processing classes for level tileset data.
 #include <vector>
 #include <array>
 #include <cstdint>
+#include <unordered_map>
 
 
 namespace pmd2
@@ -240,6 +241,49 @@ namespace pmd2
         bpcasmtbl_t     m_imgasmdat;
     };
 
+    /************************************************************************************************
+        TileRenderCache
+            Decodes the tiles of a layer into 8bpp 8x8 blocks, with the flips and palette of a
+            tilemap entry already applied. Each unique tilemap entry value is decoded only once,
+            so assembling an image from a tilemap is a matter of copying blocks.
+            Use DecodeBlock() directly when every entry is only drawn once.
+
+            Tilemap entries pointing past the last tile use the first tile instead.
+            The cache only keeps a reference to the tiles, so they must outlive it.
+    ************************************************************************************************/
+    class TileRenderCache
+    {
+    public:
+        static const unsigned int TileWidth  = 8;
+        static const unsigned int TileHeight = 8;
+        static const unsigned int NbPixels   = TileWidth * TileHeight;
+        typedef std::array<uint8_t, NbPixels> block_t;
+
+        explicit TileRenderCache( const TilesetLayer::imgdat_t & tiles );
+
+        //Returns the decoded block for the tilemap entry, decoding it if it wasn't already.
+        const block_t & GetBlock( const tileproperties & tinfo );
+
+        //Writes the decoded block for the tilemap entry into an 8bpp tile.
+        void CopyTo( const tileproperties & tinfo, gimg::tiled_image_i8bpp::tile_t & outtile );
+
+        //Amount of unique blocks decoded so far
+        inline size_t size()const { return m_blocks.size(); }
+
+        //Decodes the tile of a tilemap entry, without caching it.
+        static void DecodeBlock( const TilesetLayer::imgdat_t & tiles, const tileproperties & tinfo, block_t & out_block );
+
+    private:
+        //Uses the full tile index, unlike the packed 16 bits tilemap entry, which only has 10 bits for it.
+        static inline uint32_t MakeKey( const tileproperties & tinfo )
+        {
+            return static_cast<uint32_t>(tinfo.tileindex) | ((tinfo.hflip?1u:0u) << 16) | ((tinfo.vflip?1u:0u) << 17) | (static_cast<uint32_t>(tinfo.palindex) << 18);
+        }
+
+        const TilesetLayer::imgdat_t &          m_tiles;
+        std::unordered_map<uint32_t, block_t>   m_blocks;
+    };
+
     /************************************************************************************************
         TilesetLayers
             Contains the layers of a tileset along with their assembly table!
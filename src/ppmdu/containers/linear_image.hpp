@@ -99,6 +99,10 @@ namespace gimg
             return (const_cast<linear_image<_PIXEL_T> *>(this))->getPixel(x,y);
         }
 
+        //Access the contiguous pixels of a single scanline
+        inline pixel_t       * getRowData( unsigned int y )      { return m_img[y].data(); }
+        inline const pixel_t * getRowData( unsigned int y )const { return m_img[y].data(); }
+
         //Set the image resolution in pixels.
         inline void setPixelResolution( unsigned int pixelsWidth, unsigned int pixelsHeigth )
         {
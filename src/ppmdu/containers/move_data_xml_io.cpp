@@ -112,11 +112,11 @@ namespace pmd2 { namespace stats
 
         stringstream & MakeFilename( stringstream & out_fname, const string & outpathpre, unsigned int cntmv )
         {
-            const string * pfstr = nullptr;
-            if( !m_bNoStrings && (pfstr = m_pgametext->GetDefaultLanguage().GetStringIfBlockExists( eStringBlocks::MvNames, cntmv )) )
+            utils::StrView fstr;
+            if( !m_bNoStrings && m_pgametext->GetDefaultLanguage().GetStringIfBlockExists( eStringBlocks::MvNames, cntmv, fstr ) )
             {
                 out_fname <<outpathpre <<setw(4) <<setfill('0') <<cntmv <<"_" 
-                          <<PrepareMvNameFName(*pfstr, m_pgametext->begin()->first) <<".xml";
+                          <<PrepareMvNameFName(fstr, m_pgametext->begin()->first) <<".xml";
             }
             else
                 out_fname <<outpathpre <<setw(4) <<setfill('0') <<cntmv <<".xml";
@@ -205,13 +205,13 @@ namespace pmd2 { namespace stats
             {
                 xml_node langnode = strnode.append_child( GetGameLangName(alang.first).c_str() );
                 //Write Name
-                const string * pname = alang.second.GetStringIfBlockExists(eStringBlocks::MvNames,cntmv);
-                if( pname )
-                    WriteNodeWithValue( langnode, PROP_Name, utils::StrRemoveAfter( *pname, "\\0" ) ); //remove ending \0
+                utils::StrView name;
+                if( alang.second.GetStringIfBlockExists(eStringBlocks::MvNames,cntmv,name) )
+                    WriteNodeWithValue( langnode, PROP_Name, utils::StrRemoveAfter( name, "\\0" ) ); //remove ending \0
                 //Write Description
-                const string * pdesc = alang.second.GetStringIfBlockExists(eStringBlocks::MvDesc,cntmv);
-                if( pdesc )
-                    WriteNodeWithValue( langnode, PROP_Category, utils::StrRemoveAfter( *pdesc, "\\0" ) ); //remove ending \0
+                utils::StrView desc;
+                if( alang.second.GetStringIfBlockExists(eStringBlocks::MvDesc,cntmv,desc) )
+                    WriteNodeWithValue( langnode, PROP_Category, utils::StrRemoveAfter( desc, "\\0" ) ); //remove ending \0
             }
         }
 
@@ -482,19 +482,15 @@ namespace pmd2 { namespace stats
                 {
                     string name = curnode.child_value();
                     name += "\\0"; //put back the \0
-                    string * pstr = langstr->second.GetStringIfBlockExists(eStringBlocks::MvNames, moveid);
-                    if(!pstr)
+                    if( !langstr->second.SetStringIfBlockExists(eStringBlocks::MvNames, moveid, name) )
                         throw std::runtime_error("MoveDB_XML_Parser::ReadLangStrings(): Couldn't access the move name string block!");
-                    *(pstr) = name;
                 }
                 else if( curnode.name() == PROP_Desc )
                 {
                     string desc = curnode.child_value();
                     desc += "\\0"; //put back the \0
-                    string * pstr = langstr->second.GetStringIfBlockExists(eStringBlocks::MvDesc, moveid);
-                    if(!pstr)
+                    if( !langstr->second.SetStringIfBlockExists(eStringBlocks::MvDesc, moveid, desc) )
                         throw std::runtime_error("MoveDB_XML_Parser::ReadLangStrings(): Couldn't access the move description string block!");
-                    *(pstr) = desc;
                 }
             }
         }
@@ -0,0 +1,172 @@
+#include "palette_matcher.hpp"
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include <stdexcept>
+#include <sstream>
+using namespace std;
+
+namespace gimg
+{
+    namespace
+    {
+        const unsigned int CellShift = 8 - PaletteMatcher::NbBitsPerCellChannel;
+        const int32_t      CellSpan  = 1 << CellShift;
+
+        inline uint32_t CellIndex( uint8_t r, uint8_t g, uint8_t b )
+        {
+            return ( (r >> CellShift) << (PaletteMatcher::NbBitsPerCellChannel * 2) ) |
+                   ( (g >> CellShift) << (PaletteMatcher::NbBitsPerCellChannel)     ) |
+                     (b >> CellShift);
+        }
+
+        //Distance from a value to the closest and farthest points of the range [lo, lo + CellSpan - 1]
+        inline int32_t MinDistToRange( int32_t val, int32_t lo )
+        {
+            const int32_t hi = lo + CellSpan - 1;
+            if( val < lo ) return lo - val;
+            if( val > hi ) return val - hi;
+            return 0;
+        }
+
+        inline int32_t MaxDistToRange( int32_t val, int32_t lo )
+        {
+            const int32_t hi = lo + CellSpan - 1;
+            return std::max( std::abs(val - lo), std::abs(val - hi) );
+        }
+    };
+
+//==================================================================
+// PaletteMatcher
+//==================================================================
+    PaletteMatcher::PaletteMatcher( const std::vector<colorRGB24> & palette )
+        :m_cellbeg(NbCells, 0), m_celllen(NbCells, 0), m_cellbuilt(NbCells, false)
+    {
+        if( palette.empty() || palette.size() > 256 )
+        {
+            stringstream sstr;
+            sstr << "PaletteMatcher::PaletteMatcher(): Palette has " <<palette.size() <<" colors! Expected between 1 and 256 colors!";
+            throw std::length_error(sstr.str());
+        }
+
+        m_red  .reserve(palette.size());
+        m_green.reserve(palette.size());
+        m_blue .reserve(palette.size());
+        for( const auto & col : palette )
+        {
+            m_red  .push_back(col.red);
+            m_green.push_back(col.green);
+            m_blue .push_back(col.blue);
+        }
+        m_distbuf.resize(palette.size());
+    }
+
+    /*
+        BuildCell
+            A palette color is a candidate for a cell if its shortest possible distance to the cell
+            is not larger than the longest possible distance between the cell and the color that
+            is the most certain to be close to it. Any color failing that test can never be the
+            closest to a color within the cell.
+    */
+    void PaletteMatcher::BuildCell( uint32_t cellindex )
+    {
+        const int32_t lor = static_cast<int32_t>( (cellindex >> (NbBitsPerCellChannel * 2)) % NbCellsPerChannel ) << CellShift;
+        const int32_t log = static_cast<int32_t>( (cellindex >> NbBitsPerCellChannel)       % NbCellsPerChannel ) << CellShift;
+        const int32_t lob = static_cast<int32_t>(  cellindex                                % NbCellsPerChannel ) << CellShift;
+        const size_t  nbcolors  = m_red.size();
+        int32_t       threshold = std::numeric_limits<int32_t>::max();
+
+        for( size_t i = 0; i < nbcolors; ++i )
+        {
+            const int32_t dr = MaxDistToRange( m_red[i],   lor ),
+                          dg = MaxDistToRange( m_green[i], log ),
+                          db = MaxDistToRange( m_blue[i],  lob );
+            threshold = std::min( threshold, (dr * dr) + (dg * dg) + (db * db) );
+        }
+
+        m_cellbeg[cellindex] = m_candidx.size();
+        for( size_t i = 0; i < nbcolors; ++i )
+        {
+            const int32_t dr = MinDistToRange( m_red[i],   lor ),
+                          dg = MinDistToRange( m_green[i], log ),
+                          db = MinDistToRange( m_blue[i],  lob );
+            if( ((dr * dr) + (dg * dg) + (db * db)) > threshold )
+                continue;
+
+            //Skip duplicate colors, the first one always wins anyways
+            bool isdupe = false;
+            for( size_t j = m_cellbeg[cellindex]; j < m_candidx.size() && !isdupe; ++j )
+                isdupe = m_candred[j] == m_red[i] && m_candgreen[j] == m_green[i] && m_candblue[j] == m_blue[i];
+            if( isdupe )
+                continue;
+
+            m_candidx  .push_back( static_cast<uint8_t>(i) );
+            m_candred  .push_back( m_red[i]   );
+            m_candgreen.push_back( m_green[i] );
+            m_candblue .push_back( m_blue[i]  );
+        }
+        m_celllen  [cellindex] = static_cast<uint16_t>( m_candidx.size() - m_cellbeg[cellindex] );
+        m_cellbuilt[cellindex] = true;
+    }
+
+    uint8_t PaletteMatcher::FindIndex( uint8_t r, uint8_t g, uint8_t b, bool * out_isexact )
+    {
+        const uint32_t cellindex = CellIndex( r, g, b );
+        if( !m_cellbuilt[cellindex] )
+            BuildCell(cellindex);
+
+        const uint32_t  beg  = m_cellbeg[cellindex];
+        const uint32_t  len  = m_celllen[cellindex];
+        const int32_t * pr   = m_candred.data()   + beg;
+        const int32_t * pg   = m_candgreen.data() + beg;
+        const int32_t * pb   = m_candblue.data()  + beg;
+        int32_t       * pd   = m_distbuf.data();
+
+        //Compute all distances in one go, this loop has no dependencies and vectorizes well
+        for( uint32_t i = 0; i < len; ++i )
+        {
+            const int32_t dr = pr[i] - r,
+                          dg = pg[i] - g,
+                          db = pb[i] - b;
+            pd[i] = (dr * dr) + (dg * dg) + (db * db);
+        }
+
+        //Candidates are sorted by palette index, so strictly smaller keeps the lowest index on ties
+        uint32_t best = 0;
+        for( uint32_t i = 1; i < len; ++i )
+        {
+            if( pd[i] < pd[best] )
+                best = i;
+        }
+
+        if( out_isexact != nullptr )
+            (*out_isexact) = (pd[best] == 0);
+        return m_candidx[beg + best];
+    }
+
+    size_t PaletteMatcher::MapPixels( const uint8_t * prgb, size_t nbpixels, unsigned int bytesperpixel, uint8_t * pout )
+    {
+        size_t  nbinexact = 0;
+        bool    lastexact = true;
+        uint8_t lastidx   = 0;
+        uint8_t lastr     = 0,
+                lastg     = 0,
+                lastb     = 0;
+
+        for( size_t i = 0; i < nbpixels; ++i, prgb += bytesperpixel )
+        {
+            //Images tend to have long runs of the same color, so avoid looking up the same color twice in a row
+            if( i == 0 || prgb[0] != lastr || prgb[1] != lastg || prgb[2] != lastb )
+            {
+                lastr   = prgb[0];
+                lastg   = prgb[1];
+                lastb   = prgb[2];
+                lastidx = FindIndex( lastr, lastg, lastb, &lastexact );
+            }
+            pout[i] = lastidx;
+            if( !lastexact )
+                ++nbinexact;
+        }
+        return nbinexact;
+    }
+};
@@ -0,0 +1,89 @@
+#ifndef PALETTE_MATCHER_HPP
+#define PALETTE_MATCHER_HPP
+/*
+palette_matcher.hpp
+psycommando@gmail.com
+Description: Utility for quickly finding the palette index of the color closest to an arbitrary
+             RGB color. Used when importing non-indexed images, or images that use a different
+             palette than the one we need to use.
+*/
+#include <ppmdu/containers/color.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace gimg
+{
+    /*************************************************************************************************
+        PaletteMatcher
+            Finds the index of the closest color in a palette of at most 256 colors, using the
+            squared euclidean distance in RGB space.
+
+            The RGB space is split into a 32x32x32 grid, one cell per 15 bits color, which is the
+            color depth of the NDS. For each cell, we keep the short list of palette colors that
+            could possibly be the closest to any color within the cell. Lookups then only compare
+            against that list, instead of the whole palette.
+
+            Cells are built on first use, so only the cells actually used by an image cost anything.
+            Because of that, lookups modify the object and a single matcher shouldn't be shared
+            between threads.
+
+            When several palette colors are at the same distance, the lowest index is returned,
+            like a linear search from the start of the palette would.
+    *************************************************************************************************/
+    class PaletteMatcher
+    {
+    public:
+        static const unsigned int NbBitsPerCellChannel = 5;
+        static const unsigned int NbCellsPerChannel    = 1u << NbBitsPerCellChannel;
+        static const unsigned int NbCells              = NbCellsPerChannel * NbCellsPerChannel * NbCellsPerChannel;
+
+        explicit PaletteMatcher( const std::vector<colorRGB24> & palette );
+
+        /*
+            FindIndex
+                Returns the index of the palette color closest to the color specified.
+                If "out_isexact" isn't null, it's set to whether the color was exactly in the palette.
+        */
+        uint8_t        FindIndex( uint8_t r, uint8_t g, uint8_t b, bool * out_isexact = nullptr );
+        inline uint8_t FindIndex( const colorRGB24 & col, bool * out_isexact = nullptr )
+        {
+            return FindIndex( col.red, col.green, col.blue, out_isexact );
+        }
+
+        /*
+            MapPixels
+                Converts "nbpixels" pixels into palette indexes, and writes them to "pout".
+                "prgb" points to the red component of the first pixel, and each pixels are
+                "bytesperpixel" bytes apart. (3 for RGB, 4 for RGBA, etc..) Any extra components
+                after blue are ignored.
+
+                Returns the amount of pixels that had no exact match in the palette.
+        */
+        size_t MapPixels( const uint8_t * prgb, size_t nbpixels, unsigned int bytesperpixel, uint8_t * pout );
+
+        inline size_t size()const { return m_red.size(); }
+
+    private:
+        void BuildCell( uint32_t cellindex );
+
+        //The palette colors, one array per component, so distances are computed over contiguous memory.
+        std::vector<int32_t>  m_red;
+        std::vector<int32_t>  m_green;
+        std::vector<int32_t>  m_blue;
+
+        //For each cell, the offset and length of its candidate list in the arrays below.
+        std::vector<uint32_t> m_cellbeg;
+        std::vector<uint16_t> m_celllen;
+        std::vector<bool>     m_cellbuilt;
+
+        //All candidate lists put back to back.
+        std::vector<uint8_t>  m_candidx;
+        std::vector<int32_t>  m_candred;
+        std::vector<int32_t>  m_candgreen;
+        std::vector<int32_t>  m_candblue;
+
+        std::vector<int32_t>  m_distbuf; //Scratch buffer for distance computation
+    };
+};
+
+#endif
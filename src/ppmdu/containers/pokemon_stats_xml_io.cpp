@@ -109,6 +109,9 @@ namespace pmd2 {namespace stats
 //  Classes
 //===============================================================================================
 
+    //Each pokemon's file is written straight to disk as it's built
+    typedef XMLStreamWriter::node xmlwnode_t;
+
     /***************************************************************************************
         PokemonDB_XMLWriter
             Writes a pokemon DB objects to XML. This is a single-use object/state.
@@ -180,10 +183,10 @@ namespace pmd2 {namespace stats
 
         stringstream & MakeFilename( stringstream & out_fname, const string & outpathpre, unsigned int cntpkmn )
         {
-            const string * pfstr = nullptr;
-            if( !m_bNoStrings && (pfstr = m_pgametext->GetDefaultLanguage().GetStringIfBlockExists( eStringBlocks::PkmnNames, cntpkmn )) )
+            utils::StrView fstr;
+            if( !m_bNoStrings && m_pgametext->GetDefaultLanguage().GetStringIfBlockExists( eStringBlocks::PkmnNames, cntpkmn, fstr ) )
             {
-                out_fname <<outpathpre <<setw(4) <<setfill('0') <<cntpkmn <<"_" <<PreparePokeNameFName(*pfstr, m_pgametext->begin()->first) <<".xml";
+                out_fname <<outpathpre <<setw(4) <<setfill('0') <<cntpkmn <<"_" <<PreparePokeNameFName(fstr, m_pgametext->begin()->first) <<".xml";
             }
             else
                 out_fname <<outpathpre <<setw(4) <<setfill('0') <<cntpkmn <<".xml";
@@ -212,8 +215,8 @@ namespace pmd2 {namespace stats
                 //else
                 //    sstrfname <<outpathpre <<setw(4) <<setfill('0') <<cntpkmn <<".xml";
 
-                xml_document doc;
-                xml_node     pknode = doc.append_child( ROOT_Pkmn.c_str() );
+                XMLStreamWriter writer( sstrfname.str() );
+                xmlwnode_t      pknode = writer.Root().append_child( ROOT_Pkmn.c_str() );
 
                 if( m_src.isEoSData() )
                     AppendAttribute( pknode, ATTR_GameVer, GameVersion_EoS );
@@ -222,12 +225,11 @@ namespace pmd2 {namespace stats
 
                 WriteAPokemon( m_src[cntpkmn], pknode, cntpkmn );
 
-                if( ! doc.save_file( sstrfname.str().c_str() ) )
-                    throw std::runtime_error("Can't write xml file " + sstrfname.str());
+                writer.Close();
             }
         }
 
-        void WriteAPokemon( const CPokemon & pkmn, xml_node & pknode, unsigned int pkindex )
+        void WriteAPokemon( const CPokemon & pkmn, xmlwnode_t pknode, unsigned int pkindex )
         {
             using namespace pkmnXML;
             //Write strings block
@@ -236,14 +238,14 @@ namespace pmd2 {namespace stats
 
             //Write Gender entity 1
             WriteCommentNode( pknode, "Primary gender entity" );
-            xml_node genderent1 = pknode.append_child( NODE_GenderEnt.c_str() );
+            xmlwnode_t genderent1 = pknode.append_child( NODE_GenderEnt.c_str() );
             WriteMonsterData( pkmn.MonsterDataGender1(), genderent1 );
 
             if( pkmn.Has2GenderEntries() )
             {
                 //Write Gender entity 2
                 WriteCommentNode( pknode, "Secondary gender entity" );
-                xml_node genderent2 = pknode.append_child( NODE_GenderEnt.c_str() );
+                xmlwnode_t genderent2 = pknode.append_child( NODE_GenderEnt.c_str() );
                 WriteMonsterData( pkmn.MonsterDataGender2(), genderent2 );
             }
 
@@ -261,27 +263,27 @@ namespace pmd2 {namespace stats
             WriteStatsGrowth( pkmn.StatsGrowth(), pknode );
         }
 
-        void WriteStrings( xml_node & pn, unsigned int pkindex )
+        void WriteStrings( xmlwnode_t pn, unsigned int pkindex )
         {
             using namespace pkmnXML;
-            xml_node strnode = pn.append_child( NODE_Strings.c_str() );
+            xmlwnode_t strnode = pn.append_child( NODE_Strings.c_str() );
 
             //Add all loaded languages
             for( const auto & alang : *m_pgametext )
             {
-                xml_node langnode = strnode.append_child( GetGameLangName(alang.first).c_str() );
+                xmlwnode_t langnode = strnode.append_child( GetGameLangName(alang.first).c_str() );
                 //Write Name
-                const string * pname = alang.second.GetStringIfBlockExists(eStringBlocks::PkmnNames,pkindex);
-                if( pname )
-                    WriteNodeWithValue( langnode, PROP_Name, utils::StrRemoveAfter( *pname, "\\0" ) ); //remove ending \0
+                utils::StrView name;
+                if( alang.second.GetStringIfBlockExists(eStringBlocks::PkmnNames,pkindex,name) )
+                    WriteNodeWithValue( langnode, PROP_Name, utils::StrRemoveAfter( name, "\\0" ) ); //remove ending \0
                 //Write Category
-                const string * pcat = alang.second.GetStringIfBlockExists(eStringBlocks::PkmnCats,pkindex);
-                if( pcat )
-                    WriteNodeWithValue( langnode, PROP_Category, utils::StrRemoveAfter( *pcat, "\\0" ) ); //remove ending \0
+                utils::StrView cat;
+                if( alang.second.GetStringIfBlockExists(eStringBlocks::PkmnCats,pkindex,cat) )
+                    WriteNodeWithValue( langnode, PROP_Category, utils::StrRemoveAfter( cat, "\\0" ) ); //remove ending \0
             }
         }
 
-        void WriteMonsterData( const PokeMonsterData & md, xml_node & pn )
+        void WriteMonsterData( const PokeMonsterData & md, xmlwnode_t pn )
         {
             using namespace pkmnXML;
             WriteNodeWithValue( pn, PROP_PokeID, md.pokeID)     ;
@@ -291,7 +293,7 @@ namespace pmd2 {namespace stats
 
             //Evolution data
             //{
-                xml_node evorq = pn.append_child( NODE_EvoReq.c_str() );
+                xmlwnode_t evorq = pn.append_child( NODE_EvoReq.c_str() );
                 WriteNodeWithValue( evorq, PROP_PreEvo,    md.evoData.preEvoIndex) ;
                 WriteNodeWithValue( evorq, PROP_EvoMeth,   md.evoData.evoMethod)   ;
                 WriteNodeWithValue( evorq, PROP_EvoParam1, md.evoData.evoParam1)   ;
@@ -316,7 +318,7 @@ namespace pmd2 {namespace stats
 
             //Base stats data
             //{
-                xml_node bstats = pn.append_child( NODE_BaseStats.c_str() );
+                xmlwnode_t bstats = pn.append_child( NODE_BaseStats.c_str() );
                 WriteNodeWithValue( bstats, PROP_HP,    md.baseHP)    ;
                 WriteNodeWithValue( bstats, PROP_Atk,   md.baseAtk)   ;
                 WriteNodeWithValue( bstats, PROP_SpAtk, md.baseSpAtk) ;
@@ -336,7 +338,7 @@ namespace pmd2 {namespace stats
 
             //Exclusive items data
             //{
-                xml_node exclusive = pn.append_child( NODE_ExItems.c_str() );
+                xmlwnode_t exclusive = pn.append_child( NODE_ExItems.c_str() );
                 for( const auto & exitem : md.exclusiveItems )
                     WriteNodeWithValue( exclusive, PROP_ExItemID, exitem) ;
             //}
@@ -347,10 +349,10 @@ namespace pmd2 {namespace stats
             WriteNodeWithValue( pn, PROP_Unk30, FastTurnIntToHexCStr(md.unk30) );
         }
 
-        void WriteStatsGrowth( const PokeStatsGrowth & sg, xml_node & pn )
+        void WriteStatsGrowth( const PokeStatsGrowth & sg, xmlwnode_t pn )
         {
             using namespace pkmnXML;
-            xml_node growthnode = pn.append_child( NODE_SGrowth.c_str() );
+            xmlwnode_t growthnode = pn.append_child( NODE_SGrowth.c_str() );
 
             //Write every levels
             for( unsigned int i = 0; i < sg.size(); ++i )
@@ -361,7 +363,7 @@ namespace pmd2 {namespace stats
                 WriteCommentNode( growthnode, buflvl.data() );
 
                 //Write lvl-up data
-                xml_node lvlnode = growthnode.append_child( NODE_Level.c_str() );
+                xmlwnode_t lvlnode = growthnode.append_child( NODE_Level.c_str() );
                 //Exp Required
                 WriteNodeWithValue( lvlnode, PROP_ExpReq, FastTurnIntToCStr( sg[i].first) );
 
@@ -374,20 +376,20 @@ namespace pmd2 {namespace stats
             }
         }
 
-        void WriteMoveSet( const PokeMoveSet & mv, xml_node & pn )
+        void WriteMoveSet( const PokeMoveSet & mv, xmlwnode_t pn )
         {
             using namespace pkmnXML;
-            xml_node mvsetnode = pn.append_child( NODE_Moveset.c_str() );
+            xmlwnode_t mvsetnode = pn.append_child( NODE_Moveset.c_str() );
             array<char,32> commentbuf = {0};
 
             sprintf_s( commentbuf.data(), commentbuf.size(), "Learns %i move(s)", mv.lvlUpMoveSet.size() );
             WriteCommentNode( mvsetnode, commentbuf.data() );
 
             //Level-up moves
-            xml_node lvlupnode = mvsetnode.append_child( NODE_LvlUpMv.c_str() );
+            xmlwnode_t lvlupnode = mvsetnode.append_child( NODE_LvlUpMv.c_str() );
             for( const auto & lvlupmv : mv.lvlUpMoveSet )
             {
-                xml_node learnnode = lvlupnode.append_child( PROP_Learn.c_str() );
+                xmlwnode_t learnnode = lvlupnode.append_child( PROP_Learn.c_str() );
                 WriteNodeWithValue( learnnode, PROP_Level,  FastTurnIntToCStr(lvlupmv.first)  );
                 WriteNodeWithValue( learnnode, PROP_MoveID, FastTurnIntToCStr(lvlupmv.second) );
             }
@@ -396,7 +398,7 @@ namespace pmd2 {namespace stats
             WriteCommentNode( mvsetnode, commentbuf.data() );
 
             //Egg Moves
-            xml_node eggnode = mvsetnode.append_child( NODE_EggMv.c_str() );
+            xmlwnode_t eggnode = mvsetnode.append_child( NODE_EggMv.c_str() );
             for( const auto & eggmv : mv.eggmoves )
                 WriteNodeWithValue( eggnode, PROP_MoveID, FastTurnIntToCStr(eggmv) );
 
@@ -404,7 +406,7 @@ namespace pmd2 {namespace stats
             WriteCommentNode( mvsetnode, commentbuf.data() );
 
             //HM/TM moves
-            xml_node tmnode = mvsetnode.append_child( NODE_HMTMMv.c_str() );
+            xmlwnode_t tmnode = mvsetnode.append_child( NODE_HMTMMv.c_str() );
             for( const auto & tmmv : mv.teachableHMTMs )
                 WriteNodeWithValue( tmnode, PROP_MoveID, FastTurnIntToCStr(tmmv) );
         }
@@ -723,19 +725,15 @@ namespace pmd2 {namespace stats
                 {
                     string pkname = curnode.child_value();
                     pkname += "\\0"; //put back the \0
-                    string * pstr = langstr->second.GetStringIfBlockExists( eStringBlocks::PkmnNames, cntpkmn );
-                    if(!pstr)
+                    if( !langstr->second.SetStringIfBlockExists( eStringBlocks::PkmnNames, cntpkmn, pkname ) )
                         throw std::runtime_error("PokemonDB_XMLParser::ReadLangStrings(): Couldn't access the pokemon name string block!");
-                    *(pstr) = pkname;
                 }
                 else if( curnode.name() == PROP_Category )
                 {
                     string pkcat = curnode.child_value();
                     pkcat += "\\0"; //put back the \0
-                    string * pstr = langstr->second.GetStringIfBlockExists( eStringBlocks::PkmnCats, cntpkmn );
-                    if(!pstr)
+                    if( !langstr->second.SetStringIfBlockExists( eStringBlocks::PkmnCats, cntpkmn, pkcat ) )
                         throw std::runtime_error("PokemonDB_XMLParser::ReadLangStrings(): Couldn't access the pokemon category name string block!");
-                    *(pstr) = pkcat;
                 }
             }
         }
@@ -3,6 +3,7 @@
 #include <ppmdu/fmts/lsd.hpp>
 #include <ppmdu/fmts/ssa.hpp>
 #include <ppmdu/fmts/ssb.hpp>
+#include <limits>
 using namespace std;
 
 
@@ -56,12 +57,45 @@ namespace pmd2
         return eScrDataTy::Invalid;
     }
 
+//==============================================================================
+//  ScriptStringPool
+//==============================================================================
+    ScriptStringPool::strid_t ScriptStringPool::Append( const std::string & str )
+    {
+        //Offsets are stored on 32 bits, which is plenty for a single level
+        if( (m_buffer.size() + str.size() + 1) > std::numeric_limits<uint32_t>::max() )
+            throw std::length_error("ScriptStringPool::Append(): The string pool is full!");
+
+        strid_t id;
+        id.beg = static_cast<uint32_t>(m_buffer.size());
+        id.len = static_cast<uint32_t>(str.size());
+        m_buffer.insert( m_buffer.end(), str.begin(), str.end() );
+        m_buffer.push_back(0);
+        return id;
+    }
+
+    ScriptStringPool::strid_t ScriptStringPool::Intern( const std::string & str )
+    {
+        const size_t strhash = std::hash<std::string>()(str);
+        auto         range   = m_interned.equal_range(strhash);
+        for( auto it = range.first; it != range.second; ++it )
+        {
+            if( it->second.len == str.size() && std::equal( str.begin(), str.end(), m_buffer.begin() + it->second.beg ) )
+                return it->second;
+        }
+        strid_t id = Append(str);
+        m_interned.emplace( strhash, id );
+        return id;
+    }
+
 //==============================================================================
 //  Script
 //==============================================================================
+    //The string tables only refer to strings in the pool, so copies share the pool too.
     Script::Script(const Script & tocopy)
         :m_name(tocopy.m_name),
          m_groups(tocopy.m_groups), 
+         m_strpool(tocopy.m_strpool),
          m_strtable(tocopy.m_strtable),
          m_contants(tocopy.m_contants)
     {}
@@ -69,6 +103,7 @@ namespace pmd2
     Script::Script(Script      && tomove)
         :m_name(std::move(tomove.m_name)),
          m_groups(std::move(tomove.m_groups)), 
+         m_strpool(std::move(tomove.m_strpool)),
          m_strtable(std::move(tomove.m_strtable)),
          m_contants(std::move(tomove.m_contants))
     {}
@@ -77,6 +112,7 @@ namespace pmd2
     {
         m_name          = tocopy.m_name;
         m_groups        = tocopy.m_groups;
+        m_strpool       = tocopy.m_strpool;
         m_strtable      = tocopy.m_strtable;
         m_contants      = tocopy.m_contants;
         return *this;
@@ -86,17 +122,13 @@ namespace pmd2
     {
         m_name          = std::move(tomove.m_name);
         m_groups        = std::move(tomove.m_groups);
+        m_strpool       = std::move(tomove.m_strpool);
         m_strtable      = std::move(tomove.m_strtable);
         m_contants      = std::move(tomove.m_contants);
         return *this;
     }
 
-    void Script::InsertStrLanguage(eGameLanguages lang, strtbl_t && strings)
-    {
-        m_strtable.insert_or_assign( lang, std::forward<strtbl_t>(strings) );
-    }
-
-    inline Script::strtbl_t * Script::StrTbl(eGameLanguages lang)
+    const Script::strtbl_t * Script::StrTbl(eGameLanguages lang) const
     {
         auto itfound = m_strtable.find(lang);
 
@@ -106,9 +138,11 @@ namespace pmd2
             return nullptr;
     }
 
-    inline const Script::strtbl_t * Script::StrTbl(eGameLanguages lang) const
+    ScriptStringPool & Script::StrPool()
     {
-        return const_cast<Script*>(this)->StrTbl(lang);
+        if( !m_strpool )
+            m_strpool = std::make_shared<ScriptStringPool>();
+        return *m_strpool;
     }
 
 /***********************************************************************************************
@@ -145,15 +179,16 @@ namespace pmd2
 //  LevelScript
 //==============================================================================
     LevelScript::LevelScript(const std::string & name)
-        :m_name(name), m_bmodified(false)
+        :m_name(name), m_strpool(std::make_shared<ScriptStringPool>()), m_bmodified(false)
     {}
 
-    LevelScript::LevelScript(const std::string & name, scriptsets_t && comp, lsdtbl_t && lsdtbl)
-        :m_name(name), m_lsdentries(std::move(lsdtbl)), m_components(std::move(comp)), m_bmodified(false)
+    LevelScript::LevelScript(const std::string & name, scriptsets_t && comp, lsdtbl_t && lsdtbl, std::shared_ptr<ScriptStringPool> strpool)
+        :m_name(name), m_lsdentries(std::move(lsdtbl)), m_components(std::move(comp)), 
+         m_strpool( (strpool)? std::move(strpool) : std::make_shared<ScriptStringPool>() ), m_bmodified(false)
     {}
 
     LevelScript::LevelScript(const LevelScript & other)
-        :m_name(other.m_name), m_components(other.m_components), m_lsdentries(other.m_lsdentries), m_bmodified(other.m_bmodified)
+        :m_name(other.m_name), m_components(other.m_components), m_lsdentries(other.m_lsdentries), m_strpool(other.m_strpool), m_bmodified(other.m_bmodified)
     {}
 
     LevelScript & LevelScript::operator=(const LevelScript & other)
@@ -161,6 +196,7 @@ namespace pmd2
         m_name          = other.m_name;
         m_components    = other.m_components; 
         m_lsdentries    = other.m_lsdentries;
+        m_strpool       = other.m_strpool;
         m_bmodified     = other.m_bmodified;
         return *this;
     }
@@ -170,6 +206,7 @@ namespace pmd2
         m_name          = std::move(other.m_name);
         m_components    = std::move(other.m_components); 
         m_lsdentries    = std::move(other.m_lsdentries);
+        m_strpool       = std::move(other.m_strpool);
         m_bmodified     = other.m_bmodified;
     }
 
@@ -178,6 +215,7 @@ namespace pmd2
         m_name          = std::move(other.m_name);
         m_components    = std::move(other.m_components); 
         m_lsdentries    = std::move(other.m_lsdentries);
+        m_strpool       = std::move(other.m_strpool);
         m_bmodified     = other.m_bmodified;
         return *this;
     }
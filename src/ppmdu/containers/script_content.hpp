@@ -8,12 +8,14 @@ psycommando@gmail.com
 */
 #include <ppmdu/pmd2/pmd2.hpp>
 #include <ppmdu/pmd2/pmd2_configloader.hpp>
+#include <utils/string_table.hpp>
 #include <cstdint>
 #include <string>
 #include <map>
 #include <unordered_map>
 #include <vector>
 #include <deque>
+#include <memory>
 
 namespace pmd2
 {
@@ -201,6 +203,63 @@ namespace pmd2
         uint16_t parameter;
     };
 
+//==========================================================================================================
+//  Script String Pool
+//==========================================================================================================
+    /***********************************************************************************************
+        ScriptStringPool
+            Stores the strings used by the scripts of a level back to back in a single character 
+            buffer, each followed by a 0. Strings are referred to by their offset and length in the 
+            buffer, so handles stay valid when the buffer grows, while views and pointers obtained 
+            from the pool are invalidated by the next insertion.
+            - Append() just copies the string at the end of the buffer. Used for dialogue, which 
+              is almost never repeated.
+            - Intern() first looks for an identical string added through Intern(), and only appends
+              if there are none. Used for constant names, which are repeated a lot.
+            Each level has its own pool, and a level is only ever handled by a single thread,
+            so there's no locking.
+    ***********************************************************************************************/
+    class ScriptStringPool
+    {
+    public:
+        struct strid_t
+        {
+            uint32_t beg;
+            uint32_t len;
+        };
+
+        strid_t Append( const std::string & str );
+        strid_t Intern( const std::string & str );
+
+        template<class _init>
+            std::vector<strid_t> Append( _init itbeg, _init itend )
+        {
+            std::vector<strid_t> ids;
+            for( ; itbeg != itend; ++itbeg )
+                ids.push_back( Append(*itbeg) );
+            return std::move(ids);
+        }
+
+        template<class _init>
+            std::vector<strid_t> Intern( _init itbeg, _init itend )
+        {
+            std::vector<strid_t> ids;
+            for( ; itbeg != itend; ++itbeg )
+                ids.push_back( Intern(*itbeg) );
+            return std::move(ids);
+        }
+
+        inline utils::StrView   operator[]( strid_t id )const { return utils::StrView( m_buffer.data() + id.beg, id.len ); }
+        inline const char     * c_str     ( strid_t id )const { return m_buffer.data() + id.beg; }
+
+        inline void             reserve( size_t nbchars )     { m_buffer.reserve(nbchars); }
+        inline size_t           size   ()const                { return m_buffer.size(); } //Size of the buffer in bytes
+
+    private:
+        std::vector<char>                           m_buffer;
+        std::unordered_multimap<size_t, strid_t>    m_interned; //Hash of the string -> interned strings with that hash
+    };
+
 //==========================================================================================================
 //  Script Container
 //==========================================================================================================
@@ -212,14 +271,15 @@ namespace pmd2
     {
     public:
         static const size_t                                     NbLang = static_cast<size_t>(eGameLanguages::NbLang);
-        typedef std::vector<std::string>                        strtbl_t;
-        typedef std::vector<std::string>                        consttbl_t;
+        typedef ScriptStringPool::strid_t                       strid_t;
+        typedef std::vector<strid_t>                            strtbl_t;
+        typedef std::vector<strid_t>                            consttbl_t;
         typedef std::deque<ScriptRoutine>                       grptbl_t;
         typedef std::unordered_map<eGameLanguages, strtbl_t>    strtblset_t;
 
         Script(){}
-        Script(const std::string & name)
-            :m_name(name)
+        Script(const std::string & name, std::shared_ptr<ScriptStringPool> strpool = nullptr)
+            :m_name(name), m_strpool(std::move(strpool))
         {}
 
         Script(const Script & tocopy);
@@ -235,22 +295,41 @@ namespace pmd2
         inline const grptbl_t                   & Routines() const   { return m_groups; }
 
         //Returns the set of all strings for all languages
-        inline strtblset_t                      & StrTblSet()         { return m_strtable; }
         inline const strtblset_t                & StrTblSet() const   { return m_strtable; }
 
-        void                                      InsertStrLanguage( eGameLanguages lang, strtbl_t && strings );
+        //Appends the strings to the script's string pool, and replaces the string table for the language.
+        template<class _init>
+            void                                  InsertStrLanguage( eGameLanguages lang, _init itbeg, _init itend )
+        {
+            m_strtable[lang] = StrPool().Append(itbeg, itend);
+        }
+
         //Returns all strings for a specific language
-        inline strtbl_t                         * StrTbl( eGameLanguages lang );
-        inline const strtbl_t                   * StrTbl( eGameLanguages lang )const;
+        const strtbl_t                          * StrTbl( eGameLanguages lang )const;
 
-        inline consttbl_t          & ConstTbl()       { return m_contants; }
         inline const consttbl_t    & ConstTbl() const { return m_contants; }
 
+        //Interns the constant names into the script's string pool, and replaces the constant table.
+        template<class _init>
+            void SetConstTbl( _init itbeg, _init itend )
+        {
+            m_contants = StrPool().Intern(itbeg, itend);
+        }
+
+        //Text of an entry of the string or constant tables. Invalidated when strings are added to the pool.
+        inline utils::StrView                             Str ( strid_t id )const { return (*m_strpool)[id]; }
+        inline const char                               * CStr( strid_t id )const { return m_strpool->c_str(id); }
+
+        //The pool the strings of the script are stored in. A pool is made on first use if the script wasn't given one.
+        ScriptStringPool                                & StrPool();
+        inline const std::shared_ptr<ScriptStringPool>  & StrPoolPtr()const { return m_strpool; }
+
     private:
-        std::string m_name;
-        grptbl_t    m_groups;
-        strtblset_t m_strtable; //Multiple deques for all languages
-        consttbl_t  m_contants;
+        std::string                         m_name;
+        grptbl_t                            m_groups;
+        std::shared_ptr<ScriptStringPool>   m_strpool;  //Owns the strings referred to by the tables below
+        strtblset_t                         m_strtable; //Multiple deques for all languages
+        consttbl_t                          m_contants;
     };
 
 //==========================================================================================================
@@ -486,7 +565,7 @@ namespace pmd2
 
         //Constructors
         LevelScript            (const std::string & name);
-        LevelScript            (const std::string & name, scriptsets_t && sets, lsdtbl_t && lsdtbl );
+        LevelScript            (const std::string & name, scriptsets_t && sets, lsdtbl_t && lsdtbl, std::shared_ptr<ScriptStringPool> strpool = nullptr );
         LevelScript            (const LevelScript   & other);
         LevelScript & operator=(const LevelScript   & other);
         LevelScript            (LevelScript        && other);
@@ -503,6 +582,9 @@ namespace pmd2
         inline lsdtbl_t            & LSDTable()                       {return m_lsdentries;}
         inline const lsdtbl_t      & LSDTable()const                  {return m_lsdentries;}
 
+        //The string pool shared by all the scripts of the level
+        inline const std::shared_ptr<ScriptStringPool> & StringPool()const { return m_strpool; }
+
         //Std methods
         inline iterator              begin()      { return m_components.begin(); }
         inline const_iterator        begin()const { return m_components.begin(); }
@@ -514,6 +596,7 @@ namespace pmd2
         std::string  m_name;         //The name of the set. Ex: "D01P11A" or "COMMON"
         scriptsets_t m_components;   //All scripts + data groups (SSA,SSS,SSE + SSB)
         lsdtbl_t     m_lsdentries;   //Entries in the LSD table Stored here for now
+        std::shared_ptr<ScriptStringPool> m_strpool; //Strings used by the scripts of the level
         bool         m_bmodified;    //Whether the content of this set was modified
     };
 };
@@ -0,0 +1,235 @@
+#include "sprite_build_cache.hpp"
+#include <utils/gbyteutils.hpp>
+#include <utils/gfileio.hpp>
+#include <ppmdu/pmd2/pmd2.hpp>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <fstream>
+#include <stdexcept>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/DirectoryIterator.h>
+#include <Poco/Exception.h>
+using namespace std;
+
+namespace pmd2{ namespace graphics
+{
+    namespace
+    {
+        const uint32_t    CacheFileMagic   = 0x43525053; //"SPRC"
+        const uint32_t    CacheFileVersion = 2;
+        const std::string CacheFileExt     = "sprcache";
+
+        //Bump this whenever the output of the WAN writer or of the PKDPX compressor changes, 
+        // so the sprites they built before are built again.
+        const uint32_t    SpriteWriterVersion = 1;
+
+        //FNV-1a
+        uint64_t HashBytes( const uint8_t * pdata, size_t len, uint64_t hash = 14695981039346656037ULL )
+        {
+            for( size_t i = 0; i < len; ++i )
+            {
+                hash ^= pdata[i];
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        uint64_t HashFileContent( const std::string & path )
+        {
+            vector<uint8_t> content = utils::io::ReadFileToByteVector(path);
+            return HashBytes( content.data(), content.size() );
+        }
+
+        //Identifies the code that built the cached bytes. Cached data from another version of the writers is never reused.
+        uint64_t MakeWriterHash()
+        {
+            uint8_t wrtver[sizeof(SpriteWriterVersion)];
+            utils::WriteIntToBytes( SpriteWriterVersion, wrtver );
+            uint64_t hash = HashBytes( wrtver, sizeof(wrtver) );
+            return HashBytes( reinterpret_cast<const uint8_t*>(PMD2ToolsetVersion.data()), PMD2ToolsetVersion.size(), hash );
+        }
+
+        //Lists all the files in the directory and its sub-directories, without hashing them
+        void ListFiles( const Poco::Path & dir, const std::string & relprefix, vector<SpriteBuildCache::fingerprint::fileinfo> & out_files )
+        {
+            Poco::DirectoryIterator itdirend;
+            for( Poco::DirectoryIterator itdir(dir); itdir != itdirend; ++itdir )
+            {
+                const string relpath = relprefix + itdir.name();
+                if( itdir->isDirectory() )
+                    ListFiles( itdir.path(), relpath + "/", out_files );
+                else if( itdir->isFile() )
+                {
+                    SpriteBuildCache::fingerprint::fileinfo finf;
+                    finf.relpath = relpath;
+                    finf.size    = static_cast<uint64_t>( itdir->getSize() );
+                    finf.mtime   = static_cast<uint64_t>( itdir->getLastModified().epochMicroseconds() );
+                    finf.hash    = 0;
+                    out_files.push_back(finf);
+                }
+            }
+        }
+
+        /*
+            Cache file layout, all integers little endian:
+                uint32 magic, uint32 version, uint64 writerhash, uint32 buildflags, uint32 nbfiles,
+                nbfiles * { uint16 pathlen, char path[pathlen], uint64 size, uint64 mtime, uint64 hash },
+                uint32 builtlen, uint8 built[builtlen]
+        */
+        vector<uint8_t> WriteCacheFile( const SpriteBuildCache::fingerprint & fprint, const vector<uint8_t> & built )
+        {
+            vector<uint8_t> out;
+            auto            itout = back_inserter(out);
+            itout = utils::WriteIntToBytes( CacheFileMagic,                                itout );
+            itout = utils::WriteIntToBytes( CacheFileVersion,                              itout );
+            itout = utils::WriteIntToBytes( MakeWriterHash(),                              itout );
+            itout = utils::WriteIntToBytes( fprint.buildflags,                             itout );
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(fprint.files.size()),    itout );
+            for( const auto & finf : fprint.files )
+            {
+                itout = utils::WriteIntToBytes( static_cast<uint16_t>(finf.relpath.size()), itout );
+                itout = std::copy( finf.relpath.begin(), finf.relpath.end(), itout );
+                itout = utils::WriteIntToBytes( finf.size,  itout );
+                itout = utils::WriteIntToBytes( finf.mtime, itout );
+                itout = utils::WriteIntToBytes( finf.hash,  itout );
+            }
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(built.size()), itout );
+            std::copy( built.begin(), built.end(), itout );
+            return std::move(out);
+        }
+
+        //Throws if the file is truncated, isn't a cache file of the current version, or was built by other writers
+        void ReadCacheFile( const vector<uint8_t> & data, SpriteBuildCache::fingerprint & out_fprint, vector<uint8_t> & out_built )
+        {
+            auto itread = data.begin();
+            auto itend  = data.end();
+            if( utils::ReadIntFromBytes<uint32_t>(itread, itend) != CacheFileMagic ||
+                utils::ReadIntFromBytes<uint32_t>(itread, itend) != CacheFileVersion )
+                throw runtime_error("SpriteBuildCache: Not a cache file, or unsupported version!");
+            if( utils::ReadIntFromBytes<uint64_t>(itread, itend) != MakeWriterHash() )
+                throw runtime_error("SpriteBuildCache: Cached data was built by a different version of the sprite writers!");
+
+            out_fprint.buildflags = utils::ReadIntFromBytes<uint32_t>(itread, itend);
+            const uint32_t nbfiles = utils::ReadIntFromBytes<uint32_t>(itread, itend);
+            out_fprint.files.resize(0);
+            for( uint32_t i = 0; i < nbfiles; ++i )
+            {
+                SpriteBuildCache::fingerprint::fileinfo finf;
+                const uint16_t pathlen = utils::ReadIntFromBytes<uint16_t>(itread, itend);
+                if( static_cast<size_t>(std::distance(itread, itend)) < pathlen )
+                    throw runtime_error("SpriteBuildCache: Cache file is truncated!");
+                finf.relpath.assign( itread, itread + pathlen );
+                itread    += pathlen;
+                finf.size  = utils::ReadIntFromBytes<uint64_t>(itread, itend);
+                finf.mtime = utils::ReadIntFromBytes<uint64_t>(itread, itend);
+                finf.hash  = utils::ReadIntFromBytes<uint64_t>(itread, itend);
+                out_fprint.files.push_back( std::move(finf) );
+            }
+
+            const uint32_t builtlen = utils::ReadIntFromBytes<uint32_t>(itread, itend);
+            if( static_cast<size_t>(std::distance(itread, itend)) != builtlen )
+                throw runtime_error("SpriteBuildCache: Cache file is truncated!");
+            out_built.assign( itread, itend );
+        }
+    };
+
+//==============================================================================================
+//  SpriteBuildCache
+//==============================================================================================
+    SpriteBuildCache::SpriteBuildCache( const std::string & cachedir )
+        :m_cachedir(cachedir)
+    {}
+
+    std::string SpriteBuildCache::MakeCacheFilePath( const std::string & spritedir )const
+    {
+        Poco::Path dirpath(spritedir);
+        dirpath.makeFile();
+        return Poco::Path(m_cachedir).makeDirectory().setFileName( dirpath.getFileName() + "." + CacheFileExt ).toString();
+    }
+
+    bool SpriteBuildCache::Fetch( const std::string & spritedir, uint32_t buildflags, std::vector<uint8_t> & out_built, fingerprint & out_fprint )
+    {
+        out_fprint.spritedir  = spritedir;
+        out_fprint.buildflags = buildflags;
+        out_fprint.files.resize(0);
+        ListFiles( Poco::Path(spritedir).makeDirectory(), "", out_fprint.files );
+        std::sort( out_fprint.files.begin(), out_fprint.files.end(), []( const fingerprint::fileinfo & a, const fingerprint::fileinfo & b ){ return a.relpath < b.relpath; } );
+
+        //Load what was cached last time, if anything
+        fingerprint     cached;
+        vector<uint8_t> cachedbuilt;
+        const string    cachefpath = MakeCacheFilePath(spritedir);
+        bool            hascached  = false;
+        if( Poco::File(cachefpath).exists() )
+        {
+            try
+            {
+                ReadCacheFile( utils::io::ReadFileToByteVector(cachefpath), cached, cachedbuilt );
+                hascached = (cached.buildflags == buildflags);
+            }
+            catch( const exception & e )
+            {
+                clog <<"<!>-Warning: SpriteBuildCache::Fetch(): Ignoring cache file \"" <<cachefpath <<"\": " <<e.what() <<"\n";
+            }
+        }
+
+        //Only hash files that changed since the last time, or that weren't there
+        bool ismatch   = hascached && (cached.files.size() == out_fprint.files.size());
+        bool istouched = false;
+        for( size_t i = 0; i < out_fprint.files.size(); ++i )
+        {
+            auto & cur = out_fprint.files[i];
+            const fingerprint::fileinfo * pold = nullptr;
+            if( hascached )
+            {
+                auto itold = std::lower_bound( cached.files.begin(), cached.files.end(), cur,
+                                               []( const fingerprint::fileinfo & a, const fingerprint::fileinfo & b ){ return a.relpath < b.relpath; } );
+                if( itold != cached.files.end() && itold->relpath == cur.relpath )
+                    pold = &(*itold);
+            }
+
+            if( pold != nullptr && pold->size == cur.size && pold->mtime == cur.mtime )
+                cur.hash = pold->hash;
+            else
+            {
+                cur.hash = HashFileContent( Poco::Path(spritedir).makeDirectory().append(cur.relpath).toString() );
+                if( pold != nullptr && pold->size == cur.size && pold->hash == cur.hash )
+                    istouched = true;
+                else
+                    ismatch = false;
+            }
+        }
+
+        if( !ismatch )
+            return false;
+
+        out_built = std::move(cachedbuilt);
+
+        //Save the new modification times, so the touched files don't get hashed again next time
+        if( istouched )
+            Store( out_fprint, out_built );
+        return true;
+    }
+
+    void SpriteBuildCache::Store( const fingerprint & fprint, const std::vector<uint8_t> & built )
+    {
+        try
+        {
+            Poco::File cachedir(m_cachedir);
+            if( !cachedir.exists() )
+                cachedir.createDirectories();
+            utils::io::WriteByteVectorToFile( MakeCacheFilePath(fprint.spritedir), WriteCacheFile(fprint, built) );
+        }
+        catch( const Poco::Exception & e )
+        {
+            clog <<"<!>-Warning: SpriteBuildCache::Store(): Couldn't write the cache for \"" <<fprint.spritedir <<"\": " <<e.displayText() <<"\n";
+        }
+        catch( const exception & e )
+        {
+            clog <<"<!>-Warning: SpriteBuildCache::Store(): Couldn't write the cache for \"" <<fprint.spritedir <<"\": " <<e.what() <<"\n";
+        }
+    }
+
+};};
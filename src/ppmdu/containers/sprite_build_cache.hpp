@@ -0,0 +1,73 @@
+#ifndef SPRITE_BUILD_CACHE_HPP
+#define SPRITE_BUILD_CACHE_HPP
+/*
+sprite_build_cache.hpp
+psycommando@gmail.com
+Description: On-disk cache of the sprites built from sprite directories, so that unchanged
+             sprites don't have to be parsed and built again on the next run.
+*/
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pmd2 { namespace graphics
+{
+    /*************************************************************************************************
+        SpriteBuildCache
+            Keeps one cache file per sprite directory, in the cache directory. Each cache file
+            contains the list of files in the sprite directory, with their size, last modification
+            time and a hash of their content, along with the bytes built from that directory.
+
+            A sprite is considered unchanged when its directory contains the same files, with the
+            same content. Files whose size and modification time didn't change aren't read again.
+            Files that were touched, but whose content is the same, don't invalidate the cache.
+
+            "buildflags" are any options that change the output for the same input. Cached data
+            built with different flags, or by a different version of the sprite writers, is never
+            reused.
+
+            Different sprite directories can be fetched and stored from different threads at the
+            same time, as long as their directory names are unique.
+    *************************************************************************************************/
+    class SpriteBuildCache
+    {
+    public:
+        //What was found in a sprite directory when looking it up. Pass it to Store() once built.
+        struct fingerprint
+        {
+            struct fileinfo
+            {
+                std::string relpath;
+                uint64_t    size;
+                uint64_t    mtime;
+                uint64_t    hash;
+            };
+            std::string           spritedir;
+            uint32_t              buildflags;
+            std::vector<fileinfo> files;
+        };
+
+        //Cache files are created in "cachedir". The directory is created when needed.
+        explicit SpriteBuildCache( const std::string & cachedir );
+
+        /*
+            Fetch
+                Returns true and fills "out_built" with the cached bytes if the sprite directory
+                didn't change since they were stored. "out_fprint" is filled in either cases.
+        */
+        bool Fetch( const std::string & spritedir, uint32_t buildflags, std::vector<uint8_t> & out_built, fingerprint & out_fprint );
+
+        //Stores the bytes built from the sprite directory described by "fprint".
+        void Store( const fingerprint & fprint, const std::vector<uint8_t> & built );
+
+        inline const std::string & getCacheDir()const { return m_cachedir; }
+
+    private:
+        std::string MakeCacheFilePath( const std::string & spritedir )const;
+
+        std::string m_cachedir;
+    };
+
+};};
+
+#endif
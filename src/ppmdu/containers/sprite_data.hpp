@@ -16,6 +16,7 @@ Description:
 #include <utility>
 #include <algorithm>
 #include <atomic>
+#include <functional>
 #include <cstdint>
 
 //Forward declare for the friendly io modules !
@@ -464,7 +465,7 @@ namespace pmd2{ namespace graphics
 
     public:
         typedef TIMG_Type img_t; 
-        inline const std::vector<img_t>                & getFrames      ()const { return m_frames;        }
+        inline const std::vector<img_t>                & getFrames      ()const { DecodeFrames(); return m_frames; }
 
         virtual const std::vector<sprOffParticle>      & getPartOffsets ()const { return m_partOffsets;   } 
         virtual const std::multimap<uint32_t,uint32_t> & getMetaRefs    ()const { return m_metarefs;      }
@@ -474,7 +475,7 @@ namespace pmd2{ namespace graphics
         virtual const std::vector<AnimationSequence>   & getAnimSequences()const{ return m_animSequences; }
         virtual const std::vector<gimg::colorRGB24>    & getPalette     ()const { return m_palette;       }
         virtual const SprInfo                          & getSprInfo     ()const { return m_common;        }
-        virtual const std::vector<ImageInfo>           & getImgsInfo    ()const { return m_imgsinfo;      }
+        virtual const std::vector<ImageInfo>           & getImgsInfo    ()const { DecodeFrames(); return m_imgsinfo; }
 
         virtual std::vector<sprOffParticle>            & getPartOffsets ()      { return m_partOffsets;   } 
         virtual std::vector<MetaFrame>                 & getMetaFrames  ()      { return m_metaframes;    }
@@ -483,7 +484,7 @@ namespace pmd2{ namespace graphics
         virtual std::vector<AnimationSequence>         & getAnimSequences()     { return m_animSequences; }
         virtual std::vector<gimg::colorRGB24>          & getPalette     ()      { return m_palette;       }
         virtual SprInfo                                & getSprInfo     ()      { return m_common;        }
-        virtual std::vector<ImageInfo>                 & getImgsInfo    ()      { return m_imgsinfo;      }
+        virtual std::vector<ImageInfo>                 & getImgsInfo    ()      { DecodeFrames(); return m_imgsinfo; }
 
         //Get the data format of the sprite
         virtual const eSpriteImgType & getSpriteType()const { return MY_SPRITE_TYPE; }
@@ -492,11 +493,13 @@ namespace pmd2{ namespace graphics
 
         virtual std::vector<gimg::tiled_image_i8bpp> * getFramesAs8bpp() 
         { 
+            DecodeFrames();
             return GetMyFramePtr<SpriteData<img_t>, std::vector<gimg::tiled_image_i8bpp>>(const_cast<SpriteData<img_t>*>(this)); 
         }
 
         virtual std::vector<gimg::tiled_image_i4bpp> * getFramesAs4bpp() 
         { 
+            DecodeFrames();
             return GetMyFramePtr<SpriteData<img_t>, std::vector<gimg::tiled_image_i4bpp>>(const_cast<SpriteData<img_t>*>(this)); 
         }
 
@@ -525,6 +528,27 @@ namespace pmd2{ namespace graphics
             }
 
 
+        /*
+            Lazy frame decoding
+                Sprites parsed without decoding their images keep a function that decodes them.
+                It's called the first time the frames or the image info are accessed, or when 
+                DecodeFrames() is called. Everything else is available right away.
+
+                Decoding modifies the sprite, so a sprite with undecoded frames shouldn't be
+                accessed from several threads until DecodeFrames() was called.
+        */
+        inline bool AreFramesDecoded()const { return !m_framedecoder; }
+
+        void DecodeFrames()const
+        {
+            if( !m_framedecoder )
+                return;
+            SpriteData<TIMG_Type> * ptrme = const_cast<SpriteData<TIMG_Type>*>(this);
+            auto decoder = std::move(ptrme->m_framedecoder);
+            ptrme->m_framedecoder = nullptr;
+            decoder(*ptrme);
+        }
+
         /*
             Rebuilds the entire reference maps for everything currently in the sprite!
         */
@@ -644,6 +668,8 @@ namespace pmd2{ namespace graphics
             m_common         = std::move( other.m_common         );
             m_partOffsets    = std::move( other.m_partOffsets    );
             m_imgsinfo       = std::move( other.m_imgsinfo       );
+            m_framedecoder   = std::move( other.m_framedecoder   );
+            other.m_framedecoder = nullptr;
         }
 
         SpriteData<TIMG_Type> & operator=( SpriteData<TIMG_Type> && other )
@@ -658,6 +684,8 @@ namespace pmd2{ namespace graphics
             m_common         = std::move( other.m_common         );
             m_partOffsets    = std::move( other.m_partOffsets    );
             m_imgsinfo       = std::move( other.m_imgsinfo       );
+            m_framedecoder   = std::move( other.m_framedecoder   );
+            other.m_framedecoder = nullptr;
             return *this;
         }
 
@@ -678,6 +706,7 @@ namespace pmd2{ namespace graphics
         SprInfo                              m_common;          //Common properties about the sprite not affected by template type!
         std::vector<sprOffParticle>          m_partOffsets;     //The particle offsets list
         std::vector<ImageInfo>               m_imgsinfo;        //Data about the actual images. Things like the Z index. 
+        std::function<void(SpriteData<TIMG_Type>&)> m_framedecoder; //If not empty, the frames haven't been decoded yet. See DecodeFrames().
 
     private:
         ////We don't wanna copy
@@ -7,6 +7,9 @@
 #include <utils/library_wide.hpp>
 #include <vector>
 #include <string>
+#include <cmath>
+#include <limits>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -50,16 +53,7 @@ namespace pmd2{ namespace graphics
     **************************************************************/
     bool AreReqFilesPresent_Sprite( const std::vector<std::string> & filelist )
     {
-        for( const auto & filename : SpriteBuildingRequiredFiles )
-        {
-            auto itfound = std::find( filelist.begin(), filelist.end(), filename );
-
-            if( itfound == filelist.end() )
-                return false;
-        }
-
-        //The palette isn't required in most cases
-        return true;
+        return GetMissingRequiredFiles_Sprite(filelist).empty();
     }
 
     /**************************************************************
@@ -80,10 +74,15 @@ namespace pmd2{ namespace graphics
         {
             auto itfound = std::find( filelist.begin(), filelist.end(), filename );
 
+            //The images can be in an atlas instead of the image directory
+            if( itfound == filelist.end() && filename == (SPRITE_IMGs_DIR+"/") )
+                itfound = std::find( filelist.begin(), filelist.end(), SPRITE_AtlasIndex_fname );
+
             if( itfound == filelist.end() )
                 missingf.push_back( filename );
         }
 
+        //The palette isn't required in most cases
         return std::move( missingf );
     }
 
@@ -95,6 +94,80 @@ namespace pmd2{ namespace graphics
         return GetMissingRequiredFiles_Sprite( dircontent );
     }
 
+    /**************************************************************
+    **************************************************************/
+    bool IsSpriteDirUsingAtlas( const std::string & dirpath )
+    {
+        return !Poco::File( Poco::Path(dirpath).append(SPRITE_IMGs_DIR) ).exists() &&
+                Poco::File( Poco::Path(dirpath).append(SPRITE_AtlasIndex_fname) ).exists();
+    }
+
+    /**************************************************************
+        Simple shelf packing. Sprite frames are all small, and of
+        only a handful of sizes, so sorting them by height and
+        filling rows of a roughly square image wastes little space.
+    **************************************************************/
+    std::vector<SpriteAtlasRect> PackSpriteAtlas( const std::vector<utils::Resolution> & frmsres, utils::Resolution & out_atlasres )
+    {
+        static const uint32_t TileSz = 8;
+        vector<SpriteAtlasRect> rects( frmsres.size() );
+        vector<size_t>          order( frmsres.size() );
+        uint64_t                totalarea = 0;
+        uint32_t                maxwidth  = 0;
+
+        for( size_t i = 0; i < frmsres.size(); ++i )
+        {
+            if( (frmsres[i].width % TileSz) != 0 || (frmsres[i].height % TileSz) != 0 )
+            {
+                stringstream sstr;
+                sstr << "PackSpriteAtlas(): Frame #" <<i <<" has a resolution of " <<frmsres[i].width <<"x" <<frmsres[i].height 
+                     <<", which isn't divisible by " <<TileSz <<"!";
+                throw runtime_error(sstr.str());
+            }
+            order[i]   = i;
+            totalarea += static_cast<uint64_t>(frmsres[i].width) * frmsres[i].height;
+            maxwidth   = std::max( maxwidth, frmsres[i].width );
+        }
+
+        std::stable_sort( order.begin(), order.end(), [&frmsres]( size_t a, size_t b )
+        {
+            return frmsres[a].height > frmsres[b].height || 
+                   (frmsres[a].height == frmsres[b].height && frmsres[a].width > frmsres[b].width);
+        });
+
+        uint32_t atlaswidth = static_cast<uint32_t>( std::ceil( std::sqrt( static_cast<double>(totalarea) ) ) );
+        atlaswidth          = std::max( maxwidth, ((atlaswidth + TileSz - 1) / TileSz) * TileSz );
+
+        uint32_t curx   = 0;
+        uint32_t cury   = 0;
+        uint32_t shelfh = 0;
+        for( size_t idx : order )
+        {
+            const utils::Resolution & res = frmsres[idx];
+            if( res.width == 0 || res.height == 0 )
+                continue;   //Empty frames take no space
+
+            if( (curx + res.width) > atlaswidth )
+            {
+                cury  += shelfh;
+                curx   = 0;
+                shelfh = 0;
+            }
+            rects[idx].x      = static_cast<uint16_t>(curx);
+            rects[idx].y      = static_cast<uint16_t>(cury);
+            rects[idx].width  = static_cast<uint16_t>(res.width);
+            rects[idx].height = static_cast<uint16_t>(res.height);
+            curx  += res.width;
+            shelfh = std::max( shelfh, res.height );
+        }
+
+        out_atlasres.width  = (totalarea != 0)? atlaswidth : 0;
+        out_atlasres.height = cury + shelfh;
+        if( out_atlasres.width > std::numeric_limits<uint16_t>::max() || out_atlasres.height > std::numeric_limits<uint16_t>::max() )
+            throw runtime_error("PackSpriteAtlas(): The frames are too big to fit in an atlas image!");
+        return std::move(rects);
+    }
+
     /**************************************************************
     **************************************************************/
     bool Sprite_IsResolutionValid( uint8_t width, uint8_t height )
@@ -123,7 +196,8 @@ namespace pmd2{ namespace graphics
         void WriteSpriteToDir( const string          & folderpath, 
                                eSUPPORT_IMG_IO         imgty, 
                                bool                    xmlcolorpal = false/*, 
-                               std::atomic<uint32_t> * progresscnt = nullptr*/ ) 
+                               std::atomic<uint32_t> * progresscnt = nullptr*/,
+                               bool                    asatlas     = false ) 
         {
             //Create Root Folder
             m_outDirPath = Poco::Path(folderpath);
@@ -149,7 +223,10 @@ namespace pmd2{ namespace graphics
             stats.totalAnimFrms = totalnbfrms;
             stats.totalAnimSeqs = totalnbseqs;
 
-            ExportFrames(imgty, stats.propFrames );
+            if( asatlas )
+                ExportFramesAsAtlas(imgty);
+            else
+                ExportFrames(imgty, stats.propFrames );
 
             if( !xmlcolorpal )
                 ExportPalette();
@@ -192,6 +269,59 @@ namespace pmd2{ namespace graphics
             };
         }
 
+        /**************************************************************
+            Writes all frames into a single image in the sprite's 
+            directory, along with the index of where each frames are.
+        **************************************************************/
+        void ExportFramesAsAtlas( eSUPPORT_IMG_IO imgty )
+        {
+            typedef typename sprite_t::img_t::tile_t tile_t;
+            const auto &              frames = m_inSprite.getFrames();
+            vector<utils::Resolution> frmsres;
+            frmsres.reserve( frames.size() );
+            for( const auto & frm : frames )
+                frmsres.push_back( utils::Resolution{ frm.getNbPixelWidth(), frm.getNbPixelHeight() } );
+
+            SpriteAtlasIndex  atlasidx;
+            utils::Resolution atlasres{0,0};
+            atlasidx.frames = PackSpriteAtlas( frmsres, atlasres );
+
+            if( imgty == eSUPPORT_IMG_IO::BMP )
+                atlasidx.imgfname = SPRITE_Atlas_basename + "." + utils::io::BMP_FileExtension;
+            else
+                atlasidx.imgfname = SPRITE_Atlas_basename + "." + utils::io::PNG_FileExtension;
+
+            if( !frames.empty() )
+            {
+                typename sprite_t::img_t atlas;
+                atlas.setPixelResolution( atlasres.width, atlasres.height );
+                atlas.getPalette() = frames.front().getPalette();
+
+                //Frames are placed on tile boundaries, so we can copy them a tile at a time
+                for( size_t i = 0; i < frames.size(); ++i )
+                {
+                    const auto            & frm  = frames[i];
+                    const SpriteAtlasRect & rect = atlasidx.frames[i];
+                    for( unsigned int row = 0; row < (rect.height / tile_t::HEIGHT); ++row )
+                    {
+                        for( unsigned int col = 0; col < (rect.width / tile_t::WIDTH); ++col )
+                            atlas.getTile( (rect.x / tile_t::WIDTH) + col, (rect.y / tile_t::HEIGHT) + row ) = frm.getTile( col, row );
+                    }
+                }
+
+                const string atlaspath = Poco::Path(m_outDirPath).append(atlasidx.imgfname).toString();
+                if( imgty == eSUPPORT_IMG_IO::BMP )
+                    utils::io::ExportToBMP( atlas, atlaspath );
+                else
+                    utils::io::ExportToPNG( atlas, atlaspath );
+
+                if( utils::LibWide().isLogOn() )
+                    clog << "Exported " <<frames.size() <<" frames to atlas " <<atlasres.width <<"x" <<atlasres.height <<", " <<atlaspath <<"\n";
+            }
+
+            WriteSpriteAtlasIndex( atlasidx, m_outDirPath.toString() );
+        }
+
         /**************************************************************
         **************************************************************/
         void ExportFramesAsPNGs( const Poco::Path & outdirpath, uint32_t proportionofwork )
@@ -324,26 +454,35 @@ namespace pmd2{ namespace graphics
             //!! This must run first !!
             m_inDirPath = Poco::Path( directorypath );
             /*m_pProgress = pProgress;*/
-            auto validimgslist = ListValidImages(readImgByIndex);
+            const bool         useatlas = IsSpriteDirUsingAtlas(directorypath);
+            SpriteAtlasIndex   atlasidx;
+            vector<Poco::File> validimgslist;
+            if( useatlas )
+                atlasidx = ParseSpriteAtlasIndex(directorypath);
+            else
+                validimgslist = ListValidImages(readImgByIndex);
 
             //Parse the xml first to help with reading image with some formats
-            ParseXML(parsexmlpal, validimgslist.size() );
-            ReadImages(validimgslist);
+            ParseXML(parsexmlpal, (useatlas)? atlasidx.frames.size() : validimgslist.size() );
+
+            //Load the palette file before the images, so non-indexed images can be remapped to it
+            Poco::File palettef( (Poco::Path(directorypath).append(SPRITE_Palette_fname)) );
+            if( !parsexmlpal && palettef.exists() && palettef.isFile() )
+                m_outSprite.m_palette = utils::io::ImportFrom_RIFF_Palette( palettef.path() );
+
+            if( useatlas )
+                ReadAtlas(atlasidx);
+            else
+                ReadImages(validimgslist);
 
             //Check and fix missing/differing resolution between meta-frames and images
             if( !bNoResAutoFix )
                 CheckForMissingResolution();
 
-            if( !parsexmlpal )
+            if( !parsexmlpal && m_outSprite.m_palette.empty() )
             {
-                //See if we have a palette
-                Poco::File palettef( (Poco::Path(directorypath).append(SPRITE_Palette_fname)) );
-
-                if( palettef.exists() && palettef.isFile() )
-                {
-                    m_outSprite.m_palette = utils::io::ImportFrom_RIFF_Palette( palettef.path() );
-                }
-                else if( !( m_outSprite.m_frames.empty() ) )
+                //If we don't have a palette file
+                if( !( m_outSprite.m_frames.empty() ) )
                 {
                     //If not, use the first image's palette 
                     m_outSprite.m_palette = m_outSprite.m_frames.front().getPalette();
@@ -484,19 +623,76 @@ namespace pmd2{ namespace graphics
             }
         }
 
+        /**************************************************************
+            Cuts the frames out of the atlas image.
+        **************************************************************/
+        void ReadAtlas( const SpriteAtlasIndex & atlasidx )
+        {
+            typedef typename sprite_t::img_t::tile_t tile_t;
+            if( atlasidx.frames.empty() )
+                return;
+
+            typename sprite_t::img_t atlas;
+            Poco::File               atlasfile( Poco::Path(m_inDirPath).append(atlasidx.imgfname) );
+            ReadImageFile( atlasfile, atlas );
+
+            m_outSprite.m_frames.reserve( atlasidx.frames.size() );
+            for( size_t i = 0; i < atlasidx.frames.size(); ++i )
+            {
+                const SpriteAtlasRect & rect = atlasidx.frames[i];
+                if( (rect.x % tile_t::WIDTH) != 0 || (rect.y % tile_t::HEIGHT) != 0 || (rect.width % tile_t::WIDTH) != 0 || (rect.height % tile_t::HEIGHT) != 0 ||
+                    (rect.x + rect.width) > atlas.getNbPixelWidth() || (rect.y + rect.height) > atlas.getNbPixelHeight() )
+                {
+                    stringstream sstrerr;
+                    sstrerr << "ERROR: Frame #" <<i <<" in the atlas index, at (" <<rect.x <<"," <<rect.y <<") " <<rect.width <<"x" <<rect.height
+                            <<", isn't aligned on " <<tile_t::WIDTH <<"x" <<tile_t::HEIGHT <<" tiles, or is out of the bounds of atlas image " <<atlasfile.path() <<"!";
+                    throw runtime_error(sstrerr.str());
+                }
+
+                typename sprite_t::img_t curfrm;
+                curfrm.setPixelResolution( rect.width, rect.height );
+                curfrm.getPalette() = atlas.getPalette();
+                for( unsigned int row = 0; row < (rect.height / tile_t::HEIGHT); ++row )
+                {
+                    for( unsigned int col = 0; col < (rect.width / tile_t::WIDTH); ++col )
+                        curfrm.getTile( col, row ) = atlas.getTile( (rect.x / tile_t::WIDTH) + col, (rect.y / tile_t::HEIGHT) + row );
+                }
+                m_outSprite.m_frames.push_back( std::move(curfrm) );
+            }
+        }
+
         /**************************************************************
         **************************************************************/
         void ReadAnImage( const Poco::File & imgfile )
         {
-            Poco::Path               imgpath(imgfile.path());
             typename sprite_t::img_t curfrm;
+            ReadImageFile( imgfile, curfrm );
+            m_outSprite.m_frames.push_back( std::move(curfrm) );
+        }
+
+        /**************************************************************
+        **************************************************************/
+        void ReadImageFile( const Poco::File & imgfile, typename sprite_t::img_t & curfrm )
+        {
+            Poco::Path               imgpath(imgfile.path());
 
             //Proceed to validate the file and find out what to use to handle it!
             switch( utils::io::GetSupportedImageType( imgpath.getFileName() ) )
             {
                 case eSUPPORT_IMG_IO::PNG:
                 {
-                    utils::io::ImportFromPNG( curfrm, imgfile.path() );
+                    //Non-indexed images are remapped to the sprite's palette, if we already have one
+                    if( !m_outSprite.m_palette.empty() && !utils::io::GetPNGImgInfo( imgfile.path() ).usesPalette )
+                    {
+                        size_t nbinexact = utils::io::ImportFromPNGAndRemap( curfrm, imgfile.path(), m_outSprite.m_palette );
+                        if( nbinexact != 0 )
+                        {
+                            cerr << "\n<!>-Warning: Image " <<imgfile.path() <<" isn't indexed, and " <<nbinexact 
+                                 <<" of its pixels had colors that aren't in the sprite's palette! The closest colors were used instead!\n";
+                        }
+                    }
+                    else
+                        utils::io::ImportFromPNG( curfrm, imgfile.path() );
                     break;
                 }
                 case eSUPPORT_IMG_IO::BMP:
@@ -561,8 +757,6 @@ namespace pmd2{ namespace graphics
             //}
             //#TODO: Check is the resolution is valid !!!!
             //assert(false);
-
-            m_outSprite.m_frames.push_back( std::move(curfrm) );
         }
 
     private:
@@ -583,10 +777,11 @@ namespace pmd2{ namespace graphics
                                       const std::string                         & outpath, 
                                       utils::io::eSUPPORT_IMG_IO                  imgtype,
                                       bool                                        usexmlpal,
-                                      std::atomic<uint32_t>                     * progresscnt ) 
+                                      std::atomic<uint32_t>                     * progresscnt,
+                                      bool                                        asatlas ) 
     {
         SpriteToDirectory<SpriteData<gimg::tiled_image_i4bpp>> mywriter(srcspr);
-        mywriter.WriteSpriteToDir( outpath, imgtype, usexmlpal/*, progresscnt*/ ); 
+        mywriter.WriteSpriteToDir( outpath, imgtype, usexmlpal/*, progresscnt*/, asatlas ); 
     }
 
     /**************************************************************
@@ -596,10 +791,11 @@ namespace pmd2{ namespace graphics
                                      const std::string                         & outpath, 
                                      utils::io::eSUPPORT_IMG_IO                  imgtype,
                                      bool                                        usexmlpal,
-                                     std::atomic<uint32_t>                     * progresscnt )
+                                     std::atomic<uint32_t>                     * progresscnt,
+                                     bool                                        asatlas )
     {
         SpriteToDirectory<SpriteData<gimg::tiled_image_i8bpp>> mywriter(srcspr);
-        mywriter.WriteSpriteToDir( outpath, imgtype, usexmlpal/*, progresscnt*/ ); 
+        mywriter.WriteSpriteToDir( outpath, imgtype, usexmlpal/*, progresscnt*/, asatlas ); 
     }
 
 
@@ -609,7 +805,8 @@ namespace pmd2{ namespace graphics
                                       const std::string          & outpath, 
                                       utils::io::eSUPPORT_IMG_IO   imgtype,
                                       bool                         usexmlpal,
-                                      std::atomic<uint32_t>      * progresscnt )
+                                      std::atomic<uint32_t>      * progresscnt,
+                                      bool                         asatlas )
     {
         //
         auto spritety = srcspr->getSpriteType();
@@ -617,12 +814,12 @@ namespace pmd2{ namespace graphics
         if( spritety == eSpriteImgType::spr4bpp )
         {
             const SpriteData<gimg::tiled_image_i4bpp>* ptr = dynamic_cast<const SpriteData<gimg::tiled_image_i4bpp>*>(srcspr);
-            ExportSpriteToDirectory( (*ptr), outpath, imgtype, usexmlpal/*, progresscnt*/ );
+            ExportSpriteToDirectory( (*ptr), outpath, imgtype, usexmlpal, progresscnt, asatlas );
         }
         else if( spritety == eSpriteImgType::spr8bpp )
         {
             const SpriteData<gimg::tiled_image_i8bpp>* ptr = dynamic_cast<const SpriteData<gimg::tiled_image_i8bpp>*>(srcspr);
-            ExportSpriteToDirectory( (*ptr), outpath, imgtype, usexmlpal/*, progresscnt*/ );
+            ExportSpriteToDirectory( (*ptr), outpath, imgtype, usexmlpal, progresscnt, asatlas );
         }
     }
 
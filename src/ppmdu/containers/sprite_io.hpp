@@ -39,6 +39,8 @@ namespace pmd2 { namespace graphics
     static const std::string SPRITE_IMGs_DIR          = "imgs";         //Name of the sub-folder for the images
     static const std::string SPRITE_Palette_fname     = "palette.pal";
     static const std::string SPRITE_ImgsInfo_fname    = "imgsinfo.xml"; 
+    static const std::string SPRITE_Atlas_basename    = "atlas";        //Base name of the single image containing all the frames, when exported as an atlas
+    static const std::string SPRITE_AtlasIndex_fname  = "atlas.xml";    //Where each frames are in the atlas image
 
 //=============================================================================================
 //  Structs
@@ -57,6 +59,27 @@ namespace pmd2 { namespace graphics
         uint32_t totalAnimFrms = 0;
         uint32_t totalAnimSeqs = 0;
     };
+
+    /**************************************************************
+    Where a single frame is in a sprite's atlas image, in pixels.
+    **************************************************************/
+    struct SpriteAtlasRect
+    {
+        uint16_t x      = 0;
+        uint16_t y      = 0;
+        uint16_t width  = 0;
+        uint16_t height = 0;
+    };
+
+    /**************************************************************
+    The content of a sprite's atlas index file. The frames are in 
+    the same order as the sprite's frames.
+    **************************************************************/
+    struct SpriteAtlasIndex
+    {
+        std::string                  imgfname;  //Name of the atlas image, in the sprite's directory
+        std::vector<SpriteAtlasRect> frames;
+    };
     
 //=============================================================================================
 // Sprite IO Handling
@@ -69,23 +92,30 @@ namespace pmd2 { namespace graphics
                      RIFF palette.
         -progress  : An atomic integer to increment all the way to 100, to indicate
                      current progress with export.
+        -asatlas   : If true, all the frames are packed into a single image, along with
+                     an index of where each frames are in it, instead of one image per 
+                     frame in the "imgs" sub-directory.
     */
     template<class _Sprite_T>
         void ExportSpriteToDirectory( const _Sprite_T            & srcspr, 
                                       const std::string          & outpath, 
                                       utils::io::eSUPPORT_IMG_IO   imgtype     = utils::io::eSUPPORT_IMG_IO::PNG,
                                       bool                         usexmlpal   = false,
-                                      std::atomic<uint32_t>      * progresscnt = nullptr );
+                                      std::atomic<uint32_t>      * progresscnt = nullptr,
+                                      bool                         asatlas     = false );
 
     void ExportSpriteToDirectoryPtr( const graphics::BaseSprite * srcspr, 
                                       const std::string          & outpath, 
                                       utils::io::eSUPPORT_IMG_IO   imgtype     = utils::io::eSUPPORT_IMG_IO::PNG,
                                       bool                         usexmlpal   = false,
-                                      std::atomic<uint32_t>      * progresscnt = nullptr );
+                                      std::atomic<uint32_t>      * progresscnt = nullptr,
+                                      bool                         asatlas     = false );
 
     /*
         ImportSpriteFromDirectory
             Call this to import any types of Sprite.
+            If the directory has no "imgs" sub-directory, but has an atlas index file, the
+            frames are read from the atlas image instead.
 
             -bReadImgByIndex : If true we'll enforce the image order indicated by the number 
                                in the name of the image. If false, we'll simply pushback images
@@ -122,6 +152,19 @@ namespace pmd2 { namespace graphics
     std::vector<std::string> GetMissingRequiredFiles_Sprite( const std::string              & directorypath );
 
 
+    /*
+        Whether the sprite directory's frames are stored in an atlas image, instead of in the "imgs" sub-directory.
+    */
+    bool IsSpriteDirUsingAtlas( const std::string & dirpath );
+
+    /*
+        PackSpriteAtlas
+            Places images of the specified resolutions into a single image, and returns the 
+            position of each of them, in the same order. Resolutions must be multiples of 8.
+            The resolution of the whole atlas image is returned in "out_atlasres".
+    */
+    std::vector<SpriteAtlasRect> PackSpriteAtlas( const std::vector<utils::Resolution> & frmsres, utils::Resolution & out_atlasres );
+
     /*
         Whether the image resolution is one of the valid sprite image resolution.
     */
@@ -157,6 +200,13 @@ namespace pmd2 { namespace graphics
                                const spriteWorkStats & stats, 
                                bool                    writexmlpal = false, 
                                std::atomic<uint32_t> * progresscnt = nullptr );
+
+    /******************************************************************************************
+    WriteSpriteAtlasIndex / ParseSpriteAtlasIndex
+        Write/read the index of the frames contained in a sprite's atlas image.
+    ******************************************************************************************/
+    void             WriteSpriteAtlasIndex( const SpriteAtlasIndex & atlasidx, const std::string & spriteFolderPath );
+    SpriteAtlasIndex ParseSpriteAtlasIndex( const std::string & spriteFolderPath );
        
 };};
 
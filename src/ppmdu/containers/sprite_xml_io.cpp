@@ -12,6 +12,7 @@
 #include <iostream>
 #include <array>
 #include <pugixml.hpp>
+#include <utils/pugixml_utils.hpp>
 #include <Poco/DirectoryIterator.h>
 #include <Poco/File.h>
 #include <Poco/Path.h>
@@ -59,6 +60,15 @@ namespace pmd2 { namespace graphics
         static const string XML_NODE_IMAGE     = "ImageProperty";
         static const string XML_PROP_ZINDEX    = "ZIndex";
 
+        //Atlas index
+        static const string XML_ROOT_ATLAS     = "SpriteAtlas";
+        static const string XML_ATTR_ATLASIMG  = "Image";
+        static const string XML_NODE_ATLASFRM  = "F";
+        static const string XML_ATTR_ATLASX    = "X";
+        static const string XML_ATTR_ATLASY    = "Y";
+        static const string XML_ATTR_ATLASW    = "W";
+        static const string XML_ATTR_ATLASH    = "H";
+
         //Other nodes
         static const string XML_NODE_SHADOW    = "Shadow";
         static const string XML_NODE_SPRITE    = "Sprite";
@@ -686,6 +696,9 @@ namespace pmd2 { namespace graphics
 //=============================================================================================
 //  Sprite to XML writer
 //=============================================================================================
+    using pugixmlutils::XMLStreamWriter;
+    //The biggest files are streamed straight to disk
+    typedef XMLStreamWriter::node xmlwnode_t;
 
     class SpriteXMLWriter
     { 
@@ -749,6 +762,16 @@ namespace pmd2 { namespace graphics
             parentnode.append_child(name.c_str()).append_child(pugi::node_pcdata).set_value(value);
         }
 
+        inline void writeComment( xmlwnode_t node, const string & str )
+        {
+            node.append_comment( str.c_str() );
+        }
+
+        inline void WriteNodeWithValue( xmlwnode_t parentnode, const string & name, const char * value )
+        {
+            parentnode.append_child(name).append_pcdata(value);
+        }
+
         /*
             This clears the instance's string stream, and set it back to the beginning, ready for 
             converting more stuff.
@@ -855,23 +878,23 @@ namespace pmd2 { namespace graphics
 
         /**************************************************************
         **************************************************************/
-        void WriteAnimFrame( pugi::xml_node & parentnode, const AnimFrame & curfrm )
+        void WriteAnimFrame( xmlwnode_t parentnode, const AnimFrame & curfrm )
         {
             using namespace SpriteXMLStrings;
             using namespace pugi;
 
-            xml_node anifrmnode = parentnode.append_child( XML_NODE_ANIMFRM.c_str() );
+            xmlwnode_t anifrmnode = parentnode.append_child( XML_NODE_ANIMFRM.c_str() );
             {
                 WriteNodeWithValue( anifrmnode, XML_PROP_DURATION,  FastTurnIntToCStr( curfrm.frameDuration   ) );
                 WriteNodeWithValue( anifrmnode, XML_PROP_METAINDEX, FastTurnIntToCStr( curfrm.metaFrmGrpIndex ) );
 
-                xml_node sprnode = anifrmnode.append_child( XML_NODE_SPRITE.c_str() );
+                xmlwnode_t sprnode = anifrmnode.append_child( XML_NODE_SPRITE.c_str() );
                 {
                     WriteNodeWithValue(sprnode, XML_PROP_OFFSETX, FastTurnIntToCStr( curfrm.sprOffsetX ) );
                     WriteNodeWithValue(sprnode, XML_PROP_OFFSETY, FastTurnIntToCStr( curfrm.sprOffsetY ) );
                 }
 
-                xml_node shadnode = anifrmnode.append_child( XML_NODE_SHADOW.c_str() );
+                xmlwnode_t shadnode = anifrmnode.append_child( XML_NODE_SHADOW.c_str() );
                 {
                     WriteNodeWithValue(shadnode, XML_PROP_OFFSETX, FastTurnIntToCStr( curfrm.shadowOffsetX ) );
                     WriteNodeWithValue(shadnode, XML_PROP_OFFSETY, FastTurnIntToCStr( curfrm.shadowOffsetY ) );
@@ -881,15 +904,15 @@ namespace pmd2 { namespace graphics
 
         /**************************************************************
         **************************************************************/
-        void WriteAnimSequence( pugi::xml_node & parentnode, const AnimationSequence & aseq )
+        void WriteAnimSequence( xmlwnode_t parentnode, const AnimationSequence & aseq )
         {
             using namespace SpriteXMLStrings;
             using namespace pugi;
             
-            xml_node seqnode = parentnode.append_child( XML_NODE_ANIMSEQ.c_str() );
+            xmlwnode_t seqnode = parentnode.append_child( XML_NODE_ANIMSEQ.c_str() );
 
             //Give this sequence a name 
-            seqnode.append_attribute(XML_ATTR_NAME.c_str()).set_value(aseq.getName().c_str());
+            seqnode.append_attribute( XML_ATTR_NAME.c_str(), aseq.getName().c_str() );
 
             //Write the content of each frame in that sequence
             for( unsigned int cptfrms = 0; cptfrms < aseq.getNbFrames(); ++cptfrms )
@@ -910,10 +933,10 @@ namespace pmd2 { namespace graphics
         {
             using namespace SpriteXMLStrings;
             using namespace pugi;
-            xml_document doc;
             string       outpath      = Poco::Path(m_outPath).append(SPRITE_Animations_fname).toString();
             //uint32_t     saveprogress = 0;
-            xml_node     agnode       = doc.append_child(XML_ROOT_ANIMDAT.c_str());
+            XMLStreamWriter writer(outpath);
+            xmlwnode_t   agnode       = writer.Root().append_child(XML_ROOT_ANIMDAT.c_str());
             //if( m_pProgresscnt != nullptr )
             //    saveprogress = m_pProgresscnt->load();
 
@@ -931,7 +954,7 @@ namespace pmd2 { namespace graphics
             writeComment( agnode, m_strs.str() );
 
             //First Write the GroupRefTable
-            xml_node     grpreftblnode = agnode.append_child(XML_NODE_ANIMGRPTBL.c_str());
+            xmlwnode_t     grpreftblnode = agnode.append_child(XML_NODE_ANIMGRPTBL.c_str());
             unsigned int cptgrp        = 0;
             for( const auto & animgrp : m_pInSprite->getAnimGroups() )
             {
@@ -940,10 +963,10 @@ namespace pmd2 { namespace graphics
                 m_strs <<"Group #" <<cptgrp <<" contains " << animgrp.seqsIndexes.size() << " sequence(s)";
                 writeComment( grpreftblnode, m_strs.str() );
                         
-                xml_node grpnode = grpreftblnode.append_child(XML_NODE_ANIMGRP.c_str());
+                xmlwnode_t grpnode = grpreftblnode.append_child(XML_NODE_ANIMGRP.c_str());
 
                 //Give this group a name
-                grpnode.append_attribute(XML_ATTR_NAME.c_str()).set_value(animgrp.group_name.c_str());
+                grpnode.append_attribute( XML_ATTR_NAME.c_str(), animgrp.group_name.c_str() );
 
                 //Write the content of each sequences in that group
                 for( const auto & aseq : animgrp.seqsIndexes )
@@ -966,7 +989,7 @@ namespace pmd2 { namespace graphics
             writeComment( agnode, "===========================================================================");
 
             //Next, write the SequenceTable
-            xml_node     seqreftblnode = agnode.append_child(XML_NODE_ANIMSEQTBL.c_str());
+            xmlwnode_t     seqreftblnode = agnode.append_child(XML_NODE_ANIMSEQTBL.c_str());
             unsigned int cptaseqs = 0;
 
             //Write the content of each group
@@ -982,8 +1005,7 @@ namespace pmd2 { namespace graphics
             }
 
 
-            if( ! doc.save_file( outpath.c_str() ) )
-                throw std::runtime_error("Error, can't write animation xml file!");
+            writer.Close();
         }
 
         /**************************************************************
@@ -992,14 +1014,14 @@ namespace pmd2 { namespace graphics
         {
             using namespace SpriteXMLStrings;
             using namespace pugi;
-            xml_document doc;
             string       outpath = Poco::Path(m_outPath).append(SPRITE_Frames_fname).toString();
             //uint32_t     saveprogress = 0;
 
             //if( m_pProgresscnt != nullptr )
             //    saveprogress = m_pProgresscnt->load();
 
-            xml_node frmlstnode = doc.append_child( XML_ROOT_FRMLST.c_str() );
+            XMLStreamWriter writer(outpath);
+            xmlwnode_t      frmlstnode = writer.Root().append_child( XML_ROOT_FRMLST.c_str() );
 
             resetStrs();
             m_strs <<"Total nb of group(s)      : " <<setw(4) <<setfill(' ') <<m_pInSprite->getMetaFrmsGrps().size();
@@ -1022,17 +1044,16 @@ namespace pmd2 { namespace graphics
                 //    m_pProgresscnt->store( saveprogress + ( proportionofwork * i ) / m_pInSprite->getMetaFrmsGrps().size() );
             }
 
-            if( ! doc.save_file( outpath.c_str() ) )
-                throw std::runtime_error("Error, can't write meta-frames xml file!");
+            writer.Close();
         }
 
         /**************************************************************
         **************************************************************/
-        inline void WriteAMetaFrameGroup( pugi::xml_node & parentnode, const MetaFrameGroup & grp )
+        inline void WriteAMetaFrameGroup( xmlwnode_t parentnode, const MetaFrameGroup & grp )
         {
             using namespace SpriteXMLStrings;
             using namespace pugi;
-            xml_node        frmgrpnode = parentnode.append_child(XML_NODE_FRMGRP.c_str());
+            xmlwnode_t        frmgrpnode = parentnode.append_child(XML_NODE_FRMGRP.c_str());
 
             for( unsigned int i = 0; i < grp.metaframes.size(); ++i )
             {
@@ -1043,11 +1064,11 @@ namespace pmd2 { namespace graphics
 
         /**************************************************************
         **************************************************************/
-        void WriteMetaFrame( pugi::xml_node & parentnode, unsigned int index )
+        void WriteMetaFrame( xmlwnode_t parentnode, unsigned int index )
         {
             using namespace pugi;
             using namespace SpriteXMLStrings;
-            xml_node     mfnode = parentnode.append_child( XML_NODE_FRMFRM.c_str() );
+            xmlwnode_t     mfnode = parentnode.append_child( XML_NODE_FRMFRM.c_str() );
             const auto & aframe = m_pInSprite->getMetaFrames()[index];
 
             resetStrs();
@@ -1056,7 +1077,7 @@ namespace pmd2 { namespace graphics
             WriteNodeWithValue( mfnode, XML_PROP_UNK0,     FastTurnIntToHexCStr(aframe.unk0) );
 
             {
-                xml_node offsetnode = mfnode.append_child( XML_NODE_OFFSET.c_str() );
+                xmlwnode_t offsetnode = mfnode.append_child( XML_NODE_OFFSET.c_str() );
                 WriteNodeWithValue( offsetnode, XML_PROP_X,  FastTurnIntToCStr(aframe.offsetX ) );
                 WriteNodeWithValue( offsetnode, XML_PROP_Y,  FastTurnIntToCStr(aframe.offsetY ) );
             }
@@ -1065,7 +1086,7 @@ namespace pmd2 { namespace graphics
             WriteNodeWithValue( mfnode, XML_PROP_UNK15,    FastTurnIntToHexCStr(aframe.unk15) );
 
             {
-                xml_node resnode    = mfnode.append_child(XML_NODE_RES.c_str());
+                xmlwnode_t resnode    = mfnode.append_child(XML_NODE_RES.c_str());
                 auto     resolution = MetaFrame::eResToResolution(aframe.resolution);
                 WriteNodeWithValue( resnode, XML_PROP_WIDTH,   FastTurnIntToCStr( resolution.width  ) );
                 WriteNodeWithValue( resnode, XML_PROP_HEIGHT,  FastTurnIntToCStr( resolution.height ) );
@@ -1089,9 +1110,9 @@ namespace pmd2 { namespace graphics
         {
             using namespace SpriteXMLStrings;
             using namespace pugi;
-            xml_document doc;
             string       outpath      = Poco::Path(m_outPath).append(SPRITE_Offsets_fname).toString();
-            xml_node     offlstnode   = doc.append_child(XML_ROOT_OFFLST.c_str());
+            XMLStreamWriter writer(outpath);
+            xmlwnode_t   offlstnode   = writer.Root().append_child(XML_ROOT_OFFLST.c_str());
             //uint32_t     saveprogress = 0;
 
             if( ! m_pInSprite->getPartOffsets().empty() )
@@ -1108,7 +1129,7 @@ namespace pmd2 { namespace graphics
                     const auto & anoffset = m_pInSprite->getPartOffsets()[i];
                     writeComment( offlstnode, FastTurnIntToCStr(i) );
 
-                    xml_node offnode = offlstnode.append_child(XML_NODE_OFFSET.c_str());
+                    xmlwnode_t offnode = offlstnode.append_child(XML_NODE_OFFSET.c_str());
                     WriteNodeWithValue( offnode, XML_PROP_X, FastTurnIntToCStr( anoffset.offx ));
                     WriteNodeWithValue( offnode, XML_PROP_Y, FastTurnIntToCStr( anoffset.offy ));
 
@@ -1118,8 +1139,7 @@ namespace pmd2 { namespace graphics
                 }
             }
 
-            if( ! doc.save_file( outpath.c_str() ) )
-                throw std::runtime_error("Error, can't write offset list xml file!");
+            writer.Close();
         }
 
         void WriteImgInfo( /*uint32_t proportionofwork*/  )
@@ -1196,6 +1216,62 @@ namespace pmd2 { namespace graphics
     }
 
 
+    /******************************************************************************************
+    WriteSpriteAtlasIndex
+        Frames are written as attributes on a single node each, to keep the file small.
+    ******************************************************************************************/
+    void WriteSpriteAtlasIndex( const SpriteAtlasIndex & atlasidx, const std::string & spriteFolderPath )
+    {
+        using namespace SpriteXMLStrings;
+        using namespace pugi;
+        xml_document doc;
+        string       outpath   = Poco::Path(spriteFolderPath).append(SPRITE_AtlasIndex_fname).toString();
+        xml_node     atlasnode = doc.append_child(XML_ROOT_ATLAS.c_str());
+        atlasnode.append_attribute(XML_ATTR_ATLASIMG.c_str()).set_value(atlasidx.imgfname.c_str());
+
+        for( const auto & rect : atlasidx.frames )
+        {
+            xml_node frmnode = atlasnode.append_child(XML_NODE_ATLASFRM.c_str());
+            frmnode.append_attribute(XML_ATTR_ATLASX.c_str()).set_value(rect.x);
+            frmnode.append_attribute(XML_ATTR_ATLASY.c_str()).set_value(rect.y);
+            frmnode.append_attribute(XML_ATTR_ATLASW.c_str()).set_value(rect.width);
+            frmnode.append_attribute(XML_ATTR_ATLASH.c_str()).set_value(rect.height);
+        }
+
+        if( ! doc.save_file( outpath.c_str() ) )
+            throw std::runtime_error("Error, can't write sprite atlas index xml file!");
+    }
+
+    /******************************************************************************************
+    ParseSpriteAtlasIndex
+    ******************************************************************************************/
+    SpriteAtlasIndex ParseSpriteAtlasIndex( const std::string & spriteFolderPath )
+    {
+        using namespace SpriteXMLStrings;
+        using namespace pugi;
+        string       inpath = Poco::Path(spriteFolderPath).append(SPRITE_AtlasIndex_fname).toString();
+        xml_document doc;
+        if( ! doc.load_file( inpath.c_str() ) )
+            throw std::runtime_error("Failed to parse the sprite atlas index xml file \"" + inpath + "\"!");
+
+        SpriteAtlasIndex atlasidx;
+        xml_node         atlasnode = doc.child(XML_ROOT_ATLAS.c_str());
+        atlasidx.imgfname = atlasnode.attribute(XML_ATTR_ATLASIMG.c_str()).as_string();
+        if( atlasidx.imgfname.empty() )
+            throw std::runtime_error("The sprite atlas index file \"" + inpath + "\" doesn't specify an image!");
+
+        for( auto & frmnode : atlasnode.children(XML_NODE_ATLASFRM.c_str()) )
+        {
+            SpriteAtlasRect rect;
+            rect.x      = static_cast<uint16_t>( frmnode.attribute(XML_ATTR_ATLASX.c_str()).as_uint() );
+            rect.y      = static_cast<uint16_t>( frmnode.attribute(XML_ATTR_ATLASY.c_str()).as_uint() );
+            rect.width  = static_cast<uint16_t>( frmnode.attribute(XML_ATTR_ATLASW.c_str()).as_uint() );
+            rect.height = static_cast<uint16_t>( frmnode.attribute(XML_ATTR_ATLASH.c_str()).as_uint() );
+            atlasidx.frames.push_back(rect);
+        }
+        return std::move(atlasidx);
+    }
+
     /**************************************************************
     **************************************************************/
     eSpriteImgType QuerySpriteImgTypeFromDirectory( const std::string & dirpath )
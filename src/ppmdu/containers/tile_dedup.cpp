@@ -0,0 +1,102 @@
+#include "tile_dedup.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <sstream>
+using namespace std;
+
+namespace gimg
+{
+    namespace
+    {
+        const uint8_t FlipH = 1;
+        const uint8_t FlipV = 2;
+
+        //Writes the pixels of the tile flipped as specified by "flips" to "pout"
+        void FlipTile( const uint8_t * ppixels, uint8_t flips, uint8_t * pout )
+        {
+            const unsigned int W = TileDedupIndex::TileWidth;
+            const unsigned int H = TileDedupIndex::TileHeight;
+            for( unsigned int y = 0; y < H; ++y )
+            {
+                const uint8_t * psrcrow = ppixels + ( ((flips & FlipV) ? (H - 1 - y) : y) * W );
+                uint8_t       * pdstrow = pout + (y * W);
+                if( flips & FlipH )
+                    std::reverse_copy( psrcrow, psrcrow + W, pdstrow );
+                else
+                    std::copy( psrcrow, psrcrow + W, pdstrow );
+            }
+        }
+    };
+
+//==================================================================
+// TileDedupIndex
+//==================================================================
+    TileDedupIndex::TileDedupIndex( bool allowflips )
+        :m_nbtiles(0), m_allowflips(allowflips)
+    {}
+
+    size_t TileDedupIndex::keyhash::operator()( const key_t & key )const
+    {
+        //FNV-1a over 8 bytes at a time
+        uint64_t hash = 14695981039346656037ULL;
+        for( size_t i = 0; i < key.size(); i += sizeof(uint64_t) )
+        {
+            uint64_t word = 0;
+            std::memcpy( &word, key.data() + i, sizeof(uint64_t) );
+            hash ^= word;
+            hash *= 1099511628211ULL;
+            hash ^= (hash >> 32);
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    TileDedupIndex::tilematch TileDedupIndex::Insert( const uint8_t * ppixels )
+    {
+        //Find the canonical form, the smallest of the flipped variants
+        key_t   canon;
+        uint8_t canonflips = 0;
+        std::copy( ppixels, ppixels + NbPixels, canon.begin() );
+
+        if( m_allowflips )
+        {
+            key_t variant;
+            for( uint8_t flips = FlipH; flips <= (FlipH | FlipV); ++flips )
+            {
+                FlipTile( ppixels, flips, variant.data() );
+                if( variant < canon )
+                {
+                    canon      = variant;
+                    canonflips = flips;
+                }
+            }
+        }
+
+        auto found = m_index.find(canon);
+        if( found != m_index.end() )
+        {
+            //Flips are their own inverse and commute, so going stored -> canonical -> this tile is a xor
+            const uint8_t flips = found->second.flips ^ canonflips;
+            return tilematch{ found->second.tileindex, (flips & FlipH) != 0, (flips & FlipV) != 0, false };
+        }
+
+        if( m_nbtiles > std::numeric_limits<uint16_t>::max() )
+        {
+            stringstream sstr;
+            sstr << "TileDedupIndex::Insert(): Too many unique tiles! Can't index more than " <<std::numeric_limits<uint16_t>::max() + 1 <<" tiles!";
+            throw std::overflow_error(sstr.str());
+        }
+
+        const uint16_t newindex = static_cast<uint16_t>(m_nbtiles);
+        m_index.emplace( canon, entry{ newindex, canonflips } );
+        ++m_nbtiles;
+        return tilematch{ newindex, false, false, true };
+    }
+
+    void TileDedupIndex::clear()
+    {
+        m_index.clear();
+        m_nbtiles = 0;
+    }
+};
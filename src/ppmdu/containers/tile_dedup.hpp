@@ -0,0 +1,127 @@
+#ifndef TILE_DEDUP_HPP
+#define TILE_DEDUP_HPP
+/*
+tile_dedup.hpp
+psycommando@gmail.com
+Description: Utility for building the smallest possible set of 8x8 tiles out of an image, for formats
+             whose tilemap entries can flip tiles horizontally and vertically. (BGP, level tilesets, etc..)
+*/
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace gimg
+{
+    /*************************************************************************************************
+        TileDedupIndex
+            Hashed index of the 8x8 tiles already added to a tile set.
+
+            Each tile is stored under its canonical form, which is the smallest of its 4 flipped
+            variants. (none, horizontal, vertical, both) So a tile matches any stored tile that's
+            identical to it after being flipped, in constant time, and building the tile set of a
+            whole image is linear in the amount of tiles.
+
+            Pixels are passed as one value per pixel, row by row, and only the lowest 8 bits
+            of each value are used. For 4bpp tiles that's the palette index within the tile's
+            16 colors palette, without the palette number.
+    *************************************************************************************************/
+    class TileDedupIndex
+    {
+    public:
+        static const unsigned int TileWidth   = 8;
+        static const unsigned int TileHeight  = 8;
+        static const unsigned int NbPixels    = TileWidth * TileHeight;
+
+        /*
+            tilematch
+                Where to find a tile in the tile set, and how to flip the stored tile to get it back.
+        */
+        struct tilematch
+        {
+            uint16_t tileindex;
+            bool     hflip;
+            bool     vflip;
+            bool     isnew;     //Whether the tile wasn't in the set yet, and was just added to it
+        };
+
+        /*
+            - allowflips : If false, tiles only match tiles that are identical without flipping.
+        */
+        explicit TileDedupIndex( bool allowflips = true );
+
+        /*
+            Insert
+                Looks for the tile in the index, and adds it if there are no matches.
+                When "isnew" is true in the result, the caller must append the tile, as-is, to its
+                tile set at "tileindex". New tiles get the next index in insertion order.
+        */
+        tilematch Insert( const uint8_t * ppixels );
+
+        template<class _init>
+            tilematch InsertTile( _init itpixbeg )
+        {
+            std::array<uint8_t, NbPixels> pixels;
+            for( auto & pix : pixels )
+            {
+                pix = static_cast<uint8_t>(*itpixbeg);
+                ++itpixbeg;
+            }
+            return Insert(pixels.data());
+        }
+
+        //Amount of unique tiles inserted so far
+        inline size_t size()const { return m_nbtiles; }
+        void          clear();
+
+    private:
+        //Canonical form of a tile, one byte per pixel
+        typedef std::array<uint8_t, NbPixels> key_t;
+
+        struct keyhash
+        {
+            size_t operator()( const key_t & key )const;
+        };
+
+        struct entry
+        {
+            uint16_t tileindex;
+            uint8_t  flips;     //Flips to apply to the stored tile to get the canonical form. bit0 hflip, bit1 vflip
+        };
+
+        std::unordered_map<key_t, entry, keyhash> m_index;
+        size_t                                    m_nbtiles;
+        bool                                      m_allowflips;
+    };
+
+    /*************************************************************************************************
+        Split8bppTileTo4bpp
+            For 8bpp tiles made of 16 colors palettes, like what we export BGP and tilesets as.
+            Writes the index within its 16 colors palette of each pixels of the tile to "pout4bpp",
+            and the palette used by most pixels of the tile to "out_palindex".
+
+            Returns the amount of pixels that weren't using the same palette as the rest of the
+            tile. Those can't be displayed properly on the NDS.
+    *************************************************************************************************/
+    template<class _TileT>
+        size_t Split8bppTileTo4bpp( const _TileT & tile, uint8_t * pout4bpp, uint8_t & out_palindex )
+    {
+        static const unsigned int NbColorsPerPal = 16;
+        std::array<unsigned int, 16> palcnt;
+        palcnt.fill(0);
+
+        for( unsigned int i = 0; i < _TileT::NB_PIXELS; ++i )
+        {
+            const unsigned int pix = tile[i].pixeldata;
+            pout4bpp[i] = static_cast<uint8_t>(pix % NbColorsPerPal);
+            ++palcnt[(pix / NbColorsPerPal) % palcnt.size()];
+        }
+
+        auto itmost  = std::max_element( palcnt.begin(), palcnt.end() );
+        out_palindex = static_cast<uint8_t>( std::distance( palcnt.begin(), itmost ) );
+        return _TileT::NB_PIXELS - (*itmost);
+    }
+};
+
+#endif
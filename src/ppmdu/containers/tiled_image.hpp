@@ -127,6 +127,12 @@ namespace gimg
         */
         inline pixel_t       & getPixel( unsigned int x, unsigned int y )      { return content[y][x]; }
         inline const pixel_t & getPixel( unsigned int x, unsigned int y )const { return content[y][x]; }
+        /*
+            getRowData
+                Direct access to the WIDTH contiguous pixels of a row of the tile.
+        */
+        inline pixel_t       * getRowData( unsigned int y )      { return content[y].data(); }
+        inline const pixel_t * getRowData( unsigned int y )const { return content[y].data(); }
 
     private:
         std::vector<std::vector<pixel_t> > content;
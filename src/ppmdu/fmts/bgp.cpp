@@ -8,6 +8,11 @@
 #include <ext_fmts/png_io.hpp>
 #include <ext_fmts/bmp_io.hpp>
 #include <ext_fmts/supported_io.hpp>
+#include <ppmdu/containers/tile_dedup.hpp>
+#include <ppmdu/pmd2/pmd2_palettes.hpp>
+#include <algorithm>
+#include <array>
+#include <limits>
 
 using namespace std;
 
@@ -56,6 +61,8 @@ namespace filetypes
         {
             DecompressBGP();
             m_hdr.ReadFromContainer( m_bgpdata.begin(), m_bgpdata.end() );
+            m_out.m_unk3 = m_hdr.bgpunk3;
+            m_out.m_unk4 = m_hdr.bgpunk4;
             ParsePalette();
             ParseTileMapping();
             ParseTiles();
@@ -165,10 +172,74 @@ namespace filetypes
 
         void Write(const string & filepath)
         {
-            assert(false);
+            vector<uint8_t> rawbgp = MakeRawBGP();
+            vector<uint8_t> compressed;
+            CompressToAT4PX( rawbgp.begin(), rawbgp.end(), compressed );
+            utils::io::WriteByteVectorToFile( filepath, compressed );
         }
 
     private:
+        static uint16_t EncodeTileMappingData( const BGP::tilemapdata & tmap )
+        {
+            return static_cast<uint16_t>( (tmap.tileindex & 0x3FF)             |  //0000 0011 1111 1111, tile index
+                                          ((tmap.palindex & 0xF) << 12)        |  //1111 0000 0000 0000, pal index
+                                          (tmap.vflip? 0x800 : 0)              |  //0000 1000 0000 0000, vflip
+                                          (tmap.hflip? 0x400 : 0) );              //0000 0100 0000 0000, hflip
+        }
+
+        /*
+            The palette comes right after the header, followed by the tile mapping, then the tiles.
+        */
+        vector<uint8_t> MakeRawBGP()const
+        {
+            bgp_header hdr;
+            hdr.palbeg     = bgp_header::LENGTH;
+            hdr.pallen     = static_cast<uint32_t>( m_img.m_palettes.size() * PaletteByteLength );
+            hdr.tmapdatptr = hdr.palbeg + hdr.pallen;
+            hdr.tmapdatlen = static_cast<uint32_t>( m_img.m_mappingdat.size() * sizeof(uint16_t) );
+            hdr.tilesptr   = hdr.tmapdatptr + hdr.tmapdatlen;
+            hdr.tileslen   = static_cast<uint32_t>( m_img.m_tiles.size() * BGPTileNbBytes );
+            hdr.bgpunk3    = m_img.m_unk3;
+            hdr.bgpunk4    = m_img.m_unk4;
+
+            //The AT4PX header stores the decompressed length on 16 bits
+            const size_t totallen = hdr.tilesptr + hdr.tileslen;
+            if( totallen > std::numeric_limits<uint16_t>::max() )
+                throw runtime_error( "BGPWriter::MakeRawBGP(): The BGP is too big to be compressed into an AT4PX container!" );
+
+            vector<uint8_t> out;
+            out.reserve(totallen);
+            auto itout = back_inserter(out);
+            itout = hdr.WriteToContainer(itout);
+
+            for( const auto & apal : m_img.m_palettes )
+            {
+                if( apal.size() > PaletteNbColors )
+                    throw runtime_error( "BGPWriter::MakeRawBGP(): A palette has more than 16 colors!" );
+                for( size_t cntcol = 0; cntcol < PaletteNbColors; ++cntcol )
+                {
+                    const gimg::colorRGB24 col = (cntcol < apal.size())? apal[cntcol].getAsRGB24() : gimg::colorRGB24();
+                    itout   = col.WriteAsRawByte(itout);
+                    *itout  = pmd2::graphics::RGBX_UNUSED_BYTE_VALUE;
+                    ++itout;
+                }
+            }
+
+            for( const auto & tmap : m_img.m_mappingdat )
+                itout = utils::WriteIntToBytes( EncodeTileMappingData(tmap), itout );
+
+            for( const auto & tile : m_img.m_tiles )
+            {
+                for( size_t cntpix = 0; cntpix < BGPTileNbPix; cntpix += 2 )
+                {
+                    const uint8_t lownyb  = (cntpix     < tile.size())? (tile[cntpix].pixeldata     & 0x0F) : 0;
+                    const uint8_t highnyb = (cntpix + 1 < tile.size())? (tile[cntpix + 1].pixeldata & 0x0F) : 0;
+                    *itout = static_cast<uint8_t>( lownyb | (highnyb << 4) );
+                    ++itout;
+                }
+            }
+            return std::move(out);
+        }
 
     private:
         const BGP & m_img;
@@ -287,25 +358,43 @@ namespace filetypes
             }
         };
 
-        BGP target;
-        target.m_palettes.resize(BGPDefPalNbCol, vector<colorRGBX32>(PaletteNbColors));
-        target.m_mappingdat.resize(BGPDefTileMapNbEntries, {0,0,0,0} );
-        target.m_tiles.resize(BGPDefTilesNB, vector<pixel_indexed_4bpp>(BGPTileNbPix) );
+        //Fill the palettes
+        BGP          target;
+        const size_t nbpals = std::min<size_t>( (img.getNbColors() / PaletteNbColors) + ((img.getNbColors() % PaletteNbColors != 0)? 1 : 0), PaletteNbColors );
+        target.m_palettes.resize( std::max<size_t>(nbpals, 1), vector<colorRGBX32>(PaletteNbColors) );
+        for( size_t cntcol = 0; cntcol < img.getNbColors() && cntcol < (target.m_palettes.size() * PaletteNbColors); ++cntcol )
+            target.m_palettes[cntcol / PaletteNbColors][cntcol % PaletteNbColors].setFromRGB24( img.getPalette()[cntcol] );
+
+        //Build the smallest tile set possible, reusing flipped tiles. 
+        // Tile 0 is the null tile, a tilemap entry pointing to it marks the end of the image.
+        TileDedupIndex               tindex;
+        array<uint8_t, BGPTileNbPix> tilepix;
+        size_t                       nbbadpixels = 0;
+        target.m_tiles.push_back( vector<pixel_indexed_4bpp>(BGPTileNbPix) );
+        target.m_mappingdat.resize( BGPDefTileMapNbEntries, BGP::tilemapdata{0,0,false,false} );
+
+        const size_t nbtiles = (BGP_RES.width / tiled_image_i8bpp::tile_t::WIDTH) * (BGP_RES.height / tiled_image_i8bpp::tile_t::HEIGHT);
+        for( size_t cnttile = 0; cnttile < nbtiles; ++cnttile )
+        {
+            uint8_t palindex = 0;
+            nbbadpixels += Split8bppTileTo4bpp( img.getTile(cnttile), tilepix.data(), palindex );
 
+            auto match = tindex.Insert( tilepix.data() );
+            if( match.isnew )
+                target.m_tiles.push_back( vector<pixel_indexed_4bpp>( tilepix.begin(), tilepix.end() ) );
 
-        //#TODO: Need to find a way to sort colors so that each tiles refers to exactly one 16 colors palette..
+            if( target.m_tiles.size() > BGPDefTilesNB )
+                throw runtime_error( "ImportBGP(): Image \"" + infile + "\" has too many unique tiles to fit in a BGP!" );
 
-        //#1 - look at every 64 pixels tile, and make sure each has no more than 16 colors in use. 
-        //     if there are any extra colors, try to replace them with the closest within a certain limit.
-        //     If no closest color can be found, error out!
-        //
+            target.m_mappingdat[cnttile] = BGP::tilemapdata{ static_cast<uint16_t>(match.tileindex + 1), palindex, match.vflip, match.hflip };
+        }
 
-        //for( size_t cntcol = 0; cntcol < img.getNbColors(); ++cntcol )
-        //{
-        //    target.m_palettes[cntcol / PaletteNbColors][cntcol % PaletteNbColors].setFromRGB24( img.getColor(cntcol) );
-        //}
+        if( nbbadpixels != 0 )
+        {
+            clog << "<!>-Warning: ImportBGP(): " <<nbbadpixels <<" pixels in \"" <<infile 
+                 <<"\" don't use the same 16 colors palette as the rest of their tile! They'll use the wrong colors!\n";
+        }
 
-        assert(false);
         return move(target);
     }
 
@@ -87,6 +87,8 @@ namespace filetypes
         std::vector< std::vector<gimg::pixel_indexed_4bpp> > m_tiles;
         std::vector<tilemapdata>                             m_mappingdat;
         std::vector< std::vector<gimg::colorRGBX32> >        m_palettes;
+        uint32_t                                             m_unk3 = 0; //Unknown header values, kept as-is when re-writing a parsed BGP
+        uint32_t                                             m_unk4 = 0;
     };
 
     /*
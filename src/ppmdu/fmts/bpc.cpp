@@ -2,6 +2,7 @@
 #include <ppmdu/fmts/bpc_compression.hpp>
 #include <types/contentid_generator.hpp>
 #include <cassert>
+#include <limits>
 using namespace std;
 
 namespace filetypes
@@ -140,15 +141,121 @@ namespace filetypes
 
     /*
         BPCWriter
+            Builds a BPC file out of up to 2 layers, compressing their tiles and tile mapping tables.
+            The first, empty, tile of each layer isn't stored, like BPCParser expects.
     */
     class BPCWriter
     {
+        static const size_t NbBytesPerTilesRaw   = 32; //In 4bpp we output 32 bytes per tile!
+        static const size_t NbPixelsPerTile      = 64;
+        static const size_t NbWordsPerTMapEntry  = 9;
+        static const size_t MaxNbLayers          = 2;
     public:
-        BPCWriter()
+        BPCWriter( const pmd2::TilesetLayers & layers )
+            :m_layers(layers)
+        {}
+
+        std::vector<uint8_t> operator()()
         {
+            if( m_layers.empty() || m_layers.size() > MaxNbLayers )
+                throw std::length_error("BPCWriter::operator(): A BPC file must contain 1 or 2 layers! Got " + std::to_string(m_layers.size()) );
+
+            bpc_header                   hdr;
+            std::vector<std::vector<uint8_t>> layersdata;
+            hdr.tilesetsinfo.resize(m_layers.size());
+            for( size_t i = 0; i < m_layers.size(); ++i )
+                layersdata.push_back( WriteALayer( i, hdr.tilesetsinfo[i] ) );
+
+            //Layers are placed right after the header, one after the other
+            size_t offlayer = hdr.rawsize();
+            hdr.offsuprscr  = CheckedOffset(offlayer);
+            offlayer       += layersdata.front().size();
+            hdr.offslowrscr = (layersdata.size() > 1)? CheckedOffset(offlayer) : 0;
+
+            std::vector<uint8_t> out;
+            out.reserve( offlayer + layersdata.back().size() );
+            auto itout = std::back_inserter(out);
+            hdr.Write(itout);
+            for( const auto & layer : layersdata )
+                out.insert( out.end(), layer.begin(), layer.end() );
+            return std::move(out);
         }
 
     private:
+        std::vector<uint8_t> WriteALayer( size_t layerindex, bpc_header::indexentry & entry )const
+        {
+            const pmd2::TilesetLayer & layer = m_layers[layerindex];
+
+            //
+            //Pack the tiles to 4bpp, low nybble first
+            //
+            std::vector<uint8_t> raw4bpp;
+            raw4bpp.reserve( layer.Tiles().size() * NbBytesPerTilesRaw );
+            for( const auto & tile : layer.Tiles() )
+            {
+                for( size_t cntpixel = 0; cntpixel < NbPixelsPerTile; cntpixel += 2 )
+                {
+                    const uint8_t lownyb  = (cntpixel     < tile.size())? (tile[cntpixel].pixeldata     & 0x0F) : 0;
+                    const uint8_t highnyb = (cntpixel + 1 < tile.size())? (tile[cntpixel + 1].pixeldata & 0x0F) : 0;
+                    raw4bpp.push_back( lownyb | (highnyb << 4) );
+                }
+            }
+
+            //
+            //Tile mapping table, padded to a whole amount of entries
+            //
+            std::vector<uint8_t> rawtmap;
+            const size_t nbtmapwords = utils::CalculatePaddedLengthTotal( layer.TileMap().size(), NbWordsPerTMapEntry );
+            rawtmap.reserve( nbtmapwords * sizeof(uint16_t) );
+            auto ittmap = std::back_inserter(rawtmap);
+            for( const auto & tprop : layer.TileMap() )
+                ittmap = utils::WriteIntToBytes( static_cast<uint16_t>(tprop), ittmap );
+            for( size_t i = layer.TileMap().size(); i < nbtmapwords; ++i )
+                ittmap = utils::WriteIntToBytes( uint16_t(0), ittmap );
+
+            const size_t nbtiles    = layer.Tiles().size() + 1;  //+1 for the empty first tile
+            const size_t tmapdeclen = (nbtmapwords / NbWordsPerTMapEntry) + 1;
+            if( nbtiles > std::numeric_limits<uint16_t>::max() || tmapdeclen > std::numeric_limits<uint16_t>::max() )
+                throw std::length_error("BPCWriter::WriteALayer(): Too many tiles or tile mapping entries in layer " + std::to_string(layerindex) + "!");
+
+            entry.nbtiles    = static_cast<uint16_t>(nbtiles);
+            entry.tmapdeclen = static_cast<uint16_t>(tmapdeclen);
+            if( layerindex < m_layers.layerasmdata.size() )
+            {
+                const auto & asmdat = m_layers.layerasmdata[layerindex];
+                entry.unk2 = asmdat.unk2;
+                entry.unk3 = asmdat.unk3;
+                entry.unk4 = asmdat.unk4;
+                entry.unk5 = asmdat.unk5;
+            }
+            else
+                entry.unk2 = entry.unk3 = entry.unk4 = entry.unk5 = 0;
+
+            //
+            //Compress the image, then the tile mapping table right after
+            //
+            typedef std::vector<uint8_t>::const_iterator   rawit_t;
+            typedef std::back_insert_iterator<std::vector<uint8_t>> outit_t;
+            std::vector<uint8_t> out;
+            outit_t              itout = std::back_inserter(out);
+            itout = bpc_compression::BPCImgCompressor<rawit_t,outit_t>(raw4bpp.begin(), raw4bpp.end())(itout);
+            itout = bpc_compression::BPC_TileMapCompressor<rawit_t,outit_t>(rawtmap.begin(), rawtmap.end())(itout);
+
+            //Keep the next layer aligned on 2 bytes
+            if( (out.size() % 2) != 0 )
+                out.push_back(0);
+            return std::move(out);
+        }
+
+        static uint16_t CheckedOffset( size_t offset )
+        {
+            if( offset > std::numeric_limits<uint16_t>::max() )
+                throw std::length_error("BPCWriter::CheckedOffset(): The layers are too big to fit in a BPC file!");
+            return static_cast<uint16_t>(offset);
+        }
+
+    private:
+        const pmd2::TilesetLayers & m_layers;
     };
 
 //============================================================================================
@@ -166,8 +273,19 @@ namespace filetypes
         return std::move(BPCParser<decltype(data.begin())>(data.begin(), data.end())());
     }
 
-    void WriteBPC(const std::string & destfpath, const pmd2::Tileset & srcupscr, const pmd2::Tileset & srcbotscr)
+    void WriteBPC(const std::string & destfpath, const pmd2::TilesetLayers & layers)
+    {
+        utils::io::WriteByteVectorToFile( destfpath, BPCWriter(layers)() );
+    }
+
+    pmd2::TilesetLayers ParseBPC(const std::vector<uint8_t> & data)
+    {
+        return std::move(BPCParser<decltype(data.begin())>(data.begin(), data.end())());
+    }
+
+    std::vector<uint8_t> WriteBPC(const pmd2::TilesetLayers & layers)
     {
+        return BPCWriter(layers)();
     }
 
 
@@ -12,6 +12,7 @@ Description:
 #include <stdexcept>
 #include <iterator>
 #include <deque>
+#include <utility>
 
 namespace bpc_compression
 {
@@ -229,6 +230,16 @@ namespace bpc_compression
 
     /*
         BPCImgCompressor
+            Compresses 4bpp tile data into the format BPCImgDecompressor reads.
+
+            Each command outputs its count + 1 bytes, either copied from the bytes following
+            the command, or repeated from one of the 2 buffered pattern bytes. The input is
+            split into runs of identical bytes in a single pass, and each run is either
+            written as a pattern, or appended to the sequence of bytes to copy, whichever is
+            shorter given the pattern bytes currently buffered.
+
+            The input length must be even, since the game decompresses words.
+            The output is padded to an even length, like the decompressor expects.
     */
     template<class _intit, class _outit>
         class BPCImgCompressor
@@ -236,77 +247,159 @@ namespace bpc_compression
         typedef _outit outit_t;
         typedef _intit init_t;
 
-        /*
-        */
-        enum struct eOpType
-        {
-            Invalid,
-            SequenceCopy,   //Copy a sequence of words as-is
-            ByteCopy,       //Copy a single byte over several words
-        };
-
-        /*
-        */
-        enum struct ePatternBuffOp
-        {
-            UseCurrentByte, //Uses the current pattern byte (r7)
-            UseLastByte,    //Swap the current pattern byte with the one used that was used before the current one (r7 <-> [r13,14h])
-            SetNewByte,     //Load the next byte after the len to copy as the new current pattern byte, and keep track of the old one. (r7 -> [r13,14h], then load into r7)
-        };
-
-        /*
-        */
-        struct Operation
-        {
-            eOpType         type;
+        static const uint8_t CMD_CyclePatternAndCp                      = 0xE0;
+        static const uint8_t CMD_CyclePatternAndCp_NbCpNextByte         = 0xFF;
 
-            //Sequence info
-            init_t          itbegs;     //The start of the sequence of bytes to copy
-            init_t          itends;     //The end of the sequence of bytes to copy
-            size_t          seqlen;     //The length of the sequence to be copied. The distance between "itends" and "itbegs".
-                                        // If odd, the "differed" variable will be used to fill in, as the game always copies an even nb of bytes.
-            uint8_t         differed;   //If the sequence of similar bytes' "seqlen" is odd, this will contains the value of the byte that differed.
+        static const uint8_t CMD_UseLastPatternAndCp                    = 0xC0;
+        static const uint8_t CMD_UseLastPatternAndCp_NbCpNextByte       = 0xDF;
 
-            //Byte Patterns stuff
-            ePatternBuffOp patop;       //This will be set according to what the currently buffered pattern byte is.
-            uint8_t        newpatbyte;  //If the "patop" is "SetNewByte" this will contain the new byte to set!
+        static const uint8_t CMD_LoadByteAsPatternAndCp                 = 0x80;
+        static const uint8_t CMD_LoadByteAsPatternAndCp_NbCpNextByte    = 0xBF;
 
-            Operation()
-                :seqlen(0),type(eOpType::Invalid), patop(ePatternBuffOp::UseCurrentByte)
-            {}
+        static const uint8_t CMD_LoadNextByteAsNbToCopy = 0x7E;
+        static const uint8_t CMD_LoadNextWordAsNbToCopy = 0x7F;
 
-            inline bool HasLeftover()const
-            {
-                return (seqlen % 2 != 0);
-            }
-        };
+        static const size_t  MaxPatternLen  = 0x100;    //Longest pattern a single command can output
+        static const size_t  MaxSequenceLen = 0x10000;  //Longest sequence a single command can copy
 
     public:
         BPCImgCompressor( init_t itbeg, init_t itend )
-            :m_itbeg(itbeg), m_itend(itend)
+            :m_itbeg(itbeg), m_itend(itend), m_pitw(nullptr), m_curpat(0), m_lastpat(0), m_nbwritten(0)
         {}
 
-        void operator()(outit_t itout)
+        outit_t operator()(outit_t itout)
         {
-            m_itw = itout;
+            m_pitw      = &itout;
+            m_curpat    = 0;
+            m_lastpat   = 0;
+            m_nbwritten = 0;
+
+            init_t itseq  = m_itbeg;    //Beginning of the sequence of bytes to copy as-is
+            size_t seqlen = 0;
+            init_t itcur  = m_itbeg;
+
+            while( itcur != m_itend )
+            {
+                const uint8_t curby  = *itcur;
+                init_t        itrun  = itcur;
+                size_t        runlen = 0;
+                for( ; itrun != m_itend && (*itrun) == curby && runlen < MaxPatternLen; ++itrun, ++runlen );
+
+                //Interrupting a sequence costs an extra command byte to resume it later
+                const size_t patcost = PatternCost(curby, runlen);
+                if( (seqlen == 0)? (runlen >= patcost) : (runlen > patcost + 1) )
+                {
+                    if( seqlen != 0 )
+                        WriteSequence( itseq, seqlen );
+                    WritePattern( curby, runlen );
+                    seqlen = 0;
+                }
+                else
+                {
+                    if( seqlen == 0 )
+                        itseq = itcur;
+                    seqlen += runlen;
+                }
+                itcur = itrun;
+            }
+
+            if( seqlen != 0 )
+                WriteSequence( itseq, seqlen );
+
+            //The decompressor always reads an even amount of bytes
+            if( (m_nbwritten % 2) != 0 )
+                WriteByte(0);
+            m_pitw = nullptr;
+            return itout;
         }
 
+        inline size_t GetNbBytesWritten()const { return m_nbwritten; }
+
     private:
 
-        //#1- We want to take small 128 bytes chunks and try to see what is the 2 most common bytes, so we can set those as patterns in those locations
+        inline void WriteByte( uint8_t by )
+        {
+            assert(m_pitw);
+            (**m_pitw) = by;
+            ++(*m_pitw);
+            ++m_nbwritten;
+        }
 
-        //#2- Sequences of the same byte that end on a odd number of similar bytes need to include the byte which differed at the end of the sequence!
+        //The nb of bytes the command to output the pattern takes
+        size_t PatternCost( uint8_t patby, size_t len )const
+        {
+            const size_t nbtocp = len - 1;
+            if( patby == m_curpat )
+                return (nbtocp < (CMD_UseLastPatternAndCp_NbCpNextByte - CMD_UseLastPatternAndCp))? 1 : 2;
+            else if( patby == m_lastpat )
+                return (nbtocp < (CMD_CyclePatternAndCp_NbCpNextByte - CMD_CyclePatternAndCp))? 1 : 2;
+            else
+                return (nbtocp < (CMD_LoadByteAsPatternAndCp_NbCpNextByte - CMD_LoadByteAsPatternAndCp))? 2 : 3;
+        }
 
+        void WritePattern( uint8_t patby, size_t len )
+        {
+            const uint8_t nbtocp = static_cast<uint8_t>(len - 1);
+            if( patby == m_curpat )
+                WriteCmdAndLen( CMD_UseLastPatternAndCp, CMD_UseLastPatternAndCp_NbCpNextByte, nbtocp );
+            else if( patby == m_lastpat )
+            {
+                WriteCmdAndLen( CMD_CyclePatternAndCp, CMD_CyclePatternAndCp_NbCpNextByte, nbtocp );
+                std::swap( m_curpat, m_lastpat );
+            }
+            else
+            {
+                WriteCmdAndLen( CMD_LoadByteAsPatternAndCp, CMD_LoadByteAsPatternAndCp_NbCpNextByte, nbtocp );
+                WriteByte(patby);
+                m_lastpat = m_curpat;
+                m_curpat  = patby;
+            }
+        }
+
+        inline void WriteCmdAndLen( uint8_t cmdbeg, uint8_t cmdnextbyte, uint8_t nbtocp )
+        {
+            if( nbtocp < (cmdnextbyte - cmdbeg) )
+                WriteByte( cmdbeg + nbtocp );
+            else
+            {
+                WriteByte( cmdnextbyte );
+                WriteByte( nbtocp );
+            }
+        }
 
-        std::vector<uint8_t> MakeCommandByte( const Operation & curop )
+        void WriteSequence( init_t itseq, size_t seqlen )
         {
-            //If a sequence to copy ends with a word made of 2 different bytes, we want the sequence(minus the word made of 2 different bytes) to be written as a odd number of bytes in the command byte, 
+            while( seqlen != 0 )
+            {
+                const size_t len    = (seqlen < MaxSequenceLen)? seqlen : MaxSequenceLen;
+                const size_t nbtocp = len - 1;
+                if( nbtocp < CMD_LoadNextByteAsNbToCopy )
+                    WriteByte( static_cast<uint8_t>(nbtocp) );
+                else if( nbtocp <= 0xFF )
+                {
+                    WriteByte( CMD_LoadNextByteAsNbToCopy );
+                    WriteByte( static_cast<uint8_t>(nbtocp) );
+                }
+                else
+                {
+                    WriteByte( CMD_LoadNextWordAsNbToCopy );
+                    WriteByte( static_cast<uint8_t>(nbtocp & 0xFF) );
+                    WriteByte( static_cast<uint8_t>(nbtocp >> 8) );
+                }
+
+                for( size_t i = 0; i < len; ++i, ++itseq )
+                    WriteByte( *itseq );
+                seqlen -= len;
+            }
         }
 
     private:
         init_t                  m_itbeg;
         init_t                  m_itend;
-        outit_t                 m_itw;
+        outit_t               * m_pitw;         //Pointer to the output iterator
+        uint8_t                 m_curpat;       //The pattern byte the decompressor has buffered (r7)
+        uint8_t                 m_lastpat;      //The pattern byte used before it ([r13,14h])
+        size_t                  m_nbwritten;
     };
 
 
@@ -457,5 +550,113 @@ namespace bpc_compression
         size_t      m_decomplen;    //The length of the decompressed output in bytes
     };
 
+    /*
+        BPC_TileMapCompressor
+            Compresses a tile mapping table into the format BPC_TileMapDecompressor reads.
+
+            The high bytes of all the words are written first, followed by their low bytes. 
+            Both use the same kind of commands: a run of null bytes, a run of a single byte,
+            or a sequence of bytes copied as-is. Runs are found in a single pass over each half.
+
+            The input is the raw tile mapping table, as little endian words.
+    */
+    template<class _init, class _outit>
+        class BPC_TileMapCompressor
+    {
+        typedef _init  init_t;
+        typedef _outit outit_t;
+
+        static const uint8_t CMD_ZeroOutBeg    = 0x00;  //Null high bytes in table A, words to skip in table B
+        static const uint8_t CMD_FillOutBeg    = 0x80;  //Repeat the next byte
+        static const uint8_t CMD_CopyBytesBeg  = 0xC0;  //Copy the following bytes
+
+        static const size_t  MaxZeroLen        = CMD_FillOutBeg - CMD_ZeroOutBeg;
+        static const size_t  MaxFillLen        = CMD_CopyBytesBeg - CMD_FillOutBeg;
+        static const size_t  MaxCopyLen        = 0x100 - CMD_CopyBytesBeg;
+
+    public:
+        BPC_TileMapCompressor( init_t itbeg, init_t itend )
+            :m_itbeg(itbeg), m_itend(itend)
+        {}
+
+        outit_t operator()( outit_t itout )
+        {
+            std::vector<uint8_t> highbytes;
+            std::vector<uint8_t> lowbytes;
+            for( init_t itr = m_itbeg; itr != m_itend; )
+            {
+                const uint16_t word = utils::ReadIntFromBytes<uint16_t>(itr, m_itend);
+                lowbytes .push_back( static_cast<uint8_t>(word & 0xFF) );
+                highbytes.push_back( static_cast<uint8_t>(word >> 8) );
+            }
+
+            itout = CompressTable( highbytes, itout );
+            itout = CompressTable( lowbytes,  itout );
+            return itout;
+        }
+
+    private:
+        template<class _outit2>
+            static _outit2 CompressTable( const std::vector<uint8_t> & table, _outit2 itout )
+        {
+            size_t seqbeg = 0;
+            size_t seqlen = 0;
+            size_t cur    = 0;
+
+            while( cur < table.size() )
+            {
+                const uint8_t curby  = table[cur];
+                const size_t  maxrun = (curby == 0)? MaxZeroLen : MaxFillLen;
+                size_t        runlen = 0;
+                for( ; (cur + runlen) < table.size() && table[cur + runlen] == curby && runlen < maxrun; ++runlen );
+
+                //Interrupting a sequence costs an extra command byte to resume it later
+                const size_t runcost = (curby == 0)? 1 : 2;
+                if( (seqlen == 0)? (runlen >= runcost) : (runlen > runcost + 1) )
+                {
+                    itout = WriteSequence( table, seqbeg, seqlen, itout );
+                    seqlen = 0;
+                    if( curby == 0 )
+                        (*itout) = static_cast<uint8_t>( CMD_ZeroOutBeg + (runlen - 1) );
+                    else
+                    {
+                        (*itout) = static_cast<uint8_t>( CMD_FillOutBeg + (runlen - 1) );
+                        ++itout;
+                        (*itout) = curby;
+                    }
+                    ++itout;
+                }
+                else
+                {
+                    if( seqlen == 0 )
+                        seqbeg = cur;
+                    seqlen += runlen;
+                }
+                cur += runlen;
+            }
+            return WriteSequence( table, seqbeg, seqlen, itout );
+        }
+
+        template<class _outit2>
+            static _outit2 WriteSequence( const std::vector<uint8_t> & table, size_t seqbeg, size_t seqlen, _outit2 itout )
+        {
+            while( seqlen != 0 )
+            {
+                const size_t len = (seqlen < MaxCopyLen)? seqlen : MaxCopyLen;
+                (*itout) = static_cast<uint8_t>( CMD_CopyBytesBeg + (len - 1) );
+                ++itout;
+                for( size_t i = 0; i < len; ++i, ++itout )
+                    (*itout) = table[seqbeg + i];
+                seqbeg += len;
+                seqlen -= len;
+            }
+            return itout;
+        }
+
+    private:
+        init_t m_itbeg;
+        init_t m_itend;
+    };
+
 };
 #endif
@@ -14,7 +14,12 @@
 #include <Poco/DirectoryIterator.h>
 #include <Poco/File.h>
 #include <Poco/Path.h>
+#include <Poco/SharedMemory.h>
 #include <utils/gbyteutils.hpp>
+#include <utils/library_wide.hpp>
+#include <utils/multiple_task_handler.hpp>
+#include <functional>
+#include <atomic>
 using namespace std;
 using namespace gimg;
 using namespace pmd2;
@@ -46,6 +51,12 @@ namespace filetypes
         Poco::File myfile;
     };
 
+    //Same thing, for the memory mapped kaomado used by CKaomadoReader
+    struct kao_mapped_file
+    {
+        Poco::SharedMemory view;
+    };
+
 //========================================================================================================
 //  KaoParser
 //========================================================================================================
@@ -414,7 +425,7 @@ namespace filetypes
         m_exportType       = eSUPPORT_IMG_IO::PNG;
         m_curOffTocSub     = 0;
         m_lastNullEntryVal = 0;
-        m_imgBuff.resize(0);
+        m_compressedPorts.resize(0);
         m_outBuff.resize(0);
     }
 
@@ -461,6 +472,9 @@ namespace filetypes
         //Make aliases
         const auto & toc = m_pExportFrom->m_tableofcontent;
 
+        //PNGs are encoded on the worker threads while we go through the ToC
+        utils::io::ParallelPNGWriter pngwriter;
+
         for( tocsz_t i = 1; i < toc.size(); )
         {
             //Create the sub-folder name
@@ -476,7 +490,7 @@ namespace filetypes
                 cout << "Writing TocEntry #" <<right <<setw(4) <<setfill('0') <<i <<" to " << Poco::Path(outfoldernamess.str()).getBaseName() <<"/..\n"; 
             }
 
-            ExportAToCEntry( toc[i]._portraitsentries, outfoldernamess.str() );
+            ExportAToCEntry( toc[i]._portraitsentries, outfoldernamess.str(), pngwriter );
 
             //Increment counter here, for the completion indicator to work
             ++i;
@@ -487,11 +501,16 @@ namespace filetypes
             }
 
         }
+
+        size_t nbfailed = pngwriter.WaitAllWritten();
+        if( nbfailed != 0 )
+            cerr << "\n<!>-WARNING: KaoWriter::ExportToFolders() : " <<nbfailed <<" portrait(s) couldn't be written!\n";
+
         if( !m_bQuiet || m_bVerbose )
             cout<<"\n";
     }
 
-    void KaoWriter::ExportAToCEntry( const std::vector<tocsubentry_t> & entry, const string & directoryname )
+    void KaoWriter::ExportAToCEntry( const std::vector<tocsubentry_t> & entry, const string & directoryname, utils::io::ParallelPNGWriter & pngwriter )
     {
         bool bmadeafolder = false; //Whether we made a folder already for this entry.
                                    // We're doing it this way, because we don't want to create empty folders 
@@ -534,7 +553,7 @@ namespace filetypes
                 else //If all else fail, export to PNG !
                 {
                     strsOutputPath <<"." << PNG_FileExtension;
-                    ExportToPNG( m_pExportFrom->m_imgdata[entry[j]], strsOutputPath.str() );
+                    pngwriter.Queue( m_pExportFrom->m_imgdata[entry[j]], strsOutputPath.str() );
                 }
 
                 if( m_bVerbose )
@@ -561,21 +580,32 @@ namespace filetypes
         //#0 - Gather some stats and do some checks
         const unsigned int  SzToCEntry       = m_pExportFrom->m_nbtocsubentries       * SUBENTRY_SIZE;
         const unsigned int  Expected_ToC_Len = m_pExportFrom->m_tableofcontent.size() * SzToCEntry;
-        auto                resultlenghts    = m_pExportFrom->EstimateKaoLenAndBiggestImage();
-        const unsigned int  estimatedlength  = resultlenghts.first;
-        unsigned int        szBiggestImg     = resultlenghts.second;
         unsigned int        curoffsetToc     = 0;
         unsigned int        cptcompletion    = 0;
         unsigned int        nbentries        = m_pExportFrom->m_tableofcontent.size();
 
+        //#1 - Compress all the portraits first, then we know exactly how long the file will be
+        if( !m_bQuiet )
+            cout << "Compressing portraits..\n";
+        CompressAllPortraits();
+
+        unsigned int totallength = Expected_ToC_Len;
+        for( const auto & tocentry : m_pExportFrom->m_tableofcontent )
+        {
+            for( const auto & portrait : tocentry._portraitsentries )
+            {
+                if( CKaomado::isToCSubEntryValid( portrait ) )
+                    totallength += m_compressedPorts[portrait].size();
+            }
+        }
+
         //Allocate memory
-        m_imgBuff.reserve( szBiggestImg );
-        m_outBuff.reserve( utils::CalculatePaddedLengthTotal( estimatedlength, 16u ) ); //align on 16 bytes
+        m_outBuff.reserve( utils::CalculatePaddedLengthTotal( totallength, 16u ) ); //align on 16 bytes
 
         //Resize raw output buf to ToC lenght so we can begin inserting data afterwards
         m_outBuff.resize( Expected_ToC_Len, 0 ); 
 
-        //#2 - Skip the ToC in the output, and begin outputing portraits, writing down their offset as we go.
+        //#2 - Skip the ToC in the output, and begin outputing portraits in order, writing down their offset as we go.
         if( !m_bQuiet )
             cout << "Building kaomado file..\n";
 
@@ -621,63 +651,132 @@ namespace filetypes
         //Doing this to avoid a copy, and make sure that in case of re-use, the state of our internal vector is still valid!
         vector<uint8_t> temp;
         std::swap( m_outBuff, temp );
+        m_compressedPorts.resize(0);
 
         //Done, move the vector
         return std::move( temp );
     }
 
-    void KaoWriter::WriteAPortrait( const kao_toc_entry::subentry_t & portrait )
+    void KaoWriter::CompressAllPortraits()
     {
-        //First set both to the last valid end of data offset. "null" them out basically!
-        tocsubentry_t portraitpointer = m_lastNullEntryVal; //The offset from the beginning where we'll insert any new data!
+        const auto & imgdata = m_pExportFrom->m_imgdata;
 
-        //Make sure we output a computed file offset for valid entry, and just the entry's value if the pointer value is invalid
-        if( CKaomado::isToCSubEntryValid( portrait ) )
+        //The image to compress, and the first ToC slot refering to it
+        struct portslot
         {
-            //If we have data to write
-            auto & currentimg = m_pExportFrom->m_imgdata[portrait];
-            portraitpointer   = m_outBuff.size(); //Set the current size as the offset to insert our stuff!
+            size_t dataindex;
+            size_t tocindex;
+            size_t subentry;
+        };
 
-            if( m_bVerbose )
+        //Only compress the images the ToC refers to, once each, in the order they'll be written in
+        const auto       & toc = m_pExportFrom->m_tableofcontent;
+        vector<bool>       isreferred( imgdata.size(), false );
+        vector<portslot>   tocompress;
+        for( size_t i = 0; i < toc.size(); ++i )
+        {
+            for( size_t j = 0; j < toc[i]._portraitsentries.size(); ++j )
             {
-                cout <<hex <<showbase <<portraitpointer <<dec <<noshowbase;
+                const tocsubentry_t portrait = toc[i]._portraitsentries[j];
+                if( CKaomado::isToCSubEntryValid( portrait ) && !isreferred[portrait] )
+                {
+                    isreferred[portrait] = true;
+                    tocompress.push_back( portslot{ static_cast<size_t>(portrait), i, j } );
+                }
             }
+        }
+        std::atomic<uint32_t> nbreused(0);
 
-            //#3.1 - Write palette
-            graphics::WriteRawPalette_RGB24_As_RGB24( m_itOutBuffPushBack, currentimg.getPalette().begin(), currentimg.getPalette().end() );
+        m_compressedPorts.resize(0);
+        m_compressedPorts.resize( imgdata.size() );
 
-            if( m_bVerbose )
+        //Each portrait is compressed on its own into its own buffer, so the result doesn't depend on the order they're done in
+        auto lambdaCompress = [&]( const portslot & slot )
+        {
+            const auto      & currentimg = imgdata[slot.dataindex];
+            vector<uint8_t>   rawimg;
+            vector<uint8_t> & compressed = m_compressedPorts[slot.dataindex];
+            rawimg.reserve( (currentimg.getSizeInBits() / 8u) + 1u );
+
+            // Make a raw tiled image
+            WriteTiledImg( std::back_inserter(rawimg), currentimg, KAO_PORTRAIT_PIXEL_ORDER_REVERSED );
+
+            // Palette first, then the at4px container
+            compressed.reserve( KAO_PORTRAIT_PAL_LEN + at4px_header::HEADER_SZ + rawimg.size() + (rawimg.size() / 8u) );
+            graphics::WriteRawPalette_RGB24_As_RGB24( std::back_inserter(compressed), currentimg.getPalette().begin(), currentimg.getPalette().end() );
+
+            vector<uint8_t> prevport;
+            if( IsSameAsPreviousPortrait( slot.tocindex, slot.subentry, compressed, rawimg, prevport ) )
             {
-                cout <<" ..PalOK!";
+                compressed = std::move(prevport);
+                ++nbreused;
+                return;
             }
 
-            //Keep track of where the at4px begins
-            auto offsetafterpal = m_outBuff.size();
+            CompressToAT4PX( rawimg.begin(), 
+                             rawimg.end(), 
+                             std::back_inserter(compressed),
+                             compression::ePXCompLevel::LEVEL_3,
+                             m_bZealousStrSearch );
+        };
+
+        const size_t nbports = tocompress.size();
+        multitask::ParallelForChunks( nbports, [&]( size_t i ){ lambdaCompress( tocompress[i] ); } );
 
-            //#3.2 - Compress the image
-            unsigned int curimgmaxsz      = (currentimg.getSizeInBits() / 8u) +
-                                            ( (currentimg.getSizeInBits() % 8u != 0)? 1u : 0u); //Add one more just in case we ever overflow a byte (fat chance..)
-            unsigned int curimgszandheadr = curimgmaxsz + at4px_header::HEADER_SZ;
+        if( m_pPrevKao != nullptr && !m_bQuiet )
+            cout <<"Reused " <<nbreused <<" unchanged portrait(s) out of " <<nbports <<"!\n";
+    }
 
-            // Make a raw tiled image
-            m_imgBuff.resize(0);
-            WriteTiledImg( m_itImgBuffPushBack, currentimg, KAO_PORTRAIT_PIXEL_ORDER_REVERSED );
+    bool KaoWriter::IsSameAsPreviousPortrait( size_t tocindex, size_t subentry, const std::vector<uint8_t> & rawpal, const std::vector<uint8_t> & rawimg, std::vector<uint8_t> & out_prevport )const
+    {
+        if( m_pPrevKao == nullptr || tocindex >= m_pPrevKao->size() || subentry >= m_pPrevKao->getNbSubEntries() )
+            return false;
+
+        try
+        {
+            if( !m_pPrevKao->HasPortrait( tocindex, subentry ) )
+                return false;
+
+            //Compare the palette, then the decompressed pixels
+            out_prevport = m_pPrevKao->GetRawPortrait( tocindex, subentry );
+            if( out_prevport.size() < KAO_PORTRAIT_PAL_LEN || !std::equal( rawpal.begin(), rawpal.end(), out_prevport.begin() ) )
+                return false;
+
+            vector<uint8_t> previmg;
+            DecompressAT4PX( out_prevport.begin() + KAO_PORTRAIT_PAL_LEN, out_prevport.end(), previmg );
+            return previmg == rawimg;
+        }
+        catch( const exception & e )
+        {
+            //If the previous portrait can't be read, just compress the new one
+            clog <<"<!>-Warning: KaoWriter::IsSameAsPreviousPortrait(): Couldn't read previous portrait " <<tocindex <<"/" <<subentry <<": " <<e.what() <<"\n";
+            return false;
+        }
+    }
+
+    void KaoWriter::WriteAPortrait( const kao_toc_entry::subentry_t & portrait )
+    {
+        //First set both to the last valid end of data offset. "null" them out basically!
+        tocsubentry_t portraitpointer = m_lastNullEntryVal; //The offset from the beginning where we'll insert any new data!
+
+        //Make sure we output a computed file offset for valid entry, and just the entry's value if the pointer value is invalid
+        if( CKaomado::isToCSubEntryValid( portrait ) )
+        {
+            //If we have data to write
+            portraitpointer = m_outBuff.size(); //Set the current size as the offset to insert our stuff!
 
             if( m_bVerbose )
             {
-                cout <<" ..ImgOK!";
+                cout <<hex <<showbase <<portraitpointer <<dec <<noshowbase;
             }
 
-            //#3.3 - Expand the output to at least the raw image's length, then write at4px
-            compression::px_info_header pxinf = CompressToAT4PX( m_imgBuff.begin(), 
-                                                                 m_imgBuff.end(), 
-                                                                 m_itOutBuffPushBack,
-                                                                 compression::ePXCompLevel::LEVEL_3,
-                                                                 m_bZealousStrSearch );
+            //#3 - Append the palette and AT4PX container compressed earlier
+            const vector<uint8_t> & compressed = m_compressedPorts[portrait];
+            m_outBuff.insert( m_outBuff.end(), compressed.begin(), compressed.end() );
 
             if( m_bVerbose )
             {
-                cout <<" ..CompressOK!";
+                cout <<" ..Wrote " <<compressed.size() <<" bytes!";
             }
 
             //Update the last valid end of data offset (We fill any subsequent invalid entry with this value!)
@@ -716,43 +815,165 @@ namespace filetypes
         return numeric_limits<tocsubentry_t>::min();
     }
 
-    pair<uint32_t,uint32_t> CKaomado::EstimateKaoLenAndBiggestImage()const
+    std::vector<kao_toc_entry>::size_type CKaomado::AddImageToDataVector( data_t && img )
     {
-        //Estimate kaomado worst case scenario length. (The size as if all images weren't compressed)
-        unsigned int estimatedlength = m_tableofcontent.size() * (m_nbtocsubentries * SUBENTRY_SIZE);
-        unsigned int szBiggestImg    = 0;
+        m_imgdata.push_back(img);
+        return m_imgdata.size() - 1;
+    }
+
+    std::vector<kao_toc_entry>::size_type CKaomado::AddImageToDataVector( const data_t & img )
+    {
+        m_imgdata.push_back(img);
+        return m_imgdata.size() - 1;
+    }
+
+//========================================================================================================
+//  CKaomadoReader
+//========================================================================================================
+
+    CKaomadoReader::CKaomadoReader( const std::string & kaopath, unsigned int cachesize, unsigned int nbsubentries )
+        :m_pbeg(nullptr), m_pend(nullptr), m_nbtocsubentries(nbsubentries), m_cachesize( (cachesize != 0)? cachesize : 1 )
+    {
+        Poco::File filein(kaopath);
+        if( !filein.exists() || !filein.isFile() )
+            throw std::runtime_error( "CKaomadoReader::CKaomadoReader(): File \"" + kaopath + "\" doesn't exist !" );
+        if( filein.getSize() == 0 )
+            throw std::runtime_error( "CKaomadoReader::CKaomadoReader(): File \"" + kaopath + "\" is empty !" );
+
+        m_pfile.reset( new kao_mapped_file{ Poco::SharedMemory( filein, Poco::SharedMemory::AM_READ ) } );
+        m_pbeg = reinterpret_cast<const uint8_t*>( m_pfile->view.begin() );
+        m_pend = reinterpret_cast<const uint8_t*>( m_pfile->view.end() );
+        ParseToC();
+    }
 
-        //Use the ToC to count only valid entries!
+    CKaomadoReader::~CKaomadoReader()
+    {}
+
+    void CKaomadoReader::ParseToC()
+    {
+        //Same as KaoParser, the first non-null pointer is right after the ToC, and tells us its length
+        const size_t filelen        = std::distance( m_pbeg, m_pend );
+        const size_t entrylen       = m_nbtocsubentries * SUBENTRY_SIZE;
+        auto         itfirstnonnull = std::find_if( m_pbeg, m_pend, [](uint8_t val){ return val != 0; } );
+
+        if( itfirstnonnull == m_pend )
+            throw std::runtime_error("CKaomadoReader::ParseToC(): Entire kaomado is null!");
+
+        const size_t firstentrylen = std::distance( m_pbeg, itfirstnonnull );
+        if( ( firstentrylen / SUBENTRY_SIZE ) > m_nbtocsubentries )
+            throw std::length_error("CKaomadoReader::ParseToC(): First null entry has unexpected length of " + std::to_string(firstentrylen) );
+
+        auto           itfirstptr   = m_pbeg + ( (firstentrylen / SUBENTRY_SIZE) * SUBENTRY_SIZE );
+        const uint32_t tocend       = utils::ReadIntFromBytes<uint32_t>( itfirstptr, m_pend );
+        const size_t   nbtocentries = tocend / entrylen;
+
+        if( nbtocentries * entrylen > filelen )
+            throw std::length_error("CKaomadoReader::ParseToC(): Table of content is longer than the file!");
+
+        //Only keep the file offsets, anything invalid is set to invalid
+        m_tableofcontent.resize( nbtocentries, kao_toc_entry(m_nbtocsubentries) );
+        auto itread = m_pbeg;
         for( auto & entry : m_tableofcontent )
         {
             for( auto & subentry : entry._portraitsentries )
             {
-                if( isToCSubEntryValid( subentry ) )
-                {
-                    unsigned int  currentimgsz = (m_imgdata[subentry].getSizeInBits() / 8u) + 
-                                                 KAO_PORTRAIT_PAL_LEN + 
-                                                 at4px_header::HEADER_SZ;
-
-                    if( szBiggestImg < currentimgsz ) //Keep track of the largest image, so we can avoid resizing our compression buffer later on
-                        szBiggestImg = (currentimgsz / 8u) + currentimgsz; //Reserve some extra space for command bytes just in case
-
-                    estimatedlength += (currentimgsz / 8u) + currentimgsz; //Reserve some extra space for command bytes just in case
-                }
+                subentry = utils::ReadIntFromBytes<tocsubentry_t>( itread, m_pend );
+                if( !CKaomado::isToCSubEntryValid(subentry) || static_cast<size_t>(subentry) >= filelen )
+                    subentry = CKaomado::GetInvalidToCEntry();
             }
         }
-        return make_pair(estimatedlength, szBiggestImg);
     }
 
-    std::vector<kao_toc_entry>::size_type CKaomado::AddImageToDataVector( data_t && img )
+    CKaomadoReader::tocsubentry_t CKaomadoReader::GetToCSubEntry( std::size_t tocindex, std::size_t subentry )const
     {
-        m_imgdata.push_back(img);
-        return m_imgdata.size() - 1;
+        if( tocindex >= m_tableofcontent.size() || subentry >= m_nbtocsubentries )
+        {
+            stringstream sstr;
+            sstr <<"CKaomadoReader::GetToCSubEntry(): Portrait " <<tocindex <<"/" <<subentry <<" is out of the table of content!";
+            throw std::out_of_range( sstr.str() );
+        }
+        return m_tableofcontent[tocindex]._portraitsentries[subentry];
     }
 
-    std::vector<kao_toc_entry>::size_type CKaomado::AddImageToDataVector( const data_t & img )
+    bool CKaomadoReader::HasPortrait( std::size_t tocindex, std::size_t subentry )const
     {
-        m_imgdata.push_back(img);
-        return m_imgdata.size() - 1;
+        return CKaomado::isToCSubEntryValid( GetToCSubEntry(tocindex, subentry) );
+    }
+
+    std::vector<uint8_t> CKaomadoReader::GetRawPortrait( std::size_t tocindex, std::size_t subentry )const
+    {
+        const tocsubentry_t offset = GetToCSubEntry(tocindex, subentry);
+        if( !CKaomado::isToCSubEntryValid(offset) )
+            return std::vector<uint8_t>();
+
+        //Skip palette, and read at4px header to get the length of the portrait
+        const size_t filelen = std::distance( m_pbeg, m_pend );
+        const size_t hdrpos  = static_cast<size_t>(offset) + KAO_PORTRAIT_PAL_LEN;
+        if( hdrpos + at4px_header::HEADER_SZ > filelen )
+            throw std::out_of_range("CKaomadoReader::GetRawPortrait(): Portrait header is past the end of the file!");
+
+        at4px_header head;
+        head.ReadFromContainer( m_pbeg + hdrpos, m_pend );
+        const size_t portraitend = hdrpos + head.compressedsz;
+        if( portraitend > filelen )
+            throw std::out_of_range("CKaomadoReader::GetRawPortrait(): Portrait data is past the end of the file!");
+
+        return std::vector<uint8_t>( m_pbeg + offset, m_pbeg + portraitend );
+    }
+
+    CKaomadoReader::portrait_ptr_t CKaomadoReader::GetPortrait( std::size_t tocindex, std::size_t subentry )
+    {
+        if( !HasPortrait(tocindex, subentry) )
+            return nullptr;
+
+        const size_t key = (tocindex * m_nbtocsubentries) + subentry;
+        {
+            lock_guard<mutex> lck(m_cachemtx);
+            auto itfound = m_cacheindex.find(key);
+            if( itfound != m_cacheindex.end() )
+            {
+                m_lru.splice( m_lru.begin(), m_lru, itfound->second );
+                return itfound->second->second;
+            }
+        }
+
+        //Decode without holding the lock, so other threads can get portraits in the meantime
+        const vector<uint8_t> rawport = GetRawPortrait(tocindex, subentry);
+        auto                  itpalend = rawport.begin() + KAO_PORTRAIT_PAL_LEN;
+        vector<uint8_t>       imgbuf;
+        shared_ptr<data_t>    pport    = make_shared<data_t>();
+
+        graphics::ReadRawPalette_RGB24_As_RGB24( rawport.begin(), itpalend, pport->getPalette() );
+        DecompressAT4PX( itpalend, rawport.end(), imgbuf );
+        ParseTiledImg<data_t>( imgbuf.begin(), 
+                               imgbuf.end(), 
+                               graphics::RES_PORTRAIT, 
+                               *pport, 
+                               KAO_PORTRAIT_PIXEL_ORDER_REVERSED );
+
+        lock_guard<mutex> lck(m_cachemtx);
+        auto itfound = m_cacheindex.find(key);
+        if( itfound != m_cacheindex.end() ) //Another thread decoded it first
+        {
+            m_lru.splice( m_lru.begin(), m_lru, itfound->second );
+            return itfound->second->second;
+        }
+
+        m_lru.emplace_front( key, std::move(pport) );
+        m_cacheindex.emplace( key, m_lru.begin() );
+        if( m_lru.size() > m_cachesize )
+        {
+            m_cacheindex.erase( m_lru.back().first );
+            m_lru.pop_back();
+        }
+        return m_lru.front().second;
+    }
+
+    void CKaomadoReader::ClearCache()
+    {
+        lock_guard<mutex> lck(m_cachemtx);
+        m_cacheindex.clear();
+        m_lru.clear();
     }
 
 };
\ No newline at end of file
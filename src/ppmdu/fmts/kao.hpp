@@ -21,9 +21,15 @@ https://github.com/Zhorken
 #include <vector>
 #include <string>
 #include <utility>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
 
 using namespace utils::io;
 
+namespace utils{ namespace io{ class ParallelPNGWriter; };};
+
 namespace filetypes
 {
 //==================================================================
@@ -49,6 +55,7 @@ namespace filetypes
         Forward declare to cover up the Poco::File type from our libraries!
     */
     struct kao_file_wrapper;
+    struct kao_mapped_file;
 
     /*
         kao_toc_entry
@@ -80,6 +87,7 @@ namespace filetypes
 // Functors
 //==================================================================
     class CKaomado;
+    class CKaomadoReader;
 
     /********************************************************************************  
         KaoParser
@@ -136,6 +144,10 @@ namespace filetypes
     /******************************************************************************** 
         KaoWriter
             A functor for writing/exporting portraits data into a kaomado.kao file!
+
+            If a previous version of the kaomado is passed, portraits whose pixels and 
+            palette are the same as the one in the same slot of the previous kaomado
+            reuse its compressed data as-is, instead of being compressed again.
     ********************************************************************************/
     class KaoWriter
     {
@@ -149,15 +161,16 @@ namespace filetypes
                    const std::vector<std::string> *  psubentrynames   = nullptr,
                    bool                              zealousstrsearch = true, 
                    bool                              bequiet          = false,
-                   bool                              bverbose         = false )
+                   bool                              bverbose         = false,
+                   const CKaomadoReader *            pprevkao         = nullptr )
             :m_bZealousStrSearch(zealousstrsearch), 
              m_pExportFrom(nullptr), 
              m_bQuiet(bequiet),
              m_pFolderNames(pfoldernames), 
              m_pSubEntryNames(psubentrynames),
-             m_itImgBuffPushBack(std::back_inserter(m_imgBuff)),
              m_itOutBuffPushBack(std::back_inserter(m_outBuff)),
-             m_bVerbose(bverbose)
+             m_bVerbose(bverbose),
+             m_pPrevKao(pprevkao)
         {}
 
         //This will export a CKaomado to a "kaomado.kao" file, but will return the buffer directly
@@ -174,9 +187,12 @@ namespace filetypes
         void Reset();
 
         void ExportToFolders();
-        void ExportAToCEntry( const std::vector<tocsubentry_t> & entry, const std::string & directoryname );
+        void ExportAToCEntry( const std::vector<tocsubentry_t> & entry, const std::string & directoryname, utils::io::ParallelPNGWriter & pngwriter );
 
         std::vector<uint8_t> WriteToKaomado();
+        void                 CompressAllPortraits();
+        //If the portrait is the same as in the previous kaomado, returns true and puts the previous portrait's raw data into "out_prevport"
+        bool                 IsSameAsPreviousPortrait( std::size_t tocindex, std::size_t subentry, const std::vector<uint8_t> & rawpal, const std::vector<uint8_t> & rawimg, std::vector<uint8_t> & out_prevport )const;
         void                 WriteAPortrait( const kao_toc_entry::subentry_t & portrait );
 
     private:
@@ -185,6 +201,7 @@ namespace filetypes
         const CKaomado                 *m_pExportFrom;          //The kaomado container to use as source
         const std::vector<std::string> *m_pFolderNames;         //The string list for the names to give to the exported folders
         const std::vector<std::string> *m_pSubEntryNames;       //The string list for the names to give to the exported subentry images
+        const CKaomadoReader           *m_pPrevKao;             //The previous version of the kaomado, to reuse unchanged portraits from. Can be null
         bool                            m_bZealousStrSearch;    //Whether compression will use zealous string search
         bool                            m_bQuiet;               //Whether we should print at the console
         bool                            m_bVerbose;             //Whether to print more verbose output
@@ -192,8 +209,7 @@ namespace filetypes
         //Temporary variables - kaomado.kao output
         std::vector<uint8_t>                            m_outBuff;             //Kaomado output buffer
         std::back_insert_iterator<std::vector<uint8_t>> m_itOutBuffPushBack;   //back_inserter on m_outBuff
-        std::vector<uint8_t>                            m_imgBuff;             //Used to compress image
-        std::back_insert_iterator<std::vector<uint8_t>> m_itImgBuffPushBack;   //back_inserter on m_imgBuff
+        std::vector<std::vector<uint8_t>>               m_compressedPorts;     //Palette and AT4PX data of each portraits, by index in the image data vector
         tocsubentry_t                                   m_lastNullEntryVal;    //This is the null value to use currently, when writing the kaomado
         uint32_t                                        m_curOffTocSub;        //This is the offset to write at in the output buffer the next pointer in the ToC
 
@@ -214,6 +230,7 @@ namespace filetypes
     {
         friend class KaoWriter;
         friend class KaoParser;
+        friend class CKaomadoReader;
     public:
         //Typedef:
         typedef kao_toc_entry::subentry_t                                             tocsubentry_t;
@@ -234,9 +251,6 @@ namespace filetypes
 
         static inline bool isToCSubEntryValid( const tocsubentry_t & entry ) { return (entry > 0); }
 
-        //Value1 is toclen, value2 is biggest image len!
-        std::pair<uint32_t,uint32_t> EstimateKaoLenAndBiggestImage()const;
-
         //Return the offset where it was added in the data vector
         std::vector<kao_toc_entry>::size_type AddImageToDataVector( data_t && img ); //moves the image
         std::vector<kao_toc_entry>::size_type AddImageToDataVector( const data_t & img ); //Copy the image
@@ -249,6 +263,79 @@ namespace filetypes
         std::vector<data_t>         m_imgdata;
     };
 
+    /******************************************************************
+        CKaomadoReader
+            Read-only access to the portraits of a kaomado.kao file,
+            for when only a few portraits are needed.
+
+            Only the table of content is parsed when opening the file.
+            The file stays mapped in memory, and portraits are only
+            decompressed when they're requested. The last "cachesize"
+            portraits decoded are kept around.
+
+            Portraits can be requested from several threads at once.
+    ******************************************************************/
+    class CKaomadoReader
+    {
+    public:
+        typedef CKaomado::tocsubentry_t         tocsubentry_t;
+        typedef CKaomado::data_t                data_t;
+        typedef std::shared_ptr<const data_t>   portrait_ptr_t;
+
+        static const unsigned int SUBENTRY_SIZE    = kao_toc_entry::SUBENTRY_SIZE;
+        static const unsigned int DefNbCachedPorts = 32;
+
+        CKaomadoReader( const std::string & kaopath, 
+                        unsigned int        cachesize    = DefNbCachedPorts, 
+                        unsigned int        nbsubentries = DEF_KAO_TOC_ENTRY_NB_PTR );
+        ~CKaomadoReader();
+
+        //Amount of entries in the table of content, and of portrait slots in each
+        inline std::size_t  size()const            { return m_tableofcontent.size(); }
+        inline unsigned int getNbSubEntries()const { return m_nbtocsubentries; }
+
+        //Throws out_of_range if the indices are out of the table of content
+        bool HasPortrait( std::size_t tocindex, std::size_t subentry )const;
+
+        /*
+            GetPortrait
+                Returns the decoded portrait, or nullptr if the slot is empty.
+                The image stays valid after it was dropped from the cache.
+        */
+        portrait_ptr_t GetPortrait( std::size_t tocindex, std::size_t subentry );
+
+        /*
+            GetRawPortrait
+                Returns the portrait as it is stored in the file, its palette followed by its
+                AT4PX container. Returns an empty vector if the slot is empty.
+        */
+        std::vector<uint8_t> GetRawPortrait( std::size_t tocindex, std::size_t subentry )const;
+
+        void ClearCache();
+
+    private:
+        //No copies
+        CKaomadoReader( const CKaomadoReader & );
+        CKaomadoReader & operator=( const CKaomadoReader & );
+
+        void          ParseToC();
+        tocsubentry_t GetToCSubEntry( std::size_t tocindex, std::size_t subentry )const;
+
+        typedef std::list<std::pair<std::size_t, portrait_ptr_t>> lrulist_t;
+
+        std::unique_ptr<kao_mapped_file>                     m_pfile;
+        const uint8_t                                       *m_pbeg;
+        const uint8_t                                       *m_pend;
+        unsigned int                                         m_nbtocsubentries;
+        std::vector<kao_toc_entry>                           m_tableofcontent;  //Contains the file offsets of the portraits
+
+        //Decoded portraits, most recently used first
+        std::size_t                                          m_cachesize;
+        lrulist_t                                            m_lru;
+        std::unordered_map<std::size_t, lrulist_t::iterator> m_cacheindex;
+        std::mutex                                           m_cachemtx;
+    };
+
 
 };
 
@@ -186,10 +186,13 @@ namespace filetypes
             Intermediate format for the transition between the 
             data parsed from the ssb file and the compiler/decompiler.
     */
+    typedef std::vector<std::string>                            rawstrtbl_t;
+    typedef std::unordered_map<eGameLanguages, rawstrtbl_t>     rawstrtblset_t;
+
     struct raw_ssb_content
     {
-        Script::consttbl_t  constantstrings;
-        Script::strtblset_t strings;
+        rawstrtbl_t         constantstrings;
+        rawstrtblset_t      strings;
         lbltbl_t                      jumpoffsets;
         rawroutines_t                 rawroutines;
         rawinst_t                     rawinstructions;
@@ -253,18 +256,20 @@ namespace filetypes
 
             PrepareStringsAndConstants();
 
-            //Transfer the strings and constants over.
-            destseq.ConstTbl()  = std::move(m_rawdata.constantstrings);
-            destseq.StrTblSet() = std::move(m_rawdata.strings);
+            //Transfer the strings and constants over into the script's string pool.
+            destseq.SetConstTbl( m_rawdata.constantstrings.begin(), m_rawdata.constantstrings.end() );
+            for( const auto & lang : m_rawdata.strings )
+                destseq.InsertStrLanguage( lang.first, lang.second.begin(), lang.second.end() );
         }
 
         /*-----------------------------------------------------------------------------
             operator()
-                Returns the processed script sequence
+                Returns the processed script sequence. Its strings are stored into "strpool",
+                or into a new pool if null.
         -----------------------------------------------------------------------------*/
-        inline Script operator()(bool escapeforxml, bool bscriptdebug )
+        inline Script operator()(bool escapeforxml, bool bscriptdebug, std::shared_ptr<ScriptStringPool> strpool = nullptr )
         {
-            Script dest;
+            Script dest( std::string(), std::move(strpool) );
             operator()(dest,escapeforxml, bscriptdebug);
             return std::move(dest);
         }
@@ -564,8 +569,8 @@ namespace filetypes
         deque<ScriptInstruction>            & m_rawinst;
         const rawroutines_t                 & m_routines;
         const lbltbl_t                      & m_labels;
-        const Script::consttbl_t            & m_constants;
-        const Script::strtblset_t           & m_strings;
+        const rawstrtbl_t                   & m_constants;
+        const rawstrtblset_t                & m_strings;
         Script::grptbl_t                    * m_poutroutines;
         size_t                                m_curroutine;           //Group we currently output into
         size_t                                m_curdataoffset;      //Offset in bytes within the Data chunk
@@ -601,9 +606,9 @@ namespace filetypes
         /*******************************************************************************
             Parse
         *******************************************************************************/
-        inline Script Parse(bool parseforxml = true, bool scriptdebug = false)
+        inline Script Parse(bool parseforxml = true, bool scriptdebug = false, std::shared_ptr<ScriptStringPool> strpool = nullptr)
         {
-            return std::move(ScriptDecompiler(std::move(ParseToRaw()), m_scrversion, m_langdat)(parseforxml, scriptdebug));
+            return std::move(ScriptDecompiler(std::move(ParseToRaw()), m_scrversion, m_langdat)(parseforxml, scriptdebug, std::move(strpool)));
         }
 
         /*******************************************************************************
@@ -728,36 +733,36 @@ namespace filetypes
         /*******************************************************************************
             ParseConstants
         *******************************************************************************/
-        Script::consttbl_t ParseConstants()
+        rawstrtbl_t ParseConstants()
         {
             if( !m_nbconsts )
-                return Script::consttbl_t();
+                return rawstrtbl_t();
 
             const size_t strlutlen = (m_nbstrs * ScriptWordLen); // In the file, the offset for each constants in the constant table includes the 
                                                                  // length of the string lookup table(string pointers). Here, to compensate
                                                                  // we subtract the length of the string LUT from each pointer read.
-            return std::move(ParseOffsetTblAndStrings<Script::consttbl_t>( m_constlutbeg, m_constlutbeg, m_nbconsts, strlutlen ));
+            return std::move(ParseOffsetTblAndStrings<rawstrtbl_t>( m_constlutbeg, m_constlutbeg, m_nbconsts, strlutlen ));
         }
 
         /*******************************************************************************
             SetupLanguageTbl
         *******************************************************************************/
         //Setup all the correct languages in the string table
-        inline void SetupLanguageTbl( Script::strtblset_t & out )
+        inline void SetupLanguageTbl( rawstrtblset_t & out )
         {
             for( const auto & lg : m_stringblksSizes )
-                out.emplace( lg.first, std::move(Script::strtbl_t()) ); //Make the entry for this language
+                out.emplace( lg.first, std::move(rawstrtbl_t()) ); //Make the entry for this language
         }
 
         /*******************************************************************************
             ParseStrings
         *******************************************************************************/
-        Script::strtblset_t ParseStrings()
+        rawstrtblset_t ParseStrings()
         {
             if( !m_nbstrs )
-                return Script::strtblset_t();
+                return rawstrtblset_t();
 
-            Script::strtblset_t out;
+            rawstrtblset_t out;
             SetupLanguageTbl(out);
             //Parse the strings for any languages we have
             size_t strparseoffset = m_stringlutbeg;
@@ -767,7 +772,7 @@ namespace filetypes
             //for( auto & lang : out )
             for( auto &block : m_stringblksSizes )
             {
-                out[block.first] = std::move( ParseOffsetTblAndStrings<Script::strtbl_t>( strparseoffset, 
+                out[block.first] = std::move( ParseOffsetTblAndStrings<rawstrtbl_t>( strparseoffset, 
                                                                                      begoffset, 
                                                                                      m_nbstrs ));
                 strparseoffset += block.second; //Add the size of the last block, so we have the offset of the next table
@@ -1133,7 +1138,7 @@ namespace filetypes
             //Un-Escape the characters in the strings and constants
             for( const auto & conststr : m_src.ConstTbl() )
             {
-                m_out.constantstrings.push_back(std::move(ProcessString(conststr)));
+                m_out.constantstrings.push_back(std::move(ProcessString(m_src.Str(conststr).str())));
             }
 
             for( const auto & lang : m_src.StrTblSet() )
@@ -1145,7 +1150,7 @@ namespace filetypes
                 {
                     const StringsCatalog * pcata = m_langs.GetByLanguage(lang.first);
                     if(pcata)
-                        curstrs.push_back(std::move(ProcessString(str, pcata->GetLocaleString())));
+                        curstrs.push_back(std::move(ProcessString(m_src.Str(str).str(), pcata->GetLocaleString())));
                 }
                 m_out.strings.emplace( lang.first, std::forward<vector<string>>(curstrs));
             }
@@ -1512,7 +1517,7 @@ namespace filetypes
     /*
         ParseScript
     */
-    pmd2::Script ParseScript(const std::string & scriptfile, eGameRegion gloc, eGameVersion gvers, const LanguageFilesDB & langdat, bool escapeforxml, bool bscriptdebug )
+    pmd2::Script ParseScript(const std::string & scriptfile, eGameRegion gloc, eGameVersion gvers, const LanguageFilesDB & langdat, bool escapeforxml, bool bscriptdebug, std::shared_ptr<pmd2::ScriptStringPool> strpool )
     {
         vector<uint8_t> fdata( std::move(utils::io::ReadFileToByteVector(scriptfile)) );
         eOpCodeVersion opvers = GameVersionToOpCodeVersion(gvers);
@@ -1524,7 +1529,7 @@ namespace filetypes
         if( opvers == eOpCodeVersion::Invalid )
             throw std::runtime_error("ParseScript(): Wrong game version!!");
 
-        Script tmpscr = std::move( SSB_Parser<vector<uint8_t>::const_iterator>(fdata.begin(), fdata.end(), opvers, gloc, langdat).Parse(escapeforxml, bscriptdebug) );
+        Script tmpscr = std::move( SSB_Parser<vector<uint8_t>::const_iterator>(fdata.begin(), fdata.end(), opvers, gloc, langdat).Parse(escapeforxml, bscriptdebug, std::move(strpool)) );
         tmpscr.SetName( utils::GetBaseNameOnly(scriptfile) );
         return std::move(tmpscr);
     }
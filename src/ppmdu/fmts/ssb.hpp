@@ -127,7 +127,8 @@ namespace filetypes
                               pmd2::eGameVersion            gvers, 
                               const pmd2::LanguageFilesDB & langdat,
                               bool                          escapeforxml, //Whether to use xml escape sequence(&quot; for example) instead of C ones(\n)
-                              bool                          bscriptdebug ); //If true, all debug instructions paths will be toggled on by default!
+                              bool                          bscriptdebug,   //If true, all debug instructions paths will be toggled on by default!
+                              std::shared_ptr<pmd2::ScriptStringPool> strpool = nullptr ); //Pool to store the script's strings into. A new one is made if null.
 
     /***********************************************************************************
         WriteScript
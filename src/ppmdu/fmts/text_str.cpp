@@ -4,6 +4,7 @@
 #include <utils/utility.hpp>
 #include <utils/library_wide.hpp>
 #include <utils/poco_wrapper.hpp>
+#include <utils/string_table.hpp>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -38,21 +39,21 @@ namespace pmd2 { namespace filetypes
             :m_strFilePath(filepath), m_locale(txtloc), m_escapejis(escapejis)
         {}
 
-        operator std::vector<std::string>() //#REMOVEME: Just out of curiosity I wanted to try this!
+        operator utils::StringTable() //#REMOVEME: Just out of curiosity I wanted to try this!
         {
             return Read();
         }
 
-        std::vector<std::string> operator()()
+        utils::StringTable operator()()
         {
             return Read();
         }
 
-        std::vector<std::string> Read()
+        utils::StringTable Read()
         {
             try
             {
-                m_txtstr = vector<string>(); //Ensure the vector has a valid state
+                m_txtstr = utils::StringTable(); //Ensure the table has a valid state
                 m_filedata = utils::io::ReadFileToByteVector( m_strFilePath );
                 //Read pointer table
                 ReadPointerTable();
@@ -95,10 +96,11 @@ namespace pmd2 { namespace filetypes
             const unsigned int PtrTableSize = m_ptrTable.size()-1; // The last pointer is a pointer to the end of the file!
             const unsigned int LastPtrIndex = PtrTableSize - 1;    // Index of the last element before the end
             
-            //Allocate
-            m_txtstr.resize(m_ptrTable.size());
+            //Allocate. The file size is close to the total length of the strings, only a few get longer once escaped.
+            m_txtstr.reserve( m_ptrTable.size(), m_filedata.size() );
             
             //Read them all
+            string curstr;
             for( unsigned int i = 0; i < PtrTableSize;  )
             {
                 unsigned int len = 0;
@@ -110,19 +112,20 @@ namespace pmd2 { namespace filetypes
 
                 //char* ptrstr = reinterpret_cast<char*>(m_filedata.data() + m_ptrTable[i]); //#TODO: think of something faster...
                 auto itcurstr = m_filedata.begin() + m_ptrTable[i];
-                string curstr( itcurstr, itcurstr + len);
+                curstr.assign( itcurstr, itcurstr + len);
                 //curstr.push_back('\0');
 
-                m_txtstr[i] = std::move( EscapeUnprintableCharacters( curstr, m_escapejis, false, m_locale ) );
+                m_txtstr.push_back( EscapeUnprintableCharacters( curstr, m_escapejis, false, m_locale ) );
                 ++i;
             }
+            m_txtstr.push_back( string() ); //The pointer to the end of the file gets an empty entry too
             clog<<" Done!\n";
         }
 
         std::string              m_strFilePath;
         std::vector<uint8_t>     m_filedata;
         std::vector<uint32_t>    m_ptrTable;
-        std::vector<std::string> m_txtstr;
+        utils::StringTable       m_txtstr;
         const std::locale      & m_locale;
         bool                     m_escapejis;
     };
@@ -138,7 +141,7 @@ namespace pmd2 { namespace filetypes
     class TextStrWriter
     {
     public:
-        TextStrWriter( const std::vector<std::string> & textstr, const std::locale & txtloc )
+        TextStrWriter( const utils::StringTable & textstr, const std::locale & txtloc )
             :m_txtstr(textstr), m_locale(txtloc)
         {}
 
@@ -249,7 +252,7 @@ namespace pmd2 { namespace filetypes
 
             for( unsigned int cntstr = 0; cntstr < m_txtstr.size();  )
             {
-                const auto & str = m_txtstr[cntstr];
+                const utils::StrView str = m_txtstr[cntstr];
                 utils::WriteIntToBytes<uint32_t>( m_fileData.size(), m_fileData.begin() + m_ptrTblWriteAt );  //Write string offset
                 m_ptrTblWriteAt += PTR_LEN;
 
@@ -272,7 +275,7 @@ namespace pmd2 { namespace filetypes
                 //    }
                 //}
                 //processed = std::move( ReplaceEscapedCharacters( str, m_locale ) );
-                string processed = str; 
+                string processed = str.str(); 
                 ReplaceEscapedSequenceTest(processed);
 
                 std::copy( processed.begin(), processed.end(), itbackins );
@@ -287,23 +290,28 @@ namespace pmd2 { namespace filetypes
         static const unsigned int        PTR_LEN = sizeof(uint32_t);
         std::vector<uint8_t>             m_fileData;
         uint32_t                         m_ptrTblWriteAt;    //Position to write current str offset at
-        const std::vector<std::string> & m_txtstr;
+        const utils::StringTable       & m_txtstr;
         const std::locale              & m_locale;
     };
 
 //=========================================================================================
 //  Functions
 //=========================================================================================
-    std::vector<std::string> ParseTextStrFile( const std::string & filepath, eGameRegion gver, const std::locale & txtloc )
+    utils::StringTable ParseTextStrFile( const std::string & filepath, eGameRegion gver, const std::locale & txtloc )
     {
         bool escapejis = gver != eGameRegion::Japan;
         //Read the pointer table first
         return TextStrLoader(filepath,txtloc,escapejis); //lol, implicit cast operator
     }
     
-    void WriteTextStrFile( const std::string & filepath, const std::vector<std::string> & text, eGameRegion gver, const std::locale & txtloc )
+    void WriteTextStrFile( const std::string & filepath, const utils::StringTable & text, eGameRegion gver, const std::locale & txtloc )
     {
         TextStrWriter(text,txtloc).Write(filepath);
     }
 
+    void WriteTextStrFile( const std::string & filepath, const std::vector<std::string> & text, eGameRegion gver, const std::locale & txtloc )
+    {
+        WriteTextStrFile( filepath, utils::StringTable(text.begin(), text.end()), gver, txtloc );
+    }
+
 };};
\ No newline at end of file
@@ -8,6 +8,7 @@ Description:
     Utilities for handling the "MESSAGE/text_*.str" files used in PMD2.
 */
 #include <ppmdu/pmd2/pmd2.hpp>
+#include <utils/string_table.hpp>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -30,16 +31,21 @@ namespace pmd2{ namespace filetypes
     
     /*
         ParseTextStrFile
-            Parse a text_*.str file from PMD2, to a string vector.
+            Parse a text_*.str file from PMD2, to a string table.
     */
-    std::vector<std::string> ParseTextStrFile( const std::string              & filepath, 
+    utils::StringTable       ParseTextStrFile( const std::string              & filepath, 
                                                eGameRegion                      gver,
                                                const std::locale              & txtloc = std::locale::classic() );
 
     /*
         WriteTextStrFile
-            Write a string vector to a text_*.str file!
+            Write a string table, or a string vector to a text_*.str file!
     */
+    void                     WriteTextStrFile( const std::string              & filepath, 
+                                               const utils::StringTable       & text, 
+                                               eGameRegion                      gver,
+                                               const std::locale              & txtloc = std::locale::classic() );
+
     void                     WriteTextStrFile( const std::string              & filepath, 
                                                const std::vector<std::string> & text, 
                                                eGameRegion                      gver,
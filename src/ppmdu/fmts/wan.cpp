@@ -364,8 +364,11 @@ namespace filetypes
         {
             uint32_t curPtr = utils::ReadIntFromBytes<uint32_t>( itreadtbl, m_rawdata.end() ); //Iterator auto-incremented
             entry = curPtr;
-            nbMetaF += ( (curPtr - lastPtrRead) / WAN_LENGTH_ANIM_FRM );
-            lastPtrRead = curPtr;
+            if( curPtr > lastPtrRead ) //Groups may be shared, so pointers aren't always increasing
+            {
+                nbMetaF += ( (curPtr - lastPtrRead) / WAN_LENGTH_ANIM_FRM );
+                lastPtrRead = curPtr;
+            }
         }
 
     //#3 - Second pass parse all the meta-frames
@@ -17,10 +17,13 @@ Description: Utilities for reading ".wan" sprite files, and its derivatives.
 #include <ppmdu/containers/tiled_image.hpp>
 #include <ppmdu/pmd2/pmd2_image_formats.hpp>
 #include <utils/library_wide.hpp>
+#include <utils/multiple_task_handler.hpp>
 #include <utils/handymath.hpp>
 #include <atomic>
+#include <memory>
 #include <algorithm>
 #include <type_traits>
+#include <unordered_map>
 #include <iomanip>
 #include <functional>
 
@@ -498,8 +501,17 @@ namespace filetypes
         //Use this to determine which parsing method to use!
         pmd2::graphics::eSpriteImgType getSpriteType()const;
 
+        /*
+            Parse
+                - pProgress     : Optional progress counter.
+                - bDecodeImages : If false, only the headers, palette, meta-frames and animations
+                                  are parsed. The images are decoded the first time the sprite's
+                                  frames are accessed. (See SpriteData::DecodeFrames()) The sprite 
+                                  takes over the raw data, and the parser can't be used anymore afterwards.
+                                  Handy when only the sprite's properties and animations are needed.
+        */
         template<class TIMG_t>
-            pmd2::graphics::SpriteData<TIMG_t> Parse( std::atomic<uint32_t> * pProgress = nullptr )
+            pmd2::graphics::SpriteData<TIMG_t> Parse( std::atomic<uint32_t> * pProgress = nullptr, bool bDecodeImages = true )
         {
             SpriteData<TIMG_t> sprite;
 
@@ -531,22 +543,39 @@ namespace filetypes
             //Build references!
             sprite.RebuildAllReferences();
 
+            if( !bDecodeImages )
+            {
+                //Keep what's needed to decode the images later on. The meta-frames are copied so the 
+                // images end up with the same resolution they'd have had if they were decoded now.
+                std::shared_ptr<WAN_Parser>            pparser  = std::make_shared<WAN_Parser>( std::move(*this) );
+                std::vector<pmd2::graphics::MetaFrame> metafrms( sprite.m_metaframes );
+                std::multimap<uint32_t,uint32_t>       metarefs( sprite.m_metarefs );
+                pparser->m_pProgress = nullptr;
+
+                sprite.m_framedecoder = [pparser, metafrms, metarefs]( pmd2::graphics::SpriteData<TIMG_t> & spr )
+                {
+                    spr.m_imgsinfo.clear();
+                    pparser->ReadImages<TIMG_t>( spr.m_frames, metafrms, metarefs, spr.m_palette, spr.m_imgsinfo );
+                };
+                return std::move( sprite );
+            }
+
             //Read images, use meta frames to get proper res, thanks to the refs!
-            ReadImages<TIMG_t>( sprite.m_frames, sprite.m_metaframes, sprite.m_metarefs, sprite.getPalette(), sprite.getImgsInfo() );
+            ReadImages<TIMG_t>( sprite.m_frames, sprite.m_metaframes, sprite.m_metarefs, sprite.getPalette(), sprite.m_imgsinfo );
 
             return std::move( sprite );
         }
 
         //This parse all images of the sprite as 4bpp!
-        pmd2::graphics::SpriteData<gimg::tiled_image_i4bpp> ParseAs4bpp( std::atomic<uint32_t> * pProgress = nullptr)
+        pmd2::graphics::SpriteData<gimg::tiled_image_i4bpp> ParseAs4bpp( std::atomic<uint32_t> * pProgress = nullptr, bool bDecodeImages = true )
         {
-            return std::move(Parse<gimg::tiled_image_i4bpp>(pProgress));
+            return std::move(Parse<gimg::tiled_image_i4bpp>(pProgress, bDecodeImages));
         }
 
         //This parse all images of the sprite as 8bpp!
-        pmd2::graphics::SpriteData<gimg::tiled_image_i8bpp> ParseAs8bpp(std::atomic<uint32_t> * pProgress = nullptr)
+        pmd2::graphics::SpriteData<gimg::tiled_image_i8bpp> ParseAs8bpp(std::atomic<uint32_t> * pProgress = nullptr, bool bDecodeImages = true )
         {
-            return std::move(Parse<gimg::tiled_image_i8bpp>(pProgress));
+            return std::move(Parse<gimg::tiled_image_i8bpp>(pProgress, bDecodeImages));
         }
 
     private:
@@ -561,6 +590,12 @@ namespace filetypes
                       std::vector<pmd2::graphics::AnimationSequence>    & out_animseqs,
                       std::vector<pmd2::graphics::sprOffParticle>       & out_offsets );
 
+        /*
+            ReadImages
+                Frames are independent from each others once their assembly table is read, so big
+                sprites get their frames decoded on several threads, each into its own preallocated slot.
+                Small sprites, and any sprites while logging is on, are decoded on the calling thread.
+        */
         template<class TIMG_t>
             void ReadImages( std::vector<TIMG_t>                           & out_imgs, 
                              const std::vector<pmd2::graphics::MetaFrame>  & metafrms,
@@ -570,27 +605,34 @@ namespace filetypes
         {
             using namespace std;
             vector<uint8_t>::const_iterator itfrmptr       = (m_rawdata.begin() + m_wanImgDataInfo.ptrImgsTbl); //Make iterator to frame pointer table
-            //uint32_t                        progressBefore = 0; 
-            //ensure capacity
-            out_imgs.resize( m_wanImgDataInfo.nbImgsTblPtr ); 
+            const unsigned int              nbimgs         = m_wanImgDataInfo.nbImgsTblPtr;
+            const size_t                    firstinfo      = out_imginfo.size();
+            vector<uint32_t>                imgptrs(nbimgs);
 
-            //Save a little snapshot of the progress this far
-            //if(m_pProgress != nullptr)
-            //    progressBefore = m_pProgress->load(); 
+            //ensure capacity
+            out_imgs.resize( nbimgs ); 
+            out_imginfo.resize( firstinfo + nbimgs );
 
             //Read all ptrs in the raw data!
-            for( unsigned int i = 0; i < m_wanImgDataInfo.nbImgsTblPtr; ++i )
-            {
-                uint32_t ptrtoimg = utils::ReadIntFromBytes<uint32_t>( itfrmptr, static_cast<vector<uint8_t>::const_iterator>(m_rawdata.end()) ); //iter is incremented automatically
+            for( auto & ptrtoimg : imgptrs )
+                ptrtoimg = utils::ReadIntFromBytes<uint32_t>( itfrmptr, static_cast<vector<uint8_t>::const_iterator>(m_rawdata.end()) ); //iter is incremented automatically
 
-                if( utils::LibWide().isLogOn() )
+            //The log needs the frames in order
+            if( utils::LibWide().isLogOn() )
+            {
+                for( unsigned int i = 0; i < nbimgs; ++i )
+                {
                     std::clog <<"== Frame #" <<i <<" ==\n";
-
-                ReadImage( m_rawdata.begin() + ptrtoimg, metafrms, metarefs, pal, out_imgs[i], i, out_imginfo );
-                
-                //if( m_pProgress != nullptr )
-                //    m_pProgress->store( progressBefore + ( (ProgressProp_Frames * (i+1)) / m_wanImgDataInfo.nbImgsTblPtr ) );
+                    ReadImage( m_rawdata.begin() + imgptrs[i], metafrms, metarefs, pal, out_imgs[i], i, out_imginfo[firstinfo + i] );
+                }
+                return;
             }
+
+            //Stays on the calling thread when the sprite is already parsed on a worker thread
+            multitask::ParallelForChunks( nbimgs, [&]( size_t i )
+            {
+                ReadImage( m_rawdata.begin() + imgptrs[i], metafrms, metarefs, pal, out_imgs[i], static_cast<uint32_t>(i), out_imginfo[firstinfo + i] );
+            });
         }
 
         template<class TIMG_t>
@@ -600,7 +642,7 @@ namespace filetypes
                                const std::vector<gimg::colorRGB24>     & pal,
                                TIMG_t                                  & cur_img,
                                uint32_t                                  curfrmindex,
-                               std::vector<pmd2::graphics::ImageInfo>        & out_imginfo )
+                               pmd2::graphics::ImageInfo               & out_imginf )
         {
             auto              itfound    = metarefs.find( curfrmindex ); //Find if we have a meta-frame pointing to that frame
             utils::Resolution myres      = RES_64x64_SPRITE;
@@ -626,9 +668,7 @@ namespace filetypes
                 totalbyamt += entry.pixamt;
 
             //Keep track of the z index
-            ImageInfo imginf;
-            imginf.zindex = asmtable.front().zIndex;
-            out_imginfo.push_back(imginf);
+            out_imginf.zindex = asmtable.front().zIndex;
 
             if( itfound != metarefs.end() )
             {
@@ -863,21 +903,36 @@ namespace filetypes
             for( const auto & afrm : frms )
             {
                 gimg::WriteTiledImg( std::back_inserter(imgbuff), afrm, WAN_REVERSED_PIX_ORDER );
-                WriteACompressedFrm( imgbuff, m_pSprite->getImgsInfo()[cptfrmindex].zindex );
+                const uint32_t zindex = m_pSprite->getImgsInfo()[cptfrmindex].zindex;
+                const uint64_t frmhash = HashFrame( imgbuff, zindex );
+                uint32_t       tbloff  = 0;
+
+                //Identical frames share the same compressed data and assembly table
+                if( FindWrittenFrame( frmhash, imgbuff, zindex, tbloff ) )
+                    m_CompImagesTblOffsets.push_back( tbloff );
+                else
+                {
+                    WriteACompressedFrm( imgbuff, zindex );
+                    m_WrittenFrames.emplace( frmhash, writtenfrm{ imgbuff, zindex, m_CompImagesTblOffsets.back() } );
+                }
                 imgbuff.resize(0);
                 ++cptfrmindex;
             }
         }
 
         /*
-            This insert the next sequence into the zero strip table.
-            If its a sequence of zero, it won't write into the pixel strip table. If it is, it will.
+            Utilities for finding frames identical to one that was already written.
+        */
+        static uint64_t HashFrame( const std::vector<uint8_t> & frm, uint32_t imgZIndex );
+        bool            FindWrittenFrame( uint64_t frmhash, const std::vector<uint8_t> & frm, uint32_t imgZIndex, uint32_t & out_asmtbloffset )const;
+
+        /*
+            Builds the assembly table of a frame, stripping it of its runs of zeros when it makes the file smaller.
+            The non-zero parts of the frame are appended to the pixel strip table.
         */
-        ImgAsmTbl_WithOpTy MakeImgAsmTableEntry( std::vector<uint8_t>::const_iterator & itReadAt, 
-                                                         std::vector<uint8_t>::const_iterator   itEnd,
-                                                         std::vector<uint8_t>                 & pixStrips,
-                                                         uint32_t                             & totalbytecnt,
-                                                         uint32_t                               imgZIndex );
+        std::vector<ImgAsmTbl_WithOpTy> MakeImgAsmTable( const std::vector<uint8_t> & frm,
+                                                         std::vector<uint8_t>       & pixStrips,
+                                                         uint32_t                     imgZIndex );
 
         /*
             Same as above, but it simply makes a single assembly table entry for the whole image, not stripping the image of 
@@ -951,6 +1006,15 @@ namespace filetypes
 
         std::vector<uint32_t>  m_CompImagesTblOffsets;    //The places where the zero-strip table for each compressed image is at
 
+        struct writtenfrm
+        {
+            std::vector<uint8_t> pixels;
+            uint32_t             zindex;
+            uint32_t             asmtbloffset;
+        };
+        std::unordered_multimap<uint64_t,writtenfrm> m_WrittenFrames;  //Frames already written, by hash of their pixels and z index.
+        std::unordered_multimap<uint64_t,uint32_t>   m_WrittenMFGroups; //Offsets of meta-frame groups already written, by hash of their raw bytes.
+
         std::vector<uint32_t>  m_ptrOffsetTblToEncode;      //List of all the pointers offsets in the resulting raw file !
     };
 
@@ -10,7 +10,13 @@
 #include <functional>
 #include <string>
 #include <iostream>
+#include <cstring>
+#include <limits>
 #include <Poco/Path.h>
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define WAN_WRITER_USE_SSE2
+#endif
 using namespace std;
 using namespace pmd2::graphics;
 using namespace pmd2::filetypes;
@@ -18,6 +24,75 @@ using namespace pmd2::filetypes;
 
 namespace filetypes
 {
+    namespace
+    {
+        //FNV-1a
+        template<class _init>
+            uint64_t HashBytes( _init itbeg, _init itend, uint64_t hash = 14695981039346656037ULL )
+        {
+            for( ; itbeg != itend; ++itbeg )
+            {
+                hash ^= static_cast<uint8_t>(*itbeg);
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        //Frames are stripped of their zeros by blocks of this many bytes
+        const uint32_t ZeroStripBlockLen = 0x20;
+
+        //Whether the ZeroStripBlockLen bytes at "pblock" are all zeros
+        inline bool IsZeroBlock( const uint8_t * pblock )
+        {
+#ifdef WAN_WRITER_USE_SSE2
+            const __m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pblock) );
+            const __m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pblock + 16) );
+            return _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_or_si128(lo, hi), _mm_setzero_si128() ) ) == 0xFFFF;
+#else
+            uint64_t words[ZeroStripBlockLen / sizeof(uint64_t)];
+            std::memcpy( words, pblock, ZeroStripBlockLen );
+            return (words[0] | words[1] | words[2] | words[3]) == 0;
+#endif
+        }
+
+        //A span of a frame that's either all zeros, or contains pixels
+        struct pixrun
+        {
+            bool     iszero;
+            uint32_t len;
+        };
+
+        /*
+            Splits the frame into alternating runs of zero and non-zero blocks.
+            Bytes past the last whole block are always part of a non-zero run.
+        */
+        vector<pixrun> ScanZeroRuns( const vector<uint8_t> & frm )
+        {
+            vector<pixrun>  runs;
+            const uint8_t * pbeg    = frm.data();
+            const size_t    nbblks  = frm.size() / ZeroStripBlockLen;
+
+            for( size_t i = 0; i < nbblks; ++i )
+            {
+                const bool iszero = IsZeroBlock( pbeg + (i * ZeroStripBlockLen) );
+                if( !runs.empty() && runs.back().iszero == iszero )
+                    runs.back().len += ZeroStripBlockLen;
+                else
+                    runs.push_back( pixrun{ iszero, ZeroStripBlockLen } );
+            }
+
+            const uint32_t leftover = static_cast<uint32_t>( frm.size() % ZeroStripBlockLen );
+            if( leftover != 0 )
+            {
+                if( !runs.empty() && !runs.back().iszero )
+                    runs.back().len += leftover;
+                else
+                    runs.push_back( pixrun{ false, leftover } );
+            }
+            return std::move(runs);
+        }
+    };
+
 //==================================================================================================
 //  WAN_Writer
 //==================================================================================================
@@ -212,7 +287,7 @@ namespace filetypes
         for( const auto & agrp : m_pSprite->getMetaFrmsGrps() )
         {
         //# Note the offset where each groups begins at
-            m_MFramesGrpOffsets.push_back( m_outBuffer.size() );
+            const uint32_t grpbeg = m_outBuffer.size();
 
             //Write meta frames group
             for( unsigned int ctfrms = 0; ctfrms < agrp.metaframes.size(); ++ctfrms )
@@ -220,6 +295,28 @@ namespace filetypes
                 metafrms[ agrp.metaframes[ctfrms] ].WriteToWANContainer( m_itbackins, ( ctfrms == (agrp.metaframes.size() - 1) ) );
                 //WriteAMetaFrame( metafrms[ agrp.metaframes[ctfrms] ], ( ctfrms == (agrp.metaframes.size() - 1) ) );
             }
+
+            //If an identical group was already written, point to it instead, and drop what we just wrote
+            const uint32_t grplen  = m_outBuffer.size() - grpbeg;
+            const uint64_t grphash = HashBytes( m_outBuffer.begin() + grpbeg, m_outBuffer.end() );
+            auto           range   = m_WrittenMFGroups.equal_range(grphash);
+            auto           itfound = std::find_if( range.first, range.second, [&]( const pair<const uint64_t,uint32_t> & written )
+            {
+                //The last meta-frame of a group is flagged, so matching bytes means the groups end at the same place too
+                return (written.second + grplen) <= grpbeg && 
+                       std::equal( m_outBuffer.begin() + grpbeg, m_outBuffer.end(), m_outBuffer.begin() + written.second );
+            });
+
+            if( grplen != 0 && itfound != range.second )
+            {
+                m_outBuffer.resize(grpbeg);
+                m_MFramesGrpOffsets.push_back( itfound->second );
+            }
+            else
+            {
+                m_WrittenMFGroups.emplace( grphash, grpbeg );
+                m_MFramesGrpOffsets.push_back( grpbeg );
+            }
         }
     }
 
@@ -322,73 +419,73 @@ namespace filetypes
     }
 
     /**************************************************************
-        This insert the next sequence into the zero strip table.
-        If its a sequence of zero, it won't write into the pixel
-        strip table. If it is, it will.
+        Builds the assembly table of a frame, copying the non-zero
+        parts of the frame into the pixel strip table.
+
+        Each zero run is either stripped with its own entry, or
+        kept in the pixel strips, whichever makes the file smaller.
+        Stripping a run between two pixel strips costs a zero entry,
+        plus splitting the strip in two, which adds an entry and a
+        pointer to the pointer offset table.
     **************************************************************/
-    WAN_Writer::ImgAsmTbl_WithOpTy WAN_Writer::MakeImgAsmTableEntry( std::vector<uint8_t>::const_iterator & itReadAt,
-                                                        std::vector<uint8_t>::const_iterator   itEnd,
-                                                        std::vector<uint8_t>                 & pixStrips,
-                                                        uint32_t                             & totalbytecnt,
-                                                        uint32_t                               imgZIndex )
+    vector<WAN_Writer::ImgAsmTbl_WithOpTy> WAN_Writer::MakeImgAsmTable( const std::vector<uint8_t> & frm,
+                                                                         std::vector<uint8_t>       & pixStrips,
+                                                                         uint32_t                     imgZIndex )
     {
-        static const unsigned int MIN_Increments = 0x20; //Minimum increments of 32 bytes
-        auto lambdaIsZero    =  []( uint8_t val )->bool{ return (val == 0); };
-        auto itReadAtBefore  = itReadAt; //This is to hold the last read position for the duration of this function
-        auto itCurPos        = itReadAt; //This is to iterate over the data, without modifying itReadAt just yet!
-        std::advance( itCurPos, MIN_Increments );
+        //Pointers to pixel strips are only an entry or two apart, so they're encoded on a single byte in the pointer offset table
+        static const uint32_t PtrOffsetEncodedLen = 1;
+        static const uint32_t MaxEntryPixAmt      = std::numeric_limits<uint16_t>::max() - (std::numeric_limits<uint16_t>::max() % ZeroStripBlockLen);
 
-        //See if we're dealing with a sequence of zeroes or not!
-        bool isZeroSeq = std::all_of( itReadAtBefore, itCurPos, lambdaIsZero );
+        vector<pixrun> runs = ScanZeroRuns(frm);
 
-        //This is to indicate where the last sequence of 16 bytes we analyzed began at!
-        auto itLastSeqBeg = itCurPos;
-        uint32_t countAmtBytes = MIN_Increments;    //we already got 16 bytes in our sequence
+        //Keep zero runs that cost more to strip than to copy
+        for( size_t i = 0; i < runs.size(); ++i )
+        {
+            if( !runs[i].iszero )
+                continue;
+            const bool hasprev = (i > 0)                 && !runs[i-1].iszero;
+            const bool hasnext = ((i + 1) < runs.size()) && !runs[i+1].iszero;
+            uint32_t   stripcost = 0;
+            if( hasprev && hasnext )
+                stripcost = (ImgAsmTblEntry::LENGTH * 2) + PtrOffsetEncodedLen;
+            else if( hasprev || hasnext )
+                stripcost = ImgAsmTblEntry::LENGTH;
+            else
+                continue; //Frame is all zeros, it needs at least one entry
 
-        //Try to get other blocks of the same kind !
-        while( itCurPos != itEnd )
+            if( runs[i].len <= stripcost )
+                runs[i].iszero = false;
+        }
+
+        //Build the entries, merging runs that ended up of the same kind
+        vector<ImgAsmTbl_WithOpTy> asmtable;
+        asmtable.reserve( runs.size() );
+        auto itpix = frm.begin();
+        for( size_t i = 0; i < runs.size(); )
         {
-            std::advance( itCurPos, MIN_Increments ); //This will throw an exception if the pixel count isn't divisible by our ammount of increment #FIXME : No it won't past me
+            const bool iszero = runs[i].iszero;
+            uint32_t   runlen = 0;
+            for( ; i < runs.size() && runs[i].iszero == iszero; ++i )
+                runlen += runs[i].len;
 
-            //Check if the newly added bytes are the same kind of bytes we're looking for!
-            if( isZeroSeq == std::all_of( itLastSeqBeg, itCurPos, lambdaIsZero ) )
-            {
-                countAmtBytes += MIN_Increments;
-                itLastSeqBeg = itCurPos;
-            }
-            else
+            while( runlen != 0 )
             {
-                break;
+                ImgAsmTbl_WithOpTy myentry;
+                myentry.isZeroEntry = iszero;
+                myentry.pixamt      = static_cast<uint16_t>( std::min( runlen, MaxEntryPixAmt ) );
+                myentry.pixelsrc    = ( (iszero)? 0 : pixStrips.size() );
+                myentry.zIndex      = imgZIndex;
+
+                if( !iszero )
+                    std::copy( itpix, itpix + myentry.pixamt, std::back_inserter(pixStrips) );
+                itpix  += myentry.pixamt;
+                runlen -= myentry.pixamt;
+                asmtable.push_back(myentry);
             }
         }
-        ImgAsmTbl_WithOpTy myentry;
-        myentry.pixelsrc    = ( (isZeroSeq)? 0 : pixStrips.size() );
-        myentry.isZeroEntry = isZeroSeq;
-        myentry.pixamt      = countAmtBytes;
-        myentry.zIndex      = imgZIndex; //#TODO: figure out what this thing does !
-
-        if( !isZeroSeq )
-            std::copy( itReadAtBefore, itLastSeqBeg, std::back_inserter(pixStrips) );
-
-        //auto dist = std::distance( itReadAtBefore, itLastSeqBeg );
-
-        //Get only the actual sequence's data we're sure of between itReadAtBefore and itLastSeqBeg
-
-
-        totalbytecnt += myentry.pixamt;
-
-        //Increment the iterator now!
-        itReadAt = itLastSeqBeg;
-
-        return std::move( myentry );
-
-        //1. Read 16 bytes
-        //2. If we got 16 zeroes, we're reading a zero sequence to strip!!! Try to read as much groups of 16 zeroes as possible
-        //3. If we don't have 16 zeroes, this is a pixel strip!! Try to read another block of 16 bytes, and make sure its not 16 zeroes!
-        // Once we can't read any of our resprective sequence type, return entry!
+        return std::move(asmtable);
     }
 
-
     /**************************************************************
     **************************************************************/
     WAN_Writer::ImgAsmTbl_WithOpTy WAN_Writer::MakeImgAsmTableEntryNoStripping( vector<uint8_t>::const_iterator & itReadAt,
@@ -418,20 +515,19 @@ namespace filetypes
 
         vector<uint8_t>                 pixelstrips;
         vector<ImgAsmTbl_WithOpTy>      asmtable;
-        auto                            itLaststrip  = frm.begin();
         uint32_t                        totalbytecnt = 0;
+        pixelstrips.reserve( frm.size() );
 
         //Encode image
-        auto itCurPos = frm.begin();
-        auto itEnd    = frm.end();
-
-        while( itCurPos != itEnd )
+        if( dontStripZeros )
         {
-            if( dontStripZeros )
+            auto itCurPos = frm.begin();
+            auto itEnd    = frm.end();
+            while( itCurPos != itEnd )
                 asmtable.push_back( MakeImgAsmTableEntryNoStripping(itCurPos,itEnd,pixelstrips, totalbytecnt, imgZIndex ) );
-            else
-                asmtable.push_back( MakeImgAsmTableEntry( itCurPos, itEnd, pixelstrips, totalbytecnt, imgZIndex ) );
         }
+        else
+            asmtable = MakeImgAsmTable( frm, pixelstrips, imgZIndex );
 
         //Write pixel strips
         std::copy( pixelstrips.begin(), pixelstrips.end(), m_itbackins );
@@ -457,6 +553,29 @@ namespace filetypes
     }
 
 
+    /**************************************************************
+    **************************************************************/
+    uint64_t WAN_Writer::HashFrame( const std::vector<uint8_t> & frm, uint32_t imgZIndex )
+    {
+        uint8_t zbytes[sizeof(uint32_t)];
+        utils::WriteIntToBytes( imgZIndex, zbytes );
+        return HashBytes( frm.begin(), frm.end(), HashBytes( zbytes, zbytes + sizeof(zbytes) ) );
+    }
+
+    bool WAN_Writer::FindWrittenFrame( uint64_t frmhash, const std::vector<uint8_t> & frm, uint32_t imgZIndex, uint32_t & out_asmtbloffset )const
+    {
+        auto range = m_WrittenFrames.equal_range(frmhash);
+        for( auto it = range.first; it != range.second; ++it )
+        {
+            if( it->second.zindex == imgZIndex && it->second.pixels == frm )
+            {
+                out_asmtbloffset = it->second.asmtbloffset;
+                return true;
+            }
+        }
+        return false;
+    }
+
     /**************************************************************
     **************************************************************/
     void WAN_Writer::WritePaletteBlock()
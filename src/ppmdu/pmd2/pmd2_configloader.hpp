@@ -789,6 +789,9 @@ namespace pmd2
                 throw std::runtime_error("ConfigLoader::GetLooseBinFileData(): This kind of data doesn't have a a file path entry in the configuration!");
         }
 
+        //Path to the main configuration file the data was loaded from
+        inline const std::string            & GetConfigFilePath()const      {return m_conffile;}
+
         //Editable data
         inline const GameScriptData         & GetGameScriptData()const      {return m_gscriptdata;}
         inline GameScriptData               & GetGameScriptData()           {return m_gscriptdata;}
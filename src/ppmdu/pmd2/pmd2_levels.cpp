@@ -6,6 +6,11 @@
 #include <ppmdu/fmts/bma.hpp>
 #include <ppmdu/fmts/bg_list_data.hpp>
 #include <ppmdu/containers/level_tileset.hpp>
+#include <utils/multiple_task_handler.hpp>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
 using namespace std;
 
 
@@ -71,20 +76,12 @@ namespace pmd2
             filetypes::lvlbglist_t bglist(filetypes::LoadLevelList( sstrbglist.str() ));
             cout <<"Loaded " <<filetypes::FName_BGListFile <<"file..\n";
 
-            //3. Iterate level list, export each levels matching the index of the name in the BG list
+            //3. Make sure all levels refer to a valid entry in the BG list, before starting anything
+            vector<const pmd2::level_info*> levels;
+            levels.reserve(lvlinf.size());
             for( const pmd2::level_info & lvl : lvlinf )
             {
-                if( lvl.mapid < bglist.size() )
-                {
-                    stringstream sstrtsetpath;
-                    sstrtsetpath << utils::TryAppendSlash(destdir) <<lvl.name;
-                    string tsetpath = sstrtsetpath.str();
-
-                    cout <<"\rExporting " <<left <<setw(10) <<setfill(' ') <<lvl.name <<"..";
-                    utils::DoCreateDirectory(tsetpath);
-                    ExportATileset( lvl, bglist[lvl.mapid], tsetpath );
-                }
-                else
+                if( lvl.mapid >= bglist.size() )
                 {
                     //The map id refers to a map out of bound!
                     stringstream sstrer;
@@ -93,13 +90,93 @@ namespace pmd2
                     assert(false);
                     throw std::runtime_error(sstrer.str());
                 }
+                levels.push_back(&lvl);
+                ++(m_tsetcache[lvl.mapid].nbusersleft);
+            }
+
+            //4. Export each levels on the worker threads. The config and script data are only read from.
+            const size_t        nblevels = levels.size();
+            std::atomic<size_t> nbdone(0);
+
+            auto lambdaExportLevel = [&]( size_t index )
+            {
+                const pmd2::level_info & lvl = *(levels[index]);
+                stringstream sstrtsetpath;
+                sstrtsetpath << utils::TryAppendSlash(destdir) <<lvl.name;
+                string tsetpath = sstrtsetpath.str();
+
+                utils::DoCreateDirectory(tsetpath);
+                shared_ptr<const Tileset> ptset = AcquireTileset( lvl, bglist[lvl.mapid] );
+                ExportATileset( lvl, *ptset, tsetpath );
+                ptset.reset();
+                ReleaseTileset( lvl.mapid );
+
+                const size_t cntdone = ++nbdone;
+                lock_guard<mutex> lck(m_mtxprint);
+                cout <<"\rExported " <<left <<setw(10) <<setfill(' ') <<lvl.name <<".. " <<right <<(cntdone * 100) / nblevels <<"%";
+            };
+
+            //Every level is worth a thread, so don't wait for a minimum amount of them
+            try
+            {
+                multitask::ParallelForChunks( nblevels, lambdaExportLevel, 2 );
+            }
+            catch(...)
+            {
+                cout <<"\n";
+                m_tsetcache.clear();
+                throw;
+            }
+            cout <<"\n";
+            m_tsetcache.clear();
+        }
+
+        /*
+            AcquireTileset
+                Returns the tileset for the level's map. The first level to ask for a map decodes it,
+                the others wait for it to be done and share it.
+        */
+        shared_ptr<const Tileset> AcquireTileset( const pmd2::level_info & lvlinf, const filetypes::LevelBgEntry & entry )
+        {
+            promise<shared_ptr<const Tileset>> tsetpromise;
+            shared_future<shared_ptr<const Tileset>> tsetfuture;
+            bool bshoulddecode = false;
+            {
+                lock_guard<mutex> lck(m_mtxtsetcache);
+                tsetcacheentry & cached = m_tsetcache[lvlinf.mapid];
+                if( !cached.tileset.valid() )
+                {
+                    cached.tileset = tsetpromise.get_future().share();
+                    bshoulddecode  = true;
+                }
+                tsetfuture = cached.tileset;
+            }
+
+            if( bshoulddecode )
+            {
+                try
+                {
+                    tsetpromise.set_value( make_shared<const Tileset>( LoadTileset(m_mapbgdir, entry, lvlinf) ) );
+                }
+                catch(...)
+                {
+                    tsetpromise.set_exception( std::current_exception() );
+                }
             }
+            return tsetfuture.get();
+        }
 
+        //Drops the cached tileset once the last level using it is done with it
+        void ReleaseTileset( int16_t mapid )
+        {
+            lock_guard<mutex> lck(m_mtxtsetcache);
+            auto itfound = m_tsetcache.find(mapid);
+            if( itfound != m_tsetcache.end() && (--(itfound->second.nbusersleft)) == 0 )
+                m_tsetcache.erase(itfound);
         }
 
-        void ExportATileset( const pmd2::level_info & lvlinf, const filetypes::LevelBgEntry & entry, const std::string & destdir )
+        void ExportATileset( const pmd2::level_info & lvlinf, const Tileset & tset, const std::string & destdir )
         {
-            Tileset tset( LoadTileset(m_mapbgdir, entry, lvlinf) );
             ExportTilesetToRaw(destdir, lvlinf.name, tset);
             //PrintAssembledTilesetPreviewToPNG(utils::TryAppendSlash(destdir) + "preview", tset );
             DumpCellsToPNG( destdir, tset );
@@ -163,6 +240,17 @@ namespace pmd2
         const GameScriptData  * m_pgscriptdat;  //Pointer to the gamescript data to use to load the levels
         lvlprocopts             m_options;
         string                  m_mapbgdir;
+
+    private:
+        //Decoded tilesets shared by the levels being exported, by map id
+        struct tsetcacheentry
+        {
+            shared_future<shared_ptr<const Tileset>> tileset;
+            size_t                                   nbusersleft = 0;  //Nb of levels left to export that use this tileset
+        };
+        unordered_map<int16_t, tsetcacheentry>  m_tsetcache;
+        mutex                                   m_mtxtsetcache;
+        mutex                                   m_mtxprint;
     };
 
 
@@ -6,6 +6,7 @@
 #include <utils/poco_wrapper.hpp>
 #include <utils/utility.hpp>
 #include <utils/library_wide.hpp>
+#include <utils/parallel_tasks.hpp>
 #include <Poco/Path.h>
 #include <Poco/File.h>
 #include <Poco/DirectoryIterator.h>
@@ -14,6 +15,8 @@
 #include <sstream>
 #include <iomanip>
 #include <functional>
+#include <future>
+#include <mutex>
 using namespace std;
 using utils::logutil::slog;
 
@@ -94,10 +97,10 @@ namespace pmd2
         void LoadSub          ( const Poco::Path & datafpath, std::deque<Poco::Path> & fqueue, LevelScript & out_scrset );
         void LoadGrpLSDContent( const Poco::Path & curdir, std::deque<Poco::Path> & fqueue, LevelScript & out_scrset );
         void LoadLSD   ( LevelScript   & curset, const std::string & fpath );
-        void LoadSSB   ( ScriptSet & tgtgrp, const std::string & fpath );
+        void LoadSSB   ( ScriptSet & tgtgrp, const std::string & fpath, const std::shared_ptr<ScriptStringPool> & strpool );
         void LoadSSData( ScriptSet & tgtgrp, const std::string & fpath );
         void LoadScrDataAndMatchedNumberedSSBs( const std::string & prefix, const std::string & fext, eScriptSetType grpty, std::deque<Poco::Path> & fqueue, LevelScript & out_scrset  );
-        void LoadNumberedSSBForPrefix( std::deque<Poco::Path> & fqueue, const std::string & prefix, ScriptSet & tgtgrp );
+        void LoadNumberedSSBForPrefix( std::deque<Poco::Path> & fqueue, const std::string & prefix, ScriptSet & tgtgrp, const std::shared_ptr<ScriptStringPool> & strpool );
 
         void WriteLSD   ( const LevelScript & curset, const std::string & fpath );
         void WriteGroups( const LevelScript & curset, const std::string & dirpath );
@@ -114,7 +117,7 @@ namespace pmd2
         curset.LSDTable() = filetypes::ParseLSD(fpath);
     }
 
-    void GameScriptsHandler::LoadSSB(ScriptSet & tgtgrp, const std::string & fpath )
+    void GameScriptsHandler::LoadSSB(ScriptSet & tgtgrp, const std::string & fpath, const std::shared_ptr<ScriptStringPool> & strpool )
     {
         try 
         {
@@ -126,7 +129,8 @@ namespace pmd2
                                                             m_parent.Version(), 
                                                             m_parent.GetConfig().GetLanguageFilesDB(), 
                                                             false,                                      //! #TODO: Get rid of this option eventually
-                                                            m_parent.GetOptions().bscriptdebug) );
+                                                            m_parent.GetOptions().bscriptdebug,
+                                                            strpool) );
             script.SetName(basename);
             tgtgrp.Sequences().emplace(std::move(std::make_pair(basename, std::move(script) )));
         }
@@ -158,7 +162,7 @@ namespace pmd2
     }
 
 
-    void GameScriptsHandler::LoadNumberedSSBForPrefix( std::deque<Poco::Path> & fqueue, const std::string & prefix, ScriptSet & tgtgrp )
+    void GameScriptsHandler::LoadNumberedSSBForPrefix( std::deque<Poco::Path> & fqueue, const std::string & prefix, ScriptSet & tgtgrp, const std::shared_ptr<ScriptStringPool> & strpool )
     {
         auto itfound = fqueue.end();
 
@@ -172,7 +176,7 @@ namespace pmd2
             if( itfound != fqueue.end() )
             {
                 string curbasename = itfound->toString();
-                LoadSSB( tgtgrp, curbasename );
+                LoadSSB( tgtgrp, curbasename, strpool );
                 fqueue.erase(itfound);
                 itfound = fqueue.begin(); //Re-assign here, because the iterator got invalidated
             }
@@ -220,7 +224,7 @@ namespace pmd2
         fqueue.erase(itfounddata); //Remove it from the queue so we don't process it again
 
         //#4 - Then load the matched ssb
-        LoadNumberedSSBForPrefix( fqueue, prefix, grp );
+        LoadNumberedSSBForPrefix( fqueue, prefix, grp, out_scrset.StringPool() );
 
         //#5 - Add the group to the set
         out_scrset.Components().push_back(std::move(grp));
@@ -247,7 +251,7 @@ namespace pmd2
                 if(utils::LibWide().isLogOn())
                     slog() <<" ->Parsing \"Enter\" " <<p.getFileName() <<"\n";
                 LoadSSData( grp, p.toString() );
-                LoadNumberedSSBForPrefix( fqueue, basename, grp );
+                LoadNumberedSSBForPrefix( fqueue, basename, grp, out_scrset.StringPool() );
                 out_scrset.Components().push_back(std::move(grp));
             //}
             //while( (itcur = std::find_if( fqueue.begin(), fqueue.end(), lambdafindsse)) != fqueue.end() );
@@ -262,7 +266,7 @@ namespace pmd2
         if(utils::LibWide().isLogOn())
             slog() <<" ->Parsing \"Station\" " <<datafpath.getFileName() <<"\n";
         LoadSSData( grp, datafpath.toString() );
-        LoadNumberedSSBForPrefix( fqueue, basename, grp );
+        LoadNumberedSSBForPrefix( fqueue, basename, grp, out_scrset.StringPool() );
         out_scrset.Components().push_back(std::move(grp));
     }
 
@@ -313,7 +317,7 @@ namespace pmd2
             if(utils::LibWide().isLogOn())
                 slog() <<" ->Parsing \"Acting\" " <<ssapath.getFileName() <<"\n";
             ScriptSet scrpair( string( std::begin(afile), std::end(afile) ), eScriptSetType::UNK_acting );
-            LoadSSB   ( scrpair, ssbpath.toString() );
+            LoadSSB   ( scrpair, ssbpath.toString(), out_scrset.StringPool() );
             LoadSSData( scrpair, ssapath.toString() );
 
             //#4 - Push the pair into the set!
@@ -357,7 +361,7 @@ namespace pmd2
                 if(utils::LibWide().isLogOn())
                     slog() << " -- Parsing unionall.ssb.. --\n";
                 ScriptSet unionall( "unionall", eScriptSetType::UNK_unionall );
-                LoadSSB( unionall, itfoundunion->toString() );
+                LoadSSB( unionall, itfoundunion->toString(), curset.StringPool() );
                 curset.Components().push_back( std::move(unionall) );
                 processqueue.erase(itfoundunion);
                 //slog() <<"\n";
@@ -550,10 +554,34 @@ namespace pmd2
     std::unordered_map<std::string, LevelScript> GameScripts::LoadAll()
     {
         std::unordered_map<std::string, LevelScript> out;
+        std::mutex                                   mtxout;
+        std::vector<std::future<void>>               results;
+        utils::AsyncTaskHandler                      taskhandler;
+        out.reserve(m_setsindex.size());
+        results.reserve(m_setsindex.size());
 
+        //Each set is loaded and decompiled on its own. The config and language data are only read from.
         for( const auto & entry : m_setsindex )
-            out.emplace( entry.first, std::forward<LevelScript>(entry.second()) );
+        {
+            const string       * pname   = std::addressof(entry.first);
+            const ScrSetLoader * ploader = std::addressof(entry.second);
+            utils::AsyncTaskHandler::task_t task( [pname, ploader, &out, &mtxout]()
+            {
+                LevelScript set = (*ploader)();
+                std::lock_guard<std::mutex> lck(mtxout);
+                out.emplace( *pname, std::move(set) );
+            });
+            results.push_back( task.get_future() );
+            taskhandler.QueueTask( std::move(task) );
+        }
+
+        taskhandler.Start();
+        taskhandler.WaitTasksFinished();
+        taskhandler.WaitStop();
 
+        //Rethrow the first error, if any
+        for( auto & res : results )
+            res.get();
         return std::move(out);
     }
 
@@ -80,8 +80,9 @@ namespace pmd2
         bool bmarkoffsets;      //Whether the offsets of each instructions should be marked by comments
         bool bscriptdebug;      //Whether the debug_branch instructions should be tweaked to work as if debug mode was on
         bool basdir;            //Whether the scripts' XML data is exported/imported to/from a directory containing sub-files if true, or a single XML file if false.
+        bool bincremental;      //Whether levels whose XML didn't change since the last import are skipped when importing.
     };
-    const scriptprocoptions DefConfigOptions{true, true, false, false, false};
+    const scriptprocoptions DefConfigOptions{true, true, false, false, false, false};
 
 //==========================================================================================================
 //  Script Manager/Loader
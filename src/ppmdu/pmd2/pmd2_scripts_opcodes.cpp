@@ -2,6 +2,7 @@
 #include <sstream>
 #include <iostream>
 #include <iomanip>
+#include <unordered_map>
 using namespace std;
 
 namespace pmd2
@@ -743,395 +744,6 @@ namespace pmd2
         { "worldmap_SetMode",                       1, -1, 0, 0, eCommandCat::SingleOp      },
     } };
 
-//
-//
-//
-    const std::unordered_multimap<std::string, uint16_t> CmdLUT_EoS
-    {{
-        { "Null",                                 0 },
-        { "back_ChangeGround",                    1 },
-        { "back_SetBackEffect",                   2 },
-        { "back_SetBackScrollOffset",             3 },
-        { "back_SetBackScrollSpeed",              4 },
-        { "back_SetBanner",                       5 },
-        { "back_SetBanner2",                      6 },
-        { "back_SetEffect",                       7 },
-        { "back_SetDungeonBanner",                8 },
-        { "back_SetGround",                       9 },
-        { "back_SetSpecialEpisodeBanner",         10 },
-        { "back_SetSpecialEpisodeBanner2",        11 },
-        { "back_SetSpecialEpisodeBanner3",        12 },
-        { "back_SetTitleBanner",                  13 },
-        { "back_SetWeather",                      14 },
-        { "back_SetWeatherEffect",                15 },
-        { "back_SetWeatherScrollOffset",          16 },
-        { "back_SetWeatherScrollSpeed",           17 },
-        { "back2_SetBackEffect",                  18 },
-        { "back2_SetBackScrollOffset",            19 },
-        { "back2_SetBackScrollSpeed",             20 },
-        { "back2_SetData",                        21 },
-        { "back2_SetEffect",                      22 },
-        { "back2_SetGround",                      23 },
-        { "back2_SetMode",                        24 },
-        { "back2_SetSpecialActing",               25 },
-        { "back2_SetWeather",                     26 },
-        { "back2_SetWeatherEffect",               27 },
-        { "back2_SetWeatherScrollOffset",         28 },
-        { "back2_SetWeatherScrollSpeed",          29 },
-        { "bgm_FadeOut",                          30 },
-        { "bgm_Play",                             31 },
-        { "bgm_PlayFadeIn",                       32 },
-        { "bgm_Stop",                             33 },
-        { "bgm_ChangeVolume",                     34 },
-        { "bgm2_FadeOut",                         35 },
-        { "bgm2_Play",                            36 },
-        { "bgm2_PlayFadeIn",                      37 },
-        { "bgm2_Stop",                            38 },
-        { "bgm2_ChangeVolume",                    39 },
-        { "Branch",                               40 },
-        { "BranchBit",                            41 },
-        { "BranchDebug",                          42 },
-        { "BranchEdit",                           43 },
-        { "BranchExecuteSub",                     44 },
-        { "BranchPerformance",                    45 },
-        { "BranchScenarioNow",                    46 },
-        { "BranchScenarioNowAfter",               47 },
-        { "BranchScenarioNowBefore",              48 },
-        { "BranchScenarioAfter",                  49 },
-        { "BranchScenarioBefore",                 50 },
-        { "BranchSum",                            51 },
-        { "BranchValue",                          52 },
-        { "BranchVariable",                       53 },
-        { "BranchVariation",                      54 },
-        { "Call",                                 55 },
-        { "CallCommon",                           56 },
-        { "camera_Move2Default",                  57 },
-        { "camera_Move2MyPosition",               58 },
-        { "camera_Move2Myself",                   59 },
-        { "camera_Move2PositionMark",             60 },
-        { "camera_Move2PositionMark",             61 },
-        { "camera_Move3Default",                  62 },
-        { "camera_Move3MyPosition",               63 },
-        { "camera_Move3Myself",                   64 },
-        { "camera_Move3PositionMark",             65 },
-        { "camera_Move3PositionMark",             66 },
-        { "camera_MoveDefault",                   67 },
-        { "camera_MoveMyPosition",                68 },
-        { "camera_MoveMyself",                    69 },
-        { "camera_MovePositionMark",              70 },
-        { "camera_MovePositionMark",              71 },
-        { "camera_SetDefault",                    72 },
-        { "camera_SetEffect",                     73 },
-        { "camera_SetMyPosition",                 74 },
-        { "camera_SetMyself",                     75 },
-        { "camera_SetPositionMark",               76 },
-        { "camera2_Move2Default",                 77 },
-        { "camera2_Move2MyPosition",              78 },
-        { "camera2_Move2Myself",                  79 },
-        { "camera2_Move2PositionMark",            80 },
-        { "camera2_Move2PositionMark",            81 },
-        { "camera2_Move3Default",                 82 },
-        { "camera2_Move3MyPosition",              83 },
-        { "camera2_Move3Myself",                  84 },
-        { "camera2_Move3PositionMark",            85 },
-        { "camera2_Move3PositionMark",            86 },
-        { "camera2_MoveDefault",                  87 },
-        { "camera2_MoveMyPosition",               88 },
-        { "camera2_MoveMyself",                   89 },
-        { "camera2_MovePositionMark",             90 },
-        { "camera2_MovePositionMark",             91 },
-        { "camera2_SetDefault",                   92 },
-        { "camera2_SetEffect",                    93 },
-        { "camera2_SetMyPosition",                94 },
-        { "camera2_SetMyself",                    95 },
-        { "camera2_SetPositionMark",              96 },
-        { "CancelCut",                            97 },
-        { "CancelRecoverCommon",                  98 },
-        { "Case",                                 99 },
-        { "CaseMenu",                             100 },
-        { "CaseMenu2",                            101 },
-        { "CaseScenario",                         102 },
-        { "CaseText",                             103 },
-        { "CaseValue",                            104 },
-        { "CaseVariable",                         105 },
-        { "debug_Assert",                         106 },
-        { "debug_Print",                          107 },
-        { "debug_PrintFlag",                      108 },
-        { "debug_PrintScenario",                  109 },
-        { "DefaultText",                          110 },
-        { "Destroy",                              111 },
-        { "End",                                  112 },
-        { "EndAnimation",                         113 },
-        { "ExecuteActing",                        114 },
-        { "ExecuteCommon",                        115 },
-        { "flag_CalcBit",                         116 },
-        { "flag_CalcValue",                       117 },
-        { "flag_CalcVariable",                    118 },
-        { "flag_Clear",                           119 },
-        { "flag_Initial",                         120 },
-        { "flag_Set",                             121 },
-        { "flag_ResetDungeonResult",              122 },
-        { "flag_ResetScenario",                   123 },
-        { "flag_SetAdventureLog",                 124 },
-        { "flag_SetDungeonMode",                  125 },
-        { "flag_SetDungeonResult",                126 },
-        { "flag_SetPerformance",                  127 },
-        { "flag_SetScenario",                     128 },
-        { "Flash",                                129 },
-        { "Hold",                                 130 },
-        { "item_GetVariable",                     131 },
-        { "item_Set",                             132 },
-        { "item_SetTableData",                    133 },
-        { "item_SetVariable",                     134 },
-        { "Jump",                                 135 },
-        { "JumpCommon",                           136 },
-        { "lives",                                137 },
-        { "LoadPosition",                         138 },
-        { "Lock",                                 139 },
-        { "main_EnterAdventure",                  140 },
-        { "main_EnterDungeon",                    141 },
-        { "main_EnterGround",                     142 },
-        { "main_EnterGroundMulti",                143 },
-        { "main_EnterRescueUser",                 144 },
-        { "main_EnterTraining",                   145 },
-        { "main_EnterTraining2",                  146 },
-        { "main_SetGround",                       147 },
-        { "me_Play",                              148 },
-        { "me_Stop",                              149 },
-        { "message_Close",                        150 },
-        { "message_CloseEnforce",                 151 },
-        { "message_Explanation",                  152 },
-        { "message_FacePositionOffset",           153 },
-        { "message_ImitationSound",               154 },
-        { "message_KeyWait",                      155 },
-        { "message_Mail",                         156 },
-        { "message_Menu",                         157 },
-        { "message_Monologue",                    158 },
-        { "message_Narration",                    159 },
-        { "message_Notice",                       160 },
-        { "message_EmptyActor",                   161 },
-        { "message_ResetActor",                   162 },
-        { "message_SetActor",                     163 },
-        { "message_SetFace",                      164 },
-        { "message_SetFaceEmpty",                 165 },
-        { "message_SetFaceOnly",                  166 },
-        { "message_SetFacePosition",              167 },
-        { "message_SetWaitMode",                  168 },
-        { "message_SpecialTalk",                  169 },
-        { "message_SwitchMenu",                   170 },
-        { "message_SwitchMenu2",                  171 },
-        { "message_SwitchMonologue",              172 },
-        { "message_SwitchTalk",                   173 },
-        { "message_Talk",                         174 },
-        { "Move2Position",                        175 },
-        { "Move2PositionLives",                   176 },
-        { "Move2PositionMark",                    177 },
-        { "Move2PositionMark",                    178 },
-        { "Move2PositionOffset",                  179 },
-        { "Move2PositionOffset",                  180 },
-        { "Move2PositionOffsetRandom",            181 },
-        { "Move3Position",                        182 },
-        { "Move3PositionLives",                   183 },
-        { "Move3PositionMark",                    184 },
-        { "Move3PositionMark",                    185 },
-        { "Move3PositionOffset",                  186 },
-        { "Move3PositionOffset",                  187 },
-        { "Move3PositionOffsetRandom",            188 },
-        { "MoveDirection",                        189 },
-        { "MoveHeight",                           190 },
-        { "MovePosition",                         191 },
-        { "MovePositionLives",                    192 },
-        { "MovePositionLivesTime",                193 },
-        { "MovePositionMark",                     194 },
-        { "MovePositionMark",                     195 },
-        { "MovePositionMarkTime",                 196 },
-        { "MovePositionOffset",                   197 },
-        { "MovePositionOffset",                   198 },
-        { "MoveSpecial",                          199 },
-        { "MoveTurn",                             200 },
-        { "object",                               201 },
-        { "PauseEffect",                          202 },
-        { "performer",                            203 },
-        { "ProcessSpecial",                       204 },
-        { "PursueTurnLives",                      205 },
-        { "PursueTurnLives2",                     206 },
-        { "ResetAttribute",                       207 },
-        { "ResetFunctionAttribute",               208 },
-        { "ResetHitAttribute",                    209 },
-        { "ResetOutputAttribute",                 210 },
-        { "ResetReplyAttribute",                  211 },
-        { "ResumeEffect",                         212 },
-        { "Return",                               213 },
-        { "SavePosition",                         214 },
-        { "screen_FadeChange",                    215 },
-        { "screen_FadeChangeAll",                 216 },
-        { "screen_FadeIn",                        217 },
-        { "screen_FadeInAll",                     218 },
-        { "screen_FadeOut",                       219 },
-        { "screen_FadeOutAll",                    220 },
-        { "screen_FlushChange",                   221 },
-        { "screen_FlushIn",                       222 },
-        { "screen_FlushOut",                      223 },
-        { "screen_WhiteChange",                   224 },
-        { "screen_WhiteChangeAll",                225 },
-        { "screen_WhiteIn",                       226 },
-        { "screen_WhiteInAll",                    227 },
-        { "screen_WhiteOut",                      228 },
-        { "screen_WhiteOutAll",                   229 },
-        { "screen2_FadeChange",                   230 },
-        { "screen2_FadeChangeAll",                231 },
-        { "screen2_FadeIn",                       232 },
-        { "screen2_FadeInAll",                    233 },
-        { "screen2_FadeOut",                      234 },
-        { "screen2_FadeOutAll",                   235 },
-        { "screen2_FlushChange",                  236 },
-        { "screen2_FlushIn",                      237 },
-        { "screen2_FlushOut",                     238 },
-        { "screen2_WhiteChange",                  239 },
-        { "screen2_WhiteChangeAll",               240 },
-        { "screen2_WhiteIn",                      241 },
-        { "screen2_WhiteInAll",                   242 },
-        { "screen2_WhiteOut",                     243 },
-        { "screen2_WhiteOutAll",                  244 },
-        { "se_ChangePan",                         245 },
-        { "se_ChangeVolume",                      246 },
-        { "se_FadeOut",                           247 },
-        { "se_Play",                              248 },
-        { "se_PlayFull",                          249 },
-        { "se_PlayPan",                           250 },
-        { "se_PlayVolume",                        251 },
-        { "se_Stop",                              252 },
-        { "SetAnimation",                         253 },
-        { "SetAttribute",                         254 },
-        { "SetBlink",                             255 },
-        { "SetDirection",                         256 },
-        { "SetDirectionLives",                    257 },
-        { "SetEffect",                            258 },
-        { "SetFunctionAttribute",                 259 },
-        { "SetHeight",                            260 },
-        { "SetHitAttribute",                      261 },
-        { "SetMoveRange",                         262 },
-        { "SetOutputAttribute",                   263 },
-        { "SetPosition",                          264 },
-        { "SetPositionInitial",                   265 },
-        { "SetPositionLives",                     266 },
-        { "SetPositionMark",                      267 },
-        { "SetPositionOffset",                    268 },
-        { "SetPositionOffsetRandom",              269 },
-        { "SetReplyAttribute",                    270 },
-        { "SetupOutputAttributeAndAnimation",     271 },
-        { "Slide2Position",                       272 },
-        { "Slide2PositionLives",                  273 },
-        { "Slide2PositionMark",                   274 },
-        { "Slide2PositionMark",                   275 },
-        { "Slide2PositionOffset",                 276 },
-        { "Slide2PositionOffset",                 277 },
-        { "Slide2PositionOffsetRandom",           278 },
-        { "Slide3Position",                       279 },
-        { "Slide3PositionLives",                  280 },
-        { "Slide3PositionMark",                   281 },
-        { "Slide3PositionMark",                   282 },
-        { "Slide3PositionOffset",                 283 },
-        { "Slide3PositionOffset",                 284 },
-        { "Slide3PositionOffsetRandom",           285 },
-        { "SlideHeight",                          286 },
-        { "SlidePosition",                        287 },
-        { "SlidePositionLives",                   288 },
-        { "SlidePositionLivesTime",               289 },
-        { "SlidePositionMark",                    290 },
-        { "SlidePositionMark",                    291 },
-        { "SlidePositionMarkTime",                292 },
-        { "SlidePositionOffset",                  293 },
-        { "SlidePositionOffset",                  294 },
-        { "sound_FadeOut",                        295 },
-        { "sound_Stop",                           296 },
-        { "StopAnimation",                        297 },
-        { "supervision_Acting",                   298 },
-        { "supervision_ActingInvisible",          299 },
-        { "supervision_ExecuteActing",            300 },
-        { "supervision_ExecuteActingSub",         301 },
-        { "supervision_ExecuteCommon",            302 },
-        { "supervision_ExecuteEnter",             303 },
-        { "supervision_ExecuteStation",           304 },
-        { "supervision_ExecuteStationCommon",     305 },
-        { "supervision_ExecuteStationCommonSub",  306 },
-        { "supervision_ExecuteStationSub",        307 },
-        { "supervision_ExecuteExport",            308 },
-        { "supervision_ExecuteExportSub",         309 },
-        { "supervision_LoadStation",              310 },
-        { "supervision_Remove",                   311 },
-        { "supervision_RemoveActing",             312 },
-        { "supervision_RemoveCommon",             313 },
-        { "supervision_SpecialActing",            314 },
-        { "supervision_Station",                  315 },
-        { "supervision_StationCommon",            316 },
-        { "supervision_Suspend",                  317 },
-        { "supervision2_SpecialActing",           318 },
-        { "Switch",                               319 },
-        { "SwitchDirection",                      320 },
-        { "SwitchDirectionLives",                 321 },
-        { "SwitchDirectionLives2",                322 },
-        { "SwitchDirectionMark",                  323 },
-        { "SwitchDungeonMode",                    324 },
-        { "SwitchLives",                          325 },
-        { "SwitchRandom",                         326 },
-        { "SwitchScenario",                       327 },
-        { "SwitchScenarioLevel",                  328 },
-        { "SwitchSector",                         329 },
-        { "SwitchValue",                          330 },
-        { "SwitchVariable",                       331 },
-        { "Turn2Direction",                       332 },
-        { "Turn2DirectionLives",                  333 },
-        { "Turn2DirectionLives2",                 334 },
-        { "Turn2DirectionMark",                   335 },
-        { "Turn2DirectionTurn",                   336 },
-        { "Turn3",                                337 },
-        { "TurnDirection",                        338 },
-        { "TurnDirectionLives",                   339 },
-        { "TurnDirectionLives2",                  340 },
-        { "TurnDirectionMark",                    341 },
-        { "Unlock",                               342 },
-        { "Wait",                                 343 },
-        { "WaitAnimation",                        344 },
-        { "WaitBackEffect",                       345 },
-        { "WaitBack2Effec",                       346 },
-        { "WaitBgm",                              347 },
-        { "WaitBgm2",                             348 },
-        { "WaitBgmSignal",                        349 },
-        { "WaitEffect",                           350 },
-        { "WaitEndAnimation",                     351 },
-        { "WaitExecuteLives",                     352 },
-        { "WaitExecuteObject",                    353 },
-        { "WaitExecutePerformer",                 354 },
-        { "WaitFadeIn",                           355 },
-        { "WaitLockLives",                        356 },
-        { "WaitLockObject",                       357 },
-        { "WaitLockPerformer",                    358 },
-        { "WaitLockSupervision",                  359 },
-        { "WaitMe",                               360 },
-        { "WaitMoveCamera",                       361 },
-        { "WaitMoveCamera2",                      362 },
-        { "WaitRandom",                           363 },
-        { "WaitScreenFade",                       364 },
-        { "WaitScreenFadeAll",                    365 },
-        { "WaitScreen2Fade",                      366 },
-        { "WaitSe",                               367 },
-        { "WaitSpecialActing",                    368 },
-        { "WaitSubScreen",                        369 },
-        { "WaitSubSpecialActing",                 370 },
-        { "worldmap_BlinkMark",                   371 },
-        { "worldmap_ChangeLevel",                 372 },
-        { "worldmap_DeleteArrow",                 373 },
-        { "worldmap_MoveCamera",                  374 },
-        { "worldmap_OffMessage",                  375 },
-        { "worldmap_SetArrow",                    376 },
-        { "worldmap_SetCamera",                   377 },
-        { "worldmap_SetLevel",                    378 },
-        { "worldmap_SetMark",                     379 },
-        { "worldmap_SetMessage",                  380 },
-        { "worldmap_SetMessagePlace",             381 },
-        { "worldmap_SetMode",                     382 },
-    }};
 
 
 
@@ -1200,38 +812,73 @@ namespace pmd2
         return std::move( RoutineTyToStr(static_cast<uint16_t>(ty)) );
     }
 
-    eScriptOpCodesEoS FindOpCodeByName_EoS(const std::string & name, size_t nbparams)
-#if 0
+//
+//
+//
+    namespace
+    {
+        //Indexes the opcodes of an opcode table by name. Opcodes sharing the same name are listed in table order.
+        typedef std::unordered_map<std::string, std::vector<uint16_t>> opcodenamelut_t;
+
+        template<class _OpCodeTblTy>
+            opcodenamelut_t MakeOpCodeNameLUT( const _OpCodeTblTy & tbl )
+        {
+            opcodenamelut_t lut;
+            lut.reserve(tbl.size());
+            for( size_t i = 0; i < tbl.size(); ++i )
+                lut[tbl[i].name].push_back( static_cast<uint16_t>(i) );
+            return std::move(lut);
+        }
+    };
+
+    eOpParamTypes FindOpParamTypesByName( const std::string & name )
     {
-        auto frange = CmdLUT_EoS.equal_range(name);
-        if( frange.first != CmdLUT_EoS.end() )
+        static const std::unordered_map<std::string, eOpParamTypes> ParamTypesLUT = []()
         {
-            uint16_t pmultiparamsid = CmdLUT_EoS.size();
-            for( auto itf = frange.first; itf != frange.second; ++itf )
-            {
-                uint16_t curid = itf->second;
-                if( OpCodesInfoListEoS[curid].nbparams == nbparams )
-                    return static_cast<eScriptOpCodesEoS>(curid);
-                else if(OpCodesInfoListEoS[curid].nbparams == -1)
-                    pmultiparamsid = curid;
-            }
-            if(pmultiparamsid != CmdLUT_EoS.size())
-                return static_cast<eScriptOpCodesEoS>(pmultiparamsid);
+            std::unordered_map<std::string, eOpParamTypes> lut;
+            for( size_t i = 0; i < OpParamTypesNames.size(); ++i )
+                lut.emplace( OpParamTypesNames[i], static_cast<eOpParamTypes>(i) );
+            return std::move(lut);
+        }();
+
+        auto itf = ParamTypesLUT.find(name);
+        if( itf != ParamTypesLUT.end() )
+            return itf->second;
+        else
+            return eOpParamTypes::Invalid;
+    }
+
+    eScriptOpCodesEoTD FindOpCodeByName_EoTD( const std::string & name, size_t nbparams )
+    {
+        static const opcodenamelut_t CmdLUT_EoTD = MakeOpCodeNameLUT(OpCodesInfoListEoTD);
+
+        auto itf = CmdLUT_EoTD.find(name);
+        if( itf == CmdLUT_EoTD.end() )
+            return eScriptOpCodesEoTD::INVALID;
+
+        for( uint16_t curid : itf->second )
+        {
+            if( OpCodesInfoListEoTD[curid].nbparams == nbparams )
+                return static_cast<eScriptOpCodesEoTD>(curid);
         }
-        return eScriptOpCodesEoS::INVALID;
+        return eScriptOpCodesEoTD::INVALID;
     }
-#else
+
+    eScriptOpCodesEoS FindOpCodeByName_EoS(const std::string & name, size_t nbparams)
     {
+        static const opcodenamelut_t CmdLUT_EoS = MakeOpCodeNameLUT(OpCodesInfoListEoS);
+
+        auto itf = CmdLUT_EoS.find(name);
+        if( itf == CmdLUT_EoS.end() )
+            return eScriptOpCodesEoS::INVALID;
+
         size_t foundmultiparam = 0;
-        for( size_t i = 0; i < OpCodesInfoListEoS.size(); ++i )
+        for( uint16_t curid : itf->second )
         {
-            if( OpCodesInfoListEoS[i].name == name )
-            {
-                if( OpCodesInfoListEoS[i].nbparams == nbparams )
-                    return static_cast<eScriptOpCodesEoS>(i);   //Exact match, return
-                else if( OpCodesInfoListEoS[i].nbparams == -1 )
-                    foundmultiparam = i;                        //Mark any command that matched with -1 parameters for later
-            }
+            if( OpCodesInfoListEoS[curid].nbparams == nbparams )
+                return static_cast<eScriptOpCodesEoS>(curid);   //Exact match, return
+            else if( OpCodesInfoListEoS[curid].nbparams == -1 )
+                foundmultiparam = curid;                        //Mark any command that matched with -1 parameters for later
         }
         //Return the -1 parameter that matched the name if we didn't find an exact match
         if( foundmultiparam != 0 )
@@ -1239,7 +886,6 @@ namespace pmd2
         else
             return eScriptOpCodesEoS::INVALID;
     }
-#endif
 
     std::string RoutineTyToStr(uint16_t ty)
     {
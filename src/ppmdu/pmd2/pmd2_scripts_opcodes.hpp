@@ -1045,15 +1045,8 @@ namespace pmd2
             return nullptr;
     }
 
-    inline eOpParamTypes FindOpParamTypesByName( const std::string & name )
-    {
-        for( size_t i = 0; i < OpParamTypesNames.size(); ++i )
-        {
-            if( OpParamTypesNames[i] == name )
-                return static_cast<eOpParamTypes>(i);
-        }
-        return eOpParamTypes::Invalid;
-    }
+    //Returns eOpParamTypes::Invalid if there are no parameter types with that name.
+    eOpParamTypes FindOpParamTypesByName( const std::string & name );
 
     struct OpParamInfo
     {
@@ -1143,15 +1136,12 @@ namespace pmd2
         return FindOpCodeInfo_EoTD( static_cast<uint16_t>(opcode) );
     }
 
-    inline eScriptOpCodesEoTD FindOpCodeByName_EoTD( const std::string & name, size_t nbparams )
-    {
-        for( size_t i = 0; i < OpCodesInfoListEoTD.size(); ++i )
-        {
-            if( OpCodesInfoListEoTD[i].name == name && OpCodesInfoListEoTD[i].nbparams == nbparams )
-                return static_cast<eScriptOpCodesEoTD>(i);
-        }
-        return eScriptOpCodesEoTD::INVALID;
-    }
+    /*************************************************************************************
+        FindOpCodeByName_EoTD
+            Returns the opcode with the specified name and number of parameters.
+            Returns eScriptOpCodesEoTD::INVALID if there are none.
+    *************************************************************************************/
+    eScriptOpCodesEoTD FindOpCodeByName_EoTD( const std::string & name, size_t nbparams );
 
     inline size_t GetNbOpCodes_EoTD()
     {
@@ -1214,6 +1204,12 @@ namespace pmd2
         return FindOpCodeInfo_EoS( static_cast<uint16_t>(opcode) );
     }
 
+    /*************************************************************************************
+        FindOpCodeByName_EoS
+            Returns the opcode with the specified name and number of parameters.
+            If there are none, returns the opcode with that name taking a variable number 
+            of parameters, if any. Otherwise returns eScriptOpCodesEoS::INVALID.
+    *************************************************************************************/
     eScriptOpCodesEoS FindOpCodeByName_EoS( const std::string & name, size_t nbparams );
 
 
@@ -8,12 +8,15 @@
 #include <utils/utility.hpp>
 #include <ppmdu/pmd2/pmd2_scripts_opcodes.hpp>
 #include <ppmdu/pmd2/pmd2_xml_sniffer.hpp>
+#include <ppmdu/pmd2/script_import_manifest.hpp>
 #include <utils/pugixml_utils.hpp>
 #include <utils/library_wide.hpp>
+#include <utils/gfileio.hpp>
 //#include <utils/multiple_task_handler.hpp>
 #include <utils/parallel_tasks.hpp>
 #include <ppmdu/fmts/ssb.hpp>
 #include <atomic>
+#include <functional>
 #include <thread>
 #include <unordered_set>
 #include <Poco/DirectoryIterator.h>
@@ -537,14 +540,17 @@ namespace pmd2
                 - region : Expected game region.
                 - conf   : Configuration data of the target game the XML script data is loaded for.
                 - ptrres : Pointer to a compiler result for this particular file. Null if not used.
+                - strpool: String pool of the level the script belongs to. A new one is made if null.
         *****************************************************************************************/
-        SSBXMLParser( eGameVersion version, eGameRegion region, const ConfigLoader & conf, CompilerReport::compileresult * ptrres = nullptr )
+        SSBXMLParser( eGameVersion version, eGameRegion region, const ConfigLoader & conf, CompilerReport::compileresult * ptrres = nullptr, 
+                      std::shared_ptr<ScriptStringPool> strpool = nullptr )
             :m_version(version), 
              m_region(region), 
              m_opinfo(version),
              m_gconf(conf), 
              m_paraminf(conf),
-             m_preportentry(ptrres)
+             m_preportentry(ptrres),
+             m_strpool(std::move(strpool))
         {}
 
         /*****************************************************************************************
@@ -563,17 +569,18 @@ namespace pmd2
             }
 
             xml_node xcode = seqn.child(NODE_Code.c_str());
-            m_out = std::move( Script(xname.value()) );
+            m_out = std::move( Script(xname.value(), m_strpool) );
             ParseCode(xcode);
             CheckLabelReferences();
             OffsetAllStringReferencesParameters(); //Offset all string id parameters in all commands by the nb of entries in the const table.
 
             //Move strings
             //! #REMOVEME: this is obsolete. Since we don't store strings there anymore.
-            m_out.ConstTbl() = std::move( Script::consttbl_t( m_constqueue.begin(), m_constqueue.end() ) );
+            m_out.SetConstTbl( m_constqueue.begin(), m_constqueue.end() );
             for( auto & aq : m_strqueues )
             {
-                m_out.StrTblSet().emplace( aq.first, std::move(Script::strtbl_t(aq.second.begin(), aq.second.end())) );
+                if( !m_out.StrTbl(aq.first) )
+                    m_out.InsertStrLanguage( aq.first, aq.second.begin(), aq.second.end() );
             }
             return std::move(m_out);
         }
@@ -1415,7 +1422,7 @@ namespace pmd2
         void ParseConsts( const xml_node & constn )
         {
             using namespace scriptXML;
-            m_out.ConstTbl() = std::move( Script::consttbl_t( m_constqueue.begin(), m_constqueue.end() ) );
+            m_out.SetConstTbl( m_constqueue.begin(), m_constqueue.end() );
         }
 
         /*****************************************************************************************
@@ -1456,7 +1463,7 @@ namespace pmd2
                     throw CompileErrorException(sstrer.str(), str.offset_debug());
                 }
             }
-            m_out.InsertStrLanguage( glang, std::move(Script::strtbl_t( langstr.begin(), langstr.end() )) );
+            m_out.InsertStrLanguage( glang, langstr.begin(), langstr.end() );
         }
 
     private:
@@ -1480,6 +1487,7 @@ namespace pmd2
         ParameterReferences  m_paraminf;
         const ConfigLoader & m_gconf;
         CompilerReport::compileresult * m_preportentry; //Compiler report entry pointer, when applicable, null otherwise
+        std::shared_ptr<ScriptStringPool> m_strpool;    //Pool the strings of the parsed script are interned into
     };
 
 
@@ -1953,9 +1961,11 @@ namespace pmd2
             try
             {
                 xml_node    parentn = HandleLoadXMLDoc(doc, file, ROOT_ScripDir);
+                m_strpool = std::make_shared<ScriptStringPool>();
                 LevelScript reslvlscr( m_curfilebasename, 
                                      std::move(ParseSets(parentn)),
-                                     std::move(ParseLSD (parentn)));
+                                     std::move(ParseLSD (parentn)),
+                                     m_strpool );
                 if(m_preport)
                     m_preport->InsertSuccess(m_curfilebasename);
                 return std::move(reslvlscr);
@@ -1990,6 +2000,7 @@ namespace pmd2
 
             LevelScript::lsdtbl_t       lsdtbl;
             LevelScript::scriptsets_t   scrsets;
+            m_strpool = std::make_shared<ScriptStringPool>();
             try
             {
                 Poco::DirectoryIterator     dit(directorypath);
@@ -2007,7 +2018,7 @@ namespace pmd2
                     }
                 }
 
-                return std::move(LevelScript( dirname, std::move(scrsets), std::move(lsdtbl) ) );
+                return std::move(LevelScript( dirname, std::move(scrsets), std::move(lsdtbl), m_strpool ) );
             }
             catch( const CompileErrorException & e )
             {
@@ -2250,7 +2261,7 @@ namespace pmd2
             if(m_preport)
                 prepres = &(*m_preport)[m_curfilebasename];
             destgrp.Sequences().emplace( std::forward<string>(name), 
-                                         std::forward<Script>( SSBXMLParser(m_out_gver, m_out_reg, m_gconf, prepres)(seqn) ) );
+                                         std::forward<Script>( SSBXMLParser(m_out_gver, m_out_reg, m_gconf, prepres, m_strpool)(seqn) ) );
         }
 
         /*
@@ -2322,6 +2333,7 @@ namespace pmd2
         const ConfigLoader  & m_gconf;
         CompilerReport      * m_preport;
         std::string           m_curfilebasename;
+        std::shared_ptr<ScriptStringPool> m_strpool; //String pool of the level being parsed
     };
 
 
@@ -2329,6 +2341,9 @@ namespace pmd2
 //  GameScriptsXMLWriter
 //==============================================================================
 
+    //The script writers write their XML straight to the file as they go
+    typedef XMLStreamWriter::node xmlwnode_t;
+
     /*****************************************************************************************
         SSBXMLWriter
             Writes the content of a SSB file.
@@ -2348,11 +2363,11 @@ namespace pmd2
             //m_commentoffsets(bprintcmdoffsets)
         {}
         
-        void operator()( xml_node & parentn )
+        void operator()( xmlwnode_t parentn )
         {
             using namespace scriptXML;
             WriteSSBCommentHeader(parentn);
-            xml_node ssbnode = parentn.append_child( NODE_ScriptSeq.c_str() );
+            xmlwnode_t ssbnode = parentn.append_child( NODE_ScriptSeq.c_str() );
             AppendAttribute( ssbnode, ATTR_Name, m_seq.Name() );
 
             //prepare for counting references to strings
@@ -2368,7 +2383,7 @@ namespace pmd2
 
     private:
 
-        inline void WriteSSBCommentHeader(xml_node & parentn)
+        inline void WriteSSBCommentHeader(xmlwnode_t parentn)
         {
             stringstream sstrstats;
             size_t       nbaliases = 0;
@@ -2386,10 +2401,10 @@ namespace pmd2
 
         /*
         */
-        xml_node SetupRoutine(xml_node & parent, const ScriptRoutine & cur, size_t routinecnt, bool isUnionall)
+        xmlwnode_t SetupRoutine(xmlwnode_t parent, const ScriptRoutine & cur, size_t routinecnt, bool isUnionall)
         {
             using namespace scriptXML;
-            xml_node     xroutine;
+            xmlwnode_t     xroutine;
             string       nameid;
             string       routinetype = RoutineTyToStr(cur.type);
             stringstream sstr;
@@ -2461,17 +2476,17 @@ namespace pmd2
             return xroutine;
         }
 
-        void WriteCode( xml_node & parentn )
+        void WriteCode( xmlwnode_t parentn )
         {
             using namespace scriptXML;
-            xml_node xcode = parentn.append_child( NODE_Code.c_str() );
+            xmlwnode_t xcode = parentn.append_child( NODE_Code.c_str() );
             const bool isUnionall = m_seq.Name() == ScriptPrefix_unionall;
 
             size_t routinecnt = 0;
             
             for( const auto & routine : m_seq.Routines() )
             {
-                xml_node xroutine = SetupRoutine(xcode, routine, routinecnt, isUnionall );
+                xmlwnode_t xroutine = SetupRoutine(xcode, routine, routinecnt, isUnionall );
 
                 if( !routine.IsAliasOfPrevGroup() )
                 {
@@ -2482,7 +2497,7 @@ namespace pmd2
             }
         }
 
-        inline void HandleInstruction( xml_node & groupn, const pmd2::ScriptInstruction & instr )
+        inline void HandleInstruction( xmlwnode_t groupn, const pmd2::ScriptInstruction & instr )
         {
             using namespace scriptXML;
             if(m_options.bmarkoffsets)
@@ -2526,22 +2541,22 @@ namespace pmd2
             };                
         }
 
-        inline void WriteMetaReturnCases(xml_node & groupn, const pmd2::ScriptInstruction & intr)
+        inline void WriteMetaReturnCases(xmlwnode_t groupn, const pmd2::ScriptInstruction & intr)
         {
             WriteInstructionWithSubInst(groupn,intr);
         }
 
-        inline void WriteMetaSpecRet(xml_node & groupn, const pmd2::ScriptInstruction & intr)
+        inline void WriteMetaSpecRet(xmlwnode_t groupn, const pmd2::ScriptInstruction & intr)
         {
             WriteInstructionWithSubInst(groupn,intr);
         }
 
-        inline void WriteMetaSwitch(xml_node & groupn, const pmd2::ScriptInstruction & intr)
+        inline void WriteMetaSwitch(xmlwnode_t groupn, const pmd2::ScriptInstruction & intr)
         {
             WriteInstructionWithSubInst(groupn,intr);
         }
 
-        inline void WriteMetaAccessor(xml_node & groupn, const pmd2::ScriptInstruction & intr)
+        inline void WriteMetaAccessor(xmlwnode_t groupn, const pmd2::ScriptInstruction & intr)
         {
             if( m_options.bnodeisinst )
                 WriteInstructionWithSubInst<true>(groupn,intr);
@@ -2550,17 +2565,16 @@ namespace pmd2
         }
 
         template<bool _UseInstNameAsNodeName=true>
-            void WriteInstructionWithSubInst(xml_node & groupn, const pmd2::ScriptInstruction & intr)
+            void WriteInstructionWithSubInst(xmlwnode_t groupn, const pmd2::ScriptInstruction & intr)
         {
             using namespace scriptXML;
             OpCodeInfoWrapper curinf  = m_opinfo.Info(intr.value);
             if(curinf)
             {
-                xml_node xparent = AppendChildNode(groupn, curinf.Name() );
+                xmlwnode_t xparent = AppendChildNode(groupn, curinf.Name() );
 
                 //Write the parent's params
-                for( size_t cntparam= 0; cntparam < intr.parameters.size(); ++cntparam )
-                    WriteInstructionParam(xparent, curinf, intr, cntparam);
+                WriteInstructionParams(xparent, curinf, intr);
 
                 //Write the sub-nodes
                 WriteSubInstructions<_UseInstNameAsNodeName>(xparent, intr);
@@ -2574,25 +2588,24 @@ namespace pmd2
         }
 
         template<bool _UseInstNameAsNodeName>
-            void WriteSubInstructions(xml_node & parentinstn, const pmd2::ScriptInstruction & intr);
+            void WriteSubInstructions(xmlwnode_t parentinstn, const pmd2::ScriptInstruction & intr);
 
         template<>
-            void WriteSubInstructions<true>(xml_node & parentinstn, const pmd2::ScriptInstruction & instr)
+            void WriteSubInstructions<true>(xmlwnode_t parentinstn, const pmd2::ScriptInstruction & instr)
         {
             using namespace scriptXML;
             for(const auto & subinst : instr.subinst)
             {
                 OpCodeInfoWrapper curinf = m_opinfo.Info(subinst.value);
-                xml_node          xcase  = AppendChildNode(parentinstn, curinf.Name());
+                xmlwnode_t          xcase  = AppendChildNode(parentinstn, curinf.Name());
                 
                 //Write parameters
-                for( size_t cntparam= 0; cntparam < subinst.parameters.size(); ++cntparam )
-                    WriteInstructionParam(xcase, curinf, subinst, cntparam);
+                WriteInstructionParams(xcase, curinf, subinst);
             }
         }
 
         template<>
-            void WriteSubInstructions<false>(xml_node & parentinstn, const pmd2::ScriptInstruction & instr)
+            void WriteSubInstructions<false>(xmlwnode_t parentinstn, const pmd2::ScriptInstruction & instr)
         {
             using namespace scriptXML;
             for(const auto & subinst : instr.subinst)
@@ -2601,23 +2614,23 @@ namespace pmd2
             }
         }
 
-        inline void WriteMetaLabel(xml_node & groupn, const pmd2::ScriptInstruction & instr)
+        inline void WriteMetaLabel(xmlwnode_t groupn, const pmd2::ScriptInstruction & instr)
         {
             using namespace scriptXML;
             AppendAttribute( AppendChildNode(groupn, NODE_MetaLabel), ATTR_LblID, instr.value );
         }
 
-        inline void WriteMetaCaseLabel(xml_node & groupn, const pmd2::ScriptInstruction & instr)
+        inline void WriteMetaCaseLabel(xmlwnode_t groupn, const pmd2::ScriptInstruction & instr)
         {
             using namespace scriptXML;
             AppendAttribute( AppendChildNode(groupn, NODE_MetaCaseLabel), ATTR_LblID, instr.value );
         }
 
-        void WriteInstruction(xml_node & groupn, const pmd2::ScriptInstruction & instr)
+        void WriteInstruction(xmlwnode_t groupn, const pmd2::ScriptInstruction & instr)
         {
             using namespace scriptXML;
             OpCodeInfoWrapper opinfo = m_opinfo.Info(instr.value);
-            xml_node          xinstr;
+            xmlwnode_t          xinstr;
 
             if(opinfo)
             {
@@ -2629,10 +2642,7 @@ namespace pmd2
                     AppendAttribute( xinstr, ATTR_Name, opinfo.Name() );
                 }
 
-                for( size_t cntparam= 0; cntparam < instr.parameters.size(); ++cntparam )
-                {
-                    WriteInstructionParam( xinstr, opinfo, instr, cntparam );
-                }
+                WriteInstructionParams( xinstr, opinfo, instr );
             }
             else
             {
@@ -2641,10 +2651,40 @@ namespace pmd2
             }
         }
 
+        /*
+            WriteInstructionParams
+                Strings are written as child nodes of the instruction, so they're written after
+                all the other parameters, which are attributes.
+        */
+        template<typename _Inst_ty>
+            void WriteInstructionParams( xmlwnode_t instn, const OpCodeInfoWrapper & opinfo, const _Inst_ty & intr )
+        {
+            std::vector<uint16_t> strparams;
+            for( size_t cntparam= 0; cntparam < intr.parameters.size(); ++cntparam )
+            {
+                if( IsStringIdParam(opinfo, intr, cntparam) )
+                    strparams.push_back(intr.parameters[cntparam]);
+                else
+                    WriteInstructionParam( instn, opinfo, intr, cntparam );
+            }
+
+            for( uint16_t strid : strparams )
+                WriteStringParameter( instn, strid );
+        }
+
+        template<typename _Inst_ty>
+            inline bool IsStringIdParam( const OpCodeInfoWrapper & opinfo, const _Inst_ty & intr, size_t cntparam )const
+        {
+            if( cntparam >= opinfo.ParamInfo().size() || OpParamTypesToStr( opinfo.ParamInfo()[cntparam].ptype ) == nullptr )
+                return false;
+            const eOpParamTypes ptype = opinfo.ParamInfo()[cntparam].ptype;
+            return (ptype == eOpParamTypes::Constant || ptype == eOpParamTypes::String) && !isConstIdInRange(intr.parameters[cntparam]);
+        }
+
         //! #TODO: This will need to be better handled. We only really have strings that need a very special
         //!         treatment. All other parameters could be easily handled by a dedicated object.
         template<typename _Inst_ty>
-            void WriteInstructionParam( xml_node & instn, const OpCodeInfoWrapper & opinfo, const _Inst_ty & intr, size_t cntparam )
+            void WriteInstructionParam( xmlwnode_t instn, const OpCodeInfoWrapper & opinfo, const _Inst_ty & intr, size_t cntparam )
         {
             using namespace scriptXML;
             const string * pname = nullptr;
@@ -2854,7 +2894,7 @@ namespace pmd2
             WriteStringParameter
                 Return whether it was a string to parse or not.
         */
-        void WriteStringParameter( xml_node & instn, uint16_t pval )
+        void WriteStringParameter( xmlwnode_t instn, uint16_t pval )
         {
             using namespace scriptXML;
             
@@ -2863,8 +2903,8 @@ namespace pmd2
             {
                 auto res = m_referedconstids.insert(pval);
                 if( !res.second )
-                    cerr << "\nConstant duplicate reference to CID# " <<pval <<", \"" <<m_seq.ConstTbl()[pval] <<"\"!!\n";
-                AppendAttribute( instn, OpParamTypesNames[static_cast<size_t>(eOpParamTypes::Constant)], m_seq.ConstTbl()[pval] );
+                    cerr << "\nConstant duplicate reference to CID# " <<pval <<", \"" <<m_seq.Str(m_seq.ConstTbl()[pval]) <<"\"!!\n";
+                AppendAttribute( instn, OpParamTypesNames[static_cast<size_t>(eOpParamTypes::Constant)], m_seq.CStr(m_seq.ConstTbl()[pval]) );
 
                 return;
             }
@@ -2880,17 +2920,17 @@ namespace pmd2
 #endif
                 for( const auto & lang : m_seq.StrTblSet() )
                 {
-                    xml_node xlang = AppendChildNode(instn, NODE_String);
+                    xmlwnode_t xlang = AppendChildNode(instn, NODE_String);
                     AppendAttribute( xlang, ATTR_Language, GetGameLangName(lang.first) );
 #ifdef PMD2XML_STRING_AS_CDATA
-                    AppendCData(xlang, lang.second.at(stroffset) );
+                    AppendCData(xlang, m_seq.CStr(lang.second.at(stroffset)) );
 #elif defined(PMD2XML_STRING_AS_PCDATA)
-                    AppendPCData(xlang, lang.second.at(stroffset) );
+                    AppendPCData(xlang, m_seq.CStr(lang.second.at(stroffset)) );
 #else
-                    AppendAttribute( xlang, ATTR_Value,    lang.second.at(stroffset) );
+                    AppendAttribute( xlang, ATTR_Value,    m_seq.CStr(lang.second.at(stroffset)) );
 #endif
                     if(!res.second)
-                        cerr <<", \"" <<lang.second.at(stroffset) <<"\" ";
+                        cerr <<", \"" <<m_seq.Str(lang.second.at(stroffset)) <<"\" ";
                 }
                 if(!res.second)
                     cerr <<"\n";
@@ -2918,14 +2958,14 @@ namespace pmd2
 
         /*
         */
-        void WriteOrphanedConstants( xml_node & parentn )
+        void WriteOrphanedConstants( xmlwnode_t parentn )
         {
             using namespace scriptXML;
             if( m_seq.ConstTbl().empty() || 
                m_seq.ConstTbl().size() == m_referedconstids.size() ) //If all our consts were referenced, don't bother!
                 return;
 
-            xml_node xconsts = parentn.append_child( NODE_Constants.c_str() );
+            xmlwnode_t xconsts = parentn.append_child( NODE_Constants.c_str() );
 
             size_t cntc = 0;
             for( const auto & aconst : m_seq.ConstTbl() )
@@ -2935,8 +2975,8 @@ namespace pmd2
                     stringstream sstr;
                     sstr<<"Unreferenced Const ID#" <<cntc;
                     WriteCommentNode( xconsts, sstr.str() );
-                    xml_node xcst = xconsts.append_child( NODE_Constant.c_str() );
-                    AppendAttribute( xcst, ATTR_Value, aconst );
+                    xmlwnode_t xcst = xconsts.append_child( NODE_Constant.c_str() );
+                    AppendAttribute( xcst, ATTR_Value, m_seq.CStr(aconst) );
                 }
                 ++cntc;
             }
@@ -2944,17 +2984,16 @@ namespace pmd2
 
         /*
         */
-        void WriteOrphanedStrings( xml_node & parentn )
+        void WriteOrphanedStrings( xmlwnode_t parentn )
         {
             using namespace scriptXML;
             if( m_seq.StrTblSet().empty() || 
                 (m_referedstrids.size() == m_seq.StrTblSet().begin()->second.size()) ) //If all our strings were referenced, don't bother!
                 return;
 
-            xml_node xstrings = parentn.append_child( NODE_Strings.c_str() );
-
             for( const auto & alang : m_seq.StrTblSet() )
             {
+                xmlwnode_t xstrings = parentn.append_child( NODE_Strings.c_str() );
                 AppendAttribute( xstrings, ATTR_Language, GetGameLangName(alang.first) );
 
                 size_t cnts = 0;
@@ -2965,7 +3004,7 @@ namespace pmd2
                         stringstream sstr;
                         sstr<<"Unreferenced String ID#" <<cnts;
                         WriteCommentNode( xstrings, sstr.str() );
-                        AppendAttribute( xstrings.append_child( NODE_String.c_str() ), ATTR_Value, astring );
+                        AppendAttribute( xstrings.append_child( NODE_String.c_str() ), ATTR_Value, m_seq.CStr(astring) );
                     }
                     ++cnts;
                 }
@@ -2998,10 +3037,10 @@ namespace pmd2
             :m_data(data), m_paraminf(conf), m_gconf(conf)
         {}
 
-        void operator()(xml_node & parentn)
+        void operator()(xmlwnode_t parentn)
         {
             using namespace scriptXML;
-            xml_node xdata = AppendChildNode(parentn, NODE_ScriptData);
+            xmlwnode_t xdata = AppendChildNode(parentn, NODE_ScriptData);
             AppendAttribute( xdata, ATTR_ScrDatName, m_data.Name());
             AppendAttribute( xdata, ATTR_ScriptType, ScriptDataTypeToStr(m_data.Type()));
 
@@ -3018,12 +3057,12 @@ namespace pmd2
             return buffer;
         }
 
-        void WriteActionTable(xml_node & parentn)
+        void WriteActionTable(xmlwnode_t parentn)
         {
             using namespace scriptXML;
             if(m_data.ActionTable().empty())
                 return;
-            xml_node       xunktbl1 = AppendChildNode(parentn, NODE_ActionTable);
+            xmlwnode_t       xunktbl1 = AppendChildNode(parentn, NODE_ActionTable);
             const string   IDAttrName  = *OpParamTypesToStr(eOpParamTypes::Unk_CRoutineId);
             array<char,32> buf{0};
 
@@ -3031,7 +3070,7 @@ namespace pmd2
             for( const auto & unk1ent : m_data.ActionTable() )
             {
                 WriteCommentNode( xunktbl1, to_string(cnt) );
-                xml_node xentry = AppendChildNode(xunktbl1, NODE_ActionTableEntry);
+                xmlwnode_t xentry = AppendChildNode(xunktbl1, NODE_ActionTableEntry);
                 const auto * inf = m_paraminf.CRoutine(unk1ent.croutineid);
 
                 if(inf)
@@ -3046,19 +3085,19 @@ namespace pmd2
             }
         }
 
-        void WritePositionMarkers(xml_node & parentn)
+        void WritePositionMarkers(xmlwnode_t parentn)
         {
             using namespace scriptXML;
             if(m_data.PosMarkers().empty())
                 return;
-            xml_node        xposmark = AppendChildNode(parentn, NODE_PositionMarkers);
+            xmlwnode_t        xposmark = AppendChildNode(parentn, NODE_PositionMarkers);
             array<char,32>  buf{0};
 
             size_t cnt = 0;
             for( const auto & marker : m_data.PosMarkers() )
             {
                 WriteCommentNode( xposmark, to_string(cnt) );
-                xml_node xentry = AppendChildNode(xposmark, NODE_Marker);
+                xmlwnode_t xentry = AppendChildNode(xposmark, NODE_Marker);
                 AppendAttribute(xentry, ATTR_XOffset, marker.xoff );
                 AppendAttribute(xentry, ATTR_YOffset, marker.yoff );
                 AppendAttribute(xentry, ATTR_Unk2, MakeHexa(marker.unk2, buf.data()) );
@@ -3072,16 +3111,16 @@ namespace pmd2
         }
 
 
-        void WriteLayers(xml_node & parentn)
+        void WriteLayers(xmlwnode_t parentn)
         {
             using namespace scriptXML;
-            xml_node xlayers = AppendChildNode(parentn, NODE_Layers);
+            xmlwnode_t xlayers = AppendChildNode(parentn, NODE_Layers);
 
             size_t cntlayer = 0;
             for( const auto & layer : m_data.Layers() )
             {
                 //WriteCommentNode( xlayers, "Layer " + to_string(cntlayer) );
-                xml_node xlayer = AppendChildNode(xlayers, NODE_Layer);
+                xmlwnode_t xlayer = AppendChildNode(xlayers, NODE_Layer);
                 AppendAttribute(xlayer, ATTR_DummyID, to_string(cntlayer) );
                 WriteLayerActors    (xlayer, layer);
                 WriteLayerObjects   (xlayer, layer);
@@ -3092,13 +3131,13 @@ namespace pmd2
             }
         }
 
-        void WriteLayerActors(xml_node & parentn, const ScriptLayer & layer )
+        void WriteLayerActors(xmlwnode_t parentn, const ScriptLayer & layer )
         {
             using namespace scriptXML;
             if(layer.lives.empty())
                 return;
 
-            xml_node        xactors     = AppendChildNode( parentn, NODE_Actors );
+            xmlwnode_t        xactors     = AppendChildNode( parentn, NODE_Actors );
             const string    IDAttrName  = *OpParamTypesToStr(eOpParamTypes::Unk_LivesRef);
             size_t          cntact      = 0;
             array<char,32>  buf{0};
@@ -3106,7 +3145,7 @@ namespace pmd2
             for( const auto & actor : layer.lives )
             {
                 WriteCommentNode( xactors, to_string(cntact) );
-                xml_node              xactor = AppendChildNode( xactors, NODE_Actor );
+                xmlwnode_t              xactor = AppendChildNode( xactors, NODE_Actor );
                 const livesent_info * inf    = m_paraminf.LivesInfo(actor.livesid);
                 assert(inf);
 
@@ -3125,14 +3164,14 @@ namespace pmd2
             }
         }
 
-        void WriteLayerObjects(xml_node & parentn, const ScriptLayer & layer )
+        void WriteLayerObjects(xmlwnode_t parentn, const ScriptLayer & layer )
         {
             using namespace scriptXML;
             if(layer.objects.empty())
                 return;
             //WriteCommentNode( parentn, to_string(layer.objects.size()) + " object(s)" );
 
-            xml_node        xobjects    = AppendChildNode( parentn, NODE_Objects );
+            xmlwnode_t        xobjects    = AppendChildNode( parentn, NODE_Objects );
             size_t          cnt         = 0;
             const string    IDAttrName  = *OpParamTypesToStr(eOpParamTypes::Unk_ObjectRef);
             array<char,32>  buf{0};
@@ -3141,7 +3180,7 @@ namespace pmd2
             for( const auto & entry : layer.objects )
             {
                 WriteCommentNode( xobjects, to_string(cnt) );
-                xml_node     xobject = AppendChildNode( xobjects, NODE_Object );
+                xmlwnode_t     xobject = AppendChildNode( xobjects, NODE_Object );
 
                 AppendAttribute(xobject, IDAttrName, m_paraminf.ObjectIDToStr(entry.objid) );
                 AppendAttribute(xobject, ATTR_Direction, m_paraminf.DirectionData(entry.facing) );
@@ -3156,14 +3195,14 @@ namespace pmd2
             }
         }
 
-        void WriteLayerPerformers(xml_node & parentn, const ScriptLayer & layer )
+        void WriteLayerPerformers(xmlwnode_t parentn, const ScriptLayer & layer )
         {
             using namespace scriptXML;
             if(layer.performers.empty())
                 return;
             //WriteCommentNode( parentn, to_string(layer.performers.size()) + " performer(s)" );
 
-            xml_node        xperfs      = AppendChildNode( parentn, NODE_Performers );
+            xmlwnode_t        xperfs      = AppendChildNode( parentn, NODE_Performers );
             size_t          cnt         = 0;
             const string    IDAttrName  = *OpParamTypesToStr(eOpParamTypes::Unk_PerformerRef);
             array<char,32>  buf{0};
@@ -3171,7 +3210,7 @@ namespace pmd2
             for( const auto & entry : layer.performers )
             {
                 WriteCommentNode( xperfs, to_string(cnt) );
-                xml_node xperf = AppendChildNode( xperfs, NODE_Performer );
+                xmlwnode_t xperf = AppendChildNode( xperfs, NODE_Performer );
                 AppendAttribute(xperf, ATTR_PerfType,   entry.type );
                 AppendAttribute(xperf, ATTR_Direction,  m_paraminf.DirectionData(entry.facing) );
                 AppendAttribute(xperf, ATTR_Unk2,       MakeHexa(entry.unk2,buf.data()) );
@@ -3186,14 +3225,14 @@ namespace pmd2
             }
         }
 
-        void WriteLayerEvents(xml_node & parentn, const ScriptLayer & layer )
+        void WriteLayerEvents(xmlwnode_t parentn, const ScriptLayer & layer )
         {
             using namespace scriptXML;
             if(layer.events.empty())
                 return;
             //WriteCommentNode( parentn, to_string(layer.events.size()) + " event(s)" );
 
-            xml_node        xevents     = AppendChildNode( parentn, NODE_Events );
+            xmlwnode_t        xevents     = AppendChildNode( parentn, NODE_Events );
             size_t          cnt         = 0;
             const string    IDAttrName  = *OpParamTypesToStr(eOpParamTypes::Unk_CRoutineId);
             array<char,32>  buf{0}; //Temporary buffer for conversion ops
@@ -3201,7 +3240,7 @@ namespace pmd2
             for( const auto & entry : layer.events )
             {
                 WriteCommentNode( xevents, to_string(cnt) );
-                xml_node     xevent = AppendChildNode( xevents, NODE_Event );
+                xmlwnode_t     xevent = AppendChildNode( xevents, NODE_Event );
                 AppendAttribute(xevent, ATTR_Width,     entry.width );
                 AppendAttribute(xevent, ATTR_Height,    entry.height );
                 AppendAttribute(xevent, ATTR_XOffset,   entry.xoff );
@@ -3251,8 +3290,10 @@ namespace pmd2
             m_options = options;
             stringstream sstrfname;
             sstrfname << utils::TryAppendSlash(destdir) <<m_scrset.Name() <<".xml";
-            xml_document doc;
-            xml_node     xroot = doc.append_child( ROOT_ScripDir.c_str() );
+            m_xmlflags = (m_options.bescapepcdata)? pugi::format_default  :
+                                        pugi::format_indent | pugi::format_no_escapes;
+            XMLStreamWriter writer( sstrfname.str(), "    "/*"\t"*/, m_xmlflags );
+            xmlwnode_t      xroot = writer.Root().append_child( ROOT_ScripDir.c_str() );
 
             SetPPMDU_RootNodeXMLAttributes(xroot, m_gconf.GetGameVersion().version, m_gconf.GetGameVersion().region);
             //Write stuff
@@ -3261,11 +3302,7 @@ namespace pmd2
             for( const auto & entry : m_scrset.Components() )
                 WriteSet(xroot,entry);
 
-            m_xmlflags = (m_options.bescapepcdata)? pugi::format_default  :
-                                        pugi::format_indent | pugi::format_no_escapes;
-            //Write doc
-            if( ! doc.save_file( sstrfname.str().c_str(), "    "/*"\t"*/, m_xmlflags, pugi::encoding_utf8 ) )
-                throw std::runtime_error("GameScriptsXMLWriter::Write(): PugiXML can't write xml file " + sstrfname.str());
+            writer.Close();
         }
 
         /*
@@ -3299,8 +3336,6 @@ namespace pmd2
         void WriteSetAsFile(const ScriptSet & set, const std::string & destdir)
         {
             using namespace scriptXML;
-            xml_document doc;
-            xml_node     xroot = doc.append_child( ROOT_ScriptSet.c_str() );
             stringstream sstrfname;
 
             sstrfname <<utils::TryAppendSlash(destdir);
@@ -3312,12 +3347,11 @@ namespace pmd2
             //std::transform( name.begin(), name.end(), std::ostream_iterator<char>(sstrfname), std::bind(std::tolower<char>, std::placeholders::_1, std::cref(std::locale::classic()) ) );
             sstrfname <<".xml";
 
+            XMLStreamWriter writer( sstrfname.str(), "    ", m_xmlflags );
+            xmlwnode_t      xroot = writer.Root().append_child( ROOT_ScriptSet.c_str() );
             SetPPMDU_RootNodeXMLAttributes(xroot, m_gconf.GetGameVersion().version, m_gconf.GetGameVersion().region);
             WriteSet(xroot, set);
-
-            //Write doc
-            if( ! doc.save_file( sstrfname.str().c_str(), "    ", m_xmlflags, pugi::encoding_utf8 ) )
-                throw std::runtime_error("GameScriptsXMLWriter::WriteSetAsFile(): PugiXML can't write xml file " + sstrfname.str());
+            writer.Close();
         }
 
         /*
@@ -3331,22 +3365,19 @@ namespace pmd2
 
             using namespace scriptXML;
             //use special lsd name
-            xml_document doc;
-            xml_node     xroot = doc.append_child( ROOT_LSD.c_str() );
             stringstream sstrfname;
             sstrfname <<utils::TryAppendSlash(destdir) <<FNAME_LSD <<".xml";
 
+            XMLStreamWriter writer( sstrfname.str(), "    ", m_xmlflags );
+            xmlwnode_t      xroot = writer.Root().append_child( ROOT_LSD.c_str() );
             SetPPMDU_RootNodeXMLAttributes(xroot, m_gconf.GetGameVersion().version, m_gconf.GetGameVersion().region);
             WriteLSDTable(xroot);
-
-            //Write doc
-            if( ! doc.save_file( sstrfname.str().c_str(), "    ", m_xmlflags, pugi::encoding_utf8 ) )
-                throw std::runtime_error("GameScriptsXMLWriter::WriteLSDAsFile(): PugiXML can't write xml file " + sstrfname.str());
+            writer.Close();
         }
 
         /*
         */
-        void WriteSet( xml_node & parentn, const ScriptSet & set )
+        void WriteSet( xmlwnode_t parentn, const ScriptSet & set )
         {
             using namespace scriptXML;
             WriteCommentNode(parentn, "##########################################" );
@@ -3358,7 +3389,7 @@ namespace pmd2
             sstr.clear();
             sstr << "Has " <<((set.Data() != nullptr)? "1 data file, and ": "") <<set.Sequences().size() <<" associated script(s)";
             WriteCommentNode(parentn, sstr.str() );
-            xml_node xgroup = AppendChildNode( parentn, NODE_ScriptSet );
+            xmlwnode_t xgroup = AppendChildNode( parentn, NODE_ScriptSet );
 
             AppendAttribute( xgroup, ATTR_GrpName, set.Identifier() );
 
@@ -3371,10 +3402,10 @@ namespace pmd2
 
         /*
         */
-        void WriteLSDTable( xml_node & parentn )
+        void WriteLSDTable( xmlwnode_t parentn )
         {
             using namespace scriptXML;
-            xml_node xlsd = AppendChildNode( parentn, NODE_LSDTbl );
+            xmlwnode_t xlsd = AppendChildNode( parentn, NODE_LSDTbl );
 
             size_t cntlsd = 0;
             for( const auto & entry : m_scrset.LSDTable() )
@@ -3387,7 +3418,7 @@ namespace pmd2
 
         /*
         */
-        inline void WriteSSBContent( xml_node & parentn, const Script & seq )
+        inline void WriteSSBContent( xmlwnode_t parentn, const Script & seq )
         {
             using namespace scriptXML;
             WriteCommentNode(parentn, "++++++++++++++++++++++" );
@@ -3400,7 +3431,7 @@ namespace pmd2
 
         /*
         */
-        inline void WriteSSDataContent( xml_node & parentn, const ScriptData & dat )
+        inline void WriteSSDataContent( xmlwnode_t parentn, const ScriptData & dat )
         {
             using namespace scriptXML;
             WriteCommentNode(parentn, "======================" );
@@ -3455,7 +3486,8 @@ namespace pmd2
                             string             dest, 
                             atomic<uint32_t> & completed,
                             CompilerReport   & reporter,
-                            const scriptprocoptions & options)
+                            const scriptprocoptions & options,
+                            ScriptImportManifest    * pmanifest )
     {
         if( utils::LibWide().isLogOn() )
             slog() <<"##### Importing " << fname <<" #####\n";
@@ -3466,6 +3498,8 @@ namespace pmd2
             gs.WriteScriptSet( std::move( GameScriptsXMLParser(tempregion,tempversion, gs.GetConfig()).Parse(fname, options,&reporter) ) );
             if( tempregion != gs.Region() || tempversion != gs.Version() )
                 throw std::runtime_error("GameScripts::ImportXML(): Event " + fname + " from the wrong region or game version was loaded!! Ensure the version and region attributes are set properly!!");
+            if( pmanifest )
+                pmanifest->Update( Poco::Path(fname).getBaseName(), fname, dest );
         }
         catch(const std::exception & e)
         {
@@ -3535,6 +3569,47 @@ namespace pmd2
 
     /*
     */
+    /*
+        MakeScriptImportContextHash
+            Hash of everything besides the XML itself that changes what the scripts compile to.
+    */
+    uint64_t MakeScriptImportContextHash( const GameScripts & gs, const scriptprocoptions & options )
+    {
+        const uint8_t ctx[] = 
+        {
+            static_cast<uint8_t>(gs.Region()),
+            static_cast<uint8_t>(gs.Version()),
+            static_cast<uint8_t>(options.bescapepcdata),
+            static_cast<uint8_t>(options.bnodeisinst),
+            static_cast<uint8_t>(options.bmarkoffsets),
+            static_cast<uint8_t>(options.bscriptdebug),
+            static_cast<uint8_t>(options.basdir),
+        };
+        uint64_t hash = HashManifestContext( ctx, sizeof(ctx) );
+        hash = HashManifestContext( reinterpret_cast<const uint8_t*>(PMD2ToolsetVersion.data()), PMD2ToolsetVersion.size(), hash );
+
+        //The names and ids the scripts refer to come from the config file
+        const string & conffile = gs.GetConfig().GetConfigFilePath();
+        if( Poco::File(conffile).exists() )
+        {
+            vector<uint8_t> confdata = utils::io::ReadFileToByteVector(conffile);
+            hash = HashManifestContext( confdata.data(), confdata.size(), hash );
+        }
+        return hash;
+    }
+
+    /*
+        MakeScriptImportManifestPath
+            The manifest is kept next to the directory the XML is imported from, so it doesn't end up packed in the rom.
+    */
+    std::string MakeScriptImportManifestPath( const std::string & dir )
+    {
+        Poco::Path manifestpath(dir);
+        manifestpath.makeFile();
+        manifestpath.setFileName( manifestpath.getFileName() + ".scrmanifest" );
+        return manifestpath.toString();
+    }
+
     void ImportXMLGameScripts(const std::string & dir, 
                               GameScripts & out_dest, const 
                               scriptprocoptions & options )
@@ -3586,7 +3661,13 @@ namespace pmd2
         Poco::DirectoryIterator dirend;
         if(utils::LibWide().isLogOn())
             slog() << "<*>- Listing XML to import..\n";
-        size_t cntdir = 0;
+        size_t cntdir       = 0;
+        size_t cntunchanged = 0;
+
+        //Levels whose XML didn't change since the last import are skipped
+        unique_ptr<ScriptImportManifest> pmanifest;
+        if( options.bincremental )
+            pmanifest.reset( new ScriptImportManifest( MakeScriptImportManifestPath(dir), MakeScriptImportContextHash(out_dest, options) ) );
 
 
         if(options.basdir) //Load as directories
@@ -3598,13 +3679,20 @@ namespace pmd2
                 {
                     Poco::Path destination(out_dest.GetScriptDir());
                     destination.append(dirit.path().getBaseName());
+                    if( pmanifest && pmanifest->IsUpToDate( dirit.path().getBaseName(), dirit->path(), destination.toString() ) )
+                    {
+                        ++cntunchanged;
+                        ++dirit;
+                        continue;
+                    }
                     taskhandler.QueueTask( utils::AsyncTaskHandler::task_t( std::bind( RunLevelXMLImport, 
                                                                          std::ref(out_dest), 
                                                                          dirit->path(), 
                                                                          destination.toString(),
                                                                          std::ref(completed),
                                                                          std::ref(reporter),
-                                                                         std::cref(options)) ) );
+                                                                         std::cref(options),
+                                                                         pmanifest.get()) ) );
                     if(utils::LibWide().isLogOn())
                         slog() << "\t+ " <<dirit.path().getBaseName() <<"\n";
                     ++cntdir;
@@ -3623,13 +3711,20 @@ namespace pmd2
 
                     Poco::Path destination(out_dest.GetScriptDir());
                     destination.append(dirit.path().getBaseName());
+                    if( pmanifest && pmanifest->IsUpToDate( dirit.path().getBaseName(), dirit->path(), destination.toString() ) )
+                    {
+                        ++cntunchanged;
+                        ++dirit;
+                        continue;
+                    }
                     taskhandler.QueueTask( utils::AsyncTaskHandler::task_t( std::bind( RunLevelXMLImport, 
                                                                          std::ref(out_dest), 
                                                                          dirit->path(), 
                                                                          destination.toString(),
                                                                          std::ref(completed),
                                                                          std::ref(reporter),
-                                                                         std::cref(options)) ) );
+                                                                         std::cref(options),
+                                                                         pmanifest.get()) ) );
                     if(utils::LibWide().isLogOn())
                         slog() << "\t+ " <<dirit.path().getFileName() <<"\n";
                     ++cntdir;
@@ -3640,6 +3735,15 @@ namespace pmd2
 
         if(utils::LibWide().isLogOn())
             slog() << "Done listing " <<cntdir <<" entries\n\n";
+        if( cntunchanged != 0 && (utils::LibWide().ShouldDisplayProgress() || utils::LibWide().isLogOn()) )
+        {
+            stringstream sstr;
+            sstr <<"<*>- Skipping " <<cntunchanged <<" unchanged level(s) since the last import.\n";
+            if(utils::LibWide().isLogOn())
+                slog() << sstr.str();
+            if(utils::LibWide().ShouldDisplayProgress())
+                cout << sstr.str();
+        }
         try
         {
             if( !taskhandler.empty() )
@@ -3674,6 +3778,9 @@ namespace pmd2
             if( !options.basdir ) //We need to specify the nb when imported as XML files
                 reporter.SetNbExpected( cntdir + 1 ); //Add one for the unionall.ssb script!
             reporter.PrintErrorReport(outputresult); 
+
+            if( pmanifest )
+                pmanifest->Write();
         }
         catch(...)
         {
@@ -3794,19 +3901,15 @@ namespace pmd2
         using namespace scriptXML;
         stringstream sstrfname;
         sstrfname << utils::TryAppendSlash(destdir) <<scr.Name() <<".xml";
-        xml_document doc;
-        xml_node     xroot = doc.append_child( ROOT_SingleScript.c_str() );
+        const unsigned int flag = (options.bescapepcdata)? pugi::format_default  : 
+                                    pugi::format_indent | pugi::format_no_escapes;
+        XMLStreamWriter writer( sstrfname.str(), "\t", flag );
+        xmlwnode_t      xroot = writer.Root().append_child( ROOT_SingleScript.c_str() );
         AppendAttribute( xroot, ATTR_GVersion, GetGameVersionName(gconf.GetGameVersion().version) );
         AppendAttribute( xroot, ATTR_GRegion,  GetGameRegionNames(gconf.GetGameVersion().region) );
 
         SSBXMLWriter(scr, gconf, options)(xroot);
-
-        //Write stuff
-        const unsigned int flag = (options.bescapepcdata)? pugi::format_default  : 
-                                    pugi::format_indent | pugi::format_no_escapes;
-        //Write doc
-        if( ! doc.save_file( sstrfname.str().c_str(), "\t", flag ) )
-            throw std::runtime_error("ScriptToXML(): Can't write xml file " + sstrfname.str());
+        writer.Close();
     }
 
     /*
@@ -3859,19 +3962,15 @@ namespace pmd2
         using namespace scriptXML;
         stringstream sstrfname;
         sstrfname << utils::TryAppendSlash(destdir) <<dat.Name() <<".xml";
-        xml_document doc;
-        xml_node     xroot = doc.append_child( ROOT_SingleData.c_str() );
+        const unsigned int flag = (options.bescapepcdata)? pugi::format_default  : 
+                                    pugi::format_indent | pugi::format_no_escapes;
+        XMLStreamWriter writer( sstrfname.str(), "\t", flag );
+        xmlwnode_t      xroot = writer.Root().append_child( ROOT_SingleData.c_str() );
         AppendAttribute( xroot, ATTR_GVersion, GetGameVersionName(gconf.GetGameVersion().version) );
         AppendAttribute( xroot, ATTR_GRegion,  GetGameRegionNames(gconf.GetGameVersion().region) );
 
         SSDataXMLWriter(dat, gconf)(xroot);
-
-        //Write stuff
-        const unsigned int flag = (options.bescapepcdata)? pugi::format_default  : 
-                                    pugi::format_indent | pugi::format_no_escapes;
-        //Write doc
-        if( ! doc.save_file( sstrfname.str().c_str(), "\t", flag ) )
-            throw std::runtime_error("ScriptDataToXML(): Can't write xml file " + sstrfname.str());
+        writer.Close();
     }
 
     /*
@@ -2,10 +2,12 @@
 #include <utils/utility.hpp>
 #include <types/content_type_analyser.hpp>
 #include <ppmdu/pmd2/sprite_rle.hpp>
+#include <utils/multiple_task_handler.hpp>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <cassert>
+#include <functional>
 
 using namespace ::std;
 using namespace ::pmd2;
@@ -1572,21 +1574,33 @@ namespace pmd2
                 return;
             }
 
-            //#1 - Ensure the output is large enough
-            m_pCurSpriteOut->getAllFrames().resize( m_framepointers.size() );
+            //#1 - Read all the RLE tables first, so every frames can be allocated at their final size
+            auto                                       & frames   = m_pCurSpriteOut->getAllFrames();
+            const size_t                                 nbframes = m_framepointers.size();
+            vector<vector<compression::rle_table_entry>> rletables(nbframes);
+            frames.resize(nbframes);
 
-            //#2 - Iterate on all our frame pointers and run our functor
-            compression::rle_decoder decoder( m_pCurSpriteOut->getAllFrames().begin(),
-                                              m_pCurSpriteOut->getAllFrames().end() );
-
-            for( const auto & pointer : m_framepointers )
+            for( size_t i = 0; i < nbframes; ++i )
             {
+                uint32_t frmbeg = 0;
+                frames[i].resize( compression::ReadRLETable( m_itbegdata + m_framepointers[i], m_itenddata, rletables[i], frmbeg ) );
+
                 //Get the first frame's frm_beg
                 if( m_offsetFirstFrameBeg == 0 ) 
-                    m_offsetFirstFrameBeg = decoder( m_itbegdata, m_itenddata, m_itbegdata + pointer );
-                else
-                    decoder( m_itbegdata, m_itenddata, m_itbegdata + pointer );
+                    m_offsetFirstFrameBeg = frmbeg;
             }
+
+            //#2 - Decode the frames, on several threads if there are enough of them
+            const uint8_t * psrc   = &(*m_itbegdata);
+            const size_t    srclen = static_cast<size_t>( std::distance( m_itbegdata, m_itenddata ) );
+            auto lambdaDecode = [&]( size_t i )
+            {
+                if( !frames[i].empty() )
+                    compression::DecodeRLEFrame( rletables[i], psrc, srclen, frames[i].data() );
+            };
+
+            //Stays on the calling thread when the sprite is already parsed on a worker thread, like in the sprite analyser
+            multitask::ParallelForChunks( nbframes, lambdaDecode );
         }
 
         //INCREMENTS THE ITERATOR PASSED BY REFERENCE !!!!
@@ -6,6 +6,7 @@ pmd2_text.hpp
 #include <ppmdu/pmd2/pmd2.hpp>
 //#include <ppmdu/pmd2/pmd2_langconf.hpp>
 #include <ppmdu/pmd2/pmd2_configloader.hpp>
+#include <utils/string_table.hpp>
 #include <string>
 #include <vector>
 #include <map>
@@ -25,46 +26,54 @@ namespace pmd2
 //==================================================================================
     /****************************************************************************************
             A helper for accessing strings at offsets stored within a StringCatalog.
+            The strings are all stored in a single utils::StringTable, and returned as views.
     ****************************************************************************************/
     class StringAccessor
     {
     public:
-        typedef std::vector<std::string>::iterator       iterator;
-        typedef std::vector<std::string>::const_iterator const_iterator;
+        typedef utils::StringTable::iterator       iterator;
+        typedef utils::StringTable::const_iterator const_iterator;
 
 
-        StringAccessor( std::vector<std::string> && strs, StringsCatalog && strcatalog )
+        StringAccessor( utils::StringTable && strs, StringsCatalog && strcatalog )
             :m_cata(std::move(strcatalog)),m_strings( std::move(strs) )
         {}
 
         inline size_t         size()const  { return m_strings.size();  }
         inline bool           empty()const { return m_strings.empty(); }
-        inline iterator       begin()      { return m_strings.begin(); }
         inline const_iterator begin()const { return m_strings.begin(); }
-        inline iterator       end()        { return m_strings.end(); }
         inline const_iterator end()const   { return m_strings.end(); }
 
-        inline const std::string              & operator[]( size_t index )const     { return m_strings.at(index); }
-        inline std::string                    & operator[]( size_t index )          { return m_strings.at(index); }
-        inline std::vector<std::string>       & Strings()                           { return m_strings; }
-        inline const std::vector<std::string> & Strings()const                      { return m_strings; }
+        inline utils::StrView             operator[]( size_t index )const                           { return m_strings.at(index); }
+        inline void                       SetString ( size_t index, const std::string & str )       { m_strings.Replace(index, str); }
+        inline const utils::StringTable & Strings()const                                            { return m_strings; }
 
-        std::string * GetStringIfBlockExists(eStringBlocks blk, size_t index)
+        /*
+            GetStringIfBlockExists
+                Returns false if the block isn't loaded, or the index is outside of it.
+                Otherwise, "out_str" is set to the string.
+        */
+        bool GetStringIfBlockExists(eStringBlocks blk, size_t index, utils::StrView & out_str)const
         {
-            StringsCatalog::iterator itf;
-            if( IsBlockLoaded( blk, itf ) && 
-               (itf->second.beg + index) < itf->second.end && 
-               (itf->second.beg + index) < m_strings.size() )
-            {
-                return &(m_strings[(itf->second.beg + index)]); 
-            }
-            else
-                return nullptr;
+            size_t strindex = 0;
+            if( !GetIndexIfBlockExists(blk, index, strindex) )
+                return false;
+            out_str = m_strings[strindex];
+            return true;
         }
 
-        inline const std::string * GetStringIfBlockExists(eStringBlocks blk, size_t index)const 
+        /*
+            SetStringIfBlockExists
+                Returns false if the block isn't loaded, or the index is outside of it.
+                Otherwise, replaces the string.
+        */
+        bool SetStringIfBlockExists(eStringBlocks blk, size_t index, const std::string & str)
         {
-            return const_cast<StringAccessor*>(this)->GetStringIfBlockExists(blk,index);
+            size_t strindex = 0;
+            if( !GetIndexIfBlockExists(blk, index, strindex) )
+                return false;
+            m_strings.Replace(strindex, str);
+            return true;
         }
 
         /*
@@ -84,7 +93,7 @@ namespace pmd2
 
         inline bool IsBlockLoaded( eStringBlocks blk, StringsCatalog::const_iterator & out_found )const
         {
-            return const_cast<StringAccessor*>(this)->IsBlockLoaded(blk,out_found);
+            return (out_found = m_cata.find(blk)) != m_cata.end();
         }
 
         inline bool IsWithinBounds(eStringBlocks blk, size_t index)const
@@ -93,7 +102,7 @@ namespace pmd2
         }
 
         //
-        std::string & GetStringInBlock( eStringBlocks blkty, size_t index ) 
+        utils::StrView GetStringInBlock( eStringBlocks blkty, size_t index )const
         {
             const strbounds_t & bounds = m_cata[blkty];
             if( !IsWithinBounds( blkty, index) )
@@ -103,23 +112,13 @@ namespace pmd2
             return (m_strings[bounds.beg + index]);
         }
 
-        inline const std::string & GetStringInBlock( eStringBlocks blkty, size_t index )const
-        {
-            return const_cast<StringAccessor*>(this)->GetStringInBlock(blkty, index);
-        }
-
-        std::pair<iterator,iterator> GetBoundsStringsBlock( eStringBlocks blk )
+        std::pair<const_iterator,const_iterator> GetBoundsStringsBlock( eStringBlocks blk )const
         {
-            iterator blkbeg = m_strings.begin() + m_cata[blk].beg;
-            iterator blkend = m_strings.begin() + m_cata[blk].end;
+            const_iterator blkbeg = m_strings.begin() + m_cata[blk].beg;
+            const_iterator blkend = m_strings.begin() + m_cata[blk].end;
             return std::make_pair( blkbeg, blkend );
         }
 
-        inline std::pair<const_iterator,const_iterator> GetBoundsStringsBlock( eStringBlocks blk )const
-        {
-            return std::move(const_cast<StringAccessor*>(this)->GetBoundsStringsBlock(blk));
-        }
-
         inline size_t GetNbStringsInBlock(eStringBlocks blk)const
         {
             return (m_cata[blk].end - m_cata[blk].beg);
@@ -141,10 +140,24 @@ namespace pmd2
         }
 
     private:
+        //Returns the index of the string in the whole table, if the block is loaded and the index is within it.
+        bool GetIndexIfBlockExists(eStringBlocks blk, size_t index, size_t & out_strindex)const
+        {
+            StringsCatalog::const_iterator itf;
+            if( IsBlockLoaded( blk, itf ) && 
+               (itf->second.beg + index) < itf->second.end && 
+               (itf->second.beg + index) < m_strings.size() )
+            {
+                out_strindex = itf->second.beg + index;
+                return true;
+            }
+            else
+                return false;
+        }
 
     private:
         StringsCatalog           m_cata;
-        std::vector<std::string> m_strings;
+        utils::StringTable       m_strings;
     };
 
 
@@ -258,10 +271,10 @@ namespace pmd2
                 Get a string by index in a language's entire string table.
                 **This assumes that the language and block exists, and will throw if it doesn't.**
         */
-        inline const std::string & GetString( eGameLanguages lang, size_t index )const {return const_cast<GameText*>(this)->GetString(lang,index);}
-        inline std::string       & GetString( eGameLanguages lang, size_t index )
+        inline utils::StrView GetString( eGameLanguages lang, size_t index )const
         {
             auto itf = GetLang(lang);
+            if( index >= itf->second.size() )
                 throw std::out_of_range("GameText::GetString(): String index specified is out of bounds!");
             return (itf->second[index]);
         }
@@ -272,8 +285,7 @@ namespace pmd2
                 string block, and not the entire string table.
                 **This assumes that the language and block exists, and will throw if it doesn't.**
         */
-        inline const std::string & GetString( eGameLanguages lang, eStringBlocks blk, size_t index )const {return const_cast<GameText*>(this)->GetString(lang,blk,index);}
-        inline std::string       & GetString( eGameLanguages lang, eStringBlocks blk, size_t index )
+        inline utils::StrView GetString( eGameLanguages lang, eStringBlocks blk, size_t index )const
         {
             auto itf = GetLang(lang);
             if( itf->second.IsWithinBounds(blk,index) )
@@ -285,30 +297,29 @@ namespace pmd2
             TryGetString 
                 Same as GetString, except this one won't throw
                 exception if the string or language doesn't exist.
-                It will instead return a nullptr.
+                It will instead return false.
         */
-        inline const std::string * TryGetString( eGameLanguages lang, size_t index )const {return const_cast<GameText*>(this)->TryGetString(lang,index);}
-        inline std::string       * TryGetString( eGameLanguages lang, size_t index )
+        inline bool TryGetString( eGameLanguages lang, size_t index, utils::StrView & out_str )const
         {
             auto itf = m_languages.find(lang);
             if( itf == end() || index >= itf->second.size() )
-                return nullptr;
-            return &(itf->second[index]);
+                return false;
+            out_str = itf->second[index];
+            return true;
         }
 
         /*
             TryGetString 
                 Same as GetString, except this one won't throw
                 exception if the string, string block, or language doesn't exist.
-                It will instead return a nullptr.
+                It will instead return false.
         */
-        inline const std::string * TryGetString( eGameLanguages lang, eStringBlocks blk, size_t index )const { return const_cast<GameText*>(this)->TryGetString(lang,blk,index); }
-        inline std::string       * TryGetString( eGameLanguages lang, eStringBlocks blk, size_t index )
+        inline bool TryGetString( eGameLanguages lang, eStringBlocks blk, size_t index, utils::StrView & out_str )const
         {
             auto itf = m_languages.find(lang);
             if( itf == end() )
-                return nullptr;
-            return itf->second.GetStringIfBlockExists(blk,index);
+                return false;
+            return itf->second.GetStringIfBlockExists(blk,index,out_str);
         }
 
     private:
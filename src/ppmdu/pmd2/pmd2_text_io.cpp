@@ -52,7 +52,7 @@ namespace pmd2
                 clog <<"<*>- Reading file : " << afile <<"\n";
                 std::vector<string> strs = utils::io::ReadTextFileLineByLine( afile, std::locale(langdetails->GetLocaleString()) );
                 m_languages.insert_or_assign( glang, 
-                                                std::move(StringAccessor( std::move(strs), 
+                                                std::move(StringAccessor( utils::StringTable(strs.begin(), strs.end()), 
                                                                         std::move( StringsCatalog(*langdetails)))
                                                         )
                                             );
@@ -41,6 +41,13 @@ namespace pmd2
         pugixmlutils::AppendAttribute( destnode, CommonXMLToolVersionAttrStr, PMD2ToolsetVersion );
     }
 
+    inline void SetPPMDU_RootNodeXMLAttributes( pugixmlutils::XMLStreamWriter::node destnode, eGameVersion ver, eGameRegion reg )
+    {
+        pugixmlutils::AppendAttribute( destnode, CommonXMLGameVersionAttrStr, GetGameVersionName(ver) );
+        pugixmlutils::AppendAttribute( destnode, CommonXMLGameRegionAttrStr,  GetGameRegionNames(reg) );
+        pugixmlutils::AppendAttribute( destnode, CommonXMLToolVersionAttrStr, PMD2ToolsetVersion );
+    }
+
     /*
         GetPPMDU_RootNodeXMLAttributes
             Get from the specified XML node the attributes used on all XML root nodes used with PPMDU
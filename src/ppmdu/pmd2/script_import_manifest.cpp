@@ -0,0 +1,276 @@
+#include "script_import_manifest.hpp"
+#include <utils/gbyteutils.hpp>
+#include <utils/gfileio.hpp>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/DirectoryIterator.h>
+#include <Poco/Exception.h>
+using namespace std;
+
+namespace pmd2
+{
+    namespace
+    {
+        const uint32_t ManifestFileMagic   = 0x464D5353; //"SSMF"
+        const uint32_t ManifestFileVersion = 1;
+
+        typedef ScriptImportManifest::fileinfo   fileinfo;
+        typedef ScriptImportManifest::levelentry levelentry;
+
+        uint64_t HashFileContent( const std::string & path )
+        {
+            vector<uint8_t> content = utils::io::ReadFileToByteVector(path);
+            return HashManifestContext( content.data(), content.size() );
+        }
+
+        fileinfo MakeFileInfo( const Poco::File & file, const std::string & relpath )
+        {
+            fileinfo finf;
+            finf.relpath = relpath;
+            finf.size    = static_cast<uint64_t>( file.getSize() );
+            finf.mtime   = static_cast<uint64_t>( file.getLastModified().epochMicroseconds() );
+            finf.hash    = 0;
+            return finf;
+        }
+
+        //Lists all the files in the directory and its sub-directories, without hashing them
+        void ListFiles( const Poco::Path & dir, const std::string & relprefix, vector<fileinfo> & out_files )
+        {
+            Poco::DirectoryIterator itdirend;
+            for( Poco::DirectoryIterator itdir(dir); itdir != itdirend; ++itdir )
+            {
+                const string relpath = relprefix + itdir.name();
+                if( itdir->isDirectory() )
+                    ListFiles( itdir.path(), relpath + "/", out_files );
+                else if( itdir->isFile() )
+                    out_files.push_back( MakeFileInfo( *itdir, relpath ) );
+            }
+        }
+
+        //"path" is either a single file, or a directory. Returns an empty list if it doesn't exist.
+        vector<fileinfo> ListPathContent( const std::string & path )
+        {
+            vector<fileinfo> files;
+            Poco::File       fpath(path);
+            if( !fpath.exists() )
+                return std::move(files);
+
+            if( fpath.isDirectory() )
+            {
+                ListFiles( Poco::Path(path).makeDirectory(), "", files );
+                std::sort( files.begin(), files.end(), []( const fileinfo & a, const fileinfo & b ){ return a.relpath < b.relpath; } );
+            }
+            else
+                files.push_back( MakeFileInfo( fpath, Poco::Path(path).getFileName() ) );
+            return std::move(files);
+        }
+
+        std::string MakeFilePath( const std::string & path, const fileinfo & finf )
+        {
+            Poco::Path fpath(path);
+            if( Poco::File(fpath).isDirectory() )
+                return fpath.makeDirectory().append(finf.relpath).toString();
+            else
+                return fpath.toString();
+        }
+
+        /*
+            Hashes the files in "cur", reusing the hashes from "old" for files whose size and modification time didn't change.
+            Returns false as soon as a file doesn't match the old list, without hashing the rest.
+        */
+        bool MatchAndHashFiles( const std::string & path, const vector<fileinfo> & old, vector<fileinfo> & cur )
+        {
+            if( old.size() != cur.size() )
+                return false;
+
+            for( size_t i = 0; i < cur.size(); ++i )
+            {
+                if( old[i].relpath != cur[i].relpath || old[i].size != cur[i].size )
+                    return false;
+
+                if( old[i].mtime == cur[i].mtime )
+                    cur[i].hash = old[i].hash;
+                else if( (cur[i].hash = HashFileContent( MakeFilePath(path, cur[i]) )) != old[i].hash )
+                    return false;
+            }
+            return true;
+        }
+
+        void HashFiles( const std::string & path, vector<fileinfo> & files )
+        {
+            for( auto & finf : files )
+                finf.hash = HashFileContent( MakeFilePath(path, finf) );
+        }
+
+        /*
+            Manifest file layout, all integers little endian:
+                uint32 magic, uint32 version, uint64 contexthash, uint32 nblevels,
+                nblevels * { uint16 namelen, char name[namelen], filelist sources, filelist outputs }
+            filelist:
+                uint32 nbfiles, nbfiles * { uint16 pathlen, char path[pathlen], uint64 size, uint64 mtime, uint64 hash }
+        */
+        template<class _outit>
+            _outit WriteString( const std::string & str, _outit itout )
+        {
+            itout = utils::WriteIntToBytes( static_cast<uint16_t>(str.size()), itout );
+            return std::copy( str.begin(), str.end(), itout );
+        }
+
+        template<class _outit>
+            _outit WriteFileList( const vector<fileinfo> & files, _outit itout )
+        {
+            itout = utils::WriteIntToBytes( static_cast<uint32_t>(files.size()), itout );
+            for( const auto & finf : files )
+            {
+                itout = WriteString( finf.relpath, itout );
+                itout = utils::WriteIntToBytes( finf.size,  itout );
+                itout = utils::WriteIntToBytes( finf.mtime, itout );
+                itout = utils::WriteIntToBytes( finf.hash,  itout );
+            }
+            return itout;
+        }
+
+        template<class _init>
+            std::string ReadString( _init & itread, _init itend )
+        {
+            const uint16_t len = utils::ReadIntFromBytes<uint16_t>(itread, itend);
+            if( static_cast<size_t>(std::distance(itread, itend)) < len )
+                throw runtime_error("ScriptImportManifest: Manifest file is truncated!");
+            std::string str( itread, itread + len );
+            itread += len;
+            return std::move(str);
+        }
+
+        template<class _init>
+            vector<fileinfo> ReadFileList( _init & itread, _init itend )
+        {
+            const uint32_t   nbfiles = utils::ReadIntFromBytes<uint32_t>(itread, itend);
+            vector<fileinfo> files;
+            for( uint32_t i = 0; i < nbfiles; ++i )
+            {
+                fileinfo finf;
+                finf.relpath = ReadString(itread, itend);
+                finf.size    = utils::ReadIntFromBytes<uint64_t>(itread, itend);
+                finf.mtime   = utils::ReadIntFromBytes<uint64_t>(itread, itend);
+                finf.hash    = utils::ReadIntFromBytes<uint64_t>(itread, itend);
+                files.push_back( std::move(finf) );
+            }
+            return std::move(files);
+        }
+    };
+
+    uint64_t HashManifestContext( const uint8_t * pdata, size_t len, uint64_t hash )
+    {
+        //FNV-1a
+        for( size_t i = 0; i < len; ++i )
+        {
+            hash ^= pdata[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+//==============================================================================================
+//  ScriptImportManifest
+//==============================================================================================
+    ScriptImportManifest::ScriptImportManifest( const std::string & fpath, uint64_t contexthash )
+        :m_fpath(fpath), m_contexthash(contexthash)
+    {
+        if( !Poco::File(m_fpath).exists() )
+            return;
+
+        try
+        {
+            const vector<uint8_t> data   = utils::io::ReadFileToByteVector(m_fpath);
+            auto                  itread = data.begin();
+            auto                  itend  = data.end();
+            if( utils::ReadIntFromBytes<uint32_t>(itread, itend) != ManifestFileMagic   ||
+                utils::ReadIntFromBytes<uint32_t>(itread, itend) != ManifestFileVersion ||
+                utils::ReadIntFromBytes<uint64_t>(itread, itend) != m_contexthash )
+                return; //Not from the same version, or not made for the same game/config/options. Compile everything.
+
+            const uint32_t nblevels = utils::ReadIntFromBytes<uint32_t>(itread, itend);
+            for( uint32_t i = 0; i < nblevels; ++i )
+            {
+                std::string lvlname = ReadString(itread, itend);
+                levelentry  entry;
+                entry.sources = ReadFileList(itread, itend);
+                entry.outputs = ReadFileList(itread, itend);
+                m_previous.emplace( std::move(lvlname), std::move(entry) );
+            }
+        }
+        catch( const exception & e )
+        {
+            m_previous.clear();
+            clog <<"<!>-Warning: ScriptImportManifest::ScriptImportManifest(): Ignoring manifest file \"" <<m_fpath <<"\": " <<e.what() <<"\n";
+        }
+    }
+
+    bool ScriptImportManifest::IsUpToDate( const std::string & lvlname, const std::string & srcpath, const std::string & destdir )
+    {
+        //m_previous is never modified after construction
+        auto itold = m_previous.find(lvlname);
+        if( itold == m_previous.end() )
+            return false;
+
+        levelentry cur;
+        cur.sources = ListPathContent(srcpath);
+        cur.outputs = ListPathContent(destdir);
+        if( cur.sources.empty() ||
+            !MatchAndHashFiles( srcpath, itold->second.sources, cur.sources ) ||
+            !MatchAndHashFiles( destdir, itold->second.outputs, cur.outputs ) )
+            return false;
+
+        std::lock_guard<std::mutex> lck(m_mtx);
+        m_current[lvlname] = std::move(cur);
+        return true;
+    }
+
+    void ScriptImportManifest::Update( const std::string & lvlname, const std::string & srcpath, const std::string & destdir )
+    {
+        levelentry cur;
+        cur.sources = ListPathContent(srcpath);
+        cur.outputs = ListPathContent(destdir);
+        HashFiles( srcpath, cur.sources );
+        HashFiles( destdir, cur.outputs );
+
+        std::lock_guard<std::mutex> lck(m_mtx);
+        m_current[lvlname] = std::move(cur);
+    }
+
+    void ScriptImportManifest::Write()const
+    {
+        try
+        {
+            vector<uint8_t> out;
+            auto            itout = back_inserter(out);
+            {
+                std::lock_guard<std::mutex> lck(m_mtx);
+                itout = utils::WriteIntToBytes( ManifestFileMagic,                           itout );
+                itout = utils::WriteIntToBytes( ManifestFileVersion,                         itout );
+                itout = utils::WriteIntToBytes( m_contexthash,                               itout );
+                itout = utils::WriteIntToBytes( static_cast<uint32_t>(m_current.size()),     itout );
+                for( const auto & entry : m_current )
+                {
+                    itout = WriteString  ( entry.first,          itout );
+                    itout = WriteFileList( entry.second.sources, itout );
+                    itout = WriteFileList( entry.second.outputs, itout );
+                }
+            }
+            utils::io::WriteByteVectorToFile( m_fpath, out );
+        }
+        catch( const Poco::Exception & e )
+        {
+            clog <<"<!>-Warning: ScriptImportManifest::Write(): Couldn't write the manifest file \"" <<m_fpath <<"\": " <<e.displayText() <<"\n";
+        }
+        catch( const exception & e )
+        {
+            clog <<"<!>-Warning: ScriptImportManifest::Write(): Couldn't write the manifest file \"" <<m_fpath <<"\": " <<e.what() <<"\n";
+        }
+    }
+
+};
@@ -0,0 +1,84 @@
+#ifndef SCRIPT_IMPORT_MANIFEST_HPP
+#define SCRIPT_IMPORT_MANIFEST_HPP
+/*
+script_import_manifest.hpp
+psycommando@gmail.com
+Description: Keeps track of what script XML was compiled into what files on the last import,
+             so that levels whose XML didn't change aren't compiled again.
+*/
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pmd2
+{
+    /*************************************************************************************************
+        ScriptImportManifest
+            For each level imported, keeps the size, last modification time and a hash of the
+            content of its XML source file(s), and of the files in its output directory.
+
+            A level is up to date when its XML is the same as what was compiled last time, and
+            the files in its output directory are still the ones that were written then.
+            Files whose size and modification time didn't change aren't read again.
+
+            "contexthash" stands for anything else that changes the compiled output for the same
+            XML. (game version, config data, options..) A manifest written with a different
+            context hash is ignored entirely.
+
+            Only the levels passed to IsUpToDate() or Update() during this run are written
+            back to the manifest file, so levels that were removed, or failed to compile,
+            are compiled again next time.
+
+            IsUpToDate() and Update() can be called from several threads at the same time,
+            for different levels.
+    *************************************************************************************************/
+    class ScriptImportManifest
+    {
+    public:
+        struct fileinfo
+        {
+            std::string relpath;
+            uint64_t    size;
+            uint64_t    mtime;
+            uint64_t    hash;
+        };
+
+        struct levelentry
+        {
+            std::vector<fileinfo> sources;
+            std::vector<fileinfo> outputs;
+        };
+
+        //Loads "fpath" if it exists and was written for the same context.
+        ScriptImportManifest( const std::string & fpath, uint64_t contexthash );
+
+        /*
+            IsUpToDate
+                Returns true if the level's source file or directory, and its output directory
+                didn't change since Update() was last called for it.
+        */
+        bool IsUpToDate( const std::string & lvlname, const std::string & srcpath, const std::string & destdir );
+
+        //Records the current state of the level's source and output, once it was compiled and written.
+        void Update( const std::string & lvlname, const std::string & srcpath, const std::string & destdir );
+
+        //Writes the manifest file. Failing to do so is only a warning.
+        void Write()const;
+
+        inline const std::string & getFilePath()const { return m_fpath; }
+
+    private:
+        std::string                                 m_fpath;
+        uint64_t                                    m_contexthash;
+        std::unordered_map<std::string, levelentry> m_previous; //What was loaded from the manifest file
+        std::unordered_map<std::string, levelentry> m_current;  //What will be written to the manifest file
+        mutable std::mutex                          m_mtx;
+    };
+
+    //FNV-1a hash of a byte range, for building the context hash of a ScriptImportManifest.
+    uint64_t HashManifestContext( const uint8_t * pdata, size_t len, uint64_t hash = 14695981039346656037ULL );
+};
+
+#endif
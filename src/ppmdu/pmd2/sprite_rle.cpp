@@ -4,25 +4,14 @@
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <stdexcept>
 #include <utils\utility.hpp>
 using namespace std;
 
 
 namespace pmd2 { namespace compression
 {
-//================================================================================================
-// Utility Functions
-//================================================================================================
-
-    /*
-        Also increments the output iterator!
-    */
-    void InsertZerosIntoVector( vector<uint8_t>::iterator & itpos, unsigned int amount )
-    {
-        for( unsigned int i = 0; i < amount; ++i, ++itpos )
-            (*itpos) = 0; 
-    }
-
 //================================================================================================
 // rle_table_entry
 //================================================================================================
@@ -43,34 +32,67 @@ namespace pmd2 { namespace compression
     //}
 
 //================================================================================================
-// rle_decoder Utility Functions
+// Functions
 //================================================================================================
+    uint32_t ReadRLETable( vector<uint8_t>::const_iterator itfrmin, 
+                           vector<uint8_t>::const_iterator itend, 
+                           vector<rle_table_entry>       & out_entries,
+                           uint32_t                      & out_frmbeg )
+    {
+        unsigned int sanitycpt   = 0; //A little counter to abort in case we don't find a null entry
+        uint32_t     imagesz8bpp = 0;
+        out_frmbeg = 0;
+        out_entries.resize(0);
+
+        do
+        {
+            rle_table_entry entry;
+            //Read current entry
+            itfrmin = entry.ReadFromContainer( itfrmin, itend );
+
+            imagesz8bpp += entry.pixamt * 2; //Multiply the bytes per 2, because we're exporting to 8bpp!
 
-    /*
-        Increments the output iterator!
-    */
-    void HandleRLETableEntry( const rle_table_entry                      &entry, 
-                              std::vector<uint8_t>::const_iterator  itbeg, 
-                              std::vector<uint8_t>::iterator       &itout )
+            if( out_frmbeg == 0 && entry.pixelsrc != 0 ) //Get the beginning of the frame data if possible
+                out_frmbeg = entry.pixelsrc;
+
+            out_entries.push_back(entry);
+
+            ++sanitycpt;
+        } while( !out_entries.back().isNull() && sanitycpt < 1000u ); //We abort when hitting 1000 turns, just in case
+
+        assert( sanitycpt < 1000u ); //If we hit this, the data fed to this function is very wrong !
+        return imagesz8bpp;
+    }
+
+    void DecodeRLEFrame( const vector<rle_table_entry> & entries, 
+                         const uint8_t                 * psrc, 
+                         size_t                          srclen, 
+                         uint8_t                       * pout )
     {
-        //Execute whatever it wants to do
-        if( !entry.isNull() )
+        for( const auto & entry : entries )
         {
+            if( entry.isNull() )
+                continue;
+
+            const size_t nbpix8bpp = static_cast<size_t>(entry.pixamt) * 2; //Multiplied by 2, because 4bpp to 8bpp
             if( entry.pixelsrc == 0 )
-            {
-                InsertZerosIntoVector( itout, (entry.pixamt * 2) ); //Multiplied by 2, because 4bpp to 8bpp
-            }
+                std::memset( pout, 0, nbpix8bpp );
             else
             {
-                for( unsigned int i = 0; i < entry.pixamt; ++i )
+                if( entry.pixelsrc > srclen || entry.pixamt > (srclen - entry.pixelsrc) )
+                    throw std::out_of_range("DecodeRLEFrame(): RLE table entry points past the end of the sprite data!");
+
+                //Split each bytes into 2 pixels, low nybble first
+                const uint8_t * pin    = psrc + entry.pixelsrc;
+                const uint8_t * pinend = pin  + entry.pixamt;
+                uint8_t       * pdst   = pout;
+                for( ; pin != pinend; ++pin, pdst += 2 )
                 {
-                    uint8_t twopixels = *(itbeg + entry.pixelsrc + i );
-                    (*itout) = twopixels & 0x0F;
-                    ++itout;
-                    (*itout) = ( twopixels & 0xF0 ) >> 4;
-                    ++itout;
+                    pdst[0] = (*pin) & 0x0F;
+                    pdst[1] = (*pin) >> 4;
                 }
             }
+            pout += nbpix8bpp;
         }
     }
 
@@ -98,40 +120,15 @@ namespace pmd2 { namespace compression
             throw exception();
         }
 
-        unsigned int            sanitycpt   = 0; //A little counter to abort in case we don't find a null entry
         vector<rle_table_entry> entries;
-        uint32_t                imagesz8bpp = 0;
         uint32_t                frm_beg     = 0;
 
-        //#1 - Read our RLE table, and calculate our size
-        do
-        {
-            rle_table_entry entry;
-            //Read current entry
-            itfrmin = entry.ReadFromContainer( itfrmin, itend );
-            //advance( itfrmin, entry.size() ); //Increment reading position in the RLE table
+        //#1 - Read our RLE table, and resize the output to the decoded size
+        m_pOutput->resize( ReadRLETable( itfrmin, itend, entries, frm_beg ) );
 
-            imagesz8bpp += entry.pixamt * 2; //Multiply the bytes per 2, because we're exporting to 8bpp!
-
-            if( frm_beg == 0 && entry.pixelsrc != 0 ) //Get the beginning of the frame data if possible
-                frm_beg = entry.pixelsrc;
-
-            entries.push_back(entry);
-
-            ++sanitycpt;
-        } while( !entries.back().isNull() && sanitycpt < 1000u ); //We abort when hitting 1000 turns, just in case
-
-        assert( sanitycpt < 1000u ); //If we hit this, the data fed to this functor is very wrong !
-
-        //#2 - Resize the output
-        m_pOutput->resize( imagesz8bpp );
-        auto itoutpos  = m_pOutput->begin(); //The place in the output image we're writing at!
-
-        //#3 - Fill the image up
-        for( auto &entry : entries )
-        {
-            HandleRLETableEntry( entry, itbeg, itoutpos );
-        }
+        //#2 - Fill the image up
+        if( !m_pOutput->empty() )
+            DecodeRLEFrame( entries, &(*itbeg), static_cast<size_t>(std::distance(itbeg, itend)), m_pOutput->data() );
 
         //Increment to get the next element to output to, the next time this function is called, if applicable
         if(m_bUsingIterator ) 
@@ -48,6 +48,34 @@ namespace pmd2 { namespace compression
         }
     };
 
+//====================================================================================================
+// Functions
+//====================================================================================================
+    /*
+        ReadRLETable
+            Reads the RLE table of a frame, up to and including its null entry, into "out_entries".
+            - itfrmin      : The beginning of the RLE table. Where the frame pointer points to.
+            - out_frmbeg   : Set to the offset of the first byte of pixel data used by the frame, or 0 if none.
+            - Returns the size of the decoded frame, in 8bpp pixels.
+    */
+    uint32_t ReadRLETable( std::vector<uint8_t>::const_iterator itfrmin, 
+                           std::vector<uint8_t>::const_iterator itend, 
+                           std::vector<rle_table_entry>       & out_entries,
+                           uint32_t                           & out_frmbeg );
+
+    /*
+        DecodeRLEFrame
+            Decodes a frame whose RLE table was read with ReadRLETable.
+            - psrc   : The beginning of the container the offsets in the RLE table are calculated against.
+            - srclen : The length of that container, in bytes.
+            - pout   : Where to write the 8bpp pixels. Must have room for the size returned by ReadRLETable.
+            Throws if an entry points outside of the source data.
+    */
+    void DecodeRLEFrame( const std::vector<rle_table_entry> & entries, 
+                         const uint8_t                      * psrc, 
+                         size_t                               srclen, 
+                         uint8_t                            * pout );
+
 //====================================================================================================
 // Functors
 //====================================================================================================
@@ -218,6 +218,15 @@ namespace statsutil
             "-scrasdir",
             std::bind( &CStatsUtil::ParseOptionScriptAsDir, &GetInstance(), placeholders::_1 ),
         },
+
+        //Compile all scripts on import
+        {
+            "scrfullimport",
+            0,
+            "If present, all scripts are compiled when importing, instead of only those whose XML changed since the last import.",
+            "-scrfullimport",
+            std::bind( &CStatsUtil::ParseOptionScriptFullImport, &GetInstance(), placeholders::_1 ),
+        },
 ////////////////////////////////////////////////////////////////////////////////////////////
 
         //Specify the root of the extracted rom directory to work with
@@ -314,6 +323,7 @@ namespace statsutil
         m_dumplvllist     = false;
         m_dumpactorlist   = false;
         m_scriptasdir     = false;
+        m_scriptfullimport= false;
         utils::LibWide().StringValue(ScriptCompilerReportFname) = "compiler_report.txt"; //Set this keyvalue to our default report filename!
     }
 
@@ -526,6 +536,12 @@ namespace statsutil
         return m_scriptasdir = true;
     }
 
+    bool CStatsUtil::ParseOptionScriptFullImport(const std::vector<std::string> & optdata )
+    {
+        cout << "<!>- Compiling all scripts on import!\n";
+        return m_scriptfullimport = true;
+    }
+
     void CStatsUtil::SetupCFGPath(const std::string & cfgrelpath)
     {
         assert(!m_applicationdir.empty());
@@ -993,7 +1009,7 @@ namespace statsutil
         {
             cout <<"\nScripts\n"
                  <<"---------------------------------\n";
-            GameScripts * pgamescripts = gloader.InitScripts(pmd2::scriptprocoptions{true, true, false, m_scriptdebug, m_scriptasdir});
+            GameScripts * pgamescripts = gloader.InitScripts(pmd2::scriptprocoptions{true, true, false, m_scriptdebug, m_scriptasdir, !m_scriptfullimport});
             if(!pgamescripts)
                 throw std::runtime_error("CStatsUtil::HandleImport(): Couldn't load scripts!");
 
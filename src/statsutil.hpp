@@ -59,6 +59,7 @@ namespace statsutil
         bool ParseOptionDumpLvlList( const std::vector<std::string> & optdata );
         bool ParseOptionDumpActorList( const std::vector<std::string> & optdata );
         bool ParseOptionScriptAsDir(const std::vector<std::string> & optdata ); 
+        bool ParseOptionScriptFullImport(const std::vector<std::string> & optdata ); 
 
         //Execution
         void DetermineOperation();
@@ -193,6 +194,7 @@ namespace statsutil
         bool        m_dumplvllist;
         bool        m_dumpactorlist;
         bool        m_scriptasdir;  //Whether scripts are exported/imported as directories
+        bool        m_scriptfullimport; //Whether all scripts are compiled on import, even those that didn't change since the last import
         
         pmd2::eGameRegion  m_region;
         pmd2::eGameVersion m_version;
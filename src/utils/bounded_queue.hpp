@@ -0,0 +1,91 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+/*
+bounded_queue.hpp
+psycommando@gmail.com
+Description: A thread-safe queue with a maximum length, for passing work between the stages of a pipeline.
+             Producers block while the queue is full, so a fast stage can't run too far ahead of a slow one.
+*/
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace multitask
+{
+    /*
+        BoundedQueue
+            - Push blocks while the queue is full, and returns false if the queue was closed.
+            - Pop blocks while the queue is empty, and returns false once the queue was closed and emptied.
+            - Close is called by the producers once they're done, the consumers get what's left in the queue.
+            - Abort empties the queue and closes it, to unblock everything when a stage fails.
+    */
+    template<class _Ty>
+        class BoundedQueue
+    {
+    public:
+        typedef _Ty value_type;
+
+        explicit BoundedQueue( size_t capacity )
+            :m_capacity( (capacity != 0)? capacity : 1 ), m_bclosed(false)
+        {}
+
+        bool Push( value_type && item )
+        {
+            std::unique_lock<std::mutex> lck(m_mtx);
+            m_notfull.wait( lck, [this](){ return m_bclosed || m_items.size() < m_capacity; } );
+            if( m_bclosed )
+                return false;
+            m_items.push_back( std::move(item) );
+            lck.unlock();
+            m_notempty.notify_one();
+            return true;
+        }
+
+        bool Pop( value_type & out_item )
+        {
+            std::unique_lock<std::mutex> lck(m_mtx);
+            m_notempty.wait( lck, [this](){ return m_bclosed || !m_items.empty(); } );
+            if( m_items.empty() )
+                return false;
+            out_item = std::move( m_items.front() );
+            m_items.pop_front();
+            lck.unlock();
+            m_notfull.notify_one();
+            return true;
+        }
+
+        void Close()
+        {
+            {
+                std::lock_guard<std::mutex> lck(m_mtx);
+                m_bclosed = true;
+            }
+            m_notempty.notify_all();
+            m_notfull.notify_all();
+        }
+
+        void Abort()
+        {
+            {
+                std::lock_guard<std::mutex> lck(m_mtx);
+                m_bclosed = true;
+                m_items.clear();
+            }
+            m_notempty.notify_all();
+            m_notfull.notify_all();
+        }
+
+    private:
+        BoundedQueue( const BoundedQueue & );
+        BoundedQueue & operator=( const BoundedQueue & );
+
+        std::mutex              m_mtx;
+        std::condition_variable m_notfull;
+        std::condition_variable m_notempty;
+        std::deque<value_type>  m_items;
+        size_t                  m_capacity;
+        bool                    m_bclosed;
+    };
+};
+
+#endif
@@ -215,7 +215,7 @@ namespace utils
             for( ; (itin != itend) && (i < sizeof(T)); ++i, ++itin )
             {
                 T tmp = (*itin);
-                out_val |= ( tmp << (i * 8) ) & ( 0xFF << (i*8) );
+                out_val |= ( tmp << (i * 8) ) & ( static_cast<T>(0xFF) << (i*8) );
             }
 
             if( i != sizeof(T) )
@@ -232,7 +232,7 @@ namespace utils
             for( ; (itin != itend) && (i >= 0); --i, ++itin )
             {
                 T tmp = (*itin);
-                out_val |= ( tmp << (i * 8) ) & ( 0xFF << (i*8) );
+                out_val |= ( tmp << (i * 8) ) & ( static_cast<T>(0xFF) << (i*8) );
             }
 
             if( i != -1 )
@@ -82,7 +82,8 @@ namespace utils{ namespace io
         return std::move(stringlist);
     }
 
-    void WriteTextFileLineByLine( const std::vector<std::string> & data, const std::string & filepath, const std::locale & txtloc )
+    template<class _StrContainerTy>
+        void WriteLinesToTextFile( const _StrContainerTy & data, const std::string & filepath, const std::locale & txtloc )
     {
         static const char EOL = '\n';
         ofstream output(filepath);
@@ -106,5 +107,15 @@ namespace utils{ namespace io
         }
     }
 
+    void WriteTextFileLineByLine( const std::vector<std::string> & data, const std::string & filepath, const std::locale & txtloc )
+    {
+        WriteLinesToTextFile( data, filepath, txtloc );
+    }
+
+    void WriteTextFileLineByLine( const utils::StringTable & data, const std::string & filepath, const std::locale & txtloc )
+    {
+        WriteLinesToTextFile( data, filepath, txtloc );
+    }
+
 
 };};
\ No newline at end of file
@@ -10,6 +10,7 @@ Description: A few utilities to encapsulate writing stuff to files.
 #include <string>
 #include <cstdint>
 #include <locale>
+#include <utils/string_table.hpp>
 //#include <iostream>
 
 namespace utils{ namespace io
@@ -45,6 +46,10 @@ namespace utils{ namespace io
                                   const std::string              & filepath, 
                                   const std::locale              & txtloc = std::locale::classic() );
 
+    void WriteTextFileLineByLine( const utils::StringTable       & data, 
+                                  const std::string              & filepath, 
+                                  const std::locale              & txtloc = std::locale::classic() );
+
 };};
 
 #endif
\ No newline at end of file
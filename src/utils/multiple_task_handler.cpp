@@ -30,6 +30,8 @@ namespace multitask
 //================================================================================================
 // Utility
 //================================================================================================
+    //Whether the current thread is running tasks for a thread pool
+    static thread_local bool ThisThreadIsWorker = false;
     //void doHandleException( exception & e )
     //{
     //    assert(false);
@@ -134,6 +136,7 @@ namespace multitask
 
     bool CMultiTaskHandler::WorkerThread( thRunParam & taskSlot )
     {
+        ScopedWorkerThread markworker;
         while( !( m_stopWorkers.load() ) )
         {
             packaged_task<pktaskret_t()> mytask;
@@ -337,4 +340,64 @@ namespace multitask
         m_exceptions.push(ex);
     }
 
+//================================================================================================
+// Parallel loops
+//================================================================================================
+    bool IsWorkerThread()
+    {
+        return ThisThreadIsWorker;
+    }
+
+    ScopedWorkerThread::ScopedWorkerThread()
+        :m_bwasworker(ThisThreadIsWorker)
+    {
+        ThisThreadIsWorker = true;
+    }
+
+    ScopedWorkerThread::~ScopedWorkerThread()
+    {
+        ThisThreadIsWorker = m_bwasworker;
+    }
+
+    void ParallelForChunks( size_t nbitems, const std::function<void(size_t)> & fn, size_t minnbparallel )
+    {
+        const size_t nbthreads = LibraryWide::getInstance().Data().getNbThreadsToUse();
+        if( nbitems < minnbparallel || nbthreads < 2 || IsWorkerThread() )
+        {
+            for( size_t i = 0; i < nbitems; ++i )
+                fn(i);
+            return;
+        }
+
+        const size_t       nbchunks = std::min<size_t>( nbitems, nbthreads * 4 );
+        CMultiTaskHandler  taskmanager;
+        mutex              mtxexcept;
+        exception_ptr      firstexcept;
+
+        auto lambdaChunk = [&]( size_t chunk )->bool
+        {
+            try
+            {
+                for( size_t i = chunk; i < nbitems; i += nbchunks )
+                    fn(i);
+            }
+            catch(...)
+            {
+                lock_guard<mutex> lck(mtxexcept);
+                if( !firstexcept )
+                    firstexcept = current_exception();
+            }
+            return true;
+        };
+
+        for( size_t i = 0; i < nbchunks; ++i )
+            taskmanager.AddTask( pktask_t( std::bind( lambdaChunk, i ) ) );
+        taskmanager.Execute();
+        taskmanager.BlockUntilTaskQueueEmpty();
+        taskmanager.StopExecute();
+
+        if( firstexcept )
+            rethrow_exception(firstexcept);
+    }
+
 };
\ No newline at end of file
@@ -101,5 +101,46 @@ namespace multitask
         std::mutex                                   m_exceptionMutex;
         std::queue<std::exception_ptr>               m_exceptions;         
     };
+
+//================================================================================================
+// Parallel loops
+//================================================================================================
+    //Below this many items, running a loop on worker threads costs more than it saves.
+    static const size_t DefMinNbItemsParallel = 32;
+
+    /*
+        IsWorkerThread
+            Returns whether the calling thread is running tasks for a CMultiTaskHandler, or was
+            marked with a ScopedWorkerThread. 
+    */
+    bool IsWorkerThread();
+
+    /*
+        ScopedWorkerThread
+            Marks the calling thread as a worker thread until the object is destroyed.
+            For threads that do their own share of a parallel job without a CMultiTaskHandler.
+    */
+    class ScopedWorkerThread
+    {
+    public:
+        ScopedWorkerThread();
+        ~ScopedWorkerThread();
+    private:
+        ScopedWorkerThread( const ScopedWorkerThread & );
+        ScopedWorkerThread & operator=( const ScopedWorkerThread & );
+        bool m_bwasworker;
+    };
+
+    /*
+        ParallelForChunks
+            Calls "fn" once for every index in [0, nbitems). The indices are split into a few chunks 
+            per threads, so the slower items don't all end up on the same thread.
+            Runs everything on the calling thread instead when there are less than "minnbparallel"
+            items, when only a single thread is allowed, or when the calling thread is already a 
+            worker thread. Parallel jobs nested inside another one would only starve each others.
+            The order the items are processed in is not defined.
+            If any call throws, the first exception is rethrown once all chunks are done.
+    */
+    void ParallelForChunks( size_t nbitems, const std::function<void(size_t)> & fn, size_t minnbparallel = DefMinNbItemsParallel );
 };
 #endif
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "pugixml_utils.hpp"
+#include <stdexcept>
+#include <iostream>
 
 namespace pugixmlutils
 {
@@ -92,4 +94,285 @@ namespace pugixmlutils
             throw runtime_error( sstr.str() );
         }
     }
+
+//==============================================================================================
+//  XMLStreamWriter
+//==============================================================================================
+    namespace
+    {
+        const size_t XMLStreamBufferLen = 64 * 1024;
+
+        //Same as pugixml's indent flags
+        const unsigned int IndentNewline = 1;
+        const unsigned int IndentIndent  = 2;
+    };
+
+    XMLStreamWriter::node XMLStreamWriter::node::append_child( const char * name )
+    {
+        node child;
+        m_pwriter->BeginElement( *this, name, child );
+        return child;
+    }
+
+    void XMLStreamWriter::node::append_attribute( const char * name, const char * value )
+    {
+        m_pwriter->Attribute( *this, name, value );
+    }
+
+    void XMLStreamWriter::node::append_pcdata( const char * value )
+    {
+        m_pwriter->Text( *this, value, false );
+    }
+
+    void XMLStreamWriter::node::append_cdata( const char * value )
+    {
+        m_pwriter->Text( *this, value, true );
+    }
+
+    void XMLStreamWriter::node::append_comment( const char * value )
+    {
+        m_pwriter->Comment( *this, value );
+    }
+
+    std::string XMLStreamWriter::node::path()const
+    {
+        if( !m_pwriter )
+            return std::string();
+        return m_pwriter->Path(*this);
+    }
+
+    XMLStreamWriter::XMLStreamWriter( const std::string & fpath, const char * indent, unsigned int flags )
+        :m_fpath(fpath), m_flags(flags), m_indentflags(IndentIndent), m_nextid(1), m_bclosed(false)
+    {
+        using namespace pugi;
+        //Same rules as pugixml for when indentation is written
+        if( (m_flags & (format_indent | format_raw)) == format_indent && indent )
+            m_indent = indent;
+
+        m_outf.open( fpath, std::ios::out | std::ios::binary | std::ios::trunc );
+        if( m_outf.bad() || !m_outf.is_open() )
+            throw std::runtime_error( "XMLStreamWriter::XMLStreamWriter(): Couldn't open file \"" + fpath + "\" for writing!" );
+
+        m_buffer.reserve(XMLStreamBufferLen);
+        if( !(m_flags & format_no_declaration) )
+        {
+            m_buffer.append("<?xml version=\"1.0\"?>");
+            if( !(m_flags & format_raw) )
+                m_buffer.push_back('\n');
+        }
+    }
+
+    XMLStreamWriter::~XMLStreamWriter()
+    {
+        if( m_bclosed )
+            return;
+        try
+        {
+            Close();
+        }
+        catch( const std::exception & e )
+        {
+            std::cerr <<"<!>-Warning: XMLStreamWriter::~XMLStreamWriter(): " <<e.what() <<"\n";
+        }
+    }
+
+    void XMLStreamWriter::Close()
+    {
+        if( m_bclosed )
+            return;
+        CloseElements(0);
+        if( (m_indentflags & IndentNewline) && !(m_flags & pugi::format_raw) )
+            m_buffer.push_back('\n');
+        Flush(true);
+        m_bclosed = true;
+        m_outf.close();
+        if( m_outf.fail() )
+            throw std::runtime_error( "XMLStreamWriter::Close(): Couldn't write to file \"" + m_fpath + "\"!" );
+    }
+
+    void XMLStreamWriter::BeginElement( const node & parent, const char * name, node & out_child )
+    {
+        CheckNode(parent);
+        CloseElements(parent.m_depth);
+        EndStartTag();
+        BeginLine(parent.m_depth);
+        m_buffer.push_back('<');
+        m_buffer.append(name);
+        m_indentflags = IndentNewline | IndentIndent;
+
+        m_openelems.push_back( openelem{ name, m_nextid, true } );
+        out_child = node( this, m_openelems.size(), m_nextid );
+        ++m_nextid;
+        Flush();
+    }
+
+    void XMLStreamWriter::Attribute( const node & elem, const char * name, const char * value )
+    {
+        CheckNode(elem);
+        if( elem.m_depth == 0 || m_openelems.size() != elem.m_depth || !m_openelems.back().starttagopen )
+            throw std::logic_error( "XMLStreamWriter::Attribute(): Can't add attribute \"" + std::string(name) + "\" to \"" + Path(elem) + "\" after its content was written!" );
+        m_buffer.push_back(' ');
+        m_buffer.append(name);
+        m_buffer.append("=\"");
+        WriteText(value, true);
+        m_buffer.push_back('"');
+        Flush();
+    }
+
+    void XMLStreamWriter::Text( const node & elem, const char * value, bool iscdata )
+    {
+        CheckNode(elem);
+        CloseElements(elem.m_depth);
+        EndStartTag();
+        if( iscdata )
+        {
+            //Split the sequences that would end the CDATA, like pugixml does
+            const char * pcur = value;
+            do
+            {
+                const char * pbeg = pcur;
+                while( *pcur && !(pcur[0] == ']' && pcur[1] == ']' && pcur[2] == '>') )
+                    ++pcur;
+                if( *pcur )
+                    pcur += 2;
+                m_buffer.append("<![CDATA[");
+                m_buffer.append(pbeg, pcur);
+                m_buffer.append("]]>");
+            }
+            while( *pcur );
+        }
+        else
+            WriteText(value, false);
+        m_indentflags = 0;
+        Flush();
+    }
+
+    void XMLStreamWriter::Comment( const node & elem, const char * value )
+    {
+        CheckNode(elem);
+        CloseElements(elem.m_depth);
+        EndStartTag();
+        BeginLine(elem.m_depth);
+        m_buffer.append("<!--");
+        //"--" and a trailing '-' aren't allowed in comments
+        for( const char * pcur = value; *pcur; ++pcur )
+        {
+            m_buffer.push_back(*pcur);
+            if( *pcur == '-' && (pcur[1] == '-' || pcur[1] == 0) )
+                m_buffer.push_back(' ');
+        }
+        m_buffer.append("-->");
+        m_indentflags = IndentNewline | IndentIndent;
+        Flush();
+    }
+
+    std::string XMLStreamWriter::Path( const node & elem )const
+    {
+        std::string path;
+        for( size_t i = 0; i < elem.m_depth && i < m_openelems.size(); ++i )
+        {
+            path.push_back('/');
+            path.append(m_openelems[i].name);
+        }
+        return path;
+    }
+
+    void XMLStreamWriter::CheckNode( const node & elem )const
+    {
+        if( elem.m_pwriter != this )
+            throw std::logic_error("XMLStreamWriter: Node is empty, or from another writer!");
+        if( m_bclosed )
+            throw std::logic_error("XMLStreamWriter: Writer for \"" + m_fpath + "\" was already closed!");
+        if( elem.m_depth > m_openelems.size() || (elem.m_depth != 0 && m_openelems[elem.m_depth - 1].id != elem.m_id) )
+            throw std::logic_error("XMLStreamWriter: Can't write to an element that was already closed!");
+    }
+
+    void XMLStreamWriter::CloseElements( size_t depth )
+    {
+        while( m_openelems.size() > depth )
+        {
+            if( m_openelems.back().starttagopen )
+                m_buffer.append(" />");
+            else
+            {
+                BeginLine( m_openelems.size() - 1 );
+                m_buffer.append("</");
+                m_buffer.append(m_openelems.back().name);
+                m_buffer.push_back('>');
+            }
+            m_indentflags = IndentNewline | IndentIndent;
+            m_openelems.pop_back();
+        }
+    }
+
+    void XMLStreamWriter::EndStartTag()
+    {
+        if( !m_openelems.empty() && m_openelems.back().starttagopen )
+        {
+            m_buffer.push_back('>');
+            m_openelems.back().starttagopen = false;
+        }
+    }
+
+    void XMLStreamWriter::BeginLine( size_t depth )
+    {
+        if( (m_indentflags & IndentNewline) && !(m_flags & pugi::format_raw) )
+            m_buffer.push_back('\n');
+        if( (m_indentflags & IndentIndent) && !m_indent.empty() )
+        {
+            for( size_t i = 0; i < depth; ++i )
+                m_buffer.append(m_indent);
+        }
+    }
+
+    void XMLStreamWriter::WriteText( const char * str, bool isattribute )
+    {
+        if( m_flags & pugi::format_no_escapes )
+        {
+            m_buffer.append(str);
+            return;
+        }
+
+        for( const char * pcur = str; *pcur; ++pcur )
+        {
+            const unsigned char c = static_cast<unsigned char>(*pcur);
+            switch(c)
+            {
+                case '&': m_buffer.append("&amp;"); break;
+                case '<': m_buffer.append("&lt;");  break;
+                case '>': m_buffer.append("&gt;");  break;
+                case '"':
+                {
+                    if( isattribute )
+                        m_buffer.append("&quot;");
+                    else
+                        m_buffer.push_back('"');
+                    break;
+                }
+                default:
+                {
+                    //Control characters, except for tabs everywhere, and line breaks in text
+                    if( c < 32 && c != '\t' && (isattribute || (c != '\r' && c != '\n')) )
+                    {
+                        m_buffer.append("&#");
+                        m_buffer.push_back( static_cast<char>('0' + (c / 10)) );
+                        m_buffer.push_back( static_cast<char>('0' + (c % 10)) );
+                        m_buffer.push_back(';');
+                    }
+                    else
+                        m_buffer.push_back(*pcur);
+                }
+            };
+        }
+    }
+
+    void XMLStreamWriter::Flush( bool bforce )
+    {
+        if( !bforce && m_buffer.size() < XMLStreamBufferLen )
+            return;
+        m_outf.write( m_buffer.data(), m_buffer.size() );
+        m_buffer.clear();
+        if( m_outf.fail() )
+            throw std::runtime_error( "XMLStreamWriter::Flush(): Couldn't write to file \"" + m_fpath + "\"!" );
+    }
 };
\ No newline at end of file
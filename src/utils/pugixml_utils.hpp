@@ -13,6 +13,8 @@ Description:
 #include <codecvt>
 #include <locale>
 #include <sstream>
+#include <fstream>
+#include <vector>
 
 namespace pugixmlutils
 {
@@ -205,6 +207,177 @@ namespace pugixmlutils
     }
 
 
+//==============================================================================================
+//  XMLStreamWriter
+//==============================================================================================
+    /***************************************************************************************
+        XMLStreamWriter
+            Writes a XML file element by element as it's being built, instead of building the
+            whole document in memory with pugixml first. Meant for the big exports.
+
+            The output is formatted just like pugi::xml_document::save_file() would with the
+            same indent string and flags. The text is buffered, and written to the file every
+            time the buffer fills up.
+
+            Elements are handled through lightweight "node" handles. Appending anything to a
+            node closes the elements that were opened under it before. So, attributes must be
+            added to an element before anything is appended to it, and an element can't be
+            written to anymore once it was closed. Both throw a std::logic_error.
+
+            Only the format_indent, format_raw, format_no_escapes and format_no_declaration
+            formatting flags are supported.
+    ***************************************************************************************/
+    class XMLStreamWriter
+    {
+    public:
+        /*
+            node
+                Handle to an element being written, or to the document itself.
+                Can be copied around freely, it doesn't own anything.
+        */
+        class node
+        {
+            friend class XMLStreamWriter;
+        public:
+            node():m_pwriter(nullptr), m_depth(0), m_id(0) {}
+
+            node        append_child    ( const char * name );
+            inline node append_child    ( const std::string & name ) { return append_child(name.c_str()); }
+            void        append_attribute( const char * name, const char * value );
+            void        append_pcdata   ( const char * value );
+            void        append_cdata    ( const char * value );
+            void        append_comment  ( const char * value );
+
+            //Path to the element, separated by '/'. For error messages.
+            std::string path()const;
+
+            inline bool empty()const { return m_pwriter == nullptr; }
+
+        private:
+            node( XMLStreamWriter * pwriter, size_t depth, size_t id )
+                :m_pwriter(pwriter), m_depth(depth), m_id(id)
+            {}
+
+            XMLStreamWriter * m_pwriter;
+            size_t            m_depth;  //Amount of elements from the document to this one, this one included.
+            size_t            m_id;     //Tells apart an element from the siblings that replaced it after it was closed.
+        };
+
+        /*
+            - fpath  : Path to the file to write. It's created or truncated right away.
+            - indent : The string written for each indentation levels.
+            - flags  : pugixml formatting flags.
+        */
+        XMLStreamWriter( const std::string & fpath, const char * indent = "\t", unsigned int flags = pugi::format_default );
+        ~XMLStreamWriter();
+
+        //The document. The root element is appended to this.
+        inline node Root() { return node(this, 0, 0); }
+
+        //Closes all elements left open, and writes what's left in the buffer to the file.
+        //Throws if the file couldn't be written to. Nothing can be written after this.
+        void Close();
+
+    private:
+        struct openelem
+        {
+            std::string name;
+            size_t      id;
+            bool        starttagopen;   //Whether the start tag wasn't terminated yet, and attributes can still be added
+        };
+
+        void        BeginElement( const node & parent, const char * name, node & out_child );
+        void        Attribute   ( const node & elem, const char * name, const char * value );
+        void        Text        ( const node & elem, const char * value, bool iscdata );
+        void        Comment     ( const node & elem, const char * value );
+        std::string Path        ( const node & elem )const;
+
+        void CheckNode      ( const node & elem )const;
+        void CloseElements  ( size_t depth );
+        void EndStartTag    ();
+        void BeginLine      ( size_t depth );
+        void WriteText      ( const char * str, bool isattribute );
+        void Flush          ( bool bforce = false );   //Writes the buffer to the file once it's full, or right away if forced
+
+        std::ofstream         m_outf;
+        std::string           m_fpath;
+        std::string           m_buffer;
+        std::string           m_indent;
+        unsigned int          m_flags;
+        unsigned int          m_indentflags;
+        std::vector<openelem> m_openelems;
+        size_t                m_nextid;
+        bool                  m_bclosed;
+    };
+
+    /***************************************************************************************
+        XMLStreamWriter helpers
+            Same as the helpers above, but for elements written with a XMLStreamWriter.
+            The nodes are passed by value, since they're only handles.
+    ***************************************************************************************/
+    inline std::string ToXMLValueString( const std::string & value ) { return value; }
+    inline std::string ToXMLValueString( const char        * value ) { return value; }
+    inline std::string ToXMLValueString( char              * value ) { return value; }
+
+    template<class T>
+        inline std::string ToXMLValueString( T value )
+    {
+        return std::to_string(value);
+    }
+
+    inline void WriteCommentNode( XMLStreamWriter::node node, const std::string & str )
+    {
+        node.append_comment(str.c_str());
+    }
+
+    inline void WriteCommentNode( XMLStreamWriter::node node, const char * str )
+    {
+        node.append_comment(str);
+    }
+
+    template<class T>
+        inline void WriteNodeWithValue( XMLStreamWriter::node parentnode, const std::string & name, T value )
+    {
+        parentnode.append_child(name).append_pcdata( ToXMLValueString(value).c_str() );
+    }
+
+    inline XMLStreamWriter::node AppendChildNode( XMLStreamWriter::node parent, const std::string & childname )
+    {
+        return parent.append_child(childname);
+    }
+
+    inline void AppendAttribute( XMLStreamWriter::node parent, const std::string & name, const std::string & value )
+    {
+        parent.append_attribute( name.c_str(), value.c_str() );
+    }
+
+    inline void AppendAttribute( XMLStreamWriter::node parent, const std::string & name, const char * value )
+    {
+        parent.append_attribute( name.c_str(), value );
+    }
+
+    inline void AppendAttribute( XMLStreamWriter::node parent, const std::string & name, char * value )
+    {
+        parent.append_attribute( name.c_str(), value );
+    }
+
+    template<class T>
+        inline void AppendAttribute( XMLStreamWriter::node parent, const std::string & name, T value )
+    {
+        parent.append_attribute( name.c_str(), std::to_string(value).c_str() );
+    }
+
+    inline void AppendCData( XMLStreamWriter::node parentnode, const std::string & value )
+    {
+        parentnode.append_cdata(value.c_str());
+    }
+
+    inline void AppendPCData( XMLStreamWriter::node parentnode, const std::string & value )
+    {
+        parentnode.append_pcdata(value.c_str());
+    }
+
+
     /*
         HandleParsingError
             If there were no errors while parsing does nothing. Otherwise throws an appropriate exception!
@@ -0,0 +1,187 @@
+#ifndef STRING_TABLE_HPP
+#define STRING_TABLE_HPP
+/*
+string_table.hpp
+psycommando@gmail.com
+Description: A list of strings stored back to back in a single character buffer, with a table of
+             offsets into it. Avoids one heap allocation per string for large string files.
+*/
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace utils
+{
+    /*
+        StrView
+            A read-only view on a string stored somewhere else. It doesn't own its characters,
+            so it must not outlive the StringTable it was obtained from, and is invalidated by
+            any modification to the table.
+    */
+    class StrView
+    {
+    public:
+        typedef const char * const_iterator;
+
+        StrView()
+            :m_pstr(nullptr), m_len(0)
+        {}
+
+        StrView( const char * pstr, size_t len )
+            :m_pstr(pstr), m_len(len)
+        {}
+
+        inline const char     * data  ()const { return m_pstr; }
+        inline size_t           size  ()const { return m_len; }
+        inline size_t           length()const { return m_len; }
+        inline bool             empty ()const { return m_len == 0; }
+        inline const_iterator   begin ()const { return m_pstr; }
+        inline const_iterator   end   ()const { return m_pstr + m_len; }
+        inline char             operator[]( size_t index )const { return m_pstr[index]; }
+
+        //Makes a copy of the string
+        inline std::string      str()const                  { return std::string( m_pstr, m_len ); }
+        inline operator         std::string()const          { return str(); }
+
+        inline bool operator==( const StrView & other )const
+        {
+            return m_len == other.m_len && std::equal( begin(), end(), other.begin() );
+        }
+        inline bool operator!=( const StrView & other )const { return !(*this == other); }
+
+    private:
+        const char * m_pstr;
+        size_t       m_len;
+    };
+
+    inline std::ostream & operator<<( std::ostream & os, const StrView & str )
+    {
+        return os.write( str.data(), str.size() );
+    }
+
+    /*
+        StringTable
+            Strings are accessed by index, and returned as StrView.
+            - Replace() overwrites the string in place when the new one isn't longer, otherwise the
+              new string is appended to the end of the buffer. The old characters are left unused
+              until the table is rebuilt, which is fine for the occasional edit.
+    */
+    class StringTable
+    {
+        struct entry_t
+        {
+            size_t beg;
+            size_t len;
+        };
+    public:
+        /*
+            const_iterator
+                Random access iterator returning views by value.
+        */
+        class const_iterator : public std::iterator<std::random_access_iterator_tag, StrView, std::ptrdiff_t, const StrView *, StrView>
+        {
+        public:
+            const_iterator()
+                :m_ptbl(nullptr), m_index(0)
+            {}
+
+            const_iterator( const StringTable * ptbl, size_t index )
+                :m_ptbl(ptbl), m_index(index)
+            {}
+
+            inline StrView          operator* ()const                   { return (*m_ptbl)[m_index]; }
+            inline StrView          operator[]( std::ptrdiff_t n )const { return (*m_ptbl)[m_index + n]; }
+
+            inline const_iterator & operator++()                        { ++m_index; return *this; }
+            inline const_iterator   operator++(int)                     { const_iterator tmp(*this); ++m_index; return tmp; }
+            inline const_iterator & operator--()                        { --m_index; return *this; }
+            inline const_iterator   operator--(int)                     { const_iterator tmp(*this); --m_index; return tmp; }
+            inline const_iterator & operator+=( std::ptrdiff_t n )      { m_index += n; return *this; }
+            inline const_iterator & operator-=( std::ptrdiff_t n )      { m_index -= n; return *this; }
+            inline const_iterator   operator+ ( std::ptrdiff_t n )const { return const_iterator( m_ptbl, m_index + n ); }
+            inline const_iterator   operator- ( std::ptrdiff_t n )const { return const_iterator( m_ptbl, m_index - n ); }
+            inline std::ptrdiff_t   operator- ( const const_iterator & other )const { return static_cast<std::ptrdiff_t>(m_index) - static_cast<std::ptrdiff_t>(other.m_index); }
+
+            inline bool operator==( const const_iterator & other )const { return m_index == other.m_index; }
+            inline bool operator!=( const const_iterator & other )const { return m_index != other.m_index; }
+            inline bool operator< ( const const_iterator & other )const { return m_index <  other.m_index; }
+            inline bool operator> ( const const_iterator & other )const { return m_index >  other.m_index; }
+            inline bool operator<=( const const_iterator & other )const { return m_index <= other.m_index; }
+            inline bool operator>=( const const_iterator & other )const { return m_index >= other.m_index; }
+
+        private:
+            const StringTable * m_ptbl;
+            size_t              m_index;
+        };
+        typedef const_iterator iterator;
+
+        StringTable()
+        {}
+
+        template<class _init>
+            StringTable( _init itbeg, _init itend )
+        {
+            for( ; itbeg != itend; ++itbeg )
+                push_back(*itbeg);
+        }
+
+        //Reserve space for "nbstrs" strings, with a total length of "nbchars" characters.
+        inline void reserve( size_t nbstrs, size_t nbchars )
+        {
+            m_entries.reserve(nbstrs);
+            m_buffer.reserve(nbchars);
+        }
+
+        inline void push_back( const char * pstr, size_t len )
+        {
+            entry_t ent;
+            ent.beg = m_buffer.size();
+            ent.len = len;
+            m_buffer.insert( m_buffer.end(), pstr, pstr + len );
+            m_entries.push_back(ent);
+        }
+        inline void push_back( const std::string & str ) { push_back( str.data(), str.size() ); }
+        inline void push_back( const StrView     & str ) { push_back( str.data(), str.size() ); }
+
+        void Replace( size_t index, const std::string & str )
+        {
+            entry_t & ent = m_entries.at(index);
+            if( str.size() > ent.len )
+            {
+                ent.beg = m_buffer.size();
+                m_buffer.insert( m_buffer.end(), str.begin(), str.end() );
+            }
+            else
+                std::copy( str.begin(), str.end(), m_buffer.begin() + ent.beg );
+            ent.len = str.size();
+        }
+
+        inline StrView operator[]( size_t index )const
+        {
+            const entry_t & ent = m_entries[index];
+            return StrView( m_buffer.data() + ent.beg, ent.len );
+        }
+
+        inline StrView at( size_t index )const
+        {
+            if( index >= m_entries.size() )
+                throw std::out_of_range("StringTable::at(): String index out of range!");
+            return operator[](index);
+        }
+
+        inline size_t         size ()const { return m_entries.size(); }
+        inline bool           empty()const { return m_entries.empty(); }
+        inline const_iterator begin()const { return const_iterator( this, 0 ); }
+        inline const_iterator end  ()const { return const_iterator( this, m_entries.size() ); }
+
+    private:
+        std::vector<char>    m_buffer;
+        std::vector<entry_t> m_entries;
+    };
+};
+
+#endif